@@ -0,0 +1,558 @@
+#include "Archive.h"
+#include <Windows.h>
+#include <fstream>
+#include <mutex>
+#include <string.h>
+#include <unordered_map>
+
+// Demo archives
+//
+// Demos in zip and tar archives are listed as "<archive>|<member>" paths, so they go through the batch like any other
+// demo file. A member is read by mapping its range of the archive into memory: stored members are parsed straight from
+// the mapping, and deflated zip members are decompressed from it into the demo buffer. Nothing is extracted to disk.
+//
+// Only the central directory of a zip is read when listing it (the local headers are read for the members that are
+// actually opened), tar headers are read one by one since a tar has no index.
+//
+// The member table of an archive is read once and cached, so opening every demo of a large archive doesn't list it
+// again for each member. A cached table is dropped when the archive's size or write time changes on disk.
+
+#define ZIP_EOCD_SIGNATURE				0x06054B50
+#define ZIP_EOCD_SIZE					22
+#define ZIP_MAX_COMMENT_SIZE			65535
+#define ZIP64_EOCD_LOCATOR_SIGNATURE	0x07064B50
+#define ZIP64_EOCD_LOCATOR_SIZE			20
+#define ZIP64_EOCD_SIGNATURE			0x06064B50
+#define ZIP64_EOCD_SIZE					56
+#define ZIP64_EXTRA_ID					0x0001
+#define ZIP_CENTRAL_SIGNATURE			0x02014B50
+#define ZIP_CENTRAL_SIZE				46
+#define ZIP_LOCAL_SIGNATURE				0x04034B50
+#define ZIP_LOCAL_SIZE					30
+#define ZIP_METHOD_STORED				0
+#define ZIP_METHOD_DEFLATED				8
+#define ZIP_FLAG_ENCRYPTED				(1<<0)
+
+#define TAR_BLOCK_SIZE					512
+#define TAR_MAX_EXTENDED_HEADER_SIZE	65536	// Larger GNU long name and pax headers are skipped
+
+// =====================================================================================================================================================================
+
+static inline uint16 ReadLE16( const byte *p )
+{
+	return (uint16)( p[ 0 ] | ( p[ 1 ] << 8 ) );
+}
+
+static inline uint32 ReadLE32( const byte *p )
+{
+	return p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 ) | ( (uint32)p[ 3 ] << 24 );
+}
+
+static inline uint64 ReadLE64( const byte *p )
+{
+	return ReadLE32( p ) | ( (uint64)ReadLE32( p + 4 ) << 32 );
+}
+
+// =====================================================================================================================================================================
+
+MappedFileView::MappedFileView( void )
+{
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+	m_pView = nullptr;
+	m_offsetInView = 0;
+}
+
+// =====================================================================================================================================================================
+
+MappedFileView::~MappedFileView( void )
+{
+	if( m_pView )
+		UnmapViewOfFile( m_pView );
+
+	if( m_hMapping )
+		CloseHandle( m_hMapping );
+
+	if( m_hFile != INVALID_HANDLE_VALUE )
+		CloseHandle( m_hFile );
+}
+
+// =====================================================================================================================================================================
+
+bool MappedFileView::Map( const std::string &filename, uint64 offset, size_t size )
+{
+	if( !size )
+		return false;
+
+	m_hFile = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+	if( m_hFile == INVALID_HANDLE_VALUE )
+		return false;
+
+	m_hMapping = CreateFileMappingA( m_hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr );
+
+	if( !m_hMapping )
+		return false;
+
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+
+	const uint64 viewOffset = offset - offset % info.dwAllocationGranularity;
+	m_offsetInView = (size_t)( offset - viewOffset );
+
+	m_pView = (byte *)MapViewOfFile( m_hMapping, FILE_MAP_COPY, (DWORD)( viewOffset >> 32 ), (DWORD)viewOffset, m_offsetInView + size );
+
+	return m_pView != nullptr;
+}
+
+// =====================================================================================================================================================================
+
+byte *MappedFileView::GetData( void ) const
+{
+	return m_pView + m_offsetInView;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Finds the central directory from the end of central directory record (or its zip64 version)
+ */
+static bool FindZipCentralDirectory( std::ifstream &file, uint64 fileSize, uint64 &offset, uint64 &size, uint64 &numEntries )
+{
+	// The record is at the very end of the file, followed only by the archive comment
+	const uint64 tailSize = ( fileSize < ZIP_EOCD_SIZE + ZIP_MAX_COMMENT_SIZE )? fileSize : ZIP_EOCD_SIZE + ZIP_MAX_COMMENT_SIZE;
+
+	if( tailSize < ZIP_EOCD_SIZE )
+		return false;
+
+	std::vector< byte > tail( (size_t)tailSize );
+
+	file.seekg( fileSize - tailSize, std::ios_base::beg );
+
+	if( !file.read( (char *)tail.data(), tail.size() ) )
+		return false;
+
+	for( size_t pos = tail.size() - ZIP_EOCD_SIZE + 1; pos-- > 0; )
+	{
+		const byte *eocd = &tail[ pos ];
+
+		if( ReadLE32( eocd ) != ZIP_EOCD_SIGNATURE )
+			continue;
+
+		numEntries = ReadLE16( eocd + 10 );
+		size = ReadLE32( eocd + 12 );
+		offset = ReadLE32( eocd + 16 );
+
+		if( numEntries != 0xFFFF && size != 0xFFFFFFFF && offset != 0xFFFFFFFF )
+			return true;
+
+		// Zip64 archive, the real values are in the zip64 record that the locator before this record points to
+		const uint64 eocdOffset = fileSize - tailSize + pos;
+
+		if( eocdOffset < ZIP64_EOCD_LOCATOR_SIZE )
+			return false;
+
+		byte locator[ ZIP64_EOCD_LOCATOR_SIZE ];
+		file.seekg( eocdOffset - ZIP64_EOCD_LOCATOR_SIZE, std::ios_base::beg );
+
+		if( !file.read( (char *)locator, sizeof( locator ) ) || ReadLE32( locator ) != ZIP64_EOCD_LOCATOR_SIGNATURE )
+			return false;
+
+		byte eocd64[ ZIP64_EOCD_SIZE ];
+		file.seekg( ReadLE64( locator + 8 ), std::ios_base::beg );
+
+		if( !file.read( (char *)eocd64, sizeof( eocd64 ) ) || ReadLE32( eocd64 ) != ZIP64_EOCD_SIGNATURE )
+			return false;
+
+		numEntries = ReadLE64( eocd64 + 32 );
+		size = ReadLE64( eocd64 + 40 );
+		offset = ReadLE64( eocd64 + 48 );
+		return true;
+	}
+
+	return false;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Lists the members of a zip from its central directory
+ * The offsets are the offsets of the local headers, the data starts after the local header.
+ */
+static bool ReadZipMembers( std::ifstream &file, uint64 fileSize, std::vector< ArchiveMember_t > &members )
+{
+	uint64 offset, size, numEntries;
+
+	if( !FindZipCentralDirectory( file, fileSize, offset, size, numEntries ) || offset + size > fileSize )
+		return false;
+
+	std::vector< byte > directory( (size_t)size );
+
+	file.clear();
+	file.seekg( offset, std::ios_base::beg );
+
+	if( !file.read( (char *)directory.data(), directory.size() ) )
+		return false;
+
+	members.reserve( (size_t)numEntries );
+
+	for( size_t pos = 0; pos + ZIP_CENTRAL_SIZE <= directory.size(); )
+	{
+		const byte *entry = &directory[ pos ];
+
+		if( ReadLE32( entry ) != ZIP_CENTRAL_SIGNATURE )
+			break;
+
+		const uint16 flags = ReadLE16( entry + 8 );
+		const uint16 method = ReadLE16( entry + 10 );
+		const uint16 nameLength = ReadLE16( entry + 28 );
+		const uint16 extraLength = ReadLE16( entry + 30 );
+		const uint16 commentLength = ReadLE16( entry + 32 );
+
+		if( pos + ZIP_CENTRAL_SIZE + nameLength + extraLength > directory.size() )
+			break;
+
+		ArchiveMember_t member;
+		member.name.assign( (const char *)entry + ZIP_CENTRAL_SIZE, nameLength );
+		member.compressedSize = ReadLE32( entry + 20 );
+		member.size = ReadLE32( entry + 24 );
+		member.offset = ReadLE32( entry + 42 );
+
+		if( flags & ZIP_FLAG_ENCRYPTED )
+			member.compression = ARCHIVE_UNSUPPORTED;
+		else if( method == ZIP_METHOD_STORED )
+			member.compression = ARCHIVE_STORED;
+		else if( method == ZIP_METHOD_DEFLATED )
+			member.compression = ARCHIVE_DEFLATED;
+		else
+			member.compression = ARCHIVE_UNSUPPORTED;
+
+		// Values that don't fit in 32 bits are in the zip64 extra field, in this order
+		const byte *extra = entry + ZIP_CENTRAL_SIZE + nameLength;
+		const byte *extraEnd = extra + extraLength;
+
+		while( extra + 4 <= extraEnd )
+		{
+			const uint16 id = ReadLE16( extra );
+			const uint16 length = ReadLE16( extra + 2 );
+			const byte *value = extra + 4;
+			const byte *valueEnd = value + length;
+
+			if( valueEnd > extraEnd )
+				break;
+
+			if( id == ZIP64_EXTRA_ID )
+			{
+				if( member.size == 0xFFFFFFFF && value + 8 <= valueEnd )
+				{
+					member.size = ReadLE64( value );
+					value += 8;
+				}
+
+				if( member.compressedSize == 0xFFFFFFFF && value + 8 <= valueEnd )
+				{
+					member.compressedSize = ReadLE64( value );
+					value += 8;
+				}
+
+				if( member.offset == 0xFFFFFFFF && value + 8 <= valueEnd )
+					member.offset = ReadLE64( value );
+			}
+
+			extra = valueEnd;
+		}
+
+		members.push_back( member );
+
+		pos += ZIP_CENTRAL_SIZE + nameLength + extraLength + commentLength;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Numeric tar header fields are octal text, or big-endian binary if the high bit of the first byte is set
+ */
+static uint64 ParseTarNumber( const byte *field, int length )
+{
+	uint64 value = 0;
+
+	if( field[ 0 ] & 0x80 )
+	{
+		value = field[ 0 ] & 0x7F;
+
+		for( int i = 1; i < length; ++i )
+			value = ( value << 8 ) | field[ i ];
+
+		return value;
+	}
+
+	int i = 0;
+
+	while( i < length && field[ i ] == ' ' )
+		++i;
+
+	for( ; i < length && field[ i ] >= '0' && field[ i ] <= '7'; ++i )
+		value = ( value << 3 ) | ( field[ i ] - '0' );
+
+	return value;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Gets the path from the records of a pax extended header ("<length> path=<value>\n")
+ */
+static bool GetPaxPath( const std::string &records, std::string &path )
+{
+	size_t pos = 0;
+
+	while( pos < records.size() )
+	{
+		const size_t space = records.find( ' ', pos );
+		const size_t length = strtoul( records.c_str() + pos, nullptr, 10 );
+
+		if( space == std::string::npos || !length || pos + length > records.size() )
+			return false;
+
+		if( !records.compare( space + 1, 5, "path=" ) )
+		{
+			// Value ends before the newline that ends the record
+			path = records.substr( space + 6, pos + length - 1 - ( space + 6 ) );
+			return true;
+		}
+
+		pos += length;
+	}
+
+	return false;
+}
+
+// =====================================================================================================================================================================
+
+static bool ReadTarMembers( std::ifstream &file, uint64 fileSize, std::vector< ArchiveMember_t > &members )
+{
+	byte header[ TAR_BLOCK_SIZE ];
+	uint64 pos = 0;
+	std::string longName;	// From the GNU long name or pax header before the member
+
+	file.seekg( 0, std::ios_base::beg );
+
+	while( pos + TAR_BLOCK_SIZE <= fileSize && file.read( (char *)header, TAR_BLOCK_SIZE ) )
+	{
+		// An empty block ends the archive
+		if( !header[ 0 ] )
+			break;
+
+		const uint64 size = ParseTarNumber( header + 124, 12 );
+		const char type = header[ 156 ];
+
+		pos += TAR_BLOCK_SIZE;
+
+		if( type == 'L' || type == 'x' )
+		{
+			if( size <= TAR_MAX_EXTENDED_HEADER_SIZE )
+			{
+				std::string data( (size_t)size, '\0' );
+
+				if( !file.read( data.data(), data.size() ) )
+					return false;
+
+				if( type == 'L' )
+					longName.assign( data.c_str() );
+				else
+					GetPaxPath( data, longName );
+			}
+		}
+		else if( type == '0' || type == '\0' )
+		{
+			ArchiveMember_t member;
+
+			if( !longName.empty() )
+			{
+				member.name = longName;
+			}
+			else
+			{
+				// The ustar prefix holds the start of paths longer than 100 characters
+				if( !memcmp( header + 257, "ustar", 5 ) && header[ 345 ] )
+				{
+					member.name.assign( (const char *)header + 345, strnlen( (const char *)header + 345, 155 ) );
+					member.name += '/';
+				}
+
+				member.name.append( (const char *)header, strnlen( (const char *)header, 100 ) );
+			}
+
+			member.offset = pos;
+			member.compressedSize = size;
+			member.size = size;
+			member.compression = ARCHIVE_STORED;
+
+			members.push_back( member );
+			longName.clear();
+		}
+		else
+		{
+			longName.clear();
+		}
+
+		// Data is padded to full blocks
+		pos += ( size + TAR_BLOCK_SIZE - 1 ) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+		file.seekg( pos, std::ios_base::beg );
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+static bool ReadArchiveMembers( const std::string &archive, std::ifstream &file, std::vector< ArchiveMember_t > &members )
+{
+	file.open( archive, std::ios::binary );
+
+	if( !file.is_open() )
+		return false;
+
+	file.seekg( 0, std::ios_base::end );
+	const uint64 fileSize = file.tellg();
+
+	if( FileHasExtension( archive, "zip" ) )
+		return ReadZipMembers( file, fileSize, members );
+
+	return ReadTarMembers( file, fileSize, members );
+}
+
+// =====================================================================================================================================================================
+
+struct ArchiveListing_t
+{
+	uint64				fileSize;			///< Size and write time of the archive when it was listed
+	FILETIME			lastWriteTime;
+	std::unordered_map< std::string, ArchiveMember_t > members;			///< By member name
+};
+
+static std::mutex s_ArchiveCacheMutex;				// Archive members are opened from the parser threads
+static std::unordered_map< std::string, ArchiveListing_t > s_ArchiveCache;
+
+/**
+ * Returns the cached member table of the archive, reading the archive again if it changed since it was listed
+ * Passing members forces a fresh read and also returns the members in archive order. s_ArchiveCacheMutex must be held.
+ */
+static const ArchiveListing_t *GetArchiveListing( const std::string &archive, std::vector< ArchiveMember_t > *members )
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+
+	if( !GetFileAttributesExA( archive.c_str(), GetFileExInfoStandard, &data ) )
+		return nullptr;
+
+	const uint64 fileSize = ( (uint64)data.nFileSizeHigh << 32 ) | data.nFileSizeLow;
+	auto it = s_ArchiveCache.find( archive );
+
+	if( it != s_ArchiveCache.end() && !members && it->second.fileSize == fileSize && !CompareFileTime( &it->second.lastWriteTime, &data.ftLastWriteTime ) )
+		return &it->second;
+
+	std::ifstream file;
+	std::vector< ArchiveMember_t > list;
+
+	if( !ReadArchiveMembers( archive, file, list ) )
+	{
+		if( it != s_ArchiveCache.end() )
+			s_ArchiveCache.erase( it );
+
+		return nullptr;
+	}
+
+	ArchiveListing_t &listing = s_ArchiveCache[ archive ];
+
+	listing.fileSize = fileSize;
+	listing.lastWriteTime = data.ftLastWriteTime;
+	listing.members.clear();
+	listing.members.reserve( list.size() );
+
+	// The first of several members with the same name wins
+	for( size_t i = 0; i < list.size(); ++i )
+		listing.members.emplace( list[ i ].name, list[ i ] );
+
+	if( members )
+		members->swap( list );
+
+	return &listing;
+}
+
+// =====================================================================================================================================================================
+
+bool IsArchiveFile( const std::string &filename )
+{
+	return FileHasExtension( filename, "zip" ) || FileHasExtension( filename, "tar" );
+}
+
+// =====================================================================================================================================================================
+
+bool FindDemosInArchive( const std::string &archive, std::vector< std::string > &demos )
+{
+	std::vector< ArchiveMember_t > members;
+
+	{
+		std::lock_guard< std::mutex > lock( s_ArchiveCacheMutex );
+
+		// Always read the archive here, the cached table is only for opening the members listed
+		if( !GetArchiveListing( archive, &members ) )
+			return false;
+	}
+
+	for( size_t i = 0; i < members.size(); ++i )
+	{
+		if( IsDemoFile( members[ i ].name ) )
+			demos.emplace_back( archive + ARCHIVE_MEMBER_SEPARATOR + members[ i ].name );
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool SplitArchiveMemberPath( const std::string &path, std::string &archive, std::string &member )
+{
+	const size_t separator = path.find( ARCHIVE_MEMBER_SEPARATOR );
+
+	if( separator == std::string::npos )
+		return false;
+
+	archive = path.substr( 0, separator );
+	member = path.substr( separator + 1 );
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool FindArchiveMember( const std::string &archive, const std::string &member, ArchiveMember_t &info )
+{
+	{
+		std::lock_guard< std::mutex > lock( s_ArchiveCacheMutex );
+		const ArchiveListing_t *pListing = GetArchiveListing( archive, nullptr );
+
+		if( !pListing )
+			return false;
+
+		auto it = pListing->members.find( member );
+
+		if( it == pListing->members.end() )
+			return false;
+
+		info = it->second;
+	}
+
+	if( !FileHasExtension( archive, "zip" ) )
+		return true;
+
+	// The local header can have a different extra field than the central directory entry
+	std::ifstream file( archive, std::ios::binary );
+	byte header[ ZIP_LOCAL_SIZE ];
+
+	file.seekg( info.offset, std::ios_base::beg );
+
+	if( !file.read( (char *)header, sizeof( header ) ) || ReadLE32( header ) != ZIP_LOCAL_SIGNATURE )
+		return false;
+
+	info.offset += ZIP_LOCAL_SIZE + ReadLE16( header + 26 ) + ReadLE16( header + 28 );
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Common.h"
+#include <string>
+#include <vector>
+
+#define ARCHIVE_MEMBER_SEPARATOR	'|'		// Separates the archive and the member name in demo paths ("pack.zip|demo.dem"), never part of a Windows path
+
+enum ArchiveCompression
+{
+	ARCHIVE_STORED = 0,
+	ARCHIVE_DEFLATED,
+	ARCHIVE_UNSUPPORTED,					///< Other zip compression methods and encrypted members
+};
+
+/**
+ * A file inside a zip or tar archive
+ */
+struct ArchiveMember_t
+{
+	std::string			name;				///< Path inside the archive ('/' separated)
+	uint64				offset;				///< Offset of the member data in the archive file
+	uint64				compressedSize;		///< Size of the member data in the archive file
+	uint64				size;				///< Size of the member when decompressed
+	ArchiveCompression	compression;
+};
+
+/**
+ * Read-only view of a range of a file mapped into memory
+ * Pages are copy-on-write, so the view can be handed out as a modifiable buffer without touching the file.
+ */
+class MappedFileView
+{
+public:
+	MappedFileView( void );
+	~MappedFileView( void );
+
+	bool				Map( const std::string &filename, uint64 offset, size_t size );
+	byte *				GetData( void ) const;		///< Start of the mapped range
+
+private:
+	MappedFileView( const MappedFileView & );
+	MappedFileView &operator=( const MappedFileView & );
+
+	void *				m_hFile;
+	void *				m_hMapping;
+	byte *				m_pView;
+	size_t				m_offsetInView;				///< Views start at the allocation granularity, the range starts this far into it
+};
+
+bool IsArchiveFile( const std::string &filename );									///< .zip or .tar
+bool FindDemosInArchive( const std::string &archive, std::vector< std::string > &demos );	///< Appends the archive member paths of the demos in the archive
+bool SplitArchiveMemberPath( const std::string &path, std::string &archive, std::string &member );
+bool FindArchiveMember( const std::string &archive, const std::string &member, ArchiveMember_t &info );
\ No newline at end of file
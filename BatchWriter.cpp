@@ -0,0 +1,176 @@
+#include "BatchWriter.h"
+#include <stdio.h>
+
+BatchWriter::BatchWriter( void )
+{
+	m_iQueuedBytes = 0;
+	m_bStopRequested = false;
+}
+
+// =====================================================================================================================================================================
+
+BatchWriter::~BatchWriter()
+{
+	Stop();
+}
+
+// =====================================================================================================================================================================
+
+void BatchWriter::Start( const std::vector< std::string > &filenames )
+{
+	if( m_thread.joinable() )
+		return;
+
+	m_Profiles = std::vector< ProfileOutput_t >( filenames.size() );
+
+	for( size_t i = 0; i < filenames.size(); ++i )
+	{
+		ProfileOutput_t &output = m_Profiles[ i ];
+
+		output.filename = filenames[ i ];
+		output.file.open( output.filename );
+		output.bFileOpen = output.file.is_open();
+
+		// The frags are kept in memory instead and written to the final output at the end
+		if( !output.bFileOpen )
+		{
+			printf( "Failed to open file %s for batch output, frags will be written at the end\n", output.filename.c_str() );
+			output.filename.clear();
+		}
+	}
+
+	m_iQueuedBytes = 0;
+	m_bStopRequested = false;
+
+	m_thread = std::thread( &BatchWriter::WriterThread, this );
+}
+
+// =====================================================================================================================================================================
+
+void BatchWriter::Stop( void )
+{
+	if( !m_thread.joinable() )
+		return;
+
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		m_bStopRequested = true;
+	}
+
+	m_cvQueued.notify_one();
+	m_thread.join();
+
+	for( size_t i = 0; i < m_Profiles.size(); ++i )
+	{
+		if( m_Profiles[ i ].bFileOpen )
+			m_Profiles[ i ].file.close();
+	}
+}
+
+// =====================================================================================================================================================================
+
+void BatchWriter::Write( int profile, const std::string &text )
+{
+	std::unique_lock< std::mutex > lock( m_mutex );
+
+	// Let the writer thread catch up, so that the queue doesn't grow without limit
+	m_cvWritten.wait( lock, [this]{ return m_bStopRequested || m_iQueuedBytes < BATCH_MAX_QUEUED_SIZE; } );
+
+	ProfileOutput_t &output = m_Profiles[ profile ];
+
+	output.queue += text;
+	output.bytesWritten += text.length();
+
+	if( output.bFileOpen )
+		m_iQueuedBytes += text.length();
+
+	if( m_iQueuedBytes >= BATCH_WRITE_CHUNK_SIZE )
+	{
+		lock.unlock();
+		m_cvQueued.notify_one();
+	}
+}
+
+// =====================================================================================================================================================================
+
+bool BatchWriter::HasOutput( int profile ) const
+{
+	std::lock_guard< std::mutex > lock( m_mutex );
+
+	return m_Profiles[ profile ].bytesWritten > 0;
+}
+
+// =====================================================================================================================================================================
+
+bool BatchWriter::CopyOutput( int profile, std::ofstream &file )
+{
+	ProfileOutput_t &output = m_Profiles[ profile ];
+
+	if( !output.filename.empty() )
+	{
+		std::ifstream partialFile( output.filename );
+
+		if( !partialFile.is_open() )
+			return false;
+
+		if( output.bytesWritten > 0 )
+			file << partialFile.rdbuf();
+
+		partialFile.close();
+
+		remove( output.filename.c_str() );
+		output.filename.clear();
+	}
+
+	// Text that couldn't be written to the partial file
+	file.write( output.queue.c_str(), output.queue.length() );
+	output.queue.clear();
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+void BatchWriter::WriterThread( void )
+{
+	std::vector< std::string > chunks( m_Profiles.size() );
+
+	std::unique_lock< std::mutex > lock( m_mutex );
+
+	for( ;; )
+	{
+		m_cvQueued.wait_for( lock, std::chrono::milliseconds( BATCH_WRITE_INTERVAL_MS ), [this]{ return m_bStopRequested || m_iQueuedBytes >= BATCH_WRITE_CHUNK_SIZE; } );
+
+		const bool bStop = m_bStopRequested;
+
+		// Take the queued text and write it without holding the lock
+		for( size_t i = 0; i < m_Profiles.size(); ++i )
+		{
+			if( m_Profiles[ i ].bFileOpen )
+				chunks[ i ].swap( m_Profiles[ i ].queue );
+		}
+
+		m_iQueuedBytes = 0;
+
+		lock.unlock();
+		m_cvWritten.notify_all();
+
+		for( size_t i = 0; i < m_Profiles.size(); ++i )
+		{
+			if( chunks[ i ].empty() )
+				continue;
+
+			m_Profiles[ i ].file.write( chunks[ i ].c_str(), chunks[ i ].length() );
+			m_Profiles[ i ].file.flush();
+
+			chunks[ i ].clear();
+		}
+
+		if( bStop )
+			return;
+
+		lock.lock();
+	}
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Common.h"
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BATCH_WRITE_INTERVAL_MS		1000			// How often queued output is written and flushed at the latest
+#define BATCH_WRITE_CHUNK_SIZE		(64 * 1024)		// Queued bytes that wake up the writer thread before the interval
+#define BATCH_MAX_QUEUED_SIZE		(1024 * 1024)	// Writing frags blocks if the writer thread falls this much behind
+
+/**
+ * Streams the batch output of every settings profile to a partial output file on a separate thread
+ *
+ * The parser only appends the frag text to a queue, so the memory used stays flat no matter how big the batch is.
+ * The writer thread writes the queue in large chunks and flushes it, so the frags found so far are on disk even if
+ * the program crashes. The final batch output file is made from the partial file once the batch is done.
+ */
+class BatchWriter
+{
+public:
+	BatchWriter( void );
+	~BatchWriter();
+
+	void Start( const std::vector< std::string > &filenames );	///< Opens a partial output file per profile and starts the writer thread
+	void Stop( void );											///< Writes everything that is still queued and stops the writer thread
+
+	void Write( int profile, const std::string &text );			///< Queues text to the output of the profile
+	bool HasOutput( int profile ) const;						///< Whether anything was written for the profile
+	bool CopyOutput( int profile, std::ofstream &file );		///< Appends the output of the profile to the file and removes the partial file (after Stop)
+
+private:
+	BatchWriter( const BatchWriter & );
+	BatchWriter &operator=( const BatchWriter & );
+
+	struct ProfileOutput_t
+	{
+		ProfileOutput_t( void ) : bFileOpen( false ), bytesWritten( 0 ) {}
+
+		std::string		filename;
+		std::ofstream	file;				///< Only used by the writer thread while it runs
+		bool			bFileOpen;			///< Whether the file opened, set before the writer thread starts
+		std::string		queue;				///< Text that hasn't been written yet (kept here if the file couldn't be opened)
+		int64			bytesWritten;		///< All the text written to this profile
+	};
+
+	void WriterThread( void );
+
+	std::thread						m_thread;
+	mutable std::mutex				m_mutex;
+	std::condition_variable			m_cvQueued;		///< Signaled when the queue has grown past a chunk or the writer is stopped
+	std::condition_variable			m_cvWritten;	///< Signaled when the writer thread has taken the queue
+	std::vector< ProfileOutput_t >	m_Profiles;
+	size_t							m_iQueuedBytes;
+	bool							m_bStopRequested;
+};
\ No newline at end of file
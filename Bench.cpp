@@ -0,0 +1,468 @@
+#include "Bench.h"
+#include "DemoFile.h"
+#include "DemoParser.h"
+#include "Errors.h"
+#include "FragOutput.h"
+#include "Settings.h"
+#include <Windows.h>
+#include <Psapi.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <format>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#pragma comment( lib, "Psapi.lib" )
+
+// Benchmark mode
+//
+// Each demo is loaded into memory once and then parsed the given number of times, so only parsing is timed, and the
+// median run is reported. The demo is parsed the same way as normally (in segments or pipelined if enabled), but the
+// frags are formatted like the daemon responses instead of being printed. A thread samples the working set while the
+// demo is parsed to get its peak. When segments are enabled, the first run writes the seek index of a demo that doesn't
+// have one yet, so the later runs are split.
+//
+// The golden file has the frags of every demo and the median parse time it was recorded with:
+//   DEMO <demo> <median parse time in ms>
+//   FRAG <profile> <tick> <player> <team> <spectated 0/1> <description>
+//   OK <# of frags>  or  ERROR <tick> <message>
+
+// These match the StatsPhase enum
+static const char *s_szPhaseColumns[ NUM_STATS_PHASES ] = {
+	"signon_ms",
+	"datatables_ms",
+	"packet_entities_ms",
+	"game_events_ms",
+	"string_tables_ms",
+	"post_check_ms",
+	"frag_finding_ms" };
+
+// =====================================================================================================================================================================
+/**
+ * Parses the demo without any console or file output, the frags are handed to the sink as they are found
+ */
+void DemoParser::ParseBenchmark( DemoFile *pDemo, FragSink *pSink, BenchRunResult_t &result )
+{
+	// Sub-parsers don't print anything or touch the progress bar
+	DemoParser parser( pDemo );
+	parser.m_bSubParser = true;
+	parser.m_pFragSink = pSink;
+	parser.m_iParseStartTime = StatsTimestamp();
+
+	bf_read reader( pDemo->GetBuffer(), pDemo->GetFileSize() );
+	reader.ReadBytes( &parser.m_demoHeader, sizeof( parser.m_demoHeader ) );
+
+	try
+	{
+		if( Settings()->ParseSegmentsInParallel() )
+			parser.ParseSegments( reader );
+		else if( Settings()->ParsePipelined() )
+			parser.ParsePipelined( reader );
+		else
+			parser.ParseCommands( reader );
+
+		parser.OnParsingEnd();
+	}
+	catch( ParsingError_t error ) // OnParsingEnd was already called by the error
+	{
+		// Errors at the end of a demo are ignored, since they often happen on map change etc.
+		if( !error.at_end_of_demo )
+		{
+			result.bFailed = true;
+			result.error_msg = error.error_msg;
+			result.error_tick = error.tick;
+		}
+	}
+	catch( ... )
+	{
+		result.bFailed = true;
+		result.error_msg = "unexpected error";
+		result.error_tick = parser.m_iCurrentTick;
+	}
+
+	result.ticks = ( parser.m_demoHeader.playback_ticks > 0 )? parser.m_demoHeader.playback_ticks : parser.m_iCurrentTick;
+	result.stats = parser.m_Stats;
+	result.stats.total_ns = StatsTimestamp() - parser.m_iParseStartTime;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Tracks the peak working set of the process while a demo is being parsed
+ * The process peak can't be reset, so the working set is sampled on a separate thread instead.
+ */
+class BenchMemorySampler
+{
+public:
+	BenchMemorySampler( void ) : m_bStopRequested( false ), m_iPeak( 0 )
+	{
+		m_thread = std::thread( &BenchMemorySampler::SamplerThread, this );
+	}
+
+	~BenchMemorySampler()
+	{
+		{
+			std::lock_guard< std::mutex > lock( m_mutex );
+			m_bStopRequested = true;
+		}
+
+		m_cvStop.notify_one();
+		m_thread.join();
+	}
+
+	void Reset( void )
+	{
+		m_iPeak.store( GetWorkingSet(), std::memory_order_relaxed );
+	}
+
+	int64 GetPeak( void )
+	{
+		Sample();
+
+		return m_iPeak.load( std::memory_order_relaxed );
+	}
+
+	static int64 GetWorkingSet( void )
+	{
+		PROCESS_MEMORY_COUNTERS counters;
+
+		if( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+			return 0;
+
+		return (int64)counters.WorkingSetSize;
+	}
+
+	static int64 GetProcessPeak( void )
+	{
+		PROCESS_MEMORY_COUNTERS counters;
+
+		if( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+			return 0;
+
+		return (int64)counters.PeakWorkingSetSize;
+	}
+
+private:
+	void Sample( void )
+	{
+		const int64 current = GetWorkingSet();
+		int64 peak = m_iPeak.load( std::memory_order_relaxed );
+
+		while( current > peak && !m_iPeak.compare_exchange_weak( peak, current, std::memory_order_relaxed ) )
+			;
+	}
+
+	void SamplerThread( void )
+	{
+		std::unique_lock< std::mutex > lock( m_mutex );
+
+		while( !m_cvStop.wait_for( lock, std::chrono::milliseconds( BENCH_RSS_SAMPLE_MS ), [this]{ return m_bStopRequested; } ) )
+			Sample();
+	}
+
+	std::thread					m_thread;
+	std::mutex					m_mutex;
+	std::condition_variable		m_cvStop;
+	bool						m_bStopRequested;
+	std::atomic< int64 >		m_iPeak;				///< Largest working set since the last Reset()
+};
+
+// =====================================================================================================================================================================
+
+struct GoldenDemo_t
+{
+	double				parseMs;				///< Median parse time when the golden file was recorded
+	std::string			output;
+};
+
+typedef std::map< std::string, GoldenDemo_t > GoldenMap;
+
+/**
+ * @return						false if the file doesn't exist
+ */
+static bool LoadGoldenFile( const std::string &filename, GoldenMap &golden )
+{
+	std::ifstream file( filename );
+
+	if( !file.is_open() )
+		return false;
+
+	GoldenDemo_t *pDemo = nullptr;
+	std::string line;
+
+	while( std::getline( file, line ) )
+	{
+		if( !line.compare( 0, sizeof( BENCH_GOLDEN_DEMO ), BENCH_GOLDEN_DEMO "\t" ) )
+		{
+			// The demo name can't contain tabs, but the time is always last
+			const size_t end = line.find_last_of( '\t' );
+
+			if( end < sizeof( BENCH_GOLDEN_DEMO ) )
+			{
+				pDemo = nullptr;
+				continue;
+			}
+
+			pDemo = &golden[ line.substr( sizeof( BENCH_GOLDEN_DEMO ), end - sizeof( BENCH_GOLDEN_DEMO ) ) ];
+			pDemo->parseMs = atof( line.c_str() + end + 1 );
+		}
+		else if( pDemo && !line.empty() )
+		{
+			pDemo->output += line;
+			pDemo->output += '\n';
+		}
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Gets the first line that differs between two outputs, for telling what changed
+ */
+static void GetFirstDifference( const std::string &expected, const std::string &actual, std::string &expectedLine, std::string &actualLine )
+{
+	size_t start = 0;
+
+	while( true )
+	{
+		size_t expectedEnd = expected.find( '\n', start );
+		size_t actualEnd = actual.find( '\n', start );
+
+		expectedLine = ( start < expected.length() )? expected.substr( start, expectedEnd - start ) : "(end of output)";
+		actualLine = ( start < actual.length() )? actual.substr( start, actualEnd - start ) : "(end of output)";
+
+		if( expectedLine != actualLine || expectedEnd == std::string::npos || actualEnd == std::string::npos )
+			return;
+
+		start = expectedEnd + 1;
+	}
+}
+
+// =====================================================================================================================================================================
+
+bool RunBenchmark( const std::vector< std::string > &demos, const std::string &baseDirectory, int numRuns, const std::string &goldenFile, const std::string &reportFile )
+{
+	std::ofstream report( reportFile );
+
+	if( !report.is_open() )
+	{
+		printf( "%s: Failed to open the report file %s\n", CSSFF_NAME, reportFile.c_str() );
+		return false;
+	}
+
+	GoldenMap golden;
+	const bool bCompare = !goldenFile.empty() && LoadGoldenFile( goldenFile, golden );
+
+	std::string newGolden;		// Written if there was no golden file yet
+
+	printf( "%s: Benchmarking %d demos, %d runs each...\n", CSSFF_NAME, (int)demos.size(), numRuns );
+
+	if( bCompare )
+		printf( "Comparing the frags to %s\n", goldenFile.c_str() );
+
+	printf( "\n" );
+
+	report << "demo\tstatus\tsize_mb\tticks\tload_ms\tparse_ms\tbest_ms\tmb_per_s\tticks_per_s\tpeak_rss_mb\tfrags\tgolden_ms\tspeedup";
+#ifdef CSSFF_ENABLE_STATS
+	for( int i = 0; i < NUM_STATS_PHASES; ++i )
+		report << '\t' << s_szPhaseColumns[ i ];
+#endif
+	report << '\n';
+
+	BenchMemorySampler memory;
+
+	int numSame = 0, numChanged = 0, numNew = 0, numUnstable = 0, numInvalid = 0;
+	int64 totalBytes = 0, totalTicks = 0, totalParseNs = 0;
+	double goldenMs = 0.0, comparedMs = 0.0;	// Parse times of the demos that are in the golden file
+
+	for( size_t nDemo = 0; nDemo < demos.size(); ++nDemo )
+	{
+		const std::string &path = demos[ nDemo ];
+		std::string name = path;
+
+		if( !name.compare( 0, baseDirectory.length(), baseDirectory ) )
+			name.erase( 0, baseDirectory.length() );
+
+		printf( "Demo %d/%d: %s ", (int)nDemo + 1, (int)demos.size(), name.c_str() );
+
+		const int64 loadStart = StatsTimestamp();
+		DemoFile demo( path );
+		const int64 loadNs = StatsTimestamp() - loadStart;
+
+		if( !demo.IsValidDemo() )
+		{
+			printf( "(%s)\n", demo.GetErrorString().c_str() );
+			report << name << '\t' << demo.GetErrorString() << '\n';
+			++numInvalid;
+			continue;
+		}
+
+		std::vector< int64 > runNs;
+		std::string firstOutput;
+		BenchRunResult_t result;
+		ParsingStats_t stats;
+		bool bUnstable = false;
+		int numFrags = 0;
+
+		memory.Reset();
+
+		for( int run = 0; run < numRuns; ++run )
+		{
+			FragLines frags( -1 );
+			result = BenchRunResult_t();
+
+			const int64 parseStart = StatsTimestamp();
+			DemoParser::ParseBenchmark( &demo, &frags, result );
+			runNs.push_back( StatsTimestamp() - parseStart );
+
+			stats.Accumulate( result.stats );
+
+			if( result.bFailed )
+				std::format_to( std::back_inserter( frags.m_strText ), "ERROR\t{}\t{}\n", result.error_tick, result.error_msg );
+			else
+				std::format_to( std::back_inserter( frags.m_strText ), "OK\t{}\n", frags.m_iNumFrags );
+
+			if( run == 0 )
+			{
+				firstOutput = std::move( frags.m_strText );
+				numFrags = frags.m_iNumFrags;
+			}
+			else if( frags.m_strText != firstOutput )
+			{
+				bUnstable = true;
+			}
+		}
+
+		const int64 peakRSS = memory.GetPeak();
+
+		std::vector< int64 > sortedNs = runNs;
+		std::sort( sortedNs.begin(), sortedNs.end() );
+
+		const int64 medianNs = sortedNs[ ( sortedNs.size() - 1 ) / 2 ];
+		const double seconds = medianNs / 1e9;
+		const double megabytes = demo.GetFileSize() / (1024.0 * 1024.0);
+		const double mbPerSec = ( seconds > 0 )? megabytes / seconds : 0.0;
+		const double ticksPerSec = ( seconds > 0 )? result.ticks / seconds : 0.0;
+
+		totalBytes += demo.GetFileSize();
+		totalTicks += result.ticks;
+		totalParseNs += medianNs;
+
+		// Compare the frags to the golden file
+		const char *szStatus = "ok";
+		std::string goldenColumns = "\t";
+		auto it = golden.find( name );
+
+		if( bUnstable )
+		{
+			szStatus = "unstable";
+			++numUnstable;
+		}
+		else if( bCompare && it == golden.end() )
+		{
+			szStatus = "new";
+			++numNew;
+		}
+		else if( bCompare && it->second.output != firstOutput )
+		{
+			szStatus = "changed";
+			++numChanged;
+		}
+		else if( bCompare )
+		{
+			szStatus = "same";
+			++numSame;
+		}
+
+		if( bCompare && it != golden.end() )
+		{
+			goldenMs += it->second.parseMs;
+			comparedMs += medianNs / 1e6;
+			goldenColumns = std::format( "{:.1f}\t{:.2f}", it->second.parseMs, ( medianNs > 0 )? it->second.parseMs / ( medianNs / 1e6 ) : 0.0 );
+		}
+
+		printf( "[%.1f MB/s, %.0f ticks/s, peak %.0f MB, %d frags] %s\n", mbPerSec, ticksPerSec, peakRSS / (1024.0 * 1024.0), numFrags, szStatus );
+
+		if( bUnstable )
+			printf( "\tThe frags were not the same in every run\n" );
+
+		if( !strcmp( szStatus, "changed" ) )
+		{
+			std::string expectedLine, actualLine;
+			GetFirstDifference( it->second.output, firstOutput, expectedLine, actualLine );
+
+			printf( "\tExpected: %s\n\tFound:    %s\n", expectedLine.c_str(), actualLine.c_str() );
+		}
+
+		report << std::format( "{}\t{}\t{:.2f}\t{}\t{:.1f}\t{:.1f}\t{:.1f}\t{:.1f}\t{:.0f}\t{:.1f}\t{}\t{}", name, szStatus, megabytes, result.ticks, loadNs / 1e6,
+			medianNs / 1e6, sortedNs[ 0 ] / 1e6, mbPerSec, ticksPerSec, peakRSS / (1024.0 * 1024.0), numFrags, goldenColumns );
+#ifdef CSSFF_ENABLE_STATS
+		for( int i = 0; i < NUM_STATS_PHASES; ++i )
+			report << std::format( "\t{:.1f}", stats.phase_ns[ i ] / 1e6 / numRuns );
+#endif
+		report << '\n';
+
+		if( !bCompare )
+		{
+			std::format_to( std::back_inserter( newGolden ), BENCH_GOLDEN_DEMO "\t{}\t{:.1f}\n", name, medianNs / 1e6 );
+			newGolden += firstOutput;
+		}
+
+		if( bCompare && it != golden.end() )
+			golden.erase( it );
+	}
+
+	// Summary
+	const double totalSeconds = totalParseNs / 1e9;
+	const int numParsed = (int)demos.size() - numInvalid;
+
+	std::string summary = std::format( "{} demos, {:.1f} MB parsed in {:.2f} s (median runs): {:.1f} MB/s, {:.0f} ticks/s, {:.2f} demos/s, peak working set {:.0f} MB",
+		numParsed, totalBytes / (1024.0 * 1024.0), totalSeconds,
+		( totalSeconds > 0 )? totalBytes / (1024.0 * 1024.0) / totalSeconds : 0.0,
+		( totalSeconds > 0 )? totalTicks / totalSeconds : 0.0,
+		( totalSeconds > 0 )? numParsed / totalSeconds : 0.0,
+		BenchMemorySampler::GetProcessPeak() / (1024.0 * 1024.0) );
+
+	if( bCompare )
+	{
+		summary += std::format( "\nGolden: {} same, {} changed, {} new, {} missing from the demos", numSame, numChanged, numNew, (int)golden.size() );
+
+		if( comparedMs > 0 )
+			summary += std::format( ", speedup {:.2f}x", goldenMs / comparedMs );
+	}
+
+	if( numUnstable )
+		summary += std::format( "\n{} demos had different frags between runs", numUnstable );
+
+	printf( "\n%s\n", summary.c_str() );
+
+	report << '\n' << summary << '\n';
+	report.close();
+
+	bool bResult = report.good();
+
+	if( bResult )
+		printf( "Report has been written to file %s\n", reportFile.c_str() );
+	else
+		printf( "Failed to write the report to file\n" );
+
+	if( !goldenFile.empty() && !bCompare )
+	{
+		std::ofstream file( goldenFile );
+		file << newGolden;
+
+		if( file.good() )
+			printf( "Golden file %s has been written\n", goldenFile.c_str() );
+		else
+			printf( "Failed to write the golden file %s\n", goldenFile.c_str() );
+
+		bResult = bResult && file.good();
+	}
+
+	printf( "\n" );
+
+	return bResult && !numChanged && !numUnstable && !numInvalid;
+}
\ No newline at end of file
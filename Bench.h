@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Common.h"
+#include "Stats.h"
+#include <string>
+#include <vector>
+
+#define BENCH_DEFAULT_RUNS		3		// How many times each demo is parsed by default
+#define BENCH_RSS_SAMPLE_MS		5		// How often the working set is sampled while a demo is being parsed
+#define BENCH_GOLDEN_DEMO		"DEMO"	// Starts the frags of a demo in the golden file
+
+/**
+ * Result of parsing a demo once in the benchmark mode
+ */
+struct BenchRunResult_t
+{
+	BenchRunResult_t( void ) : bFailed( false ), error_msg( nullptr ), error_tick( 0 ), ticks( 0 ) {}
+
+	bool				bFailed;				///< A parsing error was thrown before the end of the demo
+	const char *		error_msg;
+	int					error_tick;
+	int					ticks;					///< Ticks in the demo (from the header, or parsed if the header doesn't tell)
+	ParsingStats_t		stats;					///< Only collected with CSSFF_ENABLE_STATS
+};
+
+/**
+ * Benchmark mode - parses every demo several times with the current settings and writes a report
+ *
+ * The report has the load time, the median parse time, MB/s, ticks/s, peak working set and frag count of each demo,
+ * and the time of each parsing phase in CSSFF_ENABLE_STATS builds. The frags of every run must be the same as in the
+ * first run. If the golden file exists, the frags are compared to it and the parse times are compared to the ones it
+ * was recorded with, otherwise it is written from this benchmark.
+ * @param baseDirectory			demos are named relative to this directory in the golden file (with '\' in the end)
+ * @param goldenFile			empty to not use a golden file
+ * @return						false if the frags of a demo changed or differed between runs, a demo couldn't be loaded,
+ *								or the report couldn't be written
+ */
+bool RunBenchmark( const std::vector< std::string > &demos, const std::string &baseDirectory, int numRuns, const std::string &goldenFile, const std::string &reportFile );
\ No newline at end of file
@@ -0,0 +1,608 @@
+#include "Bzip2.h"
+#include <string.h>
+
+// Bzip2 decompression
+//
+// A block is decoded in the reverse order of its compression: the Huffman coded symbols give the move-to-front indices
+// with the zero runs coded separately, then the Burrows-Wheeler transform is undone by following the links from the
+// sorted order, and the runs of four or more equal bytes are expanded while the block is written to the output. The
+// block and stream CRCs aren't checked, the demo parser rejects corrupt demos anyway.
+//
+// Files made by pbzip2 or concatenated with cat have several streams, they are decompressed one after the other into
+// the same buffer.
+
+#define BZIP2_BLOCK_MAGIC_HI		0x314159		// Block header, the BCD digits of pi
+#define BZIP2_BLOCK_MAGIC_LO		0x265359
+#define BZIP2_END_MAGIC_HI			0x177245		// End of stream, the BCD digits of the square root of pi
+#define BZIP2_END_MAGIC_LO			0x385090
+#define BZIP2_BLOCK_SIZE_UNIT		100000			// The stream header gives the maximum block size in these
+
+#define BZIP2_FAST_BITS				10
+#define BZIP2_MAX_CODE_LENGTH		20
+#define BZIP2_MAX_ALPHA_SIZE		258				// RUNA, RUNB, the 255 other move-to-front indices and the end of block
+#define BZIP2_MIN_GROUPS			2
+#define BZIP2_MAX_GROUPS			6
+#define BZIP2_GROUP_SIZE			50				// # of symbols coded with the same table
+#define BZIP2_MAX_SELECTORS			18002			// Encoders may write more, the extra selectors are never used
+
+#define BZIP2_RUNA					0
+#define BZIP2_RUNB					1
+
+// =====================================================================================================================================================================
+
+struct Bzip2HuffmanTable_t
+{
+	unsigned short	fast[ 1 << BZIP2_FAST_BITS ];			///< (symbol << 5) | code length for the short codes, 0 for the longer codes
+	short			count[ BZIP2_MAX_CODE_LENGTH + 1 ];		///< # of codes of each length
+	short			symbol[ BZIP2_MAX_ALPHA_SIZE ];			///< Symbols in canonical code order
+};
+
+// =====================================================================================================================================================================
+/**
+ * Builds the decoding table from the code lengths of the symbols
+ * @return						false if the lengths don't make a valid code
+ */
+static bool BuildHuffmanTable( Bzip2HuffmanTable_t &table, const byte *lengths, int numSymbols )
+{
+	memset( table.count, 0, sizeof( table.count ) );
+
+	for( int i = 0; i < numSymbols; ++i )
+		++table.count[ lengths[ i ] ];
+
+	int left = 1;
+
+	for( int len = 1; len <= BZIP2_MAX_CODE_LENGTH; ++len )
+	{
+		left <<= 1;
+		left -= table.count[ len ];
+
+		if( left < 0 )
+			return false;
+	}
+
+	short offsets[ BZIP2_MAX_CODE_LENGTH + 1 ];
+	offsets[ 1 ] = 0;
+
+	for( int len = 1; len < BZIP2_MAX_CODE_LENGTH; ++len )
+		offsets[ len + 1 ] = offsets[ len ] + table.count[ len ];
+
+	for( int i = 0; i < numSymbols; ++i )
+		table.symbol[ offsets[ lengths[ i ] ]++ ] = (short)i;
+
+	// Short codes go to the lookup table, the bits are read starting from the highest bit
+	memset( table.fast, 0, sizeof( table.fast ) );
+
+	int code = 0;
+	int index = 0;
+
+	for( int len = 1; len <= BZIP2_FAST_BITS; ++len )
+	{
+		for( int i = 0; i < table.count[ len ]; ++i, ++code, ++index )
+		{
+			const int first = code << ( BZIP2_FAST_BITS - len );
+
+			for( int j = 0; j < ( 1 << ( BZIP2_FAST_BITS - len ) ); ++j )
+				table.fast[ first + j ] = (unsigned short)( ( table.symbol[ index ] << 5 ) | len );
+		}
+
+		code <<= 1;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Decompresses the streams of a bzip2 file
+ */
+class Bzip2Decoder
+{
+public:
+	Bzip2Decoder( const byte *pIn, size_t inSize, DecompressBuffer &out );
+	~Bzip2Decoder( void );
+
+	DecompressResult Decompress( void );
+	size_t GetOutputPos( void ) const { return m_outPos; }
+
+private:
+	void Refill( void );
+	bool ReadBits( int numBits, uint32 &value );
+	bool DecodeSymbol( const Bzip2HuffmanTable_t &table, int &symbol );
+
+	bool Stream( void );
+	bool Block( void );
+	bool Output( uint32 origPtr, uint32 count );		///< Undoes the Burrows-Wheeler transform and the initial run-length coding
+
+	size_t MakeRoom( size_t size );						///< Grows the output buffer if it can, returns how many of the bytes fit
+	bool Fail( DecompressResult result ) { m_result = result; return false; }
+
+	const byte *		m_pIn;
+	size_t				m_inSize;
+	size_t				m_inPos;
+	uint64				m_bitBuf;						///< Bits that have been read from the input but not consumed yet, highest bit first
+	int					m_bitCount;
+
+	DecompressBuffer &	m_Out;
+	byte *				m_pOut;							///< Output buffer, cached since it only changes when the buffer grows
+	size_t				m_outSize;
+	size_t				m_outPos;
+
+	DecompressResult	m_result;						///< Why decoding stopped early
+
+	uint32 *			m_pBlock;						///< Bytes of the block, and the links of the inverse transform above them
+	uint32				m_blockCapacity;
+	uint32				m_maxBlockSize;					///< Maximum block size of the current stream
+
+	Bzip2HuffmanTable_t	m_Tables[ BZIP2_MAX_GROUPS ];
+	byte				m_Selectors[ BZIP2_MAX_SELECTORS ];
+};
+
+// =====================================================================================================================================================================
+
+Bzip2Decoder::Bzip2Decoder( const byte *pIn, size_t inSize, DecompressBuffer &out ) : m_Out( out )
+{
+	m_pIn = pIn;
+	m_inSize = inSize;
+	m_inPos = 0;
+	m_bitBuf = 0;
+	m_bitCount = 0;
+
+	m_pOut = out.GetData();
+	m_outSize = out.GetSize();
+	m_outPos = 0;
+
+	m_result = DECOMPRESS_CORRUPT;
+
+	m_pBlock = nullptr;
+	m_blockCapacity = 0;
+	m_maxBlockSize = 0;
+}
+
+// =====================================================================================================================================================================
+
+Bzip2Decoder::~Bzip2Decoder( void )
+{
+	delete[] m_pBlock;
+}
+
+// =====================================================================================================================================================================
+
+inline void Bzip2Decoder::Refill( void )
+{
+	while( m_bitCount <= 56 && m_inPos < m_inSize )
+	{
+		m_bitBuf = ( m_bitBuf << 8 ) | m_pIn[ m_inPos++ ];
+		m_bitCount += 8;
+	}
+}
+
+// =====================================================================================================================================================================
+
+inline bool Bzip2Decoder::ReadBits( int numBits, uint32 &value )
+{
+	if( m_bitCount < numBits )
+	{
+		Refill();
+
+		if( m_bitCount < numBits )
+			return Fail( DECOMPRESS_INPUT_ENDED );
+	}
+
+	m_bitCount -= numBits;
+	value = (uint32)( ( m_bitBuf >> m_bitCount ) & ( ( 1ull << numBits ) - 1 ) );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+inline bool Bzip2Decoder::DecodeSymbol( const Bzip2HuffmanTable_t &table, int &symbol )
+{
+	if( m_bitCount < BZIP2_MAX_CODE_LENGTH )
+		Refill();
+
+	// The missing bits at the end of the input are zeros for the lookup
+	const uint32 next = ( m_bitCount >= BZIP2_FAST_BITS )? (uint32)( m_bitBuf >> ( m_bitCount - BZIP2_FAST_BITS ) ) : (uint32)( m_bitBuf << ( BZIP2_FAST_BITS - m_bitCount ) );
+	const unsigned short entry = table.fast[ next & ( ( 1 << BZIP2_FAST_BITS ) - 1 ) ];
+
+	if( entry && ( entry & 31 ) <= m_bitCount )
+	{
+		m_bitCount -= entry & 31;
+		symbol = entry >> 5;
+		return true;
+	}
+
+	// Long code (or the end of the input), decode it one bit at a time
+	int code = 0;
+	int first = 0;
+	int index = 0;
+
+	for( int len = 1; len <= BZIP2_MAX_CODE_LENGTH; ++len )
+	{
+		if( !m_bitCount )
+			return Fail( DECOMPRESS_INPUT_ENDED );
+
+		--m_bitCount;
+		code |= (int)( ( m_bitBuf >> m_bitCount ) & 1 );
+
+		const int count = table.count[ len ];
+
+		if( code - count < first )
+		{
+			symbol = table.symbol[ index + ( code - first ) ];
+			return true;
+		}
+
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	return Fail( DECOMPRESS_CORRUPT );
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult Bzip2Decoder::Decompress( void )
+{
+	// Streams follow each other until the end of the file
+	do
+	{
+		if( !Stream() )
+			return m_result;
+
+		// Streams end at a byte boundary, give back the whole bytes in the bit buffer
+		m_inPos -= m_bitCount / 8;
+		m_bitBuf = 0;
+		m_bitCount = 0;
+	}
+	while( IsBzip2Data( m_pIn + m_inPos, m_inSize - m_inPos ) );
+
+	return DECOMPRESS_DONE;
+}
+
+// =====================================================================================================================================================================
+
+bool Bzip2Decoder::Stream( void )
+{
+	uint32 signature, level;
+
+	if( !ReadBits( 24, signature ) || !ReadBits( 8, level ) )
+		return false;
+
+	if( signature != ( ( 'B' << 16 ) | ( 'Z' << 8 ) | 'h' ) || level < '1' || level > '9' )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	m_maxBlockSize = ( level - '0' ) * BZIP2_BLOCK_SIZE_UNIT;
+
+	if( m_maxBlockSize > m_blockCapacity )
+	{
+		delete[] m_pBlock;
+		m_pBlock = new uint32[ m_maxBlockSize ];
+		m_blockCapacity = m_maxBlockSize;
+	}
+
+	while( true )
+	{
+		uint32 magicHi, magicLo, crc;
+
+		if( !ReadBits( 24, magicHi ) || !ReadBits( 24, magicLo ) || !ReadBits( 32, crc ) )
+			return false;
+
+		if( magicHi == BZIP2_END_MAGIC_HI && magicLo == BZIP2_END_MAGIC_LO )
+		{
+			// Padding to the byte boundary
+			m_bitCount -= m_bitCount % 8;
+			return true;
+		}
+
+		if( magicHi != BZIP2_BLOCK_MAGIC_HI || magicLo != BZIP2_BLOCK_MAGIC_LO )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		if( !Block() )
+			return false;
+	}
+}
+
+// =====================================================================================================================================================================
+
+bool Bzip2Decoder::Block( void )
+{
+	uint32 bRandomised, origPtr;
+
+	if( !ReadBits( 1, bRandomised ) || !ReadBits( 24, origPtr ) )
+		return false;
+
+	// Randomised blocks haven't been written since bzip2 0.9.5
+	if( bRandomised )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	// Bytes that occur in the block, in groups of 16
+	uint32 usedGroups;
+	byte seqToUnseq[ 256 ];
+	int numInUse = 0;
+
+	if( !ReadBits( 16, usedGroups ) )
+		return false;
+
+	for( int i = 0; i < 16; ++i )
+	{
+		if( !( usedGroups & ( 0x8000 >> i ) ) )
+			continue;
+
+		uint32 used;
+
+		if( !ReadBits( 16, used ) )
+			return false;
+
+		for( int j = 0; j < 16; ++j )
+		{
+			if( used & ( 0x8000 >> j ) )
+				seqToUnseq[ numInUse++ ] = (byte)( i * 16 + j );
+		}
+	}
+
+	if( !numInUse )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	const int alphaSize = numInUse + 2;
+
+	// Table of each group of symbols, the selectors are move-to-front coded in unary
+	uint32 numGroups, numSelectors;
+
+	if( !ReadBits( 3, numGroups ) || !ReadBits( 15, numSelectors ) )
+		return false;
+
+	if( numGroups < BZIP2_MIN_GROUPS || numGroups > BZIP2_MAX_GROUPS || !numSelectors )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	byte groupOrder[ BZIP2_MAX_GROUPS ] = { 0, 1, 2, 3, 4, 5 };
+
+	for( uint32 i = 0; i < numSelectors; ++i )
+	{
+		uint32 index = 0;
+		uint32 bit;
+
+		while( true )
+		{
+			if( !ReadBits( 1, bit ) )
+				return false;
+
+			if( !bit )
+				break;
+
+			if( ++index >= numGroups )
+				return Fail( DECOMPRESS_CORRUPT );
+		}
+
+		const byte group = groupOrder[ index ];
+		memmove( groupOrder + 1, groupOrder, index );
+		groupOrder[ 0 ] = group;
+
+		if( i < BZIP2_MAX_SELECTORS )
+			m_Selectors[ i ] = group;
+	}
+
+	if( numSelectors > BZIP2_MAX_SELECTORS )
+		numSelectors = BZIP2_MAX_SELECTORS;
+
+	// Code lengths, each one is the previous one changed by the following steps
+	for( uint32 group = 0; group < numGroups; ++group )
+	{
+		byte lengths[ BZIP2_MAX_ALPHA_SIZE ];
+		uint32 length;
+
+		if( !ReadBits( 5, length ) )
+			return false;
+
+		for( int symbol = 0; symbol < alphaSize; ++symbol )
+		{
+			while( true )
+			{
+				if( length < 1 || length > BZIP2_MAX_CODE_LENGTH )
+					return Fail( DECOMPRESS_CORRUPT );
+
+				uint32 bit;
+
+				if( !ReadBits( 1, bit ) )
+					return false;
+
+				if( !bit )
+					break;
+
+				if( !ReadBits( 1, bit ) )
+					return false;
+
+				length += bit? -1 : 1;
+			}
+
+			lengths[ symbol ] = (byte)length;
+		}
+
+		if( !BuildHuffmanTable( m_Tables[ group ], lengths, alphaSize ) )
+			return Fail( DECOMPRESS_CORRUPT );
+	}
+
+	// Move-to-front indices, with the runs of index 0 coded as bijective base-2 numbers of RUNA and RUNB
+	byte mtf[ 256 ];
+	uint32 byteCount[ 256 ];
+
+	for( int i = 0; i < 256; ++i )
+		mtf[ i ] = (byte)i;
+
+	memset( byteCount, 0, sizeof( byteCount ) );
+
+	const Bzip2HuffmanTable_t *pTable = nullptr;
+	uint32 groupLeft = 0;
+	uint32 selector = 0;
+	uint32 count = 0;
+	uint32 runLength = 0;
+	uint32 runWeight = 1;
+
+	while( true )
+	{
+		if( !groupLeft )
+		{
+			if( selector >= numSelectors )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			pTable = &m_Tables[ m_Selectors[ selector++ ] ];
+			groupLeft = BZIP2_GROUP_SIZE;
+		}
+
+		--groupLeft;
+
+		int symbol;
+
+		if( !DecodeSymbol( *pTable, symbol ) )
+			return false;
+
+		if( symbol == BZIP2_RUNA || symbol == BZIP2_RUNB )
+		{
+			if( runWeight > m_maxBlockSize )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			runLength += runWeight << symbol;
+			runWeight <<= 1;
+			continue;
+		}
+
+		if( runLength )
+		{
+			if( runLength > m_maxBlockSize - count )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			const byte value = seqToUnseq[ mtf[ 0 ] ];
+			byteCount[ value ] += runLength;
+
+			while( runLength-- )
+				m_pBlock[ count++ ] = value;
+
+			runLength = 0;
+			runWeight = 1;
+		}
+
+		// End of block
+		if( symbol == alphaSize - 1 )
+			break;
+
+		if( symbol >= alphaSize || count >= m_maxBlockSize )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		const int index = symbol - 1;
+		const byte entry = mtf[ index ];
+		memmove( mtf + 1, mtf, index );
+		mtf[ 0 ] = entry;
+
+		const byte value = seqToUnseq[ entry ];
+		++byteCount[ value ];
+		m_pBlock[ count++ ] = value;
+	}
+
+	if( origPtr >= count )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	// Link each byte to the position of the next one, above its own 8 bits
+	uint32 start = 0;
+
+	for( int i = 0; i < 256; ++i )
+	{
+		const uint32 next = start + byteCount[ i ];
+		byteCount[ i ] = start;
+		start = next;
+	}
+
+	for( uint32 i = 0; i < count; ++i )
+		m_pBlock[ byteCount[ m_pBlock[ i ] & 0xFF ]++ ] |= i << 8;
+
+	return Output( origPtr, count );
+}
+
+// =====================================================================================================================================================================
+
+bool Bzip2Decoder::Output( uint32 origPtr, uint32 count )
+{
+	uint32 pos = m_pBlock[ origPtr ] >> 8;
+	int last = -1;
+	int runCount = 0;
+
+	for( uint32 i = 0; i < count; ++i )
+	{
+		pos = m_pBlock[ pos ];
+		const byte value = (byte)( pos & 0xFF );
+		pos >>= 8;
+
+		// Four equal bytes are followed by the # of further copies
+		if( runCount == 4 )
+		{
+			const size_t room = MakeRoom( value );
+
+			memset( m_pOut + m_outPos, last, room );
+			m_outPos += room;
+
+			if( room < value )
+				return Fail( DECOMPRESS_OUTPUT_FULL );
+
+			runCount = 0;
+			continue;
+		}
+
+		if( value == last )
+		{
+			++runCount;
+		}
+		else
+		{
+			last = value;
+			runCount = 1;
+		}
+
+		if( m_outPos == m_outSize && !MakeRoom( 1 ) )
+			return Fail( DECOMPRESS_OUTPUT_FULL );
+
+		m_pOut[ m_outPos++ ] = value;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+size_t Bzip2Decoder::MakeRoom( size_t size )
+{
+	if( size > m_outSize - m_outPos && m_Out.Grow( m_outPos + size ) )
+	{
+		m_pOut = m_Out.GetData();
+		m_outSize = m_Out.GetSize();
+	}
+
+	return ( size > m_outSize - m_outPos )? m_outSize - m_outPos : size;
+}
+
+// =====================================================================================================================================================================
+
+bool IsBzip2Data( const byte *pData, size_t size )
+{
+	return size >= BZIP2_MIN_SIZE && pData[ 0 ] == 'B' && pData[ 1 ] == 'Z' && pData[ 2 ] == 'h' && pData[ 3 ] >= '1' && pData[ 3 ] <= '9';
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult Bzip2Decompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten )
+{
+	outWritten = 0;
+
+	if( !IsBzip2Data( pIn, inSize ) )
+		return DECOMPRESS_CORRUPT;
+
+	// The tables are too large for the stack
+	Bzip2Decoder *pDecoder = new Bzip2Decoder( pIn, inSize, out );
+
+	DecompressResult result = pDecoder->Decompress();
+
+	outWritten = pDecoder->GetOutputPos();
+	delete pDecoder;
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Common.h"
+#include "Decompress.h"
+
+#define BZIP2_MIN_SIZE		14		// Stream header and the end of stream marker of an empty file
+
+/**
+ * Whether the data starts with the bzip2 stream header
+ */
+bool IsBzip2Data( const byte *pData, size_t size );
+
+/**
+ * Decompresses all streams of a bzip2 file straight into the output buffer
+ * Stops when a fixed output buffer is full, so the start of a file can be read without decompressing all of it.
+ * @param outWritten			set to the # of bytes written to the output buffer
+ */
+DecompressResult Bzip2Decompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten );
\ No newline at end of file
@@ -48,7 +48,8 @@ void RemoveFileExtension( std::string &filename )
 
 void RemoveFileNameFolders( std::string &filepath )
 {
-	size_t slash = filepath.find_last_of( '\\' );
+	// Windows takes both separators, so paths given as "D:/demos/a.dem" work too
+	size_t slash = filepath.find_last_of( "\\/" );
 	if( slash != std::string::npos )
 		filepath.erase( 0, slash + 1 );
 }
@@ -66,6 +67,28 @@ bool FileHasExtension( const std::string &filename, const std::string &extension
 	return false;
 }
 
+bool IsDemoFile( const std::string &filename )
+{
+	// Compressed demos are named like demo.dem.gz
+	if( FileHasExtension( filename, "gz" ) || FileHasExtension( filename, "zst" ) || FileHasExtension( filename, "bz2" ) )
+	{
+		std::string uncompressed = filename;
+		RemoveFileExtension( uncompressed );
+
+		return FileHasExtension( uncompressed, "dem" );
+	}
+
+	return FileHasExtension( filename, "dem" );
+}
+
+void RemoveDemoExtension( std::string &filename )
+{
+	if( !FileHasExtension( filename, "dem" ) )
+		RemoveFileExtension( filename );
+
+	RemoveFileExtension( filename );
+}
+
 bool IsValidDirectory( const char *szPath )
 {
 	DWORD attributes = GetFileAttributesA( szPath );
@@ -73,9 +96,9 @@ bool IsValidDirectory( const char *szPath )
 	return (attributes != INVALID_FILE_ATTRIBUTES) && (attributes & FILE_ATTRIBUTE_DIRECTORY);
 }
 
-// The parser that is currently parsing a demo
+// The parser that is currently parsing a demo on this thread
 // This can be used to get current tick or tick interval
-extern DemoParser *gpParser;
+extern thread_local DemoParser *gpParser;
 
 float GetTimeBetweenTicks( int tick1, int tick2 )
 {
@@ -112,6 +135,13 @@ void OnParsingEnd( void )
 	gpParser->OnParsingEnd();
 }
 
+bool IsSubParser( void )
+{
+	assert( gpParser );
+
+	return gpParser->IsSubParser();
+}
+
 // ===== QAngle ==========================================================================================
 
 void QAngle::Init( void )
@@ -33,9 +33,11 @@
 #define BYTES2BITS( bytes )			(bytes<<3)
 
 typedef unsigned char				byte;
+typedef unsigned __int16			uint16;
 typedef __int32			 			int32;
 typedef unsigned __int32			uint32;
 typedef __int64						int64;
+typedef unsigned __int64			uint64;
 typedef unsigned long				CRC32_t;
 
 double Log2( double n );
@@ -44,6 +46,8 @@ void TrimString( std::string &s );
 void RemoveFileExtension( std::string &filename );
 void RemoveFileNameFolders( std::string &filepath );
 bool FileHasExtension( const std::string &filename, const std::string &extension );
+bool IsDemoFile( const std::string &filename );			// .dem, or .dem with a compression extension
+void RemoveDemoExtension( std::string &filename );		// Removes .dem and the compression extension after it
 bool IsValidDirectory( const char *szPath );
 
 // Utility from the current demo parser that other classes need as well
@@ -52,6 +56,7 @@ int GetTotalTickCount( void );
 int GetCurrentTick( void );
 int GetTickRate( void );
 void OnParsingEnd( void );
+bool IsSubParser( void );
 
 struct QAngle
 {
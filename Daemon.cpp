@@ -0,0 +1,460 @@
+#include "Daemon.h"
+#include "DemoFile.h"
+#include "DemoParser.h"
+#include "Errors.h"
+#include "FragOutput.h"
+#include "Settings.h"
+#include <WinSock2.h>
+#include <afunix.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <thread>
+
+#pragma comment( lib, "Ws2_32.lib" )
+
+// Daemon mode
+//
+// The main thread accepts connections and queues them for a pool of worker threads. A worker answers the requests of
+// one connection at a time and parses the demos on its own thread, so demos from several clients are parsed at once.
+// The settings are loaded once when the daemon starts, and nothing is printed or written to files per demo.
+
+// =====================================================================================================================================================================
+/**
+ * Parses the demo without any console or file output, the frags are handed to the sink as they are found
+ * @return						false if parsing was aborted
+ */
+bool DemoParser::ParseRequest( DemoFile *pDemo, FragSink *pSink, std::vector< ParsingWarning_t > &warnings )
+{
+	// Sub-parsers don't print anything or touch the progress bar
+	DemoParser parser( pDemo );
+	parser.m_bSubParser = true;
+	parser.m_pFragSink = pSink;
+	parser.m_pWarnings = &warnings;
+
+	bf_read reader( pDemo->GetBuffer(), pDemo->GetFileSize() );
+	reader.ReadBytes( &parser.m_demoHeader, sizeof( parser.m_demoHeader ) );
+
+	const bool bComplete = parser.ParseCommands( reader );
+
+	parser.OnParsingEnd();
+
+	return bComplete;
+}
+
+// =====================================================================================================================================================================
+
+static bool SendText( SOCKET s, const std::string &text )
+{
+	size_t sent = 0;
+
+	while( sent < text.length() )
+	{
+		int n = send( s, text.data() + sent, (int)std::min< size_t >( text.length() - sent, 64 * 1024 ), 0 );
+
+		if( n <= 0 )
+			return false;
+
+		sent += n;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Reads lines from a socket
+ */
+class SocketLineReader
+{
+public:
+	SocketLineReader( SOCKET s, size_t maxLineLength ) : m_socket( s ), m_maxLineLength( maxLineLength ) {}
+
+	/**
+	 * @return					false if the connection was closed or the line is too long
+	 */
+	bool ReadLine( std::string &line )
+	{
+		while( true )
+		{
+			size_t end = m_buffer.find( '\n' );
+
+			if( end != std::string::npos )
+			{
+				line.assign( m_buffer, 0, end );
+				m_buffer.erase( 0, end + 1 );
+
+				if( !line.empty() && line.back() == '\r' )
+					line.pop_back();
+
+				return true;
+			}
+
+			if( m_maxLineLength && m_buffer.length() > m_maxLineLength )
+				return false;
+
+			char chunk[ 4096 ];
+			int n = recv( m_socket, chunk, sizeof( chunk ), 0 );
+
+			if( n <= 0 )
+				return false;
+
+			m_buffer.append( chunk, n );
+		}
+	}
+
+private:
+	SOCKET				m_socket;
+	size_t				m_maxLineLength;	///< 0 for no limit
+	std::string			m_buffer;
+};
+
+// =====================================================================================================================================================================
+
+static std::vector< std::string > SplitFields( const std::string &line )
+{
+	std::vector< std::string > fields;
+	size_t start = 0;
+
+	while( true )
+	{
+		size_t end = line.find( '\t', start );
+
+		fields.push_back( line.substr( start, end - start ) );
+
+		if( end == std::string::npos )
+			break;
+
+		start = end + 1;
+	}
+
+	return fields;
+}
+
+// =====================================================================================================================================================================
+
+static bool FillSocketAddress( const std::string &socketPath, SOCKADDR_UN &addr )
+{
+	memset( &addr, 0, sizeof( addr ) );
+	addr.sun_family = AF_UNIX;
+
+	if( socketPath.length() >= sizeof( addr.sun_path ) )
+	{
+		printf( "%s: Socket path %s is too long\n", CSSFF_NAME, socketPath.c_str() );
+		return false;
+	}
+
+	strcpy_s( addr.sun_path, socketPath.c_str() );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+class Daemon
+{
+public:
+	Daemon( void ) : m_listenSocket( INVALID_SOCKET ), m_bStopping( false ) {}
+
+	bool Run( const std::string &socketPath );
+
+private:
+	void WorkerThread( void );
+	void HandleConnection( SOCKET client );
+	void ParseDemo( const std::string &path, int profile, std::string &response );
+	void Stop( void );
+
+	SOCKET						m_listenSocket;
+	std::mutex					m_mutex;			///< Guards the connection queue and m_bStopping
+	std::condition_variable		m_cvConnection;
+	std::deque< SOCKET >		m_Connections;		///< Accepted connections waiting for a worker
+	bool						m_bStopping;
+};
+
+// =====================================================================================================================================================================
+
+bool Daemon::Run( const std::string &socketPath )
+{
+	SOCKADDR_UN addr;
+
+	if( !FillSocketAddress( socketPath, addr ) )
+		return false;
+
+	// A socket file left behind by a previous daemon would make binding fail
+	remove( socketPath.c_str() );
+
+	m_listenSocket = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+	if( m_listenSocket == INVALID_SOCKET
+	|| bind( m_listenSocket, (const sockaddr *)&addr, sizeof( addr ) ) == SOCKET_ERROR
+	|| listen( m_listenSocket, SOMAXCONN ) == SOCKET_ERROR )
+	{
+		printf( "%s: Failed to listen on %s (error %d)\n", CSSFF_NAME, socketPath.c_str(), WSAGetLastError() );
+
+		if( m_listenSocket != INVALID_SOCKET )
+			closesocket( m_listenSocket );
+
+		return false;
+	}
+
+	const int numWorkers = std::max( 1, (int)std::thread::hardware_concurrency() );
+	std::vector< std::thread > workers;
+
+	for( int i = 0; i < numWorkers; ++i )
+		workers.emplace_back( &Daemon::WorkerThread, this );
+
+	printf( "%s: Daemon listening on %s with %d workers\n", CSSFF_NAME, socketPath.c_str(), numWorkers );
+
+	// Accept fails once STOP has closed the listening socket
+	while( true )
+	{
+		SOCKET client = accept( m_listenSocket, nullptr, nullptr );
+
+		if( client == INVALID_SOCKET )
+			break;
+
+		{
+			std::lock_guard< std::mutex > lock( m_mutex );
+			m_Connections.push_back( client );
+		}
+
+		m_cvConnection.notify_one();
+	}
+
+	Stop();
+
+	for( size_t i = 0; i < workers.size(); ++i )
+		workers[ i ].join();
+
+	remove( socketPath.c_str() );
+
+	printf( "%s: Daemon stopped\n", CSSFF_NAME );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+void Daemon::Stop( void )
+{
+	std::lock_guard< std::mutex > lock( m_mutex );
+
+	if( m_bStopping )
+		return;
+
+	m_bStopping = true;
+	closesocket( m_listenSocket );
+
+	m_cvConnection.notify_all();
+}
+
+// =====================================================================================================================================================================
+
+void Daemon::WorkerThread( void )
+{
+	while( true )
+	{
+		SOCKET client;
+
+		{
+			std::unique_lock< std::mutex > lock( m_mutex );
+			m_cvConnection.wait( lock, [this]{ return m_bStopping || !m_Connections.empty(); } );
+
+			// Queued connections are still answered when stopping
+			if( m_Connections.empty() )
+				return;
+
+			client = m_Connections.front();
+			m_Connections.pop_front();
+		}
+
+		HandleConnection( client );
+
+		closesocket( client );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void Daemon::HandleConnection( SOCKET client )
+{
+	SocketLineReader reader( client, DAEMON_MAX_REQUEST_LENGTH );
+	std::string line;
+
+	while( reader.ReadLine( line ) )
+	{
+		std::vector< std::string > fields = SplitFields( line );
+		std::string response;
+
+		if( fields[ 0 ] == "PARSE" && ( fields.size() == 2 || fields.size() == 3 ) )
+		{
+			int profile = -1;
+
+			if( fields.size() == 3 && ( sscanf_s( fields[ 2 ].c_str(), "%d", &profile ) != 1 || profile < 0 || profile >= Settings()->GetNumProfiles() ) )
+				response = "ERROR\t0\tinvalid settings profile\n";
+			else
+				ParseDemo( fields[ 1 ], profile, response );
+		}
+		else if( fields[ 0 ] == "STOP" && fields.size() == 1 )
+		{
+			Stop();
+			response = "OK\t0\n";
+		}
+		else
+		{
+			response = "ERROR\t0\tunknown request\n";
+		}
+
+		if( !SendText( client, response ) )
+			break;
+	}
+}
+
+// =====================================================================================================================================================================
+
+void Daemon::ParseDemo( const std::string &path, int profile, std::string &response )
+{
+	DemoFile demo( path );
+
+	if( !demo.IsValidDemo() )
+	{
+		response = std::format( "ERROR\t0\t{}\n", demo.GetErrorString() );
+		printf( "%s: Failed to parse (%s)\n", demo.GetFileName().c_str(), demo.GetErrorString().c_str() );
+		return;
+	}
+
+	FragLines frags( profile );
+	std::vector< ParsingWarning_t > warnings;
+	std::string result;
+
+	try
+	{
+		DemoParser::ParseRequest( &demo, &frags, warnings );
+
+		result = std::format( "OK\t{}\n", frags.m_iNumFrags );
+	}
+	catch( ParsingError_t error )
+	{
+		// Errors at the end of a demo are ignored, since they often happen on map change etc.
+		if( error.at_end_of_demo )
+			result = std::format( "OK\t{}\n", frags.m_iNumFrags );
+		else
+			result = std::format( "ERROR\t{}\t{}\n", error.tick, error.error_msg );
+	}
+	catch( ... )
+	{
+		result = "ERROR\t0\tunexpected error\n";
+	}
+
+	printf( "%s: %d frags%s\n", demo.GetFileName().c_str(), frags.m_iNumFrags, ( result[ 0 ] == 'E' )? " (parsing failed)" : "" );
+
+	response = std::move( frags.m_strText );
+
+	for( size_t i = 0; i < warnings.size(); ++i )
+		response += std::format( "WARNING\t{}\t{}\t{}\n", warnings[ i ].tick, warnings[ i ].count, g_szWarnings[ warnings[ i ].type ] );
+
+	response += result;
+}
+
+// =====================================================================================================================================================================
+
+bool RunDaemon( const std::string &socketPath )
+{
+	WSADATA wsaData;
+
+	if( WSAStartup( MAKEWORD( 2, 2 ), &wsaData ) != 0 )
+	{
+		printf( "%s: Failed to initialize Winsock\n", CSSFF_NAME );
+		return false;
+	}
+
+	Daemon daemon;
+	bool bResult = daemon.Run( socketPath );
+
+	WSACleanup();
+
+	return bResult;
+}
+
+// =====================================================================================================================================================================
+
+bool RunDaemonClient( const std::string &socketPath, const std::vector< std::string > &demos, int profile )
+{
+	SOCKADDR_UN addr;
+
+	if( !FillSocketAddress( socketPath, addr ) )
+		return false;
+
+	WSADATA wsaData;
+
+	if( WSAStartup( MAKEWORD( 2, 2 ), &wsaData ) != 0 )
+	{
+		printf( "%s: Failed to initialize Winsock\n", CSSFF_NAME );
+		return false;
+	}
+
+	SOCKET s = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+	if( s == INVALID_SOCKET || connect( s, (const sockaddr *)&addr, sizeof( addr ) ) == SOCKET_ERROR )
+	{
+		printf( "%s: Failed to connect to the daemon on %s (error %d)\n", CSSFF_NAME, socketPath.c_str(), WSAGetLastError() );
+
+		if( s != INVALID_SOCKET )
+			closesocket( s );
+
+		WSACleanup();
+		return false;
+	}
+
+	SocketLineReader reader( s, 0 );
+	std::string line;
+	bool bResult = true;
+
+	// Without demos the daemon is asked to stop
+	std::vector< std::string > requests;
+
+	for( size_t i = 0; i < demos.size(); ++i )
+	{
+		// The daemon may have a different working directory
+		char szFullPath[ MAX_PATH ];
+
+		if( !_fullpath( szFullPath, demos[ i ].c_str(), sizeof( szFullPath ) ) )
+			strcpy_s( szFullPath, demos[ i ].c_str() );
+
+		requests.push_back( ( profile >= 0 )? std::format( "PARSE\t{}\t{}\n", szFullPath, profile ) : std::format( "PARSE\t{}\n", szFullPath ) );
+	}
+
+	if( requests.empty() )
+		requests.push_back( "STOP\n" );
+
+	for( size_t i = 0; i < requests.size() && bResult; ++i )
+	{
+		if( !SendText( s, requests[ i ] ) )
+		{
+			bResult = false;
+			break;
+		}
+
+		if( i < demos.size() )
+			printf( "%s\n", demos[ i ].c_str() );
+
+		// Print the response up to its last line
+		while( ( bResult = reader.ReadLine( line ) ) )
+		{
+			printf( "%s\n", line.c_str() );
+
+			if( !line.compare( 0, 3, "OK\t" ) || !line.compare( 0, 6, "ERROR\t" ) )
+				break;
+		}
+	}
+
+	if( !bResult )
+		printf( "%s: Lost the connection to the daemon\n", CSSFF_NAME );
+
+	closesocket( s );
+	WSACleanup();
+
+	return bResult;
+}
\ No newline at end of file
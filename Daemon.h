@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Common.h"
+#include <string>
+#include <vector>
+
+#define DAEMON_SOCKET_NAME			"cssff.sock"	// Default socket file, in the program directory
+#define DAEMON_MAX_REQUEST_LENGTH	4096			// Longest request line that is accepted
+
+/**
+ * Daemon mode - keeps the program running with the settings loaded and parses demos on request
+ *
+ * Requests are read from a local (AF_UNIX) socket, one tab separated line per request:
+ *   PARSE <demo path> [<profile>]	Parse the demo, profile is the index of the settings file (all profiles if left out)
+ *   STOP							Stop the daemon after the requests being parsed are finished
+ *
+ * The response to PARSE is one line per frag, followed by a line that tells how the parsing ended:
+ *   FRAG <profile> <tick> <player> <team> <spectated 0/1> <description>
+ *   OK <# of frags>
+ *   ERROR <tick> <message>		(frags found before the error are sent as well)
+ */
+bool RunDaemon( const std::string &socketPath );
+
+/**
+ * Sends the demos to a running daemon and prints the responses
+ * @param profile				settings profile to get the frags for (-1 for all)
+ */
+bool RunDaemonClient( const std::string &socketPath, const std::vector< std::string > &demos, int profile );
\ No newline at end of file
@@ -2,25 +2,46 @@
 #include "DemoParser.h"
 #include "Errors.h"
 
+const char *StringPool::Intern( const char *pString )
+{
+	return m_Strings.emplace( pString ).first->c_str();
+}
+
+const char *StringPool::Find( const char *pString ) const
+{
+	auto it = m_Strings.find( std::string_view( pString ) );
+
+	return ( it != m_Strings.end() )? it->c_str() : nullptr;
+}
+
 void DemoParser::ParseDataTables( bf_read &reader )
 {
+	STATS_SCOPE( PHASE_DATATABLES );
+
+	// All the names are pooled, so the tables, props and excludes can be found by pointer
+	char name[ 256 ];
+
 	while( reader.ReadOneBit() )
 	{
 		SendTable table;
 		table.m_bNeedsDecoder = reader.ReadOneBit();
-		reader.ReadString( table.m_tableName, sizeof(table.m_tableName) );
+		reader.ReadString( name, sizeof(name) );
+		table.m_tableName = m_StringPool.Intern( name );
 		table.m_nProps = reader.ReadUBitLong( 9 );
+		table.m_props.reserve( table.m_nProps );
 
 		for(int i = 0; i < table.m_nProps; ++i)
 		{
-			SendProp prop;
-			prop.m_propType = (SendPropType)reader.ReadUBitLong( 5 );
-			reader.ReadString( prop.m_propName, sizeof(prop.m_propName) );
-			prop.m_flags = reader.ReadUBitLong( 13 );
+			SendProp prop = {};
+			prop.m_propType = (byte)reader.ReadUBitLong( 5 );
+			reader.ReadString( name, sizeof(name) );
+			prop.m_propName = m_StringPool.Intern( name );
+			prop.m_flags = (uint16)reader.ReadUBitLong( 13 );
 
 			if( prop.m_propType == DPT_DataTable || (prop.m_flags & SPROP_EXCLUDE) > 0 )
 			{
-				reader.ReadString( prop.m_dtname, sizeof(prop.m_dtname) );
+				reader.ReadString( name, sizeof(name) );
+				prop.m_dtname = m_StringPool.Intern( name );
 			}
 			else
 			{
@@ -33,12 +54,12 @@ void DemoParser::ParseDataTables( bf_read &reader )
 					{
 						prop.m_fLowValue = reader.ReadFloat();
 						prop.m_fHighValue = reader.ReadFloat();
-						prop.m_nBits = reader.ReadUBitLong( 6 );
+						prop.m_nBits = (byte)reader.ReadUBitLong( 6 );
 						break;
 					}
 					case DPT_Array:
 					{
-						prop.m_nNumElements = reader.ReadUBitLong( 10 );
+						prop.m_nNumElements = (uint16)reader.ReadUBitLong( 10 );
 						break;
 					}
 					default:
@@ -49,7 +70,9 @@ void DemoParser::ParseDataTables( bf_read &reader )
 			table.m_props.push_back( prop );
 		}
 
-		m_DataTables.push_back( table );
+		// The first table with the name is used if there are duplicates
+		m_DataTableIndex.emplace( table.m_tableName, (int)m_DataTables.size() );
+		m_DataTables.push_back( std::move( table ) );
 	}
 
 	short nServerClasses = reader.ReadShort();
@@ -57,6 +80,8 @@ void DemoParser::ParseDataTables( bf_read &reader )
 	if( !nServerClasses )
 		throw ParsingError_t( "no server classes in ParseDataTable" );
 
+	m_ServerClasses.reserve( nServerClasses );
+
 	for ( int i = 0; i < nServerClasses; i++ )
 	{
 		ServerClass_t entry;
@@ -66,24 +91,20 @@ void DemoParser::ParseDataTables( bf_read &reader )
 			throw ParsingError_t( "invalid class index in ParseDataTable" );
 		}
 
-		reader.ReadString( entry.strName, sizeof( entry.strName ) );
-		reader.ReadString( entry.strDTName, sizeof( entry.strDTName ) );
+		reader.ReadString( name, sizeof(name) );
+		entry.strName = m_StringPool.Intern( name );
+		reader.ReadString( name, sizeof(name) );
+		entry.strDTName = m_StringPool.Intern( name );
 
 		// Find the data table by name
-		entry.nDataTable = -1;
-		for ( size_t j = 0; j < m_DataTables.size(); ++j )
-		{
-			if ( strcmp( entry.strDTName, m_DataTables[ j ].m_tableName ) == 0 )
-			{
-				entry.nDataTable = j;
-				break;
-			}
-		}
+		auto table = m_DataTableIndex.find( entry.strDTName );
 
-		if( entry.nDataTable == -1 )
+		if( table == m_DataTableIndex.end() )
 			throw ParsingError_t( "data table for server class not found in ParseDataTable" );
 
-		m_ServerClasses.push_back( entry );
+		entry.nDataTable = table->second;
+
+		m_ServerClasses.push_back( std::move( entry ) );
 	}
 
 	for ( int i = 0; i < nServerClasses; ++i )
@@ -98,22 +119,34 @@ void DemoParser::ParseDataTables( bf_read &reader )
 		++m_iServerClassBits;
 
 	m_iServerClassBits++;
+
+	// Props that are checked for every decoded player entity
+	m_PropNames.eyeAngles0 = m_StringPool.Intern( "m_angEyeAngles[0]" );
+	m_PropNames.eyeAngles1 = m_StringPool.Intern( "m_angEyeAngles[1]" );
+	m_PropNames.flashDuration = m_StringPool.Intern( "m_flFlashDuration" );
+	m_PropNames.flags = m_StringPool.Intern( "m_fFlags" );
+	m_PropNames.origin = m_StringPool.Intern( "m_vecOrigin" );
 }
 
 SendTable *DemoParser::GetTableByName( const char *pName )
 {
-	for ( size_t i = 0; i < m_DataTables.size(); i++ )
-	{
-		if( strcmp( m_DataTables[ i ].m_tableName, pName ) == 0 )
-		{
-			return &(m_DataTables[ i ]);
-		}
-	}
-	return nullptr;
+	// Names from the props are already pooled, other names have to be looked up from the pool first
+	const char *pPooledName = m_StringPool.Find( pName );
+
+	if( !pPooledName )
+		return nullptr;
+
+	auto table = m_DataTableIndex.find( pPooledName );
+
+	return ( table != m_DataTableIndex.end() )? &m_DataTables[ table->second ] : nullptr;
 }
 
 SendTable *DemoParser::GetTableByClassID( uint32 iClassID )
 {
+	// Server classes are sent in class ID order
+	if( iClassID < m_ServerClasses.size() && m_ServerClasses[ iClassID ].nClassID == iClassID )
+		return &m_DataTables[ m_ServerClasses[ iClassID ].nDataTable ];
+
 	for ( size_t i = 0; i < m_ServerClasses.size(); i++ )
 	{
 		if ( m_ServerClasses[ i ].nClassID == iClassID )
@@ -131,7 +164,7 @@ void DemoParser::GatherExcludes( SendTable *pTable )
 		const SendProp& sendProp = pTable->m_props[ iProp ];
 		if ( sendProp.m_flags & SPROP_EXCLUDE )
 		{
-			m_currentExcludes.emplace_back( sendProp.m_propName, sendProp.m_dtname, pTable->m_tableName );
+			m_currentExcludes.emplace( sendProp.m_propName, sendProp.m_dtname, pTable->m_tableName );
 		}
 
 		if ( sendProp.m_propType == DPT_DataTable )
@@ -147,15 +180,7 @@ void DemoParser::GatherExcludes( SendTable *pTable )
 
 bool DemoParser::IsPropExcluded( SendTable *pTable, const SendProp& checkSendProp )
 {
-	for ( size_t i = 0; i < m_currentExcludes.size(); ++i )
-	{
-		if( strcmp( pTable->m_tableName, m_currentExcludes[ i ].m_pDTName ) == 0
-		&& strcmp( checkSendProp.m_propName, m_currentExcludes[ i ].m_pVarName ) == 0 )
-		{
-			return true;
-		}
-	}
-	return false;
+	return m_currentExcludes.find( ExcludeEntry( checkSendProp.m_propName, pTable->m_tableName, nullptr ) ) != m_currentExcludes.end();
 }
 
 void DemoParser::GatherProps_IterateProps( SendTable *pTable, int nServerClass, std::vector< FlattenedPropEntry > &flattenedProps )
@@ -206,10 +231,7 @@ void DemoParser::GatherProps( SendTable *pTable, int nServerClass )
 	GatherProps_IterateProps( pTable, nServerClass, tempFlattenedProps );
 
 	std::vector< FlattenedPropEntry > &flattenedProps = m_ServerClasses[ nServerClass ].flattenedProps;
-	for ( size_t i = 0; i < tempFlattenedProps.size(); ++i )
-	{
-		flattenedProps.push_back( tempFlattenedProps[ i ] );
-	}
+	flattenedProps.insert( flattenedProps.end(), tempFlattenedProps.begin(), tempFlattenedProps.end() );
 }
 
 void DemoParser::FlattenDataTable( int nServerClass )
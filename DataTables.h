@@ -1,12 +1,36 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include "Entities.h"
 
+/**
+ * Keeps one copy of every distinct string, so that pooled strings can be compared and hashed by their pointers
+ */
+class StringPool
+{
+public:
+	const char *Intern( const char *pString );			///< Get the pooled copy of the string, adding it if needed
+	const char *Find( const char *pString ) const;		///< Get the pooled copy of the string, nullptr if it isn't pooled
+
+private:
+	struct StringHash
+	{
+		using is_transparent = void;
+
+		size_t operator()( std::string_view s ) const { return std::hash< std::string_view >()( s ); }
+	};
+
+	std::unordered_set< std::string, StringHash, std::equal_to<> > m_Strings;
+};
+
 class SendTable
 {
 public:
-	char m_tableName[256];
+	const char *m_tableName;		///< Pooled
 	bool m_bNeedsDecoder;
 	int m_nProps;
 	std::vector< SendProp > m_props;
@@ -15,13 +39,23 @@ public:
 struct ServerClass_t
 {
 	int nClassID;
-	char strName[ 256 ];
-	char strDTName[ 256 ];
+	const char *strName;			///< Pooled
+	const char *strDTName;			///< Pooled
 	int nDataTable;
 
 	std::vector< FlattenedPropEntry > flattenedProps;
 };
 
+// Excludes are looked up by the pooled prop and data table names
+struct ExcludeEntryHash
+{
+	size_t operator()( const ExcludeEntry &entry ) const
+	{
+		return std::hash< const char * >()( entry.m_pVarName ) ^ ( std::hash< const char * >()( entry.m_pDTName ) * 31 );
+	}
+};
+
 typedef std::vector< ServerClass_t > ServerClassVector;
 typedef std::vector< SendTable > SendTableVector;
-typedef std::vector< ExcludeEntry > ExcludeEntryVector;
\ No newline at end of file
+typedef std::unordered_map< const char *, int > SendTableIndex;		///< Pooled table name -> index in SendTableVector
+typedef std::unordered_set< ExcludeEntry, ExcludeEntryHash > ExcludeEntrySet;
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "Decompress.h"
+#include "Gzip.h"
+#include "Zstd.h"
+#include "Bzip2.h"
+#include <string.h>
+
+// Decompression
+//
+// Compressed demos are recognized by their magic bytes, not by the file extension. The decompressors only decode what
+// the demo parser needs: they don't check the checksums of the formats, the demo parser rejects corrupt demos anyway.
+
+// =====================================================================================================================================================================
+
+DecompressBuffer::DecompressBuffer( byte *pData, size_t size )
+{
+	m_pData = pData;
+	m_size = size;
+	m_bGrowing = false;
+}
+
+// =====================================================================================================================================================================
+
+DecompressBuffer::DecompressBuffer( size_t initialSize )
+{
+	if( initialSize < 1024 )
+		initialSize = 1024;
+
+	if( initialSize > DECOMPRESS_MAX_SIZE )
+		initialSize = (size_t)DECOMPRESS_MAX_SIZE;
+
+	m_pData = (byte *)new char[ initialSize ];
+	m_size = initialSize;
+	m_bGrowing = true;
+}
+
+// =====================================================================================================================================================================
+
+DecompressBuffer::~DecompressBuffer( void )
+{
+	if( m_bGrowing )
+		delete[] (char *)m_pData;
+}
+
+// =====================================================================================================================================================================
+
+char *DecompressBuffer::Release( void )
+{
+	char *pData = (char *)m_pData;
+
+	m_pData = nullptr;
+	m_size = 0;
+
+	return pData;
+}
+
+// =====================================================================================================================================================================
+
+bool DecompressBuffer::Grow( size_t minSize )
+{
+	if( !m_bGrowing || minSize > DECOMPRESS_MAX_SIZE )
+		return false;
+
+	if( minSize <= m_size )
+		return true;
+
+	// Double the size, so the data is moved only a few times
+	size_t newSize = m_size * 2;
+
+	if( newSize < minSize )
+		newSize = minSize;
+
+	if( newSize > DECOMPRESS_MAX_SIZE )
+		newSize = (size_t)DECOMPRESS_MAX_SIZE;
+
+	byte *pData = (byte *)new char[ newSize ];
+	memcpy( pData, m_pData, m_size );
+	delete[] (char *)m_pData;
+
+	m_pData = pData;
+	m_size = newSize;
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+CompressionFormat GetCompressionFormat( const byte *pData, size_t size )
+{
+	if( IsGzipData( pData, size ) )
+		return COMPRESSION_GZIP;
+
+	if( IsZstdData( pData, size ) )
+		return COMPRESSION_ZSTD;
+
+	if( IsBzip2Data( pData, size ) )
+		return COMPRESSION_BZIP2;
+
+	return COMPRESSION_NONE;
+}
+
+// =====================================================================================================================================================================
+
+size_t GetDecompressedSizeHint( CompressionFormat format, const byte *pData, size_t size )
+{
+	switch( format )
+	{
+		case COMPRESSION_GZIP:
+		{
+			// The trailer only has the size of the last member
+			const uint32 lastMemberSize = GetGzipUncompressedSize( pData, size );
+
+			return ( lastMemberSize / GZIP_MAX_RATIO <= size )? lastMemberSize : 0;
+		}
+
+		case COMPRESSION_ZSTD:
+			return GetZstdContentSize( pData, size );
+
+		case COMPRESSION_BZIP2:
+		case COMPRESSION_NONE:
+		default:
+			return 0;
+	}
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult DecompressData( CompressionFormat format, const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten )
+{
+	outWritten = 0;
+
+	switch( format )
+	{
+		case COMPRESSION_GZIP:		return GzipDecompress( pIn, inSize, out, outWritten );
+		case COMPRESSION_ZSTD:		return ZstdDecompress( pIn, inSize, out, outWritten );
+		case COMPRESSION_BZIP2:		return Bzip2Decompress( pIn, inSize, out, outWritten );
+		case COMPRESSION_NONE:
+		default:					return DECOMPRESS_CORRUPT;
+	}
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
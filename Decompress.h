@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Common.h"
+
+#define DECOMPRESS_MAX_SIZE			0xFFFFFFFFull	// Demo sizes are 32-bit
+#define DECOMPRESS_GUESS_RATIO		4				// Initial output size per input byte when the decompressed size is not known
+
+enum DecompressResult
+{
+	DECOMPRESS_DONE = 0,			///< The whole stream was decompressed
+	DECOMPRESS_OUTPUT_FULL,			///< Output buffer was filled before the end of the data
+	DECOMPRESS_INPUT_ENDED,			///< Data ended in the middle of the compressed stream
+	DECOMPRESS_CORRUPT,				///< Not valid data of the format
+};
+
+enum CompressionFormat
+{
+	COMPRESSION_NONE = 0,
+	COMPRESSION_GZIP,				///< .dem.gz, also with multiple members (pigz, concatenated files)
+	COMPRESSION_ZSTD,				///< .dem.zst, also with multiple frames
+	COMPRESSION_BZIP2,				///< .dem.bz2, also with multiple streams (pbzip2)
+};
+
+/**
+ * Output buffer of the decompressors
+ *
+ * A fixed buffer stops decompression when it is full, so the start of a file can be read without decompressing all of
+ * it. A growing buffer is used when the decompressed size is not known exactly: the decompressors write straight into
+ * it and ask for more room when they run out, and the data written so far is moved to a larger buffer.
+ */
+class DecompressBuffer
+{
+public:
+	DecompressBuffer( byte *pData, size_t size );		///< Fixed buffer owned by the caller
+	explicit DecompressBuffer( size_t initialSize );	///< Growing buffer
+	~DecompressBuffer( void );
+
+	byte *				GetData( void ) const { return m_pData; }
+	size_t				GetSize( void ) const { return m_size; }
+	char *				Release( void );				///< Hands the growing buffer over to the caller, who frees it with delete[]
+
+	/**
+	 * Makes the buffer at least minSize bytes, keeping the data in it
+	 * @return						false if the buffer is fixed or can't be that large
+	 */
+	bool				Grow( size_t minSize );
+
+private:
+	DecompressBuffer( const DecompressBuffer & );
+	DecompressBuffer &operator=( const DecompressBuffer & );
+
+	byte *				m_pData;
+	size_t				m_size;
+	bool				m_bGrowing;
+};
+
+/**
+ * Detects the compression of a file from its magic bytes
+ */
+CompressionFormat GetCompressionFormat( const byte *pData, size_t size );
+
+/**
+ * Gets the decompressed size from the file if the format stores it (0 if unknown)
+ * The size is a hint for the output buffer, the decompressors still check the real size.
+ */
+size_t GetDecompressedSizeHint( CompressionFormat format, const byte *pData, size_t size );
+
+/**
+ * Decompresses all of the data into the output buffer
+ * @param outWritten			set to the # of bytes written to the output buffer
+ */
+DecompressResult DecompressData( CompressionFormat format, const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten );
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "Dedup.h"
+#include <fstream>
+#include <map>
+#include <string.h>
+
+// Duplicate demos
+//
+// Every demo gets a fingerprint from its size and a hash of the header and a few sampled chunks, which only needs a
+// few small reads per file. Only demos with the same fingerprint are compared byte for byte, so a hash collision can't
+// make a different demo get the frags of another one.
+
+#define FNV64_OFFSET_BASIS		14695981039346656037ull
+#define FNV64_PRIME				1099511628211ull
+
+// =====================================================================================================================================================================
+
+static uint64 HashBytes( uint64 hash, const char *data, size_t size )
+{
+	for( size_t i = 0; i < size; ++i )
+		hash = (hash ^ (byte)data[ i ]) * FNV64_PRIME;
+
+	return hash;
+}
+
+// =====================================================================================================================================================================
+
+bool DemoFingerprint_t::operator<( const DemoFingerprint_t &other ) const
+{
+	if( fileSize != other.fileSize )
+		return fileSize < other.fileSize;
+
+	return sampleHash < other.sampleHash;
+}
+
+// =====================================================================================================================================================================
+
+static bool GetDemoFingerprint( const std::string &filename, DemoFingerprint_t &fingerprint )
+{
+	std::ifstream file( filename, std::ios::binary );
+
+	if( !file.is_open() )
+		return false;
+
+	file.seekg( 0, std::ios_base::end );
+	fingerprint.fileSize = file.tellg();
+
+	if( fingerprint.fileSize <= 0 )
+		return false;
+
+	fingerprint.sampleHash = FNV64_OFFSET_BASIS;
+
+	// The first sample starts at the beginning of the file, so it always covers the demo header
+	char sample[ DEDUP_SAMPLE_SIZE ];
+	const int64 sampleSize = ( fingerprint.fileSize < DEDUP_SAMPLE_SIZE )? fingerprint.fileSize : DEDUP_SAMPLE_SIZE;
+	const int64 lastSampleOffset = fingerprint.fileSize - sampleSize;
+
+	for( int i = 0; i < DEDUP_NUM_SAMPLES; ++i )
+	{
+		const int64 offset = lastSampleOffset * i / (DEDUP_NUM_SAMPLES - 1);
+
+		file.seekg( offset, std::ios_base::beg );
+
+		if( !file.read( sample, sampleSize ) )
+			return false;
+
+		fingerprint.sampleHash = HashBytes( fingerprint.sampleHash, sample, (size_t)sampleSize );
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+/**
+ * @return						true if both files could be read and have the same contents
+ */
+static bool FilesAreEqual( const std::string &filename1, const std::string &filename2 )
+{
+	std::ifstream file1( filename1, std::ios::binary );
+	std::ifstream file2( filename2, std::ios::binary );
+
+	if( !file1.is_open() || !file2.is_open() )
+		return false;
+
+	std::vector< char > buffer1( DEDUP_READ_SIZE );
+	std::vector< char > buffer2( DEDUP_READ_SIZE );
+
+	for( ;; )
+	{
+		file1.read( buffer1.data(), buffer1.size() );
+		file2.read( buffer2.data(), buffer2.size() );
+
+		const std::streamsize size = file1.gcount();
+
+		if( size != file2.gcount() || memcmp( buffer1.data(), buffer2.data(), (size_t)size ) )
+			return false;
+
+		if( !size )
+			return file1.eof() && file2.eof();
+	}
+}
+
+// =====================================================================================================================================================================
+
+int FindDuplicateDemos( const std::vector< std::string > &demos, std::vector< int > &duplicateOf )
+{
+	duplicateOf.assign( demos.size(), -1 );
+
+	// Group the demos by fingerprint (in order, so the first copy comes first)
+	std::map< DemoFingerprint_t, std::vector< int > > groups;
+
+	for( size_t i = 0; i < demos.size(); ++i )
+	{
+		DemoFingerprint_t fingerprint;
+
+		// Demos that can't be read are left for the parser to report
+		if( GetDemoFingerprint( demos[ i ], fingerprint ) )
+			groups[ fingerprint ].push_back( (int)i );
+	}
+
+	int numDuplicates = 0;
+
+	for( auto it = groups.begin(); it != groups.end(); ++it )
+	{
+		const std::vector< int > &group = it->second;
+
+		if( group.size() < 2 )
+			continue;
+
+		// Same fingerprint, so compare the whole files with the first copy of every different demo of the group so far
+		std::vector< int > firstCopies;
+
+		for( size_t i = 0; i < group.size(); ++i )
+		{
+			size_t first = 0;
+
+			while( first < firstCopies.size() && !FilesAreEqual( demos[ firstCopies[ first ] ], demos[ group[ i ] ] ) )
+				++first;
+
+			if( first == firstCopies.size() )
+			{
+				firstCopies.push_back( group[ i ] );
+			}
+			else
+			{
+				duplicateOf[ group[ i ] ] = firstCopies[ first ];
+				++numDuplicates;
+			}
+		}
+	}
+
+	return numDuplicates;
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
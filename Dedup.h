@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Common.h"
+#include <string>
+#include <vector>
+
+#define DEDUP_NUM_SAMPLES		8				// How many chunks are hashed from each demo for the fingerprint
+#define DEDUP_SAMPLE_SIZE		(16 * 1024)		// Size of a sampled chunk
+#define DEDUP_READ_SIZE			(1024 * 1024)	// Read size when whole files have to be compared
+
+/**
+ * Cheap fingerprint of a demo file
+ * Identical files always have the same fingerprint, different files only rarely
+ */
+struct DemoFingerprint_t
+{
+	int64			fileSize;
+	uint64			sampleHash;			///< Hash of the header and chunks sampled evenly across the file
+
+	bool operator<( const DemoFingerprint_t &other ) const;
+};
+
+/**
+ * Finds demos that are byte for byte copies of an earlier demo in the list
+ * @param demos					paths of the demos
+ * @param duplicateOf			set to the index of the first copy for every duplicate, and -1 for the rest
+ * @return						number of duplicates found
+ */
+int FindDuplicateDemos( const std::vector< std::string > &demos, std::vector< int > &duplicateOf );
\ No newline at end of file
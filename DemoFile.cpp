@@ -1,21 +1,54 @@
 #include "DemoFile.h"
+#include "Archive.h"
+#include "Gzip.h"
 #include "Settings.h"
 #include <fstream>
+#include <format>
 #include <assert.h>
 
 DemoFile::DemoFile( const std::string &filename )
 {
+	m_filepath = filename;
 	m_filename = filename;
-	RemoveFileNameFolders( m_filename );
+	m_filebuffer = nullptr;
+	m_filesize = 0;
+	m_pMappedView = nullptr;
 
+	std::string archive, member;
+
+	if( SplitArchiveMemberPath( filename, archive, member ) )
+	{
+		// Members are named by their own file name, folders inside the archive use '/'
+		m_filename = member;
+		size_t slash = m_filename.find_last_of( "/\\" );
+		if( slash != std::string::npos )
+			m_filename.erase( 0, slash + 1 );
+
+		if( !ReadArchiveMember( archive, member ) )
+			return;
+	}
+	else
+	{
+		RemoveFileNameFolders( m_filename );
+
+		if( !ReadFile( filename ) )
+			return;
+	}
+
+	if( !Decompress() )
+		return;
+
+	CheckValidity();
+}
+
+bool DemoFile::ReadFile( const std::string &filename )
+{
 	std::ifstream file( filename, std::ios::binary );
 
 	if( !file.is_open() )
 	{
-		m_filebuffer = nullptr;
-		m_filesize = 0;
 		m_error = COULD_NOT_OPEN_FILE;
-		return;
+		return false;
 	}
 
 	file.seekg( 0, std::ios_base::end );
@@ -28,11 +61,9 @@ DemoFile::DemoFile( const std::string &filename )
 	}
 	else
 	{
-		m_filebuffer = nullptr;
-		m_filesize = 0;
 		m_error = FILE_TOO_SMALL;
 		file.close();
-		return;
+		return false;
 	}
 
 	file.read( m_filebuffer, size );
@@ -41,56 +72,186 @@ DemoFile::DemoFile( const std::string &filename )
 
 	m_filesize = (uint32)size;
 
-	CheckValidity();
+	return true;
 }
 
-void DemoFile::CheckValidity( void )
+/**
+ * Maps the member's range of the archive into memory
+ * Stored members are used from the mapping as is, deflated members are decompressed from it into a new buffer.
+ */
+bool DemoFile::ReadArchiveMember( const std::string &archive, const std::string &member )
 {
-	if( !m_filebuffer )
+	ArchiveMember_t info;
+
+	if( !FindArchiveMember( archive, member, info ) )
 	{
-		m_error = COULD_NOT_OPEN_FILE;
-		return;
+		m_error = ARCHIVE_READ_FAILED;
+		return false;
 	}
 
-	if( m_filesize < sizeof( demoheader_t ) )
+	if( info.compression == ARCHIVE_UNSUPPORTED )
+	{
+		m_error = UNSUPPORTED_COMPRESSION;
+		return false;
+	}
+
+	if( !info.size )
 	{
 		m_error = FILE_TOO_SMALL;
-		return;
+		return false;
 	}
 
-	demoheader_t *hdr = (demoheader_t *)m_filebuffer;
+	// Demos over 4 GB can't be parsed anyway
+	if( info.size > 0xFFFFFFFF || info.compressedSize > 0xFFFFFFFF )
+	{
+		m_error = ARCHIVE_READ_FAILED;
+		return false;
+	}
 
-	if( strcmp( hdr->demofilestamp, DEMO_HEADER_ID ) )
+	m_pMappedView = new MappedFileView;
+
+	if( !m_pMappedView->Map( archive, info.offset, (size_t)info.compressedSize ) )
 	{
-		m_error = INVALID_HDR_ID;
-		return;
+		FreeBuffer();
+		m_error = ARCHIVE_READ_FAILED;
+		return false;
 	}
 
-	if( hdr->demoprotocol != DEMO_PROTOCOL )
+	if( info.compression == ARCHIVE_STORED )
 	{
-		m_error = INVALID_DEM_PROTOCOL;
-		return;
+		// The bit reader needs dword aligned data, tar members always are but zip members can start anywhere
+		if( !( (uintptr_t)m_pMappedView->GetData() & 3 ) )
+		{
+			m_filebuffer = (char *)m_pMappedView->GetData();
+			m_filesize = (uint32)info.size;
+			return true;
+		}
+
+		char *pDemo = new char[ (uint32)info.size ];
+		memcpy( pDemo, m_pMappedView->GetData(), (size_t)info.size );
+
+		FreeBuffer();
+		m_filebuffer = pDemo;
+		m_filesize = (uint32)info.size;
+		return true;
 	}
 
-	if( strcmp( hdr->gamedirectory, CSS_GAMEDIR ) )
+	if( info.size / GZIP_MAX_RATIO > info.compressedSize )
 	{
-		m_error = INVALID_GAMEDIR;
+		FreeBuffer();
+		m_error = DECOMPRESSION_FAILED;
+		return false;
+	}
+
+	char *pDemo = new char[ (uint32)info.size ];
+	DecompressBuffer demo( (byte *)pDemo, (size_t)info.size );
+	size_t written;
+
+	DecompressResult result = DeflateDecompress( m_pMappedView->GetData(), (size_t)info.compressedSize, demo, written );
+
+	FreeBuffer();
+	m_filebuffer = pDemo;
+	m_filesize = (uint32)info.size;
+
+	if( result != DECOMPRESS_DONE || written != info.size )
+	{
+		m_error = DECOMPRESSION_FAILED;
+		return false;
+	}
+
+	return true;
+}
+
+void DemoFile::FreeBuffer( void )
+{
+	if( m_pMappedView )
+	{
+		// The buffer is inside the view
+		delete m_pMappedView;
+		m_pMappedView = nullptr;
+	}
+	else if( m_filebuffer )
+	{
+		delete[] m_filebuffer;
+	}
+
+	m_filebuffer = nullptr;
+	m_filesize = 0;
+}
+
+/**
+ * Replaces the file contents with the decompressed demo if the file is compressed (gzip, zstd or bzip2)
+ * @return						false if the demo could not be decompressed
+ */
+bool DemoFile::Decompress( void )
+{
+	const byte *pData = (const byte *)m_filebuffer;
+	const CompressionFormat format = GetCompressionFormat( pData, m_filesize );
+
+	if( format == COMPRESSION_NONE )
+		return true;
+
+	// Start from the size in the file if the format has it, the buffer grows if the demo is larger
+	size_t size = GetDecompressedSizeHint( format, pData, m_filesize );
+
+	if( !size )
+		size = (size_t)m_filesize * DECOMPRESS_GUESS_RATIO;
+
+	DecompressBuffer demo( size );
+	size_t written;
+
+	DecompressResult result = DecompressData( format, pData, m_filesize, demo, written );
+
+	FreeBuffer();
+	m_filebuffer = demo.Release();
+	m_filesize = (uint32)written;
+
+	if( result != DECOMPRESS_DONE || written < sizeof( demoheader_t ) )
+	{
+		m_error = DECOMPRESSION_FAILED;
+		return false;
+	}
+
+	return true;
+}
+
+void DemoFile::CheckValidity( void )
+{
+	if( !m_filebuffer )
+	{
+		m_error = COULD_NOT_OPEN_FILE;
 		return;
 	}
 
-	if( hdr->networkprotocol != NETWORK_PROTOCOL_V34 )
+	if( m_filesize < sizeof( demoheader_t ) )
 	{
-		m_error = INVALID_NET_PROTOCOL;
+		m_error = FILE_TOO_SMALL;
 		return;
 	}
 
-	m_error = DEMO_OK;
+	m_error = CheckHeader( *(demoheader_t *)m_filebuffer );
+}
+
+DemoError DemoFile::CheckHeader( const demoheader_t &hdr )
+{
+	if( strcmp( hdr.demofilestamp, DEMO_HEADER_ID ) )
+		return INVALID_HDR_ID;
+
+	if( hdr.demoprotocol != DEMO_PROTOCOL )
+		return INVALID_DEM_PROTOCOL;
+
+	if( strcmp( hdr.gamedirectory, CSS_GAMEDIR ) )
+		return INVALID_GAMEDIR;
+
+	if( hdr.networkprotocol != NETWORK_PROTOCOL_V34 )
+		return INVALID_NET_PROTOCOL;
+
+	return DEMO_OK;
 }
 
 DemoFile::~DemoFile( void )
 {
-	if( m_filebuffer )
-		delete[] m_filebuffer;
+	FreeBuffer();
 }
 
 bool DemoFile::IsValidDemo( void ) const
@@ -103,6 +264,50 @@ DemoError DemoFile::GetError( void ) const
 	return m_error;
 }
 
+std::string DemoFile::GetErrorString( void ) const
+{
+	const demoheader_t *hdr = (const demoheader_t *)m_filebuffer;
+
+	switch( m_error )
+	{
+		case DEMO_OK:
+			return "";
+
+		case COULD_NOT_OPEN_FILE:
+		default:
+			return std::format( "failed to open file \"{}\"", m_filename );
+
+		case FILE_TOO_SMALL:
+			return "file too small";
+
+		case INVALID_HDR_ID:
+			return "invalid demo header ID";
+
+		case DECOMPRESSION_FAILED:
+			return "compressed demo is corrupt or truncated";
+
+		case UNSUPPORTED_COMPRESSION:
+			return "unsupported compression - only deflate and stored zip members are supported";
+
+		case ARCHIVE_READ_FAILED:
+			return "failed to read the demo from the archive";
+
+		case INVALID_DEM_PROTOCOL:
+			return std::format( "demo protocol {} is invalid - expected {}", hdr->demoprotocol, DEMO_PROTOCOL );
+
+		case INVALID_GAMEDIR:
+			return std::format( "game directory \"{}\" is invalid - expected \"{}\"", hdr->gamedirectory, CSS_GAMEDIR );
+
+		case INVALID_NET_PROTOCOL:
+		{
+			if( hdr->networkprotocol >= NETWORK_PROTOCOL_NEW_MIN && hdr->networkprotocol <= NETWORK_PROTOCOL_NEW_MAX )
+				return std::format( "CS:S v77{} demo - currently unsupported", hdr->networkprotocol == NETWORK_PROTOCOL_NEW_MAX ? " or Steam CS:S" : "" );
+
+			return std::format( "network protocol {} is invalid - expected {}", hdr->networkprotocol, NETWORK_PROTOCOL_V34 );
+		}
+	}
+}
+
 char *DemoFile::GetBuffer( void ) const
 {
 	return m_filebuffer;
@@ -113,6 +318,11 @@ std::string DemoFile::GetFileName( void ) const
 	return m_filename;
 }
 
+std::string DemoFile::GetFilePath( void ) const
+{
+	return m_filepath;
+}
+
 uint32 DemoFile::GetFileSize( void ) const
 {
 	return m_filesize;
@@ -66,8 +66,13 @@ enum DemoError
 	INVALID_DEM_PROTOCOL,
 	INVALID_NET_PROTOCOL,
 	INVALID_GAMEDIR,
+	DECOMPRESSION_FAILED,
+	UNSUPPORTED_COMPRESSION,
+	ARCHIVE_READ_FAILED,
 };
 
+class MappedFileView;
+
 /**
  * Holds the raw data of a demo file
  */
@@ -79,20 +84,30 @@ public:
 
 	bool				IsValidDemo( void ) const;	///< Is this demo a valid CS:S v34 demo
 	DemoError			GetError( void ) const;		///< Get the error ID if the demo is invalid
+	std::string			GetErrorString( void ) const;	///< Get a description of the error if the demo is invalid
 	char *				GetBuffer( void ) const;	///< Get the raw contents of the demo
 	std::string			GetFileName( void ) const;	///< Get the file name without folders
+	std::string			GetFilePath( void ) const;	///< Get the file name as it was given (with folders)
 	uint32				GetFileSize( void ) const;	///< Get the file size in bytes
 
+	static DemoError	CheckHeader( const demoheader_t &hdr );	///< Check if the header is from a CS:S v34 demo
+
 private:
 	// No copying allowed due to dynamic memory
 	DemoFile( const DemoFile & );
 	DemoFile &operator=( const DemoFile & );
 
+	bool				ReadFile( const std::string &filename );
+	bool				ReadArchiveMember( const std::string &archive, const std::string &member );
 	void				CheckValidity( void );
+	bool				Decompress( void );
+	void				FreeBuffer( void );
 
 	DemoError			m_error;
 
 	char *				m_filebuffer;
+	MappedFileView *	m_pMappedView;		///< Archive mapping that m_filebuffer points into, if the demo is a stored archive member
 	std::string			m_filename;
+	std::string			m_filepath;
 	uint32				m_filesize;
 };
\ No newline at end of file
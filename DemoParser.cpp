@@ -2,19 +2,24 @@
 #include "Errors.h"
 #include "bitbuf.h"
 #include "Settings.h"
-#include <conio.h>
+#include "Progress.h"
 #include <fstream>
 
-DemoParser *gpParser = nullptr;
+thread_local DemoParser *gpParser = nullptr;
 
 extern std::string g_ProgramDirectory;
-extern std::string g_BatchOutput;
 extern std::vector< ParsingWarning_t > g_WarningDemos;
+extern ParsingStats_t g_BatchStats;
 
 DemoParser::DemoParser( DemoFile *pDemo )
+	: m_FragOutput( pDemo )
 {
 	m_pDemo = pDemo;
 
+	m_Frags.resize( Settings()->GetNumProfiles() );
+	m_pFragSink = nullptr;
+	m_pWarnings = nullptr;
+
 	memset( &m_demoHeader, 0, sizeof( demoheader_t ) );
 
 	m_iNumStringTables = 0;
@@ -37,22 +42,53 @@ DemoParser::DemoParser( DemoFile *pDemo )
 	m_iServerClassBits = 0;
 	m_iNumStringTables = 0;
 
+	memset( &m_PropNames, 0, sizeof( m_PropNames ) );
+
 	memset( &m_StringTables, 0, sizeof( m_StringTables ) );
 
-	// Only one parser should exist at any given time, so make this the global parser
+	m_iParseStartTime = 0;
+
+	m_bSubParser = false;
+	m_bStopParsing = false;
+	m_iCommandOffset = 0;
+	m_iSegmentEndOffset = 0;
+	m_pCancelSegments = nullptr;
+	m_bCancelSegments = false;
+
+	m_iFirstRound = -1;
+	m_iLastRound = -1;
+	m_iTargetTick = -1;
+	m_pSeekIndex = nullptr;
+	m_bSaveSeekKeyframe = false;
+	m_pResumeKeyframe = nullptr;
+
+	m_pSlimWriter = nullptr;
+	m_iPlayerEntityUpdates = 0;
+	m_iPlayerEntityBits = 0;
+
+	// Only one parser should exist per thread at any given time, so make this the global parser
+	// (the seek index builder creates a temporary parser on the same thread, so remember the previous one)
+	m_pPrevParser = gpParser;
+	m_pPrevStats = gpStats;
+
 	gpParser = this;
+
+#ifdef CSSFF_ENABLE_STATS
+	gpStats = &m_Stats;
+#endif
 }
 
 // ==================================================================================================================
 
 DemoParser::~DemoParser()
 {
-	gpParser = nullptr;
+	gpParser = m_pPrevParser;
+	gpStats = m_pPrevStats;
 }
 
 // ==================================================================================================================
 /**
- * The main parsing function. Reads all the commands and prints the progress bar.
+ * The main parsing function. Reads all the commands and publishes the progress for the progress sampler.
  */
 bool DemoParser::Parse( void )
 {
@@ -65,32 +101,93 @@ bool DemoParser::Parse( void )
 		printf( "Press 'Q' to abort early\n\n" );
 	}
 
+	m_iParseStartTime = StatsTimestamp();
+
 	bf_read reader( m_pDemo->GetBuffer(), m_pDemo->GetFileSize() );
 
 	// Read the header
 	reader.ReadBytes( &m_demoHeader, sizeof( m_demoHeader ) );
 
-	bool bAborted = false;	// Did the user abort parsing?
-	bool bSynced = false;	// Was sync tick encountered yet?
+	// Start the progress bar
+	Progress()->BeginDemo( m_demoHeader.playback_ticks, m_pDemo->GetFileSize() );
+
+	// The main parser outputs frags as soon as they are found
+	m_pFragSink = &m_FragOutput;
+
+	bool bAborted;	// Did the user abort parsing?
+
+	if( HasParseRange() )
+	{
+		bAborted = !ParseRange( reader );
+	}
+	else if( Settings()->ParseSegmentsInParallel() )
+	{
+		bAborted = !ParseSegments( reader );
+	}
+	else
+	{
+		// Build the seek index on the way if the demo doesn't have one yet
+		SeekIndex seekIndex;
+
+		if( Settings()->WriteSeekIndex() && !seekIndex.Load( *m_pDemo ) )
+			m_pSeekIndex = &seekIndex;
+
+		bAborted = !( Settings()->ParsePipelined()? ParsePipelined( reader ) : ParseCommands( reader ) );
+
+		if( m_pSeekIndex && !bAborted )
+			seekIndex.Save( *m_pDemo );
+
+		m_pSeekIndex = nullptr;
+	}
+
+	// Print the ending for the progress bar
+	Progress()->EndDemo( bAborted );
+
+	const double mb_per_sec = Progress()->GetDemoMBPerSecond();
+	const double ticks_per_sec = Progress()->GetDemoTicksPerSecond();
+
+	if( Settings()->BatchProcessingEnabled() )
+	{
+		if( bAborted )
+			printf( " Parsing aborted by user" );
+		else
+			printf( " Successfully parsed [%.1f MB/s, %.0f ticks/s]", mb_per_sec, ticks_per_sec );
+	}
+	else
+	{
+		if( bAborted )
+			printf( "Parsing aborted by user!\n\tNot all frags have necessarily been found.\n\n" );
+		else
+			printf( "Done parsing! [%.1f MB/s, %.0f ticks/s]\n\n", mb_per_sec, ticks_per_sec );
+	}
 
-	// Set up the progress bar
-	const int numProgressDots = Settings()->BatchProcessingEnabled()? 5 : 10;
-	const int printProgressTicks = (m_demoHeader.playback_ticks > 0)? (m_demoHeader.playback_ticks / numProgressDots) : (250000 / numProgressDots);
-	int lastTick = 0;
-	int progressTick = 0;
-	int numPrinted = 0;
+	// Do post-parsing stuff
+	DemoParser::OnParsingEnd();
 
+	return !bAborted;
+}
 
-	// ===== The main parsing loop ===========================================================================
+// ==================================================================================================================
+/**
+ * The main parsing loop. Reads commands until dem_stop, or until a segment parser reaches the end of its segment.
+ * @return						false if parsing was aborted
+ */
+bool DemoParser::ParseCommands( bf_read &reader )
+{
+	bool bSynced = false;	// Was sync tick encountered yet?
 
 	while( true )
 	{
+		m_iCommandOffset = reader.GetNumBytesRead();
+
 		// Read command type
 		byte cmd = reader.ReadByte();
 
 		if( cmd < dem_firstcmd || cmd > dem_lastcmd || reader.IsOverflowed() )
 			throw ParsingError_t( "invalid cmd number" );
 
+		STATS_ADD( commands[ cmd ], 1 );
+
 		// Done parsing?
 		if( cmd == dem_stop )
 			break;
@@ -98,19 +195,6 @@ bool DemoParser::Parse( void )
 		// Read current tick
 		m_iCurrentTick = reader.ReadLong();
 
-		// Print dots for the progress bar
-		if( bSynced )
-		{
-			progressTick += m_iCurrentTick - lastTick;
-			lastTick = m_iCurrentTick;
-			if( progressTick >= printProgressTicks )
-			{
-				printf( "." );
-				++numPrinted;
-				progressTick = 0;
-			}
-		}
-
 		// Handle the command
 		switch( cmd )
 		{
@@ -121,7 +205,17 @@ bool DemoParser::Parse( void )
 					throw ParsingError_t( "SVC_ServerInfo not encountered by sync tick" );
 				}
 
+				STATS_PHASE_SINCE( PHASE_SIGNON, m_iParseStartTime );
+
 				bSynced = true;
+
+				// Segment and range parsers only need the signon from the beginning, then they jump to their keyframe
+				if( m_pResumeKeyframe )
+				{
+					RestoreSeekKeyframe( *m_pResumeKeyframe );
+					reader.Seek( BYTES2BITS( m_pResumeKeyframe->offset ) );
+					m_pResumeKeyframe = nullptr;
+				}
 				break;
 			}
 
@@ -147,9 +241,9 @@ bool DemoParser::Parse( void )
 			{
 				// Fork the reader
 				size_t datasize = reader.ReadLong();
-				char *data = new char[ datasize ];
-				reader.ReadBytes( data, datasize );
-				bf_read forkedReader( data, datasize );
+				std::vector< char > data( datasize );
+				reader.ReadBytes( data.data(), datasize );
+				bf_read forkedReader( data.data(), datasize );
 
 				ParseDataTables( forkedReader );
 				break;
@@ -164,47 +258,36 @@ bool DemoParser::Parse( void )
 			}
 		}
 
-		// Check if the user wants to abort parsing
-		if( _kbhit() )
-		{
-			int ch = toupper( _getch() );
+		STATS_SET( bytes_processed, reader.GetNumBytesRead() );
 
-			if( ch == 'Q' )
-			{
-				bAborted = true;
-				break;
-			}
+		if( m_pSlimWriter )
+			SlimCommand( cmd, reader );
+
+		// Round start was in this command, the next one is where a range parser can resume
+		if( m_bSaveSeekKeyframe )
+		{
+			m_bSaveSeekKeyframe = false;
+			SaveSeekKeyframe( reader.GetNumBytesRead() );
 		}
-	}
 
-	// Print the ending for the progress bar
-	const int numMinPrints = bAborted? 3 : numProgressDots;
+		// Segment or range parser reached the end of its rounds
+		if( m_bStopParsing )
+			break;
 
-	if( numPrinted < numMinPrints )
-	{
-		for( int i = 0; i < numMinPrints - numPrinted; ++i )
-			printf( "." );
-	}
+		// Publish the progress only after sync tick, the sampler thread prints it
+		if( bSynced && !m_bSubParser )
+			Progress()->Update( m_iCurrentTick, reader.GetNumBytesRead() );
 
-	if( Settings()->BatchProcessingEnabled() )
-	{
-		if( bAborted )
-			printf( " Parsing aborted by user" );
-		else
-			printf( " Successfully parsed" );
-	}
-	else
-	{
-		if( bAborted )
-			printf( "Parsing aborted by user!\n\tNot all frags have necessarily been found.\n\n" );
-		else
-			printf( "Done parsing!\n\n" );
-	}
+		// Check if the user wants to abort parsing (the sampler thread polls the keyboard)
+		if( Progress()->AbortRequested() )
+			return false;
 
-	// Do post-parsing stuff
-	DemoParser::OnParsingEnd();
+		// Another segment failed, so the rest of the demo is not needed
+		if( m_pCancelSegments && m_pCancelSegments->load( std::memory_order_relaxed ) )
+			return false;
+	}
 
-	return !bAborted;
+	return true;
 }
 
 // ==================================================================================================================
@@ -249,8 +332,16 @@ int DemoParser::GetTickRate( void ) const
  */
 void DemoParser::OnParsingEnd( void )
 {
+	// Segment parsers only collect the frags, the main parser outputs them after merging
+	if( m_bSubParser )
+	{
+		OnSegmentEnd();
+		return;
+	}
+
 	// Check for frags again in case the demo ended mid-round
-	FindRoundFrags();
+	if( !m_bStopParsing )
+		FindRoundFrags();
 
 	if( !Settings()->BatchProcessingEnabled() )
 	{
@@ -272,73 +363,33 @@ void DemoParser::OnParsingEnd( void )
 		}
 	}
 
-	if( m_Frags.size() > 0 )
-	{
-		if( Settings()->BatchProcessingEnabled() )
-		{
-			printf( " (%d frag%s found)\n", m_Frags.size(), m_Frags.size() > 1? "s":"" );
-			g_BatchOutput += "========== " + m_pDemo->GetFileName() + ( m_bIsPOV ? " (POV)" : " (STV)" ) + " ==========\n\n";
-		}
-
-		std::ofstream file_output;
-		std::string filename;
+	// Print the frags and close the output files
+	m_FragOutput.Finish();
 
-		if( Settings()->DumpToFileEnabled() && !Settings()->BatchProcessingEnabled() )
-		{
-			filename = m_pDemo->GetFileName();
-			RemoveFileExtension( filename );
-			filename += ".txt";
+#ifdef CSSFF_ENABLE_STATS
+	WriteStats();
+#endif
+}
 
-			if( Settings()->WriteOutputToDemoDirectory() )
-			{
-				file_output.open( filename );
-			}
-			else
-			{
-				file_output.open( g_ProgramDirectory + filename );
-			}
-		}
+// ==================================================================================================================
+/**
+ * Writes the timings and counters of this demo into "<demo>_stats.txt" and adds them to the batch stats
+ */
+void DemoParser::WriteStats( void )
+{
+	m_Stats.total_ns = StatsTimestamp() - m_iParseStartTime;
+	m_Stats.demos = 1;
 
-		if( !Settings()->BatchProcessingEnabled() )
-			printf( "\n========== FOUND FRAGS ==========\n\n" );
+	g_BatchStats.Accumulate( m_Stats );
 
-		for( uint32 i = 0; i < m_Frags.size(); ++i )
-		{
-			char szFragDescription[ 1024 ];
-			m_Frags[ i ].GetStringRepresentation( szFragDescription, sizeof(szFragDescription) );
+	std::string filename = m_pDemo->GetFileName();
+	RemoveDemoExtension( filename );
+	filename += "_stats.txt";
 
-			if( !Settings()->BatchProcessingEnabled() )
-			{
-				printf( szFragDescription );
+	if( !Settings()->WriteOutputToDemoDirectory() )
+		filename = g_ProgramDirectory + filename;
 
-				if( Settings()->DumpToFileEnabled() && file_output.is_open() )
-					file_output.write( szFragDescription, strlen( szFragDescription ) );
-			}
-			else
-			{
-				g_BatchOutput += szFragDescription;
-			}
-		}
-
-		if( Settings()->DumpToFileEnabled() && !Settings()->BatchProcessingEnabled() && file_output.is_open() )
-		{
-			if( !Settings()->BatchProcessingEnabled() )
-				printf( "Output has been written to file %s in %s folder\n\n", filename.c_str(), Settings()->WriteOutputToDemoDirectory()? "demo's" : "program" );
-
-			file_output.close();
-		}
-	}
-	else
-	{
-		if( Settings()->BatchProcessingEnabled() )
-		{
-			printf( " (no frags found)\n" );
-		}
-		else
-		{
-			printf( "\nNo frags found with the current settings.\n\n" );
-		}
-	}
+	m_Stats.WriteToFile( filename, std::string( CSSFF_NAME ) + " parsing stats for " + m_pDemo->GetFileName() );
 }
 
 // ==================================================================================================================
\ No newline at end of file
@@ -2,11 +2,20 @@
 
 #include "GameEvents.h"
 #include "DemoFile.h"
+#include "Errors.h"
 #include "Frag.h"
+#include "FragOutput.h"
 #include "Player.h"
 #include "StringTables.h"
 #include "DataTables.h"
+#include "Stats.h"
+#include "Segments.h"
+#include "SeekIndex.h"
+#include "Pipeline.h"
+#include "Bench.h"
+#include "Slim.h"
 #include "bitbuf.h"
+#include <atomic>
 
 /**
  * Parses the raw data of a demo file
@@ -25,14 +34,33 @@ public:
 	int GetTickRate( void ) const;					///< Get the # of ticks per second
 	void OnParsingEnd( void );						///< Called when demo is successfully parsed or a parsing error is thrown
 
+	bool IsSubParser( void ) const;					///< Is this a segment parser or another helper parser instead of the main parser
+	std::vector< ParsingWarning_t > *GetWarnings( void ) const;	///< Where the warnings of this demo go (nullptr for the batch warning list)
+
+	void SetParseRange( int firstRound, int lastRound, int tick );	///< Only parse the given rounds, or the round containing the tick
+	void KeepOutput( KeptOutput_t *pKept );			///< Keep a copy of the batch output for copies of this demo
+
+	static bool ParseRequest( DemoFile *pDemo, FragSink *pSink, std::vector< ParsingWarning_t > &warnings );	///< Parses a demo for the daemon mode, without any console or file output
+	static void ParseBenchmark( DemoFile *pDemo, FragSink *pSink, BenchRunResult_t &result );	///< Parses a demo once for the benchmark mode, the way it is parsed normally
+	static bool ExportSlim( DemoFile *pDemo, const std::string &filename, FragSink *pSink );	///< Parses a demo and writes a copy with only the data the parser uses
+
 private:
+	bool ParseCommands( bf_read &reader );			///< The main parsing loop
+
 	// ===== Frags =================================================================================================
-	void FindRoundFrags( void );					///< Finds all the frags from the current round (called at round start)
+	void FindRoundFrags( void );					///< Finds all the frags from the current round for every settings profile (called at round start)
+	void FindPlayerRoundFrags( const Player &player, const round_kills_t &round_kills, int profile );
+	void ClearFrags( void );
+	void EmitFrag( const Frag &frag, int profile );	///< Hands a final frag to the frag sink, or keeps it if there is no sink
 
-	FragVector m_Frags;								///< Holds all the frags found on the demo being parsed
+	std::vector< FragVector > m_Frags;				///< Frags kept by segment parsers until the main parser merges them, per settings profile
+	FragOutput			m_FragOutput;				///< Outputs the frags of the main parser
+	FragSink *			m_pFragSink;				///< Where the frags go as soon as they are found (nullptr to keep them in m_Frags)
+	std::vector< ParsingWarning_t > *m_pWarnings;	///< Warnings of a daemon request, which are returned with its response instead of being kept for the batch
 
 	// ===== Net messages ==========================================================================================
 	void HandleDemoPacket( bf_read &reader );
+	void HandleNetMessage( bf_read &reader, int msg );	///< Decodes one NET/SVC message of a packet
 	void HandleNETDisconnect( bf_read &reader );
 	void HandleNETFile( bf_read &reader );
 	void HandleNETTick( bf_read &reader );
@@ -66,7 +94,7 @@ private:
 
 	// ===== String tables =========================================================================================
 	void CreateStringTable( const char *name, int max_entries, int user_data_size, int user_data_size_bits, bool user_data_fixed_size );
-	void ParseStringTableUpdate( bf_read &reader, int entries, int max_entries, int user_data_size, int user_data_size_bits, bool user_data_fixed_size, bool is_user_info );
+	void ParseUserInfoUpdate( bf_read &reader, int entries, const StringTableData_t &table );
 	const StringTableData_t *GetStringTableData( uint32 tableID );
 
 	uint32				m_iNumStringTables;
@@ -86,7 +114,19 @@ private:
 	int					m_iServerClassBits;				///< # of bits used to encode server class IDs
 	ServerClassVector	m_ServerClasses;
 	SendTableVector		m_DataTables;
-	ExcludeEntryVector	m_currentExcludes;
+	SendTableIndex		m_DataTableIndex;				///< Pooled table name -> index in m_DataTables
+	ExcludeEntrySet		m_currentExcludes;
+	StringPool			m_StringPool;					///< Table, class and prop names of this demo
+
+	// Pooled names of the props that are handled while decoding player entities
+	struct
+	{
+		const char *	eyeAngles0;
+		const char *	eyeAngles1;
+		const char *	flashDuration;
+		const char *	flags;
+		const char *	origin;
+	}					m_PropNames;
 
 
 	// ===== Entities ==============================================================================================
@@ -125,6 +165,62 @@ private:
 	void HandleRoundStartEvent( bf_read &reader, const GameEvent &event );
 
 
+	// ===== Stats =================================================================================================
+	void WriteStats( void );							///< Writes the stats of this demo to file and adds them to the batch stats
+
+	int64				m_iParseStartTime;				///< Timestamp in nanoseconds when parsing started
+	ParsingStats_t		m_Stats;						///< Timings and counters of this demo (only collected with CSSFF_ENABLE_STATS)
+
+
+	// ===== Segments ==============================================================================================
+	bool ParseSegments( bf_read &reader );			///< Parses the demo in segments on multiple threads if it has a seek index
+	void OnSegmentRoundStart( void );				///< Checks if a segment or range parser ends its rounds on this round start
+	void OnSegmentEnd( void );						///< OnParsingEnd for segment parsers
+	void ParseSegment( SegmentResult_t &result );	///< Entry point of a segment parser
+
+	static void SegmentThread( DemoFile *pDemo, const SeekKeyframe_t *pKeyframe, uint32 endOffset, const std::atomic< bool > *pCancel, SegmentResult_t *pResult );
+
+	bool				m_bSubParser;					///< Segment, seek index, benchmark or slim export parser (no output, no progress)
+	bool				m_bStopParsing;					///< Segment or range parser reached the end of its rounds
+	uint32				m_iCommandOffset;				///< Byte offset of the demo command being parsed
+	uint32				m_iSegmentEndOffset;			///< Stop parsing after the round start at this command offset (0 to parse until the end)
+	const std::atomic< bool > *m_pCancelSegments;		///< Set by the main parser if the results of this segment are no longer needed
+	std::atomic< bool >	m_bCancelSegments;				///< The cancel flag of this parser's segment parsers
+
+	// ===== Seek index ============================================================================================
+	bool HasParseRange( void ) const;
+	bool ParseRange( bf_read &reader );				///< Parses only the requested rounds using the seek index
+	bool BuildSeekIndex( SeekIndex &index );		///< Parses the whole demo on a sub parser to collect the keyframes
+	void SaveSeekKeyframe( uint32 offset );
+	void SaveSeekPropValue( std::string &state, const Prop_t &prop );
+	void RestoreSeekKeyframe( const SeekKeyframe_t &keyframe );
+	void RestoreSeekPropValue( SeekStateReader &state, Prop_t &prop );
+
+	int					m_iFirstRound;					///< First round to parse (-1 to parse the whole demo)
+	int					m_iLastRound;					///< Last round to parse
+	int					m_iTargetTick;					///< Parse the round containing this tick (-1 if not used)
+	SeekIndex *			m_pSeekIndex;					///< Where keyframes are saved at round starts (nullptr if the index is not built)
+	bool				m_bSaveSeekKeyframe;			///< Round start was encountered, save a keyframe after the current command
+	const SeekKeyframe_t *m_pResumeKeyframe;			///< Keyframe the segment or range parser jumps to after the signon
+
+	// ===== Pipeline ==============================================================================================
+	bool ParsePipelined( bf_read &reader );			///< ParseCommands with the packets framed on a separate thread
+	bool DecodeFrames( FrameQueue &queue );			///< Parser side of the pipeline
+	void DecodePacket( const DemoFrame_t &frame );
+
+	// ===== Slim export ===========================================================================================
+	void SlimCommand( byte cmd, bf_read &reader );	///< Writes the command that was just parsed to the slim copy
+	void SlimMessage( int msg, bf_read &packetReader, int startBit );	///< Adds the message that was just parsed to the slim copy of the packet
+
+	SlimDemoWriter *	m_pSlimWriter;					///< Where the slim copy is written (nullptr if not exporting)
+	int					m_iPlayerEntityUpdates;			///< # of entity updates in the last SVC_PacketEntities up to the last player
+	int					m_iPlayerEntityBits;			///< Bits of entity data those updates take
+
+
+	DemoParser *		m_pPrevParser;					///< The global parser before this one was created
+	ParsingStats_t *	m_pPrevStats;
+
+
 	// =============================================================================================================
 	// Useful information read from the demo file
 	demoheader_t		m_demoHeader;					///< General demo info
@@ -114,6 +114,8 @@ bool DemoParser::ProcessPacketEntities( bf_read &reader, int maxentries, int upd
 		{
 			UpdateFlags = FHDR_ZERO;
 
+			const int nHeaderBit = reader.GetNumBitsRead();
+
 			nNewEntity = nHeaderBase + 1 + reader.ReadUBitVar();
 			nHeaderBase = nNewEntity;
 
@@ -121,7 +123,12 @@ bool DemoParser::ProcessPacketEntities( bf_read &reader, int maxentries, int upd
 			// we can just stop processing entities after all the players have been updated
 			// (this can speed up demo parsing by over 20x)
 			if( nNewEntity > m_iMaxClients )
+			{
+				// The slim export keeps the updates up to here
+				m_iPlayerEntityUpdates = updatedentries - nHeaderCount - 1;
+				m_iPlayerEntityBits = nHeaderBit;
 				return true;
+			}
 
 			// Leave PVS flag
 			if ( reader.ReadOneBit() == 0 )
@@ -174,6 +181,8 @@ bool DemoParser::ProcessPacketEntities( bf_read &reader, int maxentries, int upd
 					uint32 uClass = reader.ReadUBitLong( m_iServerClassBits );
 					uint32 uSerialNum = reader.ReadUBitLong( NUM_NETWORKED_EHANDLE_SERIAL_NUMBER_BITS );
 
+					STATS_ADD( entities_decoded, 1 );
+
 					EntityEntry *pEntity = AddEntity( nNewEntity, uClass, uSerialNum );
 					if ( !ReadNewEntity( reader, pEntity ) )
 					{
@@ -203,6 +212,8 @@ bool DemoParser::ProcessPacketEntities( bf_read &reader, int maxentries, int upd
 
 					if ( pEntity )
 					{
+						STATS_ADD( entities_decoded, 1 );
+
 						if ( !ReadNewEntity( reader, pEntity ) )
 						{
 							throw ParsingError_t( "error reading entity in delta entity" );
@@ -256,11 +267,15 @@ bool DemoParser::ReadNewEntity( bf_read &reader, EntityEntry *pEntity )
 		FlattenedPropEntry *pSendProp = GetSendPropByIndex( pEntity->m_uClass, index );
 		if ( pSendProp )
 		{
+			STATS_ADD( props_decoded, 1 );
+
 			Prop_t *pProp = DecodeProp( reader, pSendProp, pEntity->m_uClass, index );
 			pEntity->AddOrUpdateProp( pSendProp, pProp );
 
-			// TODO: save the index for these props when server classes are added for faster checking
-			if( !strcmp( pSendProp->m_prop->m_propName, "m_angEyeAngles[0]" ) ) // Pitch
+			// Prop names are pooled, so they can be compared by pointer
+			const char *pPropName = pSendProp->m_prop->m_propName;
+
+			if( pPropName == m_PropNames.eyeAngles0 ) // Pitch
 			{
 				Player *pPlayer = FindPlayerByEntityIndex( pEntity->m_nEntity );
 
@@ -268,7 +283,7 @@ bool DemoParser::ReadNewEntity( bf_read &reader, EntityEntry *pEntity )
 
 				pPlayer->AddPitchAngle( pProp->m_value.m_float );
 			}
-			else if( !strcmp( pSendProp->m_prop->m_propName, "m_angEyeAngles[1]" ) ) // Yaw
+			else if( pPropName == m_PropNames.eyeAngles1 ) // Yaw
 			{
 				Player *pPlayer = FindPlayerByEntityIndex( pEntity->m_nEntity );
 
@@ -276,7 +291,7 @@ bool DemoParser::ReadNewEntity( bf_read &reader, EntityEntry *pEntity )
 
 				pPlayer->AddYawAngle( pProp->m_value.m_float );
 			}
-			else if( !strcmp( pSendProp->m_prop->m_propName, "m_flFlashDuration" ) )
+			else if( pPropName == m_PropNames.flashDuration )
 			{
 				Player *pPlayer = FindPlayerByEntityIndex( pEntity->m_nEntity );
 
@@ -285,7 +300,7 @@ bool DemoParser::ReadNewEntity( bf_read &reader, EntityEntry *pEntity )
 				pPlayer->flashinfo.tick = m_iCurrentTick;
 				pPlayer->flashinfo.time = pProp->m_value.m_float;
 			}
-			else if( !strcmp( pSendProp->m_prop->m_propName, "m_fFlags" ) )
+			else if( pPropName == m_PropNames.flags )
 			{
 				Player *pPlayer = FindPlayerByEntityIndex( pEntity->m_nEntity );
 
@@ -301,7 +316,7 @@ bool DemoParser::ReadNewEntity( bf_read &reader, EntityEntry *pEntity )
 					pPlayer->airstatus = PL_ON_GROUND;
 				}
 			}
-			else if( !strcmp( pSendProp->m_prop->m_propName, "m_vecOrigin" ) )
+			else if( pPropName == m_PropNames.origin )
 			{
 				Player *pPlayer = FindPlayerByEntityIndex( pEntity->m_nEntity );
 
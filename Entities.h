@@ -63,17 +63,18 @@ enum SendPropType
 
 // =====================================================================================================================================================================
 
+// Thousands of these are kept per demo, so the fields are packed by their sizes on the wire
 class SendProp
 {
 public:
-	char m_propName[256];
-	SendPropType m_propType;
-	int m_flags;
 	float m_fLowValue;
 	float m_fHighValue;
-	int m_nBits;
-	int m_nNumElements;			///< Used if this is an array prop
-	char m_dtname[ 256 ];
+	uint16 m_flags;				///< SPROP_* flags (13 bits)
+	uint16 m_nNumElements;		///< Used if this is an array prop (10 bits)
+	byte m_nBits;				///< 6 bits
+	byte m_propType;			///< SendPropType
+	const char *m_propName;		///< Pooled by the parser
+	const char *m_dtname;		///< Pooled, only set for data table and exclude props
 
 	friend class SendTable;
 };
@@ -103,6 +104,11 @@ struct ExcludeEntry
 	{
 	}
 
+	bool operator==( const ExcludeEntry &other ) const
+	{
+		return m_pVarName == other.m_pVarName && m_pDTName == other.m_pDTName;
+	}
+
 	const char *m_pVarName;
 	const char *m_pDTName;
 	const char *m_pDTExcluding;
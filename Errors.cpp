@@ -2,8 +2,12 @@
 #include "DemoParser.h"
 #include "Common.h"
 #include "Settings.h"
+#include "Progress.h"
+#include <mutex>
 
 std::vector< ParsingWarning_t > g_WarningDemos;		// Filenames and the warning numbers of demos where a warning was triggered
+extern thread_local DemoParser *gpParser;
+static std::mutex s_WarningMutex;					// Demo segments can be parsed on multiple threads
 
 // Textual representation of the warnings
 // These match the WarningType enum
@@ -29,12 +33,19 @@ ParsingError_t::ParsingError_t( const char *msg )
 		at_end_of_demo = false;
 	}
 
-	if( !Settings()->BatchProcessingEnabled() )
+	// Segment parsers hand the error over to the main parser, which reports it
+	if( !IsSubParser() )
 	{
-		if( at_end_of_demo )
-			printf( "Done parsing!\n\n" );
-		else
-			printf( "Error encountered!\n\n" );
+		// Stop the progress bar where it is
+		Progress()->CancelDemo();
+
+		if( !Settings()->BatchProcessingEnabled() )
+		{
+			if( at_end_of_demo )
+				printf( "Done parsing!\n\n" );
+			else
+				printf( "Error encountered!\n\n" );
+		}
 	}
 
 	OnParsingEnd();
@@ -49,7 +60,7 @@ ParsingWarning_t::ParsingWarning_t( const std::string &_demoname, WarningType _t
 
 }
 
-void ParsingWarning_t::GetString( std::string &buffer )
+void ParsingWarning_t::GetString( std::string &buffer ) const
 {
 	buffer = demoname + ": " + g_szWarnings[ type ] + " on tick " + std::to_string( (long long)tick );
 
@@ -61,15 +72,20 @@ void ParsingWarning_t::GetString( std::string &buffer )
 
 void AddWarning( const std::string &demoname, WarningType type )
 {
-	for( size_t i = 0; i < g_WarningDemos.size(); ++i )
+	// A daemon request keeps its own warnings, the batch list would grow for as long as the daemon runs
+	std::vector< ParsingWarning_t > &warnings = ( gpParser && gpParser->GetWarnings() )? *gpParser->GetWarnings() : g_WarningDemos;
+
+	std::lock_guard< std::mutex > lock( s_WarningMutex );
+
+	for( size_t i = 0; i < warnings.size(); ++i )
 	{
-		if( g_WarningDemos[ i ].type == type
-		&& g_WarningDemos[ i ].demoname == demoname )
+		if( warnings[ i ].type == type
+		&& warnings[ i ].demoname == demoname )
 		{
-			++g_WarningDemos[ i ].count;
+			++warnings[ i ].count;
 			return;
 		}
 	}
 
-	g_WarningDemos.emplace_back( demoname, type );
+	warnings.emplace_back( demoname, type );
 }
\ No newline at end of file
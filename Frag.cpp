@@ -2,11 +2,13 @@
 #include "DemoParser.h"
 #include "Settings.h"
 #include "Weapons.h"
+#include <format>
+#include <iterator>
 #include <string>
 
 // =====================================================================================================================================================================
 
-bool TryToAddMultiKillFragDescriptor( Frag &frag, MultiKillFragType frag_type, const std::vector< const kill_info_t * > &kills, int cur_kill_idx, int min_frag_kills )
+bool TryToAddMultiKillFragDescriptor( Frag &frag, MultiKillFragType frag_type, const round_kills_t &round_kills, int cur_kill_idx, int min_frag_kills, int profile )
 {
 	// Check if there is already a better frag added
 	MultiKillFragType existing_type = frag.GetMultiKillFragType();
@@ -22,40 +24,39 @@ bool TryToAddMultiKillFragDescriptor( Frag &frag, MultiKillFragType frag_type, c
 			return false;
 	}
 
-	const int start_tick = kills[ cur_kill_idx - min_frag_kills ]->tick;
+	const std::vector< const kill_info_t * > &kills = round_kills.enemy_kills;
+	const int first_kill_idx = cur_kill_idx - min_frag_kills;
+
+	const int start_tick = kills[ first_kill_idx ]->tick;
 	const int end_tick = kills[ cur_kill_idx - 1 ]->tick;
 
 	const float frag_time = GetTimeBetweenTicks( start_tick, end_tick );
 
-	// Get a list of weapons and the number of headshots
+	// Headshots and special kills in the window from the running counts
+	const short num_headshots = round_kills.headshots_before[ cur_kill_idx ] - round_kills.headshots_before[ first_kill_idx ];
+	const bool contains_special_kill = round_kills.special_kills_before[ cur_kill_idx ] != round_kills.special_kills_before[ first_kill_idx ];
+
+	// Get a list of weapons and the farthest distance from the start (the window has at most 5 kills)
 	CSWeaponID weapons[ multi_kill_frag_descriptor_t::FRAG_MAX_WEAPONS ];
 	short num_weapons = 0;
-	short num_headshots = 0;
-	bool contains_special_kill = false;
 
 	float farthest_kill_distance = -1.f;
-	Vector vecFragOrigin = kills[ cur_kill_idx - min_frag_kills ]->position;
+	Vector vecFragOrigin = kills[ first_kill_idx ]->position;
 
-	for( int i = cur_kill_idx - min_frag_kills; i < cur_kill_idx; ++i )
+	for( int i = first_kill_idx; i < cur_kill_idx; ++i )
 	{
 		const kill_info_t *kill = kills[ i ];
 
 		if( num_weapons < multi_kill_frag_descriptor_t::FRAG_MAX_WEAPONS )
 			weapons[ num_weapons++ ] = kill->weaponID;
 
-		if( kill->headshot )
-			++num_headshots;
-
-		if( kill->flickshot || kill->midair != ON_GROUND || kill->noscope || kill->penetrated || kill->blind )
-			contains_special_kill = true;
-
 		const float distance_to_start = (kill->position - vecFragOrigin).Length();
 
 		if( distance_to_start > farthest_kill_distance )
 			farthest_kill_distance = distance_to_start;
 	}
 
-	if( !Settings()->ShouldTickFrag( frag_type, GetWeaponCategory( weapons, num_weapons ), frag_time, farthest_kill_distance, num_headshots, contains_special_kill ) )
+	if( !Settings()->ShouldTickFrag( frag_type, GetWeaponCategory( weapons, num_weapons ), frag_time, farthest_kill_distance, num_headshots, contains_special_kill, profile ) )
 		return false;
 
 	return frag.AddMultiKillFragDescriptor( frag_type, weapons, num_weapons, start_tick, end_tick, num_headshots );
@@ -63,57 +64,125 @@ bool TryToAddMultiKillFragDescriptor( Frag &frag, MultiKillFragType frag_type, c
 
 // =====================================================================================================================================================================
 
-float GetDeltaTimeToClosestKill( const Player *pPlayer, int killIdx )
+// Kills of a collat have the same tick and weapon
+static inline bool KillsAreInSameCollat( const kill_info_t &kill1, const kill_info_t &kill2 )
+{
+	return kill1.tick == kill2.tick && kill1.weaponID == kill2.weaponID;
+}
+
+/**
+ * Gathers everything about the player's kills on the round that doesn't depend on the settings,
+ * in a single sweep over the kills (and one more in both directions for the wallbang kill distances)
+ */
+void GatherRoundKills( const Player &player, round_kills_t &round_kills )
 {
-	int tick = pPlayer->GetKill( killIdx ).tick;
-	CSWeaponID weapon = pPlayer->GetKill( killIdx ).weaponID;
-	int closestTickBefore = 999999999;
-	int closestTickAfter = 999999999;
-	int tickDeltaToBefore = 999999999;
-	int tickDeltaToAfter = 999999999;
+	const int num_all_kills = player.GetNumKills();
+
+	round_kills.enemy_kills.clear();
+	round_kills.headshots_before.assign( 1, 0 );
+	round_kills.special_kills_before.assign( 1, 0 );
+	round_kills.spectated = false;
 
-	// Check earlier kill
-	int idxCopy = killIdx;
-	while( --idxCopy >= 0 )
+	bool has_wallbangs = false;
+
+	for( int k = 0; k < num_all_kills; ++k )
 	{
-		const kill_info_t &kill = pPlayer->GetKill( idxCopy );
+		const kill_info_t &kill = player.GetKill( k );
 
-		if( kill.teamkill )
-			continue;
+		round_kills.spectated = kill.spectated;
 
-		if( kill.tick == tick && kill.weaponID == weapon )
-			continue;
+		if( kill.penetrated )
+			has_wallbangs = true;
+
+		if( !kill.teamkill )
+		{
+			const bool special = kill.flickshot || kill.midair != ON_GROUND || kill.noscope || kill.penetrated || kill.blind;
 
-		closestTickBefore = kill.tick;
-		tickDeltaToBefore = abs( tick - closestTickBefore );
-		break;
+			round_kills.enemy_kills.push_back( &kill );
+			round_kills.headshots_before.push_back( round_kills.headshots_before.back() + (kill.headshot? 1 : 0) );
+			round_kills.special_kills_before.push_back( round_kills.special_kills_before.back() + (special? 1 : 0) );
+		}
 	}
 
-	// Check kill after
-	idxCopy = killIdx;
-	while( ++idxCopy < pPlayer->GetNumKills() )
-	{
-		const kill_info_t &kill = pPlayer->GetKill( idxCopy );
+	round_kills.time_to_closest_kill.assign( num_all_kills, 0.f );
 
-		if( kill.teamkill )
-			continue;
+	if( !has_wallbangs )
+		return;
 
-		if( kill.tick == tick && kill.weaponID == weapon )
-			continue;
+	// Tick distance to the closest enemy kill before and after each kill, skipping the kills of the same collat
+	// The closest one that isn't in the same collat is either the last enemy kill, or the last one before it that wasn't in its collat
+	const int NO_KILL = 999999999;
 
-		closestTickAfter = kill.tick;
-		tickDeltaToAfter = abs( tick - closestTickAfter );
-		break;
-	}
+	std::vector< int > closest_tick_before( num_all_kills, NO_KILL );
+	std::vector< int > tick_delta_to_before( num_all_kills, NO_KILL );
+
+	int last = -1;
+	int last_other_collat = -1;
 
-	// Return shorter time
-	if( tickDeltaToBefore < tickDeltaToAfter )
+	for( int k = 0; k < num_all_kills; ++k )
 	{
-		return GetTimeBetweenTicks( tick, closestTickBefore );
+		const kill_info_t &kill = player.GetKill( k );
+
+		int closest = last;
+		if( closest >= 0 && KillsAreInSameCollat( player.GetKill( closest ), kill ) )
+			closest = last_other_collat;
+
+		if( closest >= 0 )
+		{
+			closest_tick_before[ k ] = player.GetKill( closest ).tick;
+			tick_delta_to_before[ k ] = abs( kill.tick - closest_tick_before[ k ] );
+		}
+
+		if( !kill.teamkill )
+		{
+			if( last >= 0 && !KillsAreInSameCollat( player.GetKill( last ), kill ) )
+				last_other_collat = last;
+
+			last = k;
+		}
 	}
-	else
+
+	last = -1;
+	last_other_collat = -1;
+
+	for( int k = num_all_kills - 1; k >= 0; --k )
 	{
-		return GetTimeBetweenTicks( tick, closestTickAfter );
+		const kill_info_t &kill = player.GetKill( k );
+
+		int closest = last;
+		if( closest >= 0 && KillsAreInSameCollat( player.GetKill( closest ), kill ) )
+			closest = last_other_collat;
+
+		int closest_tick_after = NO_KILL;
+		int tick_delta_to_after = NO_KILL;
+
+		if( closest >= 0 )
+		{
+			closest_tick_after = player.GetKill( closest ).tick;
+			tick_delta_to_after = abs( kill.tick - closest_tick_after );
+		}
+
+		if( !kill.teamkill )
+		{
+			if( last >= 0 && !KillsAreInSameCollat( player.GetKill( last ), kill ) )
+				last_other_collat = last;
+
+			last = k;
+		}
+
+		// Only wallbangs need the time
+		if( !kill.penetrated )
+			continue;
+
+		// Return shorter time
+		if( tick_delta_to_before[ k ] < tick_delta_to_after )
+		{
+			round_kills.time_to_closest_kill[ k ] = GetTimeBetweenTicks( kill.tick, closest_tick_before[ k ] );
+		}
+		else
+		{
+			round_kills.time_to_closest_kill[ k ] = GetTimeBetweenTicks( kill.tick, closest_tick_after );
+		}
 	}
 }
 
@@ -121,217 +190,245 @@ float GetDeltaTimeToClosestKill( const Player *pPlayer, int killIdx )
 
 void DemoParser::FindRoundFrags( void )
 {
+	STATS_SCOPE( PHASE_FRAG_FINDING );
+
+	round_kills_t round_kills;
+
 	for( auto p = m_Players.begin(); p != m_Players.end(); ++p )
 	{
 		if( p->ishltv )
 			continue;
 
-		const int num_all_kills = p->GetNumKills();
-
-		if( num_all_kills <= 0 )
+		if( p->GetNumKills() <= 0 )
 			continue;
 
-		// Make a list of all killed enemies
-		std::vector< const kill_info_t * > enemy_kills;
-		bool spectated = false;
-		for( int k = 0; k < num_all_kills; ++k )
-		{
-			const kill_info_t &kill = p->GetKill( k );
+		GatherRoundKills( *p, round_kills );
 
-			spectated = kill.spectated;
+		// The kills were gathered once, so checking them against more settings profiles is cheap
+		for( int profile = 0; profile < (int)m_Frags.size(); ++profile )
+			FindPlayerRoundFrags( *p, round_kills, profile );
+	}
+}
 
-			if( !kill.teamkill )
-			{
-				enemy_kills.push_back( &kill );
-			}
-		}
+// =====================================================================================================================================================================
 
-		const int num_enemy_kills = enemy_kills.size();
+void DemoParser::ClearFrags( void )
+{
+	for( size_t i = 0; i < m_Frags.size(); ++i )
+		m_Frags[ i ].clear();
+}
 
-		Frag player_frag( num_enemy_kills, p->GetKill( 0 ).team, spectated );
+// =====================================================================================================================================================================
 
-		// Check for 5/4/3k frags before any 1k/collat frags
-		const int MIN_FRAG_KILLS = 3;
-		for( int k = num_enemy_kills; k >= MIN_FRAG_KILLS; --k )
-		{
-			bool bDescAdded = false;
+void DemoParser::KeepOutput( KeptOutput_t *pKept )
+{
+	m_FragOutput.KeepOutput( pKept );
+}
 
-			if( k >= 5 )
-			{
-				bDescAdded = TryToAddMultiKillFragDescriptor( player_frag, FRAG_5K, enemy_kills, k, 5 );
-			}
-			if( k >= 4 && !bDescAdded )
-			{
-				bDescAdded = TryToAddMultiKillFragDescriptor( player_frag, FRAG_4K, enemy_kills, k, 4 );
-			}
-			if( k >= 3 && !bDescAdded )
-			{
-				bDescAdded = TryToAddMultiKillFragDescriptor( player_frag, FRAG_3K, enemy_kills, k, 3 );
-			}
-		}
+// =====================================================================================================================================================================
 
-		// Then check for collats and 1k frags
-		for( int k = num_all_kills - 1; k >= 0; --k )
+void DemoParser::EmitFrag( const Frag &frag, int profile )
+{
+	if( m_pFragSink )
+		m_pFragSink->OnFrag( frag, profile );
+	else
+		m_Frags[ profile ].push_back( frag );
+}
+
+// =====================================================================================================================================================================
+
+/**
+ * Checks the player's kills on the round against the frag settings of the profile and emits the frag if there is one
+ */
+void DemoParser::FindPlayerRoundFrags( const Player &player, const round_kills_t &round_kills, int profile )
+{
+	const int num_all_kills = player.GetNumKills();
+	const int num_enemy_kills = round_kills.enemy_kills.size();
+
+	Frag player_frag( num_enemy_kills, player.GetKill( 0 ).team, round_kills.spectated );
+
+	// Check for 5/4/3k frags before any 1k/collat frags
+	const int MIN_FRAG_KILLS = 3;
+	for( int k = num_enemy_kills; k >= MIN_FRAG_KILLS; --k )
+	{
+		bool bDescAdded = false;
+
+		if( k >= 5 )
+		{
+			bDescAdded = TryToAddMultiKillFragDescriptor( player_frag, FRAG_5K, round_kills, k, 5, profile );
+		}
+		if( k >= 4 && !bDescAdded )
+		{
+			bDescAdded = TryToAddMultiKillFragDescriptor( player_frag, FRAG_4K, round_kills, k, 4, profile );
+		}
+		if( k >= 3 && !bDescAdded )
 		{
-			const kill_info_t *kill = &p->GetKill( k );
-			unsigned short type_flags = 0;
+			bDescAdded = TryToAddMultiKillFragDescriptor( player_frag, FRAG_3K, round_kills, k, 3, profile );
+		}
+	}
 
-			short kills_on_tick = 1;
-			short teamkills = kill->teamkill? 1 : 0;
-			short headshots = kill->headshot? 1 : 0;
-			float time_to_closest_kill = (kill->penetrated? GetDeltaTimeToClosestKill( &(*p), k ) : 0.f);
-			float longest_distance = kill->distance;
-			bool blind = kill->blind;
+	// Then check for collats and 1k frags
+	for( int k = num_all_kills - 1; k >= 0; --k )
+	{
+		const kill_info_t *kill = &player.GetKill( k );
+		unsigned short type_flags = 0;
 
-			while( k >= 1 && kill->tick == p->GetKill( k - 1 ).tick && kill->weaponID == p->GetKill( k - 1 ).weaponID )
-			{
-				--k;
-				++kills_on_tick;
+		short kills_on_tick = 1;
+		short teamkills = kill->teamkill? 1 : 0;
+		short headshots = kill->headshot? 1 : 0;
+		float time_to_closest_kill = round_kills.time_to_closest_kill[ k ];
+		float longest_distance = kill->distance;
+		bool blind = kill->blind;
 
-				// Check flags from first kill in collat,
-				// because in doubles, all other kills will always have penetrated flag on
-				kill = &p->GetKill( k );
+		while( k >= 1 && KillsAreInSameCollat( *kill, player.GetKill( k - 1 ) ) )
+		{
+			--k;
+			++kills_on_tick;
 
-				if( kill->teamkill )
-					++teamkills;
+			// Check flags from first kill in collat,
+			// because in doubles, all other kills will always have penetrated flag on
+			kill = &player.GetKill( k );
 
-				if( kill->headshot )
-					++headshots;
+			if( kill->teamkill )
+				++teamkills;
 
-				// Keep track of longest distance in case this won't be ticked as a collat
-				if( kill->distance > longest_distance )
-					longest_distance = kill->distance;
+			if( kill->headshot )
+				++headshots;
 
-				blind = kill->blind;
-			}
+			// Keep track of longest distance in case this won't be ticked as a collat
+			if( kill->distance > longest_distance )
+				longest_distance = kill->distance;
+
+			blind = kill->blind;
+		}
 
-			if( kills_on_tick > 1 )
+		if( kills_on_tick > 1 )
+		{
+			if( kills_on_tick == 2 )
 			{
-				if( kills_on_tick == 2 )
-				{
-					type_flags |= FL_KILL_DOUBLE;
-				}
-				else if( kills_on_tick == 3 )
-				{
-					type_flags |= FL_KILL_TRIPLE;
-				}
-				else if( kills_on_tick == 4 )
-				{
-					type_flags |= FL_KILL_QUADRO;
-				}
-				else
-				{
-					type_flags |= FL_KILL_PENTA;
-				}
+				type_flags |= FL_KILL_DOUBLE;
 			}
-
-			if( kill->flickshot )
-				type_flags |= FL_KILL_FLICKSHOT;
-			if( kill->midair == IN_AIR )
-				type_flags |= FL_KILL_MIDAIR;
-			else if( kill->midair == ON_LADDER )
-				type_flags |= FL_KILL_LADDERSHOT;
-			if( kill->noscope )
-				type_flags |= FL_KILL_NOSCOPE;
-			if( kill->penetrated )
-				type_flags |= FL_KILL_WALLBANG;
-
-			if( kill->weaponID == WEAPON_FLASHBANG )
-				type_flags |= FL_KILL_FLASHKILL;
-			else if( kill->weaponID == WEAPON_SMOKEGRENADE )
-				type_flags |= FL_KILL_SMOKEKILL;
-
-			if( type_flags != 0 )
+			else if( kills_on_tick == 3 )
 			{
-				if( blind )	// Don't tick if only this flag was set
-					type_flags |= FL_KILL_BLIND;
-
-				player_frag.AddFragDescriptor( kill->tick, type_flags, teamkills, headshots, kill->weaponID, longest_distance, kill->flickangle, time_to_closest_kill );
+				type_flags |= FL_KILL_TRIPLE;
+			}
+			else if( kills_on_tick == 4 )
+			{
+				type_flags |= FL_KILL_QUADRO;
+			}
+			else
+			{
+				type_flags |= FL_KILL_PENTA;
 			}
 		}
 
-		if( player_frag.IsValidFrag() ) // Were there any actions to save?
+		if( kill->flickshot )
+			type_flags |= FL_KILL_FLICKSHOT;
+		if( kill->midair == IN_AIR )
+			type_flags |= FL_KILL_MIDAIR;
+		else if( kill->midair == ON_LADDER )
+			type_flags |= FL_KILL_LADDERSHOT;
+		if( kill->noscope )
+			type_flags |= FL_KILL_NOSCOPE;
+		if( kill->penetrated )
+			type_flags |= FL_KILL_WALLBANG;
+
+		if( kill->weaponID == WEAPON_FLASHBANG )
+			type_flags |= FL_KILL_FLASHKILL;
+		else if( kill->weaponID == WEAPON_SMOKEGRENADE )
+			type_flags |= FL_KILL_SMOKEKILL;
+
+		if( type_flags != 0 )
 		{
-			m_Frags.push_back( player_frag );
-			(m_Frags.end() - 1)->SetPlayername( p->name );
+			if( blind )	// Don't tick if only this flag was set
+				type_flags |= FL_KILL_BLIND;
+
+			player_frag.AddFragDescriptor( kill->tick, type_flags, teamkills, headshots, kill->weaponID, longest_distance, kill->flickangle, time_to_closest_kill, profile );
 		}
 	}
+
+	if( player_frag.IsValidFrag() ) // Were there any actions to save?
+	{
+		player_frag.SetPlayername( player.name );
+		EmitFrag( player_frag, profile );
+	}
 }
 
 // =====================================================================================================================================================================
 
-void frag_descriptor_t::GetStringRepresentation( char *buffer, size_t buffer_size, bool write_hs /*= true*/, bool write_weapon /*= true*/ ) const
+void frag_descriptor_t::GetStringRepresentation( std::string &out, bool write_hs /*= true*/, bool write_weapon /*= true*/ ) const
 {
-	_snprintf_s( buffer, buffer_size, buffer_size, "" );
-
 	if( type_flags == 0 )
 	{
 		return;
 	}
 
+	auto it = std::back_inserter( out );
+
 	// Fields other than count shouldn't matter for flash/smoke kills
 	if( type_flags & FL_KILL_FLASHKILL )
 	{
 		if( count > 1 )
-			_snprintf_s( buffer, buffer_size, buffer_size, "%d flashkills", count );
+			std::format_to( it, "{} flashkills", count );
 		else
-			_snprintf_s( buffer, buffer_size, buffer_size, "flashkill" );
+			out += "flashkill";
 
 		return;
 	}
 	else if( type_flags & FL_KILL_SMOKEKILL )
 	{
 		if( count > 1 )
-			_snprintf_s( buffer, buffer_size, buffer_size, "%d smokekills", count );
+			std::format_to( it, "{} smokekills", count );
 		else
-			_snprintf_s( buffer, buffer_size, buffer_size, "smokekill" );
+			out += "smokekill";
 
 		return;
 	}
 
+	const size_t start = out.length();
+
 	if( count > 1 )
 	{
-		_snprintf_s( buffer, buffer_size, buffer_size, "%d ", count );
+		std::format_to( it, "{} ", count );
 	}
 
 	if( type_flags & FL_KILL_BLIND )
 	{
-		strcat_s( buffer, buffer_size, "flashed " );
+		out += "flashed ";
 	}
 
 	if( write_weapon && weapon != WEAPON_HEGRENADE )
 	{
-		_snprintf_s( buffer, buffer_size, buffer_size, "%s%s ", buffer, WeaponIDToAlias( weapon ) );
+		out += WeaponIDToAlias( weapon );
+		out += ' ';
 	}
 
 	if( !FragIsCollat( type_flags ) && teamkills == count )
 	{
-		strcat_s( buffer, buffer_size, "teamkill " );
+		out += "teamkill ";
 	}
 
 	if( type_flags & FL_KILL_NOSCOPE )
 	{
-		strcat_s( buffer, buffer_size, "noscope " );
+		out += "noscope ";
 	}
 	if( type_flags & FL_KILL_FLICKSHOT )
 	{
 		// Write angle
 		if( count == 1 && flick_angle != 0.f )
 		{
-			int angle = GetRoundedFlickAngle();
-			char szAngle[8];
-			_snprintf_s( szAngle, sizeof(szAngle), sizeof(szAngle), "%d ", angle );
-			strcat_s( buffer, buffer_size, szAngle );
+			std::format_to( it, "{}", GetRoundedFlickAngle() );
+			out += " ";
 		}
 
 		// Don't write "shot" if we will write "headshot" afterwards
 		if( write_hs && !FragIsCollat( type_flags ) && headshots == count )
 		{
-			strcat_s( buffer, buffer_size, "flick " );
+			out += "flick ";
 		}
 		else
 		{
-			strcat_s( buffer, buffer_size, "flickshot " );
+			out += "flickshot ";
 		}
 	}
 	if( type_flags & FL_KILL_MIDAIR )
@@ -341,31 +438,29 @@ void frag_descriptor_t::GetStringRepresentation( char *buffer, size_t buffer_siz
 			&& !FragIsCollat( type_flags )
 			&& (!write_hs || headshots != count) )
 		{
-			strcat_s( buffer, buffer_size, "mid-air kill " );
+			out += "mid-air kill ";
 		}
 		else
 		{
-			strcat_s( buffer, buffer_size, "mid-air " );
+			out += "mid-air ";
 		}
 	}
 	else if( type_flags & FL_KILL_LADDERSHOT )
 	{
-		strcat_s( buffer, buffer_size, "laddershot " );
+		out += "laddershot ";
 	}
 	if( type_flags & FL_KILL_WALLBANG )
 	{
-		strcat_s( buffer, buffer_size, "wallbang " );
+		out += "wallbang ";
 	}
 
 	// Because at least one flag had to be set for non-collat frags,
 	// this might be the end of the description if "headshots" is not written later,
 	// so add the plural suffix on the last flag descriptor
-	if( count > 1 && !FragIsCollat( type_flags ) && (!write_hs || headshots != count) )
+	if( count > 1 && !FragIsCollat( type_flags ) && (!write_hs || headshots != count) && out.length() > start )
 	{
-		size_t len = strlen( buffer );
-		buffer[ len-1 ] = 's';
-		buffer[ len ] = ' ';
-		buffer[ len+1 ] = '\0';
+		out.back() = 's';
+		out += ' ';
 	}
 
 	if( FragIsCollat( type_flags ) )
@@ -375,50 +470,50 @@ void frag_descriptor_t::GetStringRepresentation( char *buffer, size_t buffer_siz
 		{
 			if( type_flags & FL_KILL_DOUBLE )
 			{
-				strcat_s( buffer, buffer_size, "2k HE" );
+				out += "2k HE";
 			}
 			else if( type_flags & FL_KILL_TRIPLE )
 			{
-				strcat_s( buffer, buffer_size, "3k HE" );
+				out += "3k HE";
 			}
 			else if( type_flags & FL_KILL_QUADRO )
 			{
-				strcat_s( buffer, buffer_size, "4k HE" );
+				out += "4k HE";
 			}
 			else if( type_flags & FL_KILL_PENTA )
 			{
-				strcat_s( buffer, buffer_size, "5k HE" );
+				out += "5k HE";
 			}
 
 			if( count > 1 )
-				strcat_s( buffer, buffer_size, "'s " );
+				out += "'s ";
 			else
-				strcat_s( buffer, buffer_size, " " );
+				out += ' ';
 		}
 		// Collat done with bullets
 		else
 		{
 			if( type_flags & FL_KILL_DOUBLE )
 			{
-				strcat_s( buffer, buffer_size, "double" );
+				out += "double";
 			}
 			else if( type_flags & FL_KILL_TRIPLE )
 			{
-				strcat_s( buffer, buffer_size, "triple" );
+				out += "triple";
 			}
 			else if( type_flags & FL_KILL_QUADRO )
 			{
-				strcat_s( buffer, buffer_size, "quadro" );
+				out += "quadro";
 			}
 			else if( type_flags & FL_KILL_PENTA )
 			{
-				strcat_s( buffer, buffer_size, "penta" );
+				out += "penta";
 			}
 
 			if( count > 1 )
-				strcat_s( buffer, buffer_size, "s " );
+				out += "s ";
 			else
-				strcat_s( buffer, buffer_size, " " );
+				out += ' ';
 		}
 	}
 
@@ -427,28 +522,24 @@ void frag_descriptor_t::GetStringRepresentation( char *buffer, size_t buffer_siz
 		if( !FragIsCollat( type_flags ) && headshots == count )
 		{
 			if( count > 1 )
-				strcat_s( buffer, buffer_size, "headshots " );
+				out += "headshots ";
 			else
-				strcat_s( buffer, buffer_size, "headshot " );
+				out += "headshot ";
 		}
 		else if( headshots > 0 )
 		{
-			char szHs[12];
-			_snprintf_s( szHs, sizeof(szHs), sizeof(szHs), "(%dhs) ", headshots );
-			strcat_s( buffer, buffer_size, szHs );
+			std::format_to( it, "({}hs) ", headshots );
 		}
 	}
 
 	if( teamkills > 0 && (FragIsCollat( type_flags ) || teamkills != count) )
 	{
-		char szTk[12];
-		_snprintf_s( szTk, sizeof(szTk), sizeof(szTk), "(%dtk) ", teamkills );
-		strcat_s( buffer, buffer_size, szTk );
+		std::format_to( it, "({}tk) ", teamkills );
 	}
 
 	// Remove last character, because the description always ends in a whitespace
-	size_t len = strlen( buffer );
-	buffer[ len-1 ] = '\0';
+	if( out.length() > start )
+		out.pop_back();
 }
 
 // =====================================================================================================================================================================
@@ -475,9 +566,11 @@ int frag_descriptor_t::GetRoundedFlickAngle( void ) const
 
 // =====================================================================================================================================================================
 
-void multi_kill_frag_descriptor_t::GetStringRepresentation( char *buffer, size_t buffer_size ) const
+void multi_kill_frag_descriptor_t::GetStringRepresentation( std::string &out ) const
 {
-	_snprintf_s( buffer, buffer_size, buffer_size, "%dk ", static_cast<int>(frag_type) );
+	auto it = std::back_inserter( out );
+
+	std::format_to( it, "{}k ", static_cast<int>(frag_type) );
 
 	byte hs_print_mode = PRINT_HS_IN_MAIN;
 
@@ -517,29 +610,26 @@ void multi_kill_frag_descriptor_t::GetStringRepresentation( char *buffer, size_t
 	// Print hs count
 	if( headshots > 0 && hs_print_mode != PRINT_HS_IN_SUB )
 	{
-		char szHs[12];
-		_snprintf_s( szHs, sizeof(szHs), sizeof(szHs), "(%dhs) ", headshots );
-		strcat_s( buffer, buffer_size, szHs );
+		std::format_to( it, "({}hs) ", headshots );
 	}
 
 	// Add used weapons
 	for( int i = 0; i < num_weapons; ++i )
 	{
 		if( i )
-			strcat_s( buffer, buffer_size, "/" );
+			out += '/';
 
-		strcat_s( buffer, buffer_size, WeaponIDToAlias( weapons[ i ] ) );
+		out += WeaponIDToAlias( weapons[ i ] );
 	}
 
-	strcat_s( buffer, buffer_size, " " );
+	out += ' ';
 
 	const int num_sub_descs = sub_descriptors.size();
 
 	// Add sub descriptors
 	if( num_sub_descs )
 	{
-		strcat_s( buffer, buffer_size, "with " );
-		char sub_buffer[256];
+		out += "with ";
 		const int first_sub_desc = num_sub_descs - 1;
 
 		// Add them in reverse order, since they're added to the vector in reverse order
@@ -548,25 +638,18 @@ void multi_kill_frag_descriptor_t::GetStringRepresentation( char *buffer, size_t
 			if( i < first_sub_desc )
 			{
 				if( i == 0 )
-					strcat_s( buffer, buffer_size, " & " );
+					out += " & ";
 				else 
-					strcat_s( buffer, buffer_size, ", " );
+					out += ", ";
 			}
 
-			sub_descriptors[ i ].GetStringRepresentation( sub_buffer, sizeof(sub_buffer), hs_print_mode != PRINT_HS_IN_MAIN, false );
-			strcat_s( buffer, buffer_size, sub_buffer );
+			sub_descriptors[ i ].GetStringRepresentation( out, hs_print_mode != PRINT_HS_IN_MAIN, false );
 		}
 
-		strcat_s( buffer, buffer_size, " " );
+		out += ' ';
 	}
 
-	char szTime[32];
-	_snprintf_s( szTime, sizeof(szTime), sizeof(szTime), "in %.02f seconds ", frag_length );
-	strcat_s( buffer, buffer_size, szTime );
-
-	// Remove last character, because the description always ends in a whitespace
-	size_t len = strlen( buffer );
-	buffer[ len-1 ] = '\0';
+	std::format_to( it, "in {:.2f} seconds", frag_length );
 }
 
 // =====================================================================================================================================================================
@@ -715,7 +798,7 @@ bool Frag::AddMultiKillFragDescriptor( MultiKillFragType type, const CSWeaponID
 
 // =====================================================================================================================================================================
 
-void Frag::AddFragDescriptor( uint32 tick, unsigned short type_flags, short teamkills, short headshots, CSWeaponID weapon, float distance, float flickangle, float time_to_closest_kill )
+void Frag::AddFragDescriptor( uint32 tick, unsigned short type_flags, short teamkills, short headshots, CSWeaponID weapon, float distance, float flickangle, float time_to_closest_kill, int profile )
 {
 	assert( (type_flags & ~FL_KILL_BLIND) != 0 );
 
@@ -737,7 +820,7 @@ void Frag::AddFragDescriptor( uint32 tick, unsigned short type_flags, short team
 	// but separate descriptors are not necessarily added depending on the settings
 	if( !in_multikill_frag )
 	{
-		if( !Settings()->ShouldTickFrag( type_flags, GetWeaponCategory( weapon ), distance, headshots, time_to_closest_kill ) )
+		if( !Settings()->ShouldTickFrag( type_flags, GetWeaponCategory( weapon ), distance, headshots, time_to_closest_kill, profile ) )
 			return;
 	}
 
@@ -844,34 +927,47 @@ bool Frag::IsValidFrag( void ) const
 
 // =====================================================================================================================================================================
 
-void Frag::GetStringRepresentation( char *buffer, size_t buffer_size ) const
+void Frag::GetStringRepresentation( std::string &out ) const
+{
+	if( !IsValidFrag() )
+	{
+		return;
+	}
+
+	auto it = std::back_inserter( out );
+
+	std::format_to( it, "Tick: {}    Player: {} ({}){}\nFrag: ", GetRoundedTick(), m_szPlayername, GetTeamString(), m_bSpectated? " (*SPEC*)" : "" );
+
+	GetDescription( out );
+
+	out += "\n\n\n";
+}
+
+// =====================================================================================================================================================================
+
+void Frag::GetDescription( std::string &out ) const
 {
 	if( !IsValidFrag() )
 	{
-		_snprintf_s( buffer, buffer_size, buffer_size, "" );
 		return;
 	}
 
-	_snprintf_s( buffer, buffer_size, buffer_size, "Tick: %d    Player: %s (%s)%s\nFrag: ", GetRoundedTick(), m_szPlayername, GetTeamString(), m_bSpectated? " (*SPEC*)" : "" );
+	auto it = std::back_inserter( out );
 
 	int implied_kills = GetImpliedKillCount();
 
 	if( m_nTotalKills > implied_kills )
 	{
-		char prefixbuffer[20];
-		_snprintf_s( prefixbuffer, sizeof(prefixbuffer), sizeof(prefixbuffer), "%dk %s ", m_nTotalKills, m_multiKillDescriptor.IsValid()? "including" : "with" );
-		strcat_s( buffer, buffer_size, prefixbuffer );
+		std::format_to( it, "{}k {} ", m_nTotalKills, m_multiKillDescriptor.IsValid()? "including" : "with" );
 	}
 
 	if( m_multiKillDescriptor.IsValid() )
 	{
-		char mkbuffer[512];
-		m_multiKillDescriptor.GetStringRepresentation( mkbuffer, sizeof(mkbuffer) );
-		strcat_s( buffer, buffer_size, mkbuffer );
+		m_multiKillDescriptor.GetStringRepresentation( out );
 
 		if( m_descriptors.size() )
 		{
-			strcat_s( buffer, buffer_size, " and " );
+			out += " and ";
 		}
 	}
 
@@ -879,35 +975,31 @@ void Frag::GetStringRepresentation( char *buffer, size_t buffer_size ) const
 	const int first_descriptor = m_descriptors.size() - 1;
 	for( int i = first_descriptor; i >= 0; --i )
 	{
-		char descbuffer[256] = "\0";
-		m_descriptors[ i ].GetStringRepresentation( descbuffer, sizeof(descbuffer) );
-
-		// Capitalize first letter if this is the first descriptor
-		if( i == first_descriptor
-			&& m_nTotalKills == implied_kills
-			&& !m_multiKillDescriptor.IsValid()
-			&& m_descriptors[ i ].count == 1
-			&& descbuffer[0] != '\0' )
-		{
-			descbuffer[0] = toupper( descbuffer[0] );
-		}
-
 		if( i < first_descriptor )
 		{
 			if( i == 0 )
 			{
-				strcat_s( buffer, buffer_size, " & " );
+				out += " & ";
 			}
 			else
 			{
-				strcat_s( buffer, buffer_size, ", " );
+				out += ", ";
 			}
 		}
 
-		strcat_s( buffer, buffer_size, descbuffer );
-	}
+		const size_t desc_start = out.length();
+		m_descriptors[ i ].GetStringRepresentation( out );
 
-	strcat_s( buffer, buffer_size, "\n\n\n" );
+		// Capitalize first letter if this is the first descriptor
+		if( i == first_descriptor
+			&& m_nTotalKills == implied_kills
+			&& !m_multiKillDescriptor.IsValid()
+			&& m_descriptors[ i ].count == 1
+			&& out.length() > desc_start )
+		{
+			out[ desc_start ] = toupper( out[ desc_start ] );
+		}
+	}
 }
 
 // =====================================================================================================================================================================
@@ -1,13 +1,30 @@
 #pragma once
 
 #include "Common.h"
+#include <string>
 #include <vector>
 
 enum CSWeaponID;
 class Frag;
+struct Player;
+struct kill_info_t;
 
 typedef std::vector< Frag > FragVector;
 
+/**
+ * The player's kills on a round, gathered once before they are checked against the frag settings
+ */
+struct round_kills_t
+{
+	std::vector< const kill_info_t * > enemy_kills;		///< Kills that are not teamkills
+	std::vector< short > headshots_before;				///< # of headshots in enemy_kills before each index (has one extra element for the total)
+	std::vector< short > special_kills_before;			///< # of flickshot/midair/noscope/wallbang/blind kills in enemy_kills before each index
+	std::vector< float > time_to_closest_kill;			///< Time from each wallbang kill to the closest other enemy kill (indexed like the player's kills)
+	bool spectated;										///< Whether the last kill was spectated by the POV player
+};
+
+void GatherRoundKills( const Player &player, round_kills_t &round_kills );
+
 // Frag type flags
 #define FL_KILL_DOUBLE			(1<<0)
 #define FL_KILL_TRIPLE			(1<<1)
@@ -49,8 +66,8 @@ struct frag_descriptor_t
 	CSWeaponID weapon;				///< What weapon was used to do this frag
 	float flick_angle;				///< Only relevant if flick flag is set (for string output)
 
-	// Get a description of this action in the form of text (for output)
-	void GetStringRepresentation( char *buffer, size_t buffer_size, bool write_hs = true, bool write_weapon = true ) const;
+	// Append a description of this action in the form of text to the string (for output)
+	void GetStringRepresentation( std::string &out, bool write_hs = true, bool write_weapon = true ) const;
 
 private:
 	int GetRoundedFlickAngle( void ) const;
@@ -79,7 +96,7 @@ struct multi_kill_frag_descriptor_t
 private:
 	enum { PRINT_HS_IN_SUB, PRINT_HS_IN_MAIN, PRINT_HS_IN_BOTH };
 public:
-	void GetStringRepresentation( char *buffer, size_t buffer_size ) const;
+	void GetStringRepresentation( std::string &out ) const;
 
 	void AddWeaponIDs( const CSWeaponID *pWeapons, int num );
 
@@ -106,23 +123,29 @@ public:
 	bool AddMultiKillFragDescriptor( MultiKillFragType type, const CSWeaponID *weapons, short num_weapons, uint32 start_tick, uint32 end_tick, short headshots );
 
 	// Add a descriptor for a 1k/collat frag
-	void AddFragDescriptor( uint32 tick, unsigned short type_flags, short teamkills, short headshots, CSWeaponID weapon, float distance, float flickangle, float time_to_closest_kill );
+	void AddFragDescriptor( uint32 tick, unsigned short type_flags, short teamkills, short headshots, CSWeaponID weapon, float distance, float flickangle, float time_to_closest_kill, int profile = 0 );
 
 	bool IsValidFrag( void ) const;
 
-	void GetStringRepresentation( char *buffer, size_t buffer_size ) const;
+	// Append the frag description to the string, the string can be reused between frags to avoid allocations
+	void GetStringRepresentation( std::string &out ) const;
 
-private:
-	// Get the amount of enemy kills that the descriptors in this frag imply
-	int GetImpliedKillCount( void ) const;
-
-	enum { TEAM_T = 2, TEAM_CT = 3 };
+	// Append only the description of the kills (the "Frag:" line without the prefix)
+	void GetDescription( std::string &out ) const;
 
+	const char *GetPlayername( void ) const { return m_szPlayername; }
 	const char *GetTeamString( void ) const;
+	bool IsSpectated( void ) const { return m_bSpectated; }
 
 	// Get a nice rounded tick for string
 	int GetRoundedTick( void ) const;
 
+private:
+	// Get the amount of enemy kills that the descriptors in this frag imply
+	int GetImpliedKillCount( void ) const;
+
+	enum { TEAM_T = 2, TEAM_CT = 3 };
+
 	char m_szPlayername[ MAX_PLAYER_NAME_LENGTH ];			///< Name is copied in case the player leaves before the demo ends
 	multi_kill_frag_descriptor_t m_multiKillDescriptor;		///< The 5/4/3k descriptor of this frag, if any
 	std::vector< frag_descriptor_t > m_descriptors;			///< What kind of other smaller frags this frag contains that are not contained within the 5/4/3k
@@ -0,0 +1,241 @@
+#include "FragOutput.h"
+#include "Settings.h"
+#include "BatchWriter.h"
+#include <format>
+
+extern std::string g_ProgramDirectory;
+extern BatchWriter g_BatchWriter;
+
+FragOutput::FragOutput( const DemoFile *pDemo )
+	: m_pDemo( pDemo )
+	, m_bIsPOV( false )
+	, m_pKept( nullptr )
+	, m_Profiles( Settings()->GetNumProfiles() )
+{
+}
+
+// =====================================================================================================================================================================
+
+void FragOutput::SetPOV( bool bIsPOV )
+{
+	m_bIsPOV = bIsPOV;
+
+	if( m_pKept )
+		m_pKept->bIsPOV = bIsPOV;
+}
+
+// =====================================================================================================================================================================
+
+void FragOutput::KeepOutput( KeptOutput_t *pKept )
+{
+	m_pKept = pKept;
+
+	m_pKept->fragText.assign( m_Profiles.size(), std::string() );
+	m_pKept->numFrags.assign( m_Profiles.size(), 0 );
+}
+
+// =====================================================================================================================================================================
+
+int FragOutput::GetNumFrags( int profile ) const
+{
+	return m_Profiles[ profile ].numFrags;
+}
+
+// =====================================================================================================================================================================
+
+void FragOutput::OpenDumpFile( int profile )
+{
+	ProfileOutput_t &output = m_Profiles[ profile ];
+
+	output.dumpFilename = m_pDemo->GetFileName();
+	RemoveDemoExtension( output.dumpFilename );
+
+	if( m_Profiles.size() > 1 )
+		output.dumpFilename += "_" + Settings()->GetProfileName( profile );
+
+	output.dumpFilename += ".txt";
+
+	if( Settings()->WriteOutputToDemoDirectory() )
+	{
+		output.dumpFile.open( output.dumpFilename );
+	}
+	else
+	{
+		output.dumpFile.open( g_ProgramDirectory + output.dumpFilename );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void FragOutput::OnFrag( const Frag &frag, int profile )
+{
+	ProfileOutput_t &output = m_Profiles[ profile ];
+
+	// The buffer keeps its capacity, so formatting doesn't allocate after the first few frags
+	m_strFragText.clear();
+	frag.GetStringRepresentation( m_strFragText );
+
+	if( Settings()->BatchProcessingEnabled() )
+	{
+		if( output.numFrags == 0 )
+			g_BatchWriter.Write( profile, "========== " + m_pDemo->GetFileName() + ( m_bIsPOV ? " (POV)" : " (STV)" ) + " ==========\n\n" );
+
+		g_BatchWriter.Write( profile, m_strFragText );
+
+		if( m_pKept )
+		{
+			m_pKept->fragText[ profile ] += m_strFragText;
+			++m_pKept->numFrags[ profile ];
+		}
+	}
+	else
+	{
+		if( Settings()->DumpToFileEnabled() )
+		{
+			if( output.numFrags == 0 )
+				OpenDumpFile( profile );
+
+			if( output.dumpFile.is_open() )
+			{
+				output.dumpFile.write( m_strFragText.c_str(), m_strFragText.length() );
+				output.dumpFile.flush();
+			}
+		}
+
+		output.consoleLines.push_back( m_strFragText );
+	}
+
+	++output.numFrags;
+}
+
+// =====================================================================================================================================================================
+
+void FragOutput::Finish( void )
+{
+	const int numProfiles = (int)m_Profiles.size();
+
+	// Frag counts on the batch progress line
+	if( Settings()->BatchProcessingEnabled() )
+	{
+		std::vector< int > numFrags( numProfiles );
+
+		for( int profile = 0; profile < numProfiles; ++profile )
+			numFrags[ profile ] = m_Profiles[ profile ].numFrags;
+
+		PrintBatchFragCounts( numFrags );
+		return;
+	}
+
+	for( int profile = 0; profile < numProfiles; ++profile )
+	{
+		ProfileOutput_t &output = m_Profiles[ profile ];
+
+		if( output.numFrags > 0 )
+		{
+			if( numProfiles > 1 )
+				printf( "\n========== FOUND FRAGS (%s) ==========\n\n", Settings()->GetProfileName( profile ).c_str() );
+			else
+				printf( "\n========== FOUND FRAGS ==========\n\n" );
+
+			for( size_t i = 0; i < output.consoleLines.size(); ++i )
+				printf( "%s", output.consoleLines[ i ].c_str() );
+
+			output.consoleLines.clear();
+
+			if( output.dumpFile.is_open() )
+			{
+				printf( "Output has been written to file %s in %s folder\n\n", output.dumpFilename.c_str(), Settings()->WriteOutputToDemoDirectory()? "demo's" : "program" );
+
+				output.dumpFile.close();
+			}
+		}
+		else
+		{
+			if( numProfiles > 1 )
+				printf( "\nNo frags found with the settings of %s.\n\n", Settings()->GetProfileName( profile ).c_str() );
+			else
+				printf( "\nNo frags found with the current settings.\n\n" );
+		}
+	}
+}
+
+// =====================================================================================================================================================================
+
+void FragOutput::PrintBatchFragCounts( const std::vector< int > &numFrags )
+{
+	const int numProfiles = (int)numFrags.size();
+
+	if( numProfiles == 1 )
+	{
+		if( numFrags[ 0 ] > 0 )
+			printf( " (%d frag%s found)\n", numFrags[ 0 ], numFrags[ 0 ] > 1? "s":"" );
+		else
+			printf( " (no frags found)\n" );
+	}
+	else
+	{
+		printf( " (frags found:" );
+
+		for( int profile = 0; profile < numProfiles; ++profile )
+			printf( "%s %s %d", profile? "," : "", Settings()->GetProfileName( profile ).c_str(), numFrags[ profile ] );
+
+		printf( ")\n" );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void FragOutput::WriteKeptOutput( const KeptOutput_t &kept, const std::string &demoName )
+{
+	for( size_t profile = 0; profile < kept.fragText.size(); ++profile )
+	{
+		if( kept.numFrags[ profile ] == 0 )
+			continue;
+
+		g_BatchWriter.Write( (int)profile, "========== " + demoName + ( kept.bIsPOV ? " (POV)" : " (STV)" ) + " ==========\n\n" );
+		g_BatchWriter.Write( (int)profile, kept.fragText[ profile ] );
+	}
+
+	PrintBatchFragCounts( kept.numFrags );
+}
+
+// =====================================================================================================================================================================
+
+void FragLines::OnFrag( const Frag &frag, int profile )
+{
+	if( m_iProfile >= 0 && profile != m_iProfile )
+		return;
+
+	std::format_to( std::back_inserter( m_strText ), "FRAG\t{}\t{}\t", profile, frag.GetRoundedTick() );
+	AppendField( frag.GetPlayername() );
+	std::format_to( std::back_inserter( m_strText ), "\t{}\t{}\t", frag.GetTeamString(), frag.IsSpectated()? 1 : 0 );
+
+	const size_t start = m_strText.length();
+	frag.GetDescription( m_strText );
+	ReplaceSeparators( start );
+
+	m_strText += '\n';
+	++m_iNumFrags;
+}
+
+// =====================================================================================================================================================================
+
+void FragLines::AppendField( const char *pText )
+{
+	const size_t start = m_strText.length();
+	m_strText += pText;
+	ReplaceSeparators( start );
+}
+
+// =====================================================================================================================================================================
+
+void FragLines::ReplaceSeparators( size_t start )
+{
+	for( size_t i = start; i < m_strText.length(); ++i )
+	{
+		if( m_strText[ i ] == '\t' || m_strText[ i ] == '\r' || m_strText[ i ] == '\n' )
+			m_strText[ i ] = ' ';
+	}
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Frag.h"
+#include "DemoFile.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Receives frags as soon as they are final (a player's frag can't change after the round it was done in has ended)
+ */
+class FragSink
+{
+public:
+	virtual ~FragSink() {}
+
+	virtual void OnFrag( const Frag &frag, int profile ) = 0;
+};
+
+/**
+ * Formats frags into tab separated lines for other programs to read:
+ *   FRAG <profile> <tick> <player> <team> <spectated 0/1> <description>
+ */
+class FragLines : public FragSink
+{
+public:
+	FragLines( int profile ) : m_iNumFrags( 0 ), m_iProfile( profile ) {}
+
+	virtual void OnFrag( const Frag &frag, int profile );
+
+	std::string			m_strText;
+	int					m_iNumFrags;
+
+private:
+	void AppendField( const char *pText );
+	void ReplaceSeparators( size_t start );		///< Player names can contain anything, so make sure they don't break the line format
+
+	int					m_iProfile;				///< -1 for all profiles
+};
+
+/**
+ * Batch output of a demo, kept so that it can be written again for copies of the same demo
+ */
+struct KeptOutput_t
+{
+	KeptOutput_t( void ) : bIsPOV( false ), bComplete( false ) {}
+
+	bool						bIsPOV;
+	bool						bComplete;		///< Whether the demo was parsed to the end
+	std::vector< std::string >	fragText;		///< Frags without the demo name line, per settings profile
+	std::vector< int >			numFrags;
+};
+
+/**
+ * Outputs the frags of the demo being parsed for every settings profile
+ *
+ * Frags are written to the dump file and the batch output right away. Frags of a single demo are also printed
+ * at the end, so that they don't get mixed with the progress bar.
+ */
+class FragOutput : public FragSink
+{
+public:
+	FragOutput( const DemoFile *pDemo );
+
+	virtual void OnFrag( const Frag &frag, int profile );
+
+	void SetPOV( bool bIsPOV );					///< Demo type for the batch output, known once SVC_ServerInfo has been read
+	void Finish( void );						///< Prints the found frags and closes the dump files
+	int GetNumFrags( int profile ) const;
+
+	void KeepOutput( KeptOutput_t *pKept );		///< Also copy the batch output to pKept
+	static void WriteKeptOutput( const KeptOutput_t &kept, const std::string &demoName );	///< Writes kept batch output again under another demo name
+
+private:
+	static void PrintBatchFragCounts( const std::vector< int > &numFrags );
+
+	struct ProfileOutput_t
+	{
+		ProfileOutput_t( void ) : numFrags( 0 ) {}
+
+		int							numFrags;
+		std::string					dumpFilename;
+		std::ofstream				dumpFile;
+		std::vector< std::string >	consoleLines;	///< Frags of a single demo to print at the end
+	};
+
+	void OpenDumpFile( int profile );
+
+	const DemoFile *				m_pDemo;
+	bool							m_bIsPOV;
+	std::string						m_strFragText;		///< Reused for formatting every frag
+	KeptOutput_t *					m_pKept;
+	std::vector< ProfileOutput_t >	m_Profiles;
+};
\ No newline at end of file
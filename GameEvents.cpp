@@ -279,6 +279,9 @@ void DemoParser::HandlePlayerDeathEvent( bf_read &reader, const GameEvent &event
 		m_bPOVPlayerIsDead = true;
 	}
 
+	// Resolve the weapon name once, the rest of the kill handling only uses the ID
+	const CSWeaponID weaponID = AliasToWeaponID( weaponName );
+
 	bool bSpectatingAttacker = false;
 	bool bSuicide = !pAttacker || pAttacker == pVictim;
 
@@ -366,7 +369,7 @@ void DemoParser::HandlePlayerDeathEvent( bf_read &reader, const GameEvent &event
 			}
 		}
 
-		bool bullet_kill = WeaponUsesBullets( weaponName );
+		bool bullet_kill = WeaponUsesBullets( weaponID );
 
 		// Add bullet kills to post check list
 		if( bullet_kill )
@@ -439,7 +442,7 @@ void DemoParser::HandlePlayerDeathEvent( bf_read &reader, const GameEvent &event
 		}
 
 		// ===== Noscope check ====================
-		if( !noscope && WeaponIsSniper( weaponName ) )
+		if( !noscope && WeaponIsSniper( weaponID ) )
 		{
 			prop = pEntAttacker->FindProp( "m_iFOV" );
 
@@ -484,7 +487,7 @@ void DemoParser::HandlePlayerDeathEvent( bf_read &reader, const GameEvent &event
 			distance = to.Length();
 		}
 
-		pAttacker->AddKill( m_iCurrentTick, attackerTeam, weaponName, teamkill, headshot, noscope, midair, penetrated, flickshot, distance, vecAttacker, bSpectatingAttacker, blind_kill );
+		pAttacker->AddKill( m_iCurrentTick, attackerTeam, weaponID, teamkill, headshot, noscope, midair, penetrated, flickshot, distance, vecAttacker, bSpectatingAttacker, blind_kill );
 	}
 }
 
@@ -548,6 +551,12 @@ void DemoParser::HandleRoundStartEvent( bf_read &reader, const GameEvent &event
 	{
 		it->ResetKills();
 	}
+
+	// Keyframes are saved after the whole command has been handled
+	if( m_pSeekIndex )
+		m_bSaveSeekKeyframe = true;
+
+	OnSegmentRoundStart();
 }
 
 // =====================================================================================================================================================================
\ No newline at end of file
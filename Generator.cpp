@@ -0,0 +1,1068 @@
+#include "Generator.h"
+#include "DemoFile.h"
+#include "Entities.h"
+#include "GameEvents.h"
+#include "Gzip.h"
+#include "Netmessages.h"
+#include "Player.h"
+#include "bitbuf.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <vector>
+
+// Demo generator
+//
+// Writes a demo that the parser reads like a real CS:S v34 STV demo. The signon has SVC_ServerInfo, the userinfo string
+// table, SVC_GameEventList and the data tables of a minimal player class, and every tick after sync tick is a packet with
+// the entity deltas of the living players and the game events of the round. Every round starts with round_start and a
+// full entity update, so once the seek index has been written the demo is split into segments at every round.
+//
+// The kill pattern makes one player per round kill the given number of enemies in quick succession (AK-47 headshots),
+// which the default settings tick as a frag. The other kills of the round are made by different players, one kill each,
+// so they don't add frags of their own.
+//
+// The gzipped copies are test files for the decompressor: the demo is compressed with only stored, fixed Huffman or
+// dynamic Huffman blocks, and once as three members of different block types. Each copy is read back like a demo that is
+// parsed, and it has to decompress to the same bytes as the demo.
+
+#define GENERATOR_PACKET_SIZE			262144	// Max size of one packet in bytes
+#define GENERATOR_MESSAGE_SIZE			131072	// Max size of the data of one message in bytes
+#define GENERATOR_ROUND_SECONDS			90
+#define GENERATOR_MULTIKILL_INTERVAL	0.15f	// Seconds between the kills of a scripted multikill
+#define GENERATOR_USERINFO_ENTRIES		256		// Must be a power of two
+#define GENERATOR_MAP_SIZE				2000.f	// Players move inside this distance from the map origin
+#define GENERATOR_PLAYER_SPEED			200.f	// Units per second
+
+// =====================================================================================================================================================================
+
+enum
+{
+	CLASS_WORLD = 0,
+	CLASS_CSPLAYER,
+	NUM_SERVER_CLASSES
+};
+
+/**
+ * Flattened prop indices of CCSPlayer
+ * The props that change often are declared first, so flattening doesn't reorder them.
+ */
+enum
+{
+	PROP_EYEANGLES0 = 0,
+	PROP_EYEANGLES1,
+	PROP_ORIGIN,
+	PROP_FLAGS,
+	PROP_FOV,
+	PROP_TEAMNUM,		///< From the collapsed DT_BaseEntity
+};
+
+enum
+{
+	EVENT_PLAYER_DEATH = 0,
+	EVENT_PLAYER_SPAWN,
+	EVENT_ROUND_START,
+	EVENT_ROUND_END,
+	NUM_GENERATOR_EVENTS
+};
+
+struct GeneratorSendProp_t
+{
+	SendPropType		type;
+	const char *		name;
+	int					flags;
+	float				lowValue;
+	float				highValue;
+	int					bits;
+	const char *		dtName;					///< Only for data table props
+};
+
+struct GeneratorSendTable_t
+{
+	const char *				name;
+	const GeneratorSendProp_t *	props;
+	int							numProps;
+};
+
+static const GeneratorSendProp_t s_BaseEntityProps[] =
+{
+	{ DPT_Int,			"m_iTeamNum",			0,											0.f,	0.f,	6,	nullptr },
+};
+
+static const GeneratorSendProp_t s_WorldSpawnProps[] =
+{
+	{ DPT_DataTable,	"baseclass",			SPROP_COLLAPSIBLE | SPROP_PROXY_ALWAYS_YES,	0.f,	0.f,	0,	"DT_BaseEntity" },
+};
+
+static const GeneratorSendProp_t s_CSPlayerProps[] =
+{
+	{ DPT_Float,		"m_angEyeAngles[0]",	SPROP_CHANGES_OFTEN,						0.f,	360.f,	16,	nullptr },
+	{ DPT_Float,		"m_angEyeAngles[1]",	SPROP_CHANGES_OFTEN,						0.f,	360.f,	16,	nullptr },
+	{ DPT_Vector,		"m_vecOrigin",			SPROP_COORD | SPROP_CHANGES_OFTEN,			0.f,	0.f,	0,	nullptr },
+	{ DPT_Int,			"m_fFlags",				SPROP_UNSIGNED,								0.f,	0.f,	11,	nullptr },
+	{ DPT_Int,			"m_iFOV",				SPROP_UNSIGNED,								0.f,	0.f,	8,	nullptr },
+	{ DPT_DataTable,	"baseclass",			SPROP_COLLAPSIBLE | SPROP_PROXY_ALWAYS_YES,	0.f,	0.f,	0,	"DT_BaseEntity" },
+};
+
+static const GeneratorSendTable_t s_SendTables[] =
+{
+	{ "DT_BaseEntity",	s_BaseEntityProps,	std::size( s_BaseEntityProps ) },
+	{ "DT_WorldSpawn",	s_WorldSpawnProps,	std::size( s_WorldSpawnProps ) },
+	{ "DT_CSPlayer",	s_CSPlayerProps,	std::size( s_CSPlayerProps ) },
+};
+
+// In class ID order
+static const char *s_ServerClasses[ NUM_SERVER_CLASSES ][ 2 ] =
+{
+	{ "CWorld",		"DT_WorldSpawn" },
+	{ "CCSPlayer",	"DT_CSPlayer" },
+};
+
+struct GeneratorEvent_t
+{
+	const char *		name;
+
+	struct
+	{
+		const char *		name;
+		GameEventValueType	type;
+	}
+	fields[ 4 ];								///< Ends at the first VAL_NONE
+};
+
+// In event ID order, the values are written in the order of the fields
+static const GeneratorEvent_t s_GameEvents[ NUM_GENERATOR_EVENTS ] =
+{
+	{ "player_death",	{ { "userid", VAL_SHORT }, { "attacker", VAL_SHORT }, { "weapon", VAL_STRING }, { "headshot", VAL_BOOL } } },
+	{ "player_spawn",	{ { "userid", VAL_SHORT } } },
+	{ "round_start",	{ { "timelimit", VAL_LONG }, { "fraglimit", VAL_LONG }, { "objective", VAL_STRING } } },
+	{ "round_end",		{ { "winner", VAL_BYTE }, { "reason", VAL_BYTE }, { "message", VAL_STRING } } },
+};
+
+// Weapons of the kills that are not scripted
+static const char *s_FillerWeapons[] = { "ak47", "m4a1", "deagle", "usp", "glock", "awp", "mp5navy", "famas", "galil", "p90" };
+
+/**
+ * Userinfo string table data, which the parser reads as the start of a Player (public/cdll_int.h)
+ */
+struct player_info_t
+{
+	char				name[ MAX_PLAYER_NAME_LENGTH ];
+	int					userID;
+	char				guid[ SIGNED_GUID_LEN + 1 ];
+	uint32				friendsID;
+	char				friendsName[ MAX_PLAYER_NAME_LENGTH ];
+	bool				fakeplayer;
+	bool				ishltv;
+	CRC32_t				customfiles[ MAX_CUSTOM_FILES ];
+	unsigned char		filesDownloaded;
+};
+
+struct GeneratorPlayer_t
+{
+	int					userID;
+	int					team;
+	bool				bAlive;
+	Vector				origin;
+	float				pitch;
+	float				yaw;
+};
+
+struct GeneratorKill_t
+{
+	int					tick;					///< Tick from the start of the round
+	int					attacker;				///< Index in the player list
+	int					victim;
+	const char *		weapon;
+	bool				bHeadshot;
+};
+
+// =====================================================================================================================================================================
+
+class DemoGenerator
+{
+public:
+	DemoGenerator( const GeneratorOptions_t &options );
+
+	bool ParseKillPattern( void );
+	bool Generate( const std::string &filename );
+
+	int GetNumRounds( void ) const { return m_iNumRounds; }
+	int GetNumScriptedFrags( int kills ) const { return m_iScriptedFrags[ kills ]; }
+	int64 GetFileSize( void ) const { return m_iFileSize; }
+
+private:
+	// Demo commands
+	void WriteInt( int32 value );
+	void WriteCommandHeader( byte cmd, int tick );
+	void WritePacket( byte cmd, int tick );			///< Writes the messages in m_Packet as a packet and clears it
+	void WriteDataTables( int tick );
+
+	// Messages
+	void WriteMessageType( int msg );
+	void WriteMessageData( void );					///< Appends the bits in m_Data to m_Packet and clears it
+	void WriteSignonMessages( void );
+	void WriteUserInfoTable( void );
+	void WriteGameEventList( void );
+	void WritePacketEntities( bool bFullUpdate );
+	void WritePlayerProps( const GeneratorPlayer_t &player, bool bFullUpdate );
+	void BeginGameEvent( int eventID );
+	void EndGameEvent( void );
+
+	// Rounds
+	void PlanRound( int round, std::vector< GeneratorKill_t > &kills );
+	bool PickFillerKill( int featured, std::vector< bool > &alive, std::vector< bool > &killed, GeneratorKill_t &kill );
+	void WriteRound( int round );
+	void SpawnPlayers( void );
+	void MovePlayers( void );
+
+	void ClearBuffer( bf_write &writer );
+	int64 GetWrittenSize( void ) { return (int64)m_File.tellp(); }
+
+	const GeneratorOptions_t &m_Options;
+	std::ofstream		m_File;
+	std::mt19937		m_Random;
+
+	std::vector< uint32 > m_PacketBuffer;
+	std::vector< uint32 > m_DataBuffer;
+	bf_write			m_Packet;						///< Messages of the packet being written
+	bf_write			m_Data;							///< Data of the message being written
+
+	std::vector< GeneratorPlayer_t > m_Players;
+	std::vector< int >	m_KillPattern;					///< Empty for random kills
+	int					m_iServerClassBits;
+	float				m_fTickInterval;
+	int					m_iTick;
+	int					m_iNumFrames;
+	int					m_iSequence;
+	int					m_iNumRounds;
+	int64				m_iFileSize;
+	int					m_iScriptedFrags[ 6 ];			///< # of scripted rounds by the number of kills
+};
+
+// =====================================================================================================================================================================
+
+DemoGenerator::DemoGenerator( const GeneratorOptions_t &options ) : m_Options( options ), m_Random( options.seed )
+{
+	m_PacketBuffer.resize( GENERATOR_PACKET_SIZE / sizeof( uint32 ) );
+	m_DataBuffer.resize( GENERATOR_MESSAGE_SIZE / sizeof( uint32 ) );
+	m_Packet.StartWriting( m_PacketBuffer.data(), GENERATOR_PACKET_SIZE );
+	m_Data.StartWriting( m_DataBuffer.data(), GENERATOR_MESSAGE_SIZE );
+
+	// Same as the parser
+	int nTemp = NUM_SERVER_CLASSES;
+	m_iServerClassBits = 0;
+	while( nTemp >>= 1 )
+		++m_iServerClassBits;
+
+	m_iServerClassBits++;
+
+	m_fTickInterval = 1.f / options.tickRate;
+	m_iTick = 0;
+	m_iNumFrames = 0;
+	m_iSequence = 1;
+	m_iNumRounds = 0;
+	m_iFileSize = 0;
+	memset( m_iScriptedFrags, 0, sizeof( m_iScriptedFrags ) );
+
+	// Two teams, the players of a team are every other player
+	for( int i = 0; i < options.numPlayers; ++i )
+	{
+		GeneratorPlayer_t player;
+		player.userID = i + 2;
+		player.team = 2 + i % 2;
+		player.bAlive = true;
+		player.pitch = 0.f;
+		player.yaw = 0.f;
+
+		m_Players.push_back( player );
+	}
+}
+
+// =====================================================================================================================================================================
+
+bool DemoGenerator::ParseKillPattern( void )
+{
+	if( m_Options.killPattern == "random" )
+		return true;
+
+	const char *p = m_Options.killPattern.c_str();
+
+	while( *p )
+	{
+		char *end;
+		long kills = strtol( p, &end, 10 );
+
+		if( end == p || kills < 0 || kills > 5 )
+			return false;
+
+		m_KillPattern.push_back( (int)kills );
+
+		p = end;
+
+		if( *p == ',' )
+			++p;
+		else if( *p )
+			return false;
+	}
+
+	return !m_KillPattern.empty();
+}
+
+// =====================================================================================================================================================================
+
+bool DemoGenerator::Generate( const std::string &filename )
+{
+	m_File.open( filename, std::ios::binary | std::ios::trunc );
+
+	if( !m_File.is_open() )
+		return false;
+
+	demoheader_t header;
+	memset( &header, 0, sizeof( header ) );
+	strcpy_s( header.demofilestamp, DEMO_HEADER_ID );
+	header.demoprotocol = DEMO_PROTOCOL;
+	header.networkprotocol = NETWORK_PROTOCOL_V34;
+	strcpy_s( header.servername, "cssff generator" );
+	strcpy_s( header.clientname, "SourceTV Demo" );
+	strcpy_s( header.mapname, "de_dust2" );
+	strcpy_s( header.gamedirectory, CSS_GAMEDIR );
+
+	// The lengths are filled in at the end
+	m_File.write( (const char *)&header, sizeof( header ) );
+
+	// Signon
+	WriteSignonMessages();
+	WritePacket( dem_signon, m_iTick );
+
+	WriteDataTables( m_iTick );
+
+	WriteMessageType( NET_SignOnState );
+	m_Packet.WriteByte( 6 );	// SIGNONSTATE_FULL
+	m_Packet.WriteLong( 1 );
+	WritePacket( dem_signon, m_iTick );
+
+	header.signonlength = (int32)( GetWrittenSize() - sizeof( header ) );
+
+	// Kills are ignored during the first half second of the demo
+	m_iTick = m_Options.tickRate;
+	const int startTick = m_iTick;
+
+	WriteCommandHeader( dem_synctick, m_iTick );
+
+	for( int round = 0; m_Options.targetSize? GetWrittenSize() < m_Options.targetSize : round < m_Options.numRounds; ++round )
+	{
+		WriteRound( round );
+		++m_iNumRounds;
+
+		if( !m_File.good() )
+			return false;
+	}
+
+	WriteCommandHeader( dem_stop, m_iTick );
+
+	header.playback_ticks = m_iTick - startTick;
+	header.playback_time = header.playback_ticks * m_fTickInterval;
+	header.playback_frames = m_iNumFrames;
+
+	m_iFileSize = GetWrittenSize();
+
+	m_File.seekp( 0 );
+	m_File.write( (const char *)&header, sizeof( header ) );
+
+	return m_File.good();
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteInt( int32 value )
+{
+	m_File.write( (const char *)&value, sizeof( value ) );
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteCommandHeader( byte cmd, int tick )
+{
+	m_File.put( (char)cmd );
+	WriteInt( tick );
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WritePacket( byte cmd, int tick )
+{
+	WriteCommandHeader( cmd, tick );
+
+	democmdinfo_t info;
+	memset( &info, 0, sizeof( info ) );
+	m_File.write( (const char *)&info, sizeof( info ) );
+
+	WriteInt( m_iSequence );	// nSeqNrIn
+	WriteInt( m_iSequence );	// nSeqNrOut
+	++m_iSequence;
+
+	WriteInt( m_Packet.GetNumBytesWritten() );
+	m_File.write( (const char *)m_Packet.GetData(), m_Packet.GetNumBytesWritten() );
+
+	ClearBuffer( m_Packet );
+	++m_iNumFrames;
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteDataTables( int tick )
+{
+	for( size_t i = 0; i < std::size( s_SendTables ); ++i )
+	{
+		const GeneratorSendTable_t &table = s_SendTables[ i ];
+
+		m_Data.WriteOneBit( 1 );
+		m_Data.WriteOneBit( 0 );	// needsdecoder
+		m_Data.WriteString( table.name );
+		m_Data.WriteUBitLong( table.numProps, 9 );
+
+		for( int j = 0; j < table.numProps; ++j )
+		{
+			const GeneratorSendProp_t &prop = table.props[ j ];
+
+			m_Data.WriteUBitLong( prop.type, 5 );
+			m_Data.WriteString( prop.name );
+			m_Data.WriteUBitLong( prop.flags, 13 );
+
+			if( prop.type == DPT_DataTable )
+			{
+				m_Data.WriteString( prop.dtName );
+			}
+			else
+			{
+				m_Data.WriteFloat( prop.lowValue );
+				m_Data.WriteFloat( prop.highValue );
+				m_Data.WriteUBitLong( prop.bits, 6 );
+			}
+		}
+	}
+
+	m_Data.WriteOneBit( 0 );
+
+	m_Data.WriteShort( NUM_SERVER_CLASSES );
+
+	for( int i = 0; i < NUM_SERVER_CLASSES; ++i )
+	{
+		m_Data.WriteShort( i );
+		m_Data.WriteString( s_ServerClasses[ i ][ 0 ] );
+		m_Data.WriteString( s_ServerClasses[ i ][ 1 ] );
+	}
+
+	WriteCommandHeader( dem_datatables, tick );
+	WriteInt( m_Data.GetNumBytesWritten() );
+	m_File.write( (const char *)m_Data.GetData(), m_Data.GetNumBytesWritten() );
+
+	ClearBuffer( m_Data );
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteMessageType( int msg )
+{
+	m_Packet.WriteUBitLong( msg, 5 );
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteMessageData( void )
+{
+	m_Packet.WriteBits( m_Data.GetData(), m_Data.GetNumBitsWritten() );
+
+	ClearBuffer( m_Data );
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteSignonMessages( void )
+{
+	WriteMessageType( NET_Tick );
+	m_Packet.WriteLong( m_iTick );
+
+	WriteMessageType( SVC_ServerInfo );
+	m_Packet.WriteShort( NETWORK_PROTOCOL_V34 );
+	m_Packet.WriteLong( 1 );						// servercount
+	m_Packet.WriteOneBit( 1 );						// ishltv
+	m_Packet.WriteOneBit( 1 );						// isdedicated
+	m_Packet.WriteLong( 0 );						// clientcrc
+	m_Packet.WriteShort( NUM_SERVER_CLASSES );
+	m_Packet.WriteLong( 0 );						// mapcrc
+	m_Packet.WriteByte( m_Options.numPlayers );		// playerslot
+	m_Packet.WriteByte( GENERATOR_MAX_PLAYERS );
+	m_Packet.WriteFloat( m_fTickInterval );
+	m_Packet.WriteChar( 'w' );
+	m_Packet.WriteString( CSS_GAMEDIR );
+	m_Packet.WriteString( "de_dust2" );
+	m_Packet.WriteString( "sky_dust" );
+	m_Packet.WriteString( "cssff generator" );
+
+	WriteMessageType( SVC_ClassInfo );
+	m_Packet.WriteShort( NUM_SERVER_CLASSES );
+	m_Packet.WriteOneBit( 1 );						// createonclient
+
+	// A table that the parser skips
+	WriteMessageType( SVC_CreateStringTable );
+	m_Packet.WriteString( "downloadables" );
+	m_Packet.WriteShort( 8192 );
+	m_Packet.WriteUBitLong( 0, (int)(Log2( 8192 )+1) );
+	m_Packet.WriteUBitLong( 0, 20 );
+	m_Packet.WriteOneBit( 0 );
+
+	WriteUserInfoTable();
+
+	WriteMessageType( SVC_VoiceInit );
+	m_Packet.WriteString( "vaudio_speex" );
+	m_Packet.WriteByte( 5 );
+
+	WriteGameEventList();
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteUserInfoTable( void )
+{
+	for( size_t i = 0; i < m_Players.size(); ++i )
+	{
+		player_info_t info;
+		memset( &info, 0, sizeof( info ) );
+		_snprintf_s( info.name, sizeof( info.name ), _TRUNCATE, "Player%d", (int)i + 1 );
+		info.userID = m_Players[ i ].userID;
+		_snprintf_s( info.guid, sizeof( info.guid ), _TRUNCATE, "STEAM_0:1:%d", 1000 + (int)i );
+		info.friendsID = 2000 + (uint32)i;
+
+		char entry[ 16 ];
+		_snprintf_s( entry, sizeof( entry ), _TRUNCATE, "%d", (int)i );
+
+		m_Data.WriteOneBit( 1 );	// Entries are in order
+		m_Data.WriteOneBit( 1 );	// Has a string
+		m_Data.WriteOneBit( 0 );	// Not a substring of a previous entry
+		m_Data.WriteString( entry );
+		m_Data.WriteOneBit( 1 );	// Has user data
+		m_Data.WriteUBitLong( sizeof( info ), 12 );
+		m_Data.WriteBytes( &info, sizeof( info ) );
+	}
+
+	WriteMessageType( SVC_CreateStringTable );
+	m_Packet.WriteString( "userinfo" );
+	m_Packet.WriteShort( GENERATOR_USERINFO_ENTRIES );
+	m_Packet.WriteUBitLong( m_Options.numPlayers, (int)(Log2( GENERATOR_USERINFO_ENTRIES )+1) );
+	m_Packet.WriteUBitLong( m_Data.GetNumBitsWritten(), 20 );
+	m_Packet.WriteOneBit( 0 );						// user_data_fixed_size
+	WriteMessageData();
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteGameEventList( void )
+{
+	for( int i = 0; i < NUM_GENERATOR_EVENTS; ++i )
+	{
+		const GeneratorEvent_t &event = s_GameEvents[ i ];
+
+		m_Data.WriteUBitLong( i, 9 );
+		m_Data.WriteString( event.name );
+
+		for( size_t j = 0; j < std::size( event.fields ) && event.fields[ j ].type != VAL_NONE; ++j )
+		{
+			m_Data.WriteUBitLong( event.fields[ j ].type, 3 );
+			m_Data.WriteString( event.fields[ j ].name );
+		}
+
+		m_Data.WriteUBitLong( VAL_NONE, 3 );
+	}
+
+	WriteMessageType( SVC_GameEventList );
+	m_Packet.WriteUBitLong( NUM_GENERATOR_EVENTS, 9 );
+	m_Packet.WriteUBitLong( m_Data.GetNumBitsWritten(), 20 );
+	WriteMessageData();
+}
+
+// =====================================================================================================================================================================
+/**
+ * Full updates have every player, deltas only the living players
+ */
+void DemoGenerator::WritePacketEntities( bool bFullUpdate )
+{
+	int nHeaderBase = -1;
+	int numUpdated = 0;
+
+	for( size_t i = 0; i < m_Players.size(); ++i )
+	{
+		const GeneratorPlayer_t &player = m_Players[ i ];
+
+		if( !bFullUpdate && !player.bAlive )
+			continue;
+
+		// Player entities are right after the world
+		const int nEntity = (int)i + 1;
+
+		m_Data.WriteUBitVar( nEntity - nHeaderBase - 1 );
+		nHeaderBase = nEntity;
+
+		m_Data.WriteOneBit( 0 );	// Leave PVS
+
+		if( bFullUpdate )
+		{
+			m_Data.WriteOneBit( 1 );	// Enter PVS
+			m_Data.WriteUBitLong( CLASS_CSPLAYER, m_iServerClassBits );
+			m_Data.WriteUBitLong( nEntity, NUM_NETWORKED_EHANDLE_SERIAL_NUMBER_BITS );
+		}
+		else
+		{
+			m_Data.WriteOneBit( 0 );
+		}
+
+		WritePlayerProps( player, bFullUpdate );
+		++numUpdated;
+	}
+
+	WriteMessageType( SVC_PacketEntities );
+	m_Packet.WriteUBitLong( m_Options.numPlayers + 1, MAX_EDICT_BITS );
+	m_Packet.WriteOneBit( !bFullUpdate );
+
+	if( !bFullUpdate )
+		m_Packet.WriteLong( m_iTick - 1 );
+
+	m_Packet.WriteUBitLong( 0, 1 );					// baseline
+	m_Packet.WriteUBitLong( numUpdated, MAX_EDICT_BITS );
+	m_Packet.WriteUBitLong( m_Data.GetNumBitsWritten(), 20 );
+	m_Packet.WriteOneBit( 0 );						// updatebaseline
+	WriteMessageData();
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WritePlayerProps( const GeneratorPlayer_t &player, bool bFullUpdate )
+{
+	const int numProps = bFullUpdate? PROP_TEAMNUM + 1 : PROP_ORIGIN + 1;
+
+	// Every prop is sent, so the index deltas are 0
+	for( int index = 0; index < numProps; ++index )
+	{
+		m_Data.WriteOneBit( 1 );
+		m_Data.WriteUBitVar( 0 );
+
+		switch( index )
+		{
+			case PROP_EYEANGLES0:
+			case PROP_EYEANGLES1:
+			{
+				float angle = ( index == PROP_EYEANGLES0 )? player.pitch : player.yaw;
+				angle = fmodf( angle + 360.f, 360.f );
+
+				m_Data.WriteUBitLong( (uint32)( angle / 360.f * ( ( 1 << 16 ) - 1 ) + 0.5f ), 16 );
+				break;
+			}
+
+			case PROP_ORIGIN:
+			{
+				m_Data.WriteBitCoord( player.origin.x );
+				m_Data.WriteBitCoord( player.origin.y );
+				m_Data.WriteBitCoord( player.origin.z );
+				break;
+			}
+
+			case PROP_FLAGS:
+			{
+				m_Data.WriteUBitLong( FL_ONGROUND, 11 );
+				break;
+			}
+
+			case PROP_FOV:
+			{
+				m_Data.WriteUBitLong( 90, 8 );
+				break;
+			}
+
+			case PROP_TEAMNUM:
+			{
+				m_Data.WriteSBitLong( player.team, 6 );
+				break;
+			}
+		}
+	}
+
+	m_Data.WriteOneBit( 0 );
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::BeginGameEvent( int eventID )
+{
+	m_Data.WriteUBitLong( eventID, 9 );
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::EndGameEvent( void )
+{
+	WriteMessageType( SVC_GameEvent );
+	m_Packet.WriteUBitLong( m_Data.GetNumBitsWritten(), 11 );
+	WriteMessageData();
+}
+
+// =====================================================================================================================================================================
+/**
+ * Picks the kills of the round in tick order
+ */
+void DemoGenerator::PlanRound( int round, std::vector< GeneratorKill_t > &kills )
+{
+	const int numPlayers = m_Options.numPlayers;
+	const int roundTicks = GENERATOR_ROUND_SECONDS * m_Options.tickRate;
+
+	std::vector< bool > alive( numPlayers, true );
+	std::vector< bool > killed( numPlayers, false );	// Made a kill already
+
+	kills.clear();
+
+	GeneratorKill_t kill;
+	int featured = -1;
+	int tick = roundTicks / 4;
+	int numFillerKills;
+
+	if( m_KillPattern.empty() )
+	{
+		numFillerKills = std::uniform_int_distribution< int >( 1, numPlayers - 1 )( m_Random );
+	}
+	else
+	{
+		// The featured player is a different one each round, and every other player is on the other team
+		featured = round % numPlayers;
+
+		std::vector< int > enemies;
+		for( int i = 0; i < numPlayers; ++i )
+		{
+			if( m_Players[ i ].team != m_Players[ featured ].team )
+				enemies.push_back( i );
+		}
+
+		std::shuffle( enemies.begin(), enemies.end(), m_Random );
+
+		const int numKills = std::min( m_KillPattern[ round % m_KillPattern.size() ], (int)enemies.size() );
+		const int interval = std::max( 1, (int)( GENERATOR_MULTIKILL_INTERVAL * m_Options.tickRate ) );
+
+		for( int i = 0; i < numKills; ++i )
+		{
+			kill.tick = tick;
+			kill.attacker = featured;
+			kill.victim = enemies[ i ];
+			kill.weapon = "ak47";
+			kill.bHeadshot = true;
+			kills.push_back( kill );
+
+			alive[ kill.victim ] = false;
+			tick += interval;
+		}
+
+		killed[ featured ] = true;
+
+		if( numKills >= 2 )
+			++m_iScriptedFrags[ numKills ];
+
+		numFillerKills = std::uniform_int_distribution< int >( 0, numPlayers / 2 )( m_Random );
+	}
+
+	// The rest of the kills are spread over the rest of the round
+	const int fillerStart = tick + m_Options.tickRate;
+	const int fillerEnd = roundTicks - m_Options.tickRate;
+
+	std::vector< int > fillerTicks;
+	for( int i = 0; i < numFillerKills && fillerStart < fillerEnd; ++i )
+		fillerTicks.push_back( std::uniform_int_distribution< int >( fillerStart, fillerEnd )( m_Random ) );
+
+	std::sort( fillerTicks.begin(), fillerTicks.end() );
+
+	for( size_t i = 0; i < fillerTicks.size(); ++i )
+	{
+		if( !PickFillerKill( featured, alive, killed, kill ) )
+			break;
+
+		kill.tick = fillerTicks[ i ];
+		kills.push_back( kill );
+	}
+}
+
+// =====================================================================================================================================================================
+/**
+ * In a scripted round each player makes at most one filler kill, so only the featured player has a multikill
+ * @return						false if nobody can kill anyone anymore
+ */
+bool DemoGenerator::PickFillerKill( int featured, std::vector< bool > &alive, std::vector< bool > &killed, GeneratorKill_t &kill )
+{
+	const bool bRandom = m_KillPattern.empty();
+
+	std::vector< int > attackers;
+	for( int i = 0; i < (int)m_Players.size(); ++i )
+	{
+		if( alive[ i ] && i != featured && ( bRandom || !killed[ i ] ) )
+			attackers.push_back( i );
+	}
+
+	std::shuffle( attackers.begin(), attackers.end(), m_Random );
+
+	for( size_t i = 0; i < attackers.size(); ++i )
+	{
+		std::vector< int > victims;
+		for( int j = 0; j < (int)m_Players.size(); ++j )
+		{
+			if( alive[ j ] && m_Players[ j ].team != m_Players[ attackers[ i ] ].team )
+				victims.push_back( j );
+		}
+
+		if( victims.empty() )
+			continue;
+
+		kill.attacker = attackers[ i ];
+		kill.victim = victims[ std::uniform_int_distribution< size_t >( 0, victims.size() - 1 )( m_Random ) ];
+		kill.weapon = s_FillerWeapons[ std::uniform_int_distribution< size_t >( 0, std::size( s_FillerWeapons ) - 1 )( m_Random ) ];
+		kill.bHeadshot = std::uniform_int_distribution< int >( 0, 1 )( m_Random ) != 0;
+
+		alive[ kill.victim ] = false;
+		killed[ kill.attacker ] = true;
+		return true;
+	}
+
+	return false;
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::WriteRound( int round )
+{
+	std::vector< GeneratorKill_t > kills;
+	PlanRound( round, kills );
+
+	SpawnPlayers();
+
+	const int roundTicks = GENERATOR_ROUND_SECONDS * m_Options.tickRate;
+	size_t nextKill = 0;
+
+	for( int tick = 0; tick < roundTicks; ++tick, ++m_iTick )
+	{
+		WriteMessageType( NET_Tick );
+		m_Packet.WriteLong( m_iTick );
+
+		if( tick == 0 )
+		{
+			WritePacketEntities( true );
+
+			BeginGameEvent( EVENT_ROUND_START );
+			m_Data.WriteLong( GENERATOR_ROUND_SECONDS );
+			m_Data.WriteLong( 0 );
+			m_Data.WriteString( "BOMB TARGET" );
+			EndGameEvent();
+
+			for( size_t i = 0; i < m_Players.size(); ++i )
+			{
+				BeginGameEvent( EVENT_PLAYER_SPAWN );
+				m_Data.WriteShort( m_Players[ i ].userID );
+				EndGameEvent();
+			}
+		}
+		else
+		{
+			MovePlayers();
+			WritePacketEntities( false );
+		}
+
+		for( ; nextKill < kills.size() && kills[ nextKill ].tick == tick; ++nextKill )
+		{
+			const GeneratorKill_t &kill = kills[ nextKill ];
+
+			BeginGameEvent( EVENT_PLAYER_DEATH );
+			m_Data.WriteShort( m_Players[ kill.victim ].userID );
+			m_Data.WriteShort( m_Players[ kill.attacker ].userID );
+			m_Data.WriteString( kill.weapon );
+			m_Data.WriteOneBit( kill.bHeadshot );
+			EndGameEvent();
+
+			m_Players[ kill.victim ].bAlive = false;
+		}
+
+		if( tick == roundTicks - 1 )
+		{
+			BeginGameEvent( EVENT_ROUND_END );
+			m_Data.WriteByte( 2 + round % 2 );
+			m_Data.WriteByte( 0 );
+			m_Data.WriteString( round % 2? "#CTs_Win" : "#Terrorists_Win" );
+			EndGameEvent();
+		}
+
+		WritePacket( dem_packet, m_iTick );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::SpawnPlayers( void )
+{
+	for( size_t i = 0; i < m_Players.size(); ++i )
+	{
+		GeneratorPlayer_t &player = m_Players[ i ];
+
+		// Teams spawn at opposite corners, facing each other
+		const float side = ( player.team == 2 )? -1.f : 1.f;
+
+		player.bAlive = true;
+		player.origin.Init( side * GENERATOR_MAP_SIZE * 0.75f + 64.f * ( i / 2 ), side * GENERATOR_MAP_SIZE * 0.75f, 64.f );
+		player.pitch = 0.f;
+		player.yaw = ( player.team == 2 )? 45.f : 225.f;
+	}
+}
+
+// =====================================================================================================================================================================
+/**
+ * The players turn slowly enough that no kill looks like a flick
+ */
+void DemoGenerator::MovePlayers( void )
+{
+	std::uniform_real_distribution< float > turn( -0.5f, 0.5f );
+
+	const float step = GENERATOR_PLAYER_SPEED * m_fTickInterval;
+
+	for( size_t i = 0; i < m_Players.size(); ++i )
+	{
+		GeneratorPlayer_t &player = m_Players[ i ];
+
+		if( !player.bAlive )
+			continue;
+
+		player.yaw += turn( m_Random );
+		player.pitch = std::clamp( player.pitch + turn( m_Random ), -15.f, 15.f );
+
+		const float yaw = player.yaw * 3.14159265f / 180.f;
+		player.origin.x = std::clamp( player.origin.x + cosf( yaw ) * step, -GENERATOR_MAP_SIZE, GENERATOR_MAP_SIZE );
+		player.origin.y = std::clamp( player.origin.y + sinf( yaw ) * step, -GENERATOR_MAP_SIZE, GENERATOR_MAP_SIZE );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void DemoGenerator::ClearBuffer( bf_write &writer )
+{
+	// Clear the bits after the end too, so the same options always give the same file
+	memset( writer.GetData(), 0, ( writer.GetNumBytesWritten() + 3 ) & ~3 );
+	writer.Reset();
+}
+
+// =====================================================================================================================================================================
+/**
+ * Writes the gzipped copies of the demo next to it (<demo>_stored.dem.gz etc.) and checks that they decompress to the demo
+ */
+static bool WriteGzipCopies( const std::string &filename )
+{
+	static const char *s_Suffixes[ 4 ] = { "_stored", "_fixed", "_dynamic", "_members" };
+
+	std::ifstream file( filename, std::ios::binary | std::ios::ate );
+	std::vector< byte > demo( (size_t)file.tellg() );
+	file.seekg( 0 );
+	file.read( (char *)demo.data(), demo.size() );
+
+	if( !file.good() )
+		return false;
+
+	std::string baseName = filename;
+	RemoveDemoExtension( baseName );
+
+	for( int copy = 0; copy < 4; ++copy )
+	{
+		std::vector< byte > compressed;
+
+		if( copy == DEFLATE_STORED || copy == DEFLATE_FIXED || copy == DEFLATE_DYNAMIC )
+		{
+			GzipCompress( demo.data(), demo.size(), (DeflateBlockType)copy, compressed );
+		}
+		else
+		{
+			// A third of the demo in a member of each block type
+			const size_t third = demo.size() / 3;
+
+			GzipCompress( demo.data(), third, DEFLATE_STORED, compressed );
+			GzipCompress( demo.data() + third, third, DEFLATE_FIXED, compressed );
+			GzipCompress( demo.data() + third * 2, demo.size() - third * 2, DEFLATE_DYNAMIC, compressed );
+		}
+
+		const std::string copyName = baseName + s_Suffixes[ copy ] + ".dem.gz";
+		std::ofstream out( copyName, std::ios::binary | std::ios::trunc );
+		out.write( (const char *)compressed.data(), compressed.size() );
+		out.close();
+
+		if( !out.good() )
+		{
+			printf( "Failed to write the gzipped copy %s\n\n", copyName.c_str() );
+			return false;
+		}
+
+		DemoFile check( copyName );
+
+		if( !check.IsValidDemo() || check.GetFileSize() != demo.size() || memcmp( check.GetBuffer(), demo.data(), demo.size() ) )
+		{
+			printf( "The gzipped copy %s doesn't decompress to the demo\n\n", copyName.c_str() );
+			return false;
+		}
+
+		printf( "Wrote gzipped copy %s (%.1f MB)\n", copyName.c_str(), compressed.size() / (1024.0 * 1024.0) );
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool GenerateDemo( const std::string &filename, const GeneratorOptions_t &options )
+{
+	if( options.numPlayers < 2 || options.numPlayers > GENERATOR_MAX_PLAYERS )
+	{
+		printf( "%s: The number of players must be between 2 and %d\n", CSSFF_NAME, GENERATOR_MAX_PLAYERS );
+		return false;
+	}
+
+	if( options.tickRate < 10 || options.tickRate > 1000 )
+	{
+		printf( "%s: The tickrate must be between 10 and 1000\n", CSSFF_NAME );
+		return false;
+	}
+
+	if( options.numRounds <= 0 && options.targetSize <= 0 )
+	{
+		printf( "%s: The demo must have at least one round\n", CSSFF_NAME );
+		return false;
+	}
+
+	DemoGenerator generator( options );
+
+	if( !generator.ParseKillPattern() )
+	{
+		printf( "%s: Invalid kill pattern \"%s\" (expected \"random\" or a list like \"5,0,3\" with 0-5 kills per round)\n", CSSFF_NAME, options.killPattern.c_str() );
+		return false;
+	}
+
+	printf( "%s: Generating demo %s...\n", CSSFF_NAME, filename.c_str() );
+
+	if( !generator.Generate( filename ) )
+	{
+		printf( "Failed to write the demo\n\n" );
+		return false;
+	}
+
+	printf( "Generated %d rounds (%.1f MB, %d players, tickrate %d)\n", generator.GetNumRounds(), generator.GetFileSize() / (1024.0 * 1024.0), options.numPlayers, options.tickRate );
+
+	if( options.killPattern != "random" )
+	{
+		// Rounds with 2 scripted kills aren't counted, a 2K is never ticked as a frag
+		printf( "Scripted frags: %d 5Ks, %d 4Ks, %d 3Ks\n", generator.GetNumScriptedFrags( 5 ), generator.GetNumScriptedFrags( 4 ), generator.GetNumScriptedFrags( 3 ) );
+	}
+
+	if( options.bGzipCopies && !WriteGzipCopies( filename ) )
+		return false;
+
+	printf( "\n" );
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Common.h"
+#include <string>
+
+#define GENERATOR_DEFAULT_ROUNDS		30
+#define GENERATOR_DEFAULT_PLAYERS		10
+#define GENERATOR_DEFAULT_TICKRATE		66
+#define GENERATOR_DEFAULT_KILLS			"5,0,3,4,0,2,0"
+#define GENERATOR_MAX_PLAYERS			64		// Max clients of the generated server
+
+/**
+ * What kind of demo the generator writes
+ */
+struct GeneratorOptions_t
+{
+	GeneratorOptions_t( void ) : numRounds( GENERATOR_DEFAULT_ROUNDS ), targetSize( 0 ), numPlayers( GENERATOR_DEFAULT_PLAYERS ), tickRate( GENERATOR_DEFAULT_TICKRATE ), killPattern( GENERATOR_DEFAULT_KILLS ), seed( 1 ), bGzipCopies( false ) {}
+
+	int				numRounds;
+	int64			targetSize;			///< Rounds are added until the demo is at least this many bytes (0 to use numRounds)
+	int				numPlayers;			///< Split evenly into two teams
+	int				tickRate;
+	std::string		killPattern;		///< "random", or a comma separated list of how many kills one player makes in quick succession on each round (cycled)
+	uint32			seed;				///< The same options and seed always give the same demo
+	bool			bGzipCopies;		///< Also write gzipped copies with each deflate block type, and one with several gzip members
+};
+
+/**
+ * Writes a synthetic CS:S v34 STV demo with scripted rounds
+ * @return						false if the options are invalid or the file could not be written
+ */
+bool GenerateDemo( const std::string &filename, const GeneratorOptions_t &options );
\ No newline at end of file
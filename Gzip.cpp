@@ -0,0 +1,1163 @@
+#include "Gzip.h"
+#include <string.h>
+
+// Gzip decompression (RFC 1951 and RFC 1952)
+//
+// Huffman codes up to INFLATE_FAST_BITS long are decoded with a lookup table, and the rare longer codes bit by bit from
+// the canonical code counts. The output goes straight into the caller's buffer, which is also the window that the
+// back-references are copied from, so the whole demo is decompressed without any intermediate copies.
+//
+// Files made by pigz or concatenated with cat have several members, they are decompressed one after the other into the
+// same buffer. The size in the trailer is the size of the last member only, so it is just a hint for the buffer size.
+//
+// The compressor only exists to write test files with each of the block types (the -gengzip option of the generator).
+
+#define INFLATE_FAST_BITS			10
+#define INFLATE_MAX_BITS			15
+#define INFLATE_MAX_LITLEN_CODES	288
+#define INFLATE_MAX_DIST_CODES		30
+
+#define DEFLATE_BLOCK_SIZE			65535	// Input bytes per block, the most that a stored block can have
+#define DEFLATE_WINDOW_SIZE			32768
+#define DEFLATE_MIN_MATCH			3
+#define DEFLATE_MAX_MATCH			258
+#define DEFLATE_HASH_BITS			15
+#define DEFLATE_END_OF_BLOCK		256
+#define DEFLATE_CODE_LENGTH_CODES	19
+#define DEFLATE_MAX_CODE_LENGTH_BITS	7
+
+// Gzip header flags
+#define GZIP_FHCRC			(1<<1)
+#define GZIP_FEXTRA			(1<<2)
+#define GZIP_FNAME			(1<<3)
+#define GZIP_FCOMMENT		(1<<4)
+
+static const unsigned short s_LengthBase[ 29 ] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const byte s_LengthExtra[ 29 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const unsigned short s_DistBase[ 30 ] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const byte s_DistExtra[ 30 ] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const byte s_CodeLengthOrder[ 19 ] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// =====================================================================================================================================================================
+
+struct HuffmanTable_t
+{
+	unsigned short	fast[ 1 << INFLATE_FAST_BITS ];			///< (symbol << 4) | code length for the short codes, 0 for the longer codes
+	short			count[ INFLATE_MAX_BITS + 1 ];			///< # of codes of each length
+	short			symbol[ INFLATE_MAX_LITLEN_CODES ];		///< Symbols in canonical code order
+};
+
+// =====================================================================================================================================================================
+/**
+ * Builds the decoding table from the code lengths of the symbols
+ * @return						false if the lengths don't make a valid code
+ */
+static bool BuildHuffmanTable( HuffmanTable_t &table, const byte *lengths, int numSymbols )
+{
+	memset( table.count, 0, sizeof( table.count ) );
+
+	for( int i = 0; i < numSymbols; ++i )
+		++table.count[ lengths[ i ] ];
+
+	table.count[ 0 ] = 0;
+
+	// Over-subscribed lengths are invalid, incomplete codes are allowed (e.g. a single distance code)
+	int left = 1;
+
+	for( int len = 1; len <= INFLATE_MAX_BITS; ++len )
+	{
+		left <<= 1;
+		left -= table.count[ len ];
+
+		if( left < 0 )
+			return false;
+	}
+
+	short offsets[ INFLATE_MAX_BITS + 1 ];
+	offsets[ 1 ] = 0;
+
+	for( int len = 1; len < INFLATE_MAX_BITS; ++len )
+		offsets[ len + 1 ] = offsets[ len ] + table.count[ len ];
+
+	for( int i = 0; i < numSymbols; ++i )
+	{
+		if( lengths[ i ] )
+			table.symbol[ offsets[ lengths[ i ] ]++ ] = (short)i;
+	}
+
+	// Short codes go to the lookup table, bit reversed since the bits are read starting from the lowest bit
+	memset( table.fast, 0, sizeof( table.fast ) );
+
+	int code = 0;
+	int index = 0;
+
+	for( int len = 1; len <= INFLATE_FAST_BITS; ++len )
+	{
+		for( int i = 0; i < table.count[ len ]; ++i, ++code, ++index )
+		{
+			int reversed = 0;
+
+			for( int bit = 0; bit < len; ++bit )
+				reversed |= ( ( code >> bit ) & 1 ) << ( len - 1 - bit );
+
+			for( int j = reversed; j < ( 1 << INFLATE_FAST_BITS ); j += 1 << len )
+				table.fast[ j ] = (unsigned short)( ( table.symbol[ index ] << 4 ) | len );
+		}
+
+		code <<= 1;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Decompresses one deflate stream
+ */
+class Inflater
+{
+public:
+	Inflater( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t outPos );
+
+	DecompressResult Inflate( void );
+	size_t GetOutputPos( void ) const { return m_outPos; }
+	size_t GetInputUsed( void ) const { return m_inPos - m_bitCount / 8; }	///< Input bytes up to the end of the stream
+
+private:
+	void Refill( void );
+	bool ReadBits( int numBits, uint32 &value );
+	bool DecodeSymbol( const HuffmanTable_t &table, int &symbol );
+	size_t MakeRoom( size_t size );				///< Grows the output buffer if it can, returns how many of the bytes fit
+
+	bool StoredBlock( void );
+	bool FixedBlock( void );
+	bool DynamicBlock( void );
+	bool DecodeCodes( void );					///< Decodes a compressed block with the current tables
+
+	bool Fail( DecompressResult result ) { m_result = result; return false; }
+
+	const byte *		m_pIn;
+	size_t				m_inSize;
+	size_t				m_inPos;
+	uint64				m_bitBuf;				///< Bits that have been read from the input but not consumed yet, lowest bit first
+	int					m_bitCount;
+
+	DecompressBuffer &	m_Out;
+	byte *				m_pOut;					///< Output buffer, cached since it only changes when the buffer grows
+	size_t				m_outSize;
+	size_t				m_outStart;				///< Start of the stream in the output, back-references can't go further
+	size_t				m_outPos;
+
+	DecompressResult	m_result;				///< Why decoding stopped early
+	HuffmanTable_t		m_LitLen;
+	HuffmanTable_t		m_Dist;
+	HuffmanTable_t		m_CodeLengths;
+};
+
+// =====================================================================================================================================================================
+
+Inflater::Inflater( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t outPos ) : m_Out( out )
+{
+	m_pIn = pIn;
+	m_inSize = inSize;
+	m_inPos = 0;
+	m_bitBuf = 0;
+	m_bitCount = 0;
+
+	m_pOut = out.GetData();
+	m_outSize = out.GetSize();
+	m_outStart = outPos;
+	m_outPos = outPos;
+
+	m_result = DECOMPRESS_CORRUPT;
+}
+
+// =====================================================================================================================================================================
+
+inline void Inflater::Refill( void )
+{
+	while( m_bitCount <= 56 && m_inPos < m_inSize )
+	{
+		m_bitBuf |= (uint64)m_pIn[ m_inPos++ ] << m_bitCount;
+		m_bitCount += 8;
+	}
+}
+
+// =====================================================================================================================================================================
+
+inline bool Inflater::ReadBits( int numBits, uint32 &value )
+{
+	if( m_bitCount < numBits )
+	{
+		Refill();
+
+		if( m_bitCount < numBits )
+			return Fail( DECOMPRESS_INPUT_ENDED );
+	}
+
+	value = (uint32)( m_bitBuf & ( ( 1ull << numBits ) - 1 ) );
+	m_bitBuf >>= numBits;
+	m_bitCount -= numBits;
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+inline bool Inflater::DecodeSymbol( const HuffmanTable_t &table, int &symbol )
+{
+	if( m_bitCount < INFLATE_MAX_BITS )
+		Refill();
+
+	const unsigned short entry = table.fast[ m_bitBuf & ( ( 1 << INFLATE_FAST_BITS ) - 1 ) ];
+
+	if( entry && ( entry & 15 ) <= m_bitCount )
+	{
+		m_bitBuf >>= entry & 15;
+		m_bitCount -= entry & 15;
+		symbol = entry >> 4;
+		return true;
+	}
+
+	// Long code (or the end of the input), decode it one bit at a time
+	int code = 0;
+	int first = 0;
+	int index = 0;
+
+	for( int len = 1; len <= INFLATE_MAX_BITS; ++len )
+	{
+		if( !m_bitCount )
+			return Fail( DECOMPRESS_INPUT_ENDED );
+
+		code |= (int)( m_bitBuf & 1 );
+		m_bitBuf >>= 1;
+		--m_bitCount;
+
+		const int count = table.count[ len ];
+
+		if( code - count < first )
+		{
+			symbol = table.symbol[ index + ( code - first ) ];
+			return true;
+		}
+
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	return Fail( DECOMPRESS_CORRUPT );
+}
+
+// =====================================================================================================================================================================
+
+size_t Inflater::MakeRoom( size_t size )
+{
+	if( size > m_outSize - m_outPos && m_Out.Grow( m_outPos + size ) )
+	{
+		m_pOut = m_Out.GetData();
+		m_outSize = m_Out.GetSize();
+	}
+
+	return ( size > m_outSize - m_outPos )? m_outSize - m_outPos : size;
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult Inflater::Inflate( void )
+{
+	uint32 bLastBlock;
+
+	do
+	{
+		uint32 type;
+
+		if( !ReadBits( 1, bLastBlock ) || !ReadBits( 2, type ) )
+			return m_result;
+
+		bool bOk;
+
+		switch( type )
+		{
+			case 0:		bOk = StoredBlock(); break;
+			case 1:		bOk = FixedBlock(); break;
+			case 2:		bOk = DynamicBlock(); break;
+			default:	return DECOMPRESS_CORRUPT;
+		}
+
+		if( !bOk )
+			return m_result;
+	}
+	while( !bLastBlock );
+
+	return DECOMPRESS_DONE;
+}
+
+// =====================================================================================================================================================================
+
+bool Inflater::StoredBlock( void )
+{
+	// Go to the byte boundary and give back the whole bytes in the bit buffer
+	m_inPos -= m_bitCount / 8;
+	m_bitBuf = 0;
+	m_bitCount = 0;
+
+	if( m_inPos + 4 > m_inSize )
+		return Fail( DECOMPRESS_INPUT_ENDED );
+
+	const size_t length = m_pIn[ m_inPos ] | ( m_pIn[ m_inPos + 1 ] << 8 );
+	const size_t lengthComplement = m_pIn[ m_inPos + 2 ] | ( m_pIn[ m_inPos + 3 ] << 8 );
+	m_inPos += 4;
+
+	if( length != ( ~lengthComplement & 0xFFFF ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	size_t copy = MakeRoom( length );
+
+	if( copy > m_inSize - m_inPos )
+		copy = m_inSize - m_inPos;
+
+	memcpy( m_pOut + m_outPos, m_pIn + m_inPos, copy );
+	m_outPos += copy;
+	m_inPos += copy;
+
+	if( copy < length )
+		return Fail( ( m_outPos == m_outSize )? DECOMPRESS_OUTPUT_FULL : DECOMPRESS_INPUT_ENDED );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool Inflater::FixedBlock( void )
+{
+	byte lengths[ INFLATE_MAX_LITLEN_CODES ];
+
+	memset( lengths, 8, 144 );
+	memset( lengths + 144, 9, 256 - 144 );
+	memset( lengths + 256, 7, 280 - 256 );
+	memset( lengths + 280, 8, INFLATE_MAX_LITLEN_CODES - 280 );
+	BuildHuffmanTable( m_LitLen, lengths, INFLATE_MAX_LITLEN_CODES );
+
+	memset( lengths, 5, INFLATE_MAX_DIST_CODES );
+	BuildHuffmanTable( m_Dist, lengths, INFLATE_MAX_DIST_CODES );
+
+	return DecodeCodes();
+}
+
+// =====================================================================================================================================================================
+
+bool Inflater::DynamicBlock( void )
+{
+	uint32 numLitLen, numDist, numCodeLengths;
+
+	if( !ReadBits( 5, numLitLen ) || !ReadBits( 5, numDist ) || !ReadBits( 4, numCodeLengths ) )
+		return false;
+
+	numLitLen += 257;
+	numDist += 1;
+	numCodeLengths += 4;
+
+	if( numLitLen > 286 || numDist > INFLATE_MAX_DIST_CODES )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	// Code lengths of the code length alphabet
+	byte lengths[ INFLATE_MAX_LITLEN_CODES + INFLATE_MAX_DIST_CODES ];
+	memset( lengths, 0, 19 );
+
+	for( uint32 i = 0; i < numCodeLengths; ++i )
+	{
+		uint32 length;
+
+		if( !ReadBits( 3, length ) )
+			return false;
+
+		lengths[ s_CodeLengthOrder[ i ] ] = (byte)length;
+	}
+
+	if( !BuildHuffmanTable( m_CodeLengths, lengths, 19 ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	// Code lengths of the literal/length and distance alphabets
+	for( uint32 index = 0; index < numLitLen + numDist; )
+	{
+		int symbol;
+
+		if( !DecodeSymbol( m_CodeLengths, symbol ) )
+			return false;
+
+		if( symbol < 16 )
+		{
+			lengths[ index++ ] = (byte)symbol;
+			continue;
+		}
+
+		byte value = 0;
+		uint32 repeat;
+
+		if( symbol == 16 )
+		{
+			if( index == 0 )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			value = lengths[ index - 1 ];
+
+			if( !ReadBits( 2, repeat ) )
+				return false;
+
+			repeat += 3;
+		}
+		else if( symbol == 17 )
+		{
+			if( !ReadBits( 3, repeat ) )
+				return false;
+
+			repeat += 3;
+		}
+		else
+		{
+			if( !ReadBits( 7, repeat ) )
+				return false;
+
+			repeat += 11;
+		}
+
+		if( index + repeat > numLitLen + numDist )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		while( repeat-- )
+			lengths[ index++ ] = value;
+	}
+
+	// The block can't end without the end of block code
+	if( !lengths[ 256 ] )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	if( !BuildHuffmanTable( m_LitLen, lengths, numLitLen ) || !BuildHuffmanTable( m_Dist, lengths + numLitLen, numDist ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	return DecodeCodes();
+}
+
+// =====================================================================================================================================================================
+
+bool Inflater::DecodeCodes( void )
+{
+	while( true )
+	{
+		int symbol;
+
+		if( !DecodeSymbol( m_LitLen, symbol ) )
+			return false;
+
+		// Literal byte
+		if( symbol < 256 )
+		{
+			if( m_outPos == m_outSize && !MakeRoom( 1 ) )
+				return Fail( DECOMPRESS_OUTPUT_FULL );
+
+			m_pOut[ m_outPos++ ] = (byte)symbol;
+			continue;
+		}
+
+		// End of block
+		if( symbol == 256 )
+			return true;
+
+		// Back-reference
+		symbol -= 257;
+
+		if( symbol >= 29 )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		uint32 extra;
+
+		if( !ReadBits( s_LengthExtra[ symbol ], extra ) )
+			return false;
+
+		size_t length = s_LengthBase[ symbol ] + extra;
+
+		if( !DecodeSymbol( m_Dist, symbol ) )
+			return false;
+
+		if( symbol >= INFLATE_MAX_DIST_CODES )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		if( !ReadBits( s_DistExtra[ symbol ], extra ) )
+			return false;
+
+		const size_t distance = s_DistBase[ symbol ] + extra;
+
+		if( distance > m_outPos - m_outStart )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		const size_t fullLength = length;
+		length = MakeRoom( length );
+		const bool bFull = length < fullLength;
+
+		byte *pDest = m_pOut + m_outPos;
+		const byte *pSrc = pDest - distance;
+
+		// The source overlaps the destination when the distance is shorter than the length (repeating pattern)
+		if( distance >= length )
+		{
+			memcpy( pDest, pSrc, length );
+		}
+		else
+		{
+			for( size_t i = 0; i < length; ++i )
+				pDest[ i ] = pSrc[ i ];
+		}
+
+		m_outPos += length;
+
+		if( bFull )
+			return Fail( DECOMPRESS_OUTPUT_FULL );
+	}
+}
+
+// =====================================================================================================================================================================
+
+bool IsGzipData( const byte *pData, size_t size )
+{
+	return size >= GZIP_MIN_SIZE && pData[ 0 ] == 0x1F && pData[ 1 ] == 0x8B;
+}
+
+// =====================================================================================================================================================================
+
+uint32 GetGzipUncompressedSize( const byte *pData, size_t size )
+{
+	const byte *pSize = pData + size - 4;
+
+	return pSize[ 0 ] | ( pSize[ 1 ] << 8 ) | ( pSize[ 2 ] << 16 ) | ( (uint32)pSize[ 3 ] << 24 );
+}
+
+// =====================================================================================================================================================================
+
+/**
+ * Gets the size of a gzip member header
+ * @return						0 if the header isn't complete
+ */
+static size_t GetGzipHeaderSize( const byte *pData, size_t size )
+{
+	// Skip the optional header fields after the fixed part (magic, method, flags, time, extra flags and OS)
+	const byte flags = pData[ 3 ];
+	size_t pos = 10;
+
+	if( flags & GZIP_FEXTRA )
+		pos += 2 + ( pData[ pos ] | ( pData[ pos + 1 ] << 8 ) );
+
+	if( flags & GZIP_FNAME )
+	{
+		while( pos < size && pData[ pos ] )
+			++pos;
+
+		++pos;
+	}
+
+	if( flags & GZIP_FCOMMENT )
+	{
+		while( pos < size && pData[ pos ] )
+			++pos;
+
+		++pos;
+	}
+
+	if( flags & GZIP_FHCRC )
+		pos += 2;
+
+	return ( pos < size )? pos : 0;
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult GzipDecompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten )
+{
+	outWritten = 0;
+
+	if( !IsGzipData( pIn, inSize ) )
+		return DECOMPRESS_CORRUPT;
+
+	size_t pos = 0;
+
+	// Members follow each other until the end of the file
+	do
+	{
+		// Only deflate is defined as the compression method
+		if( pIn[ pos + 2 ] != 8 )
+			return DECOMPRESS_CORRUPT;
+
+		const size_t headerSize = GetGzipHeaderSize( pIn + pos, inSize - pos );
+
+		if( !headerSize )
+			return DECOMPRESS_INPUT_ENDED;
+
+		pos += headerSize;
+
+		Inflater inflater( pIn + pos, inSize - pos, out, outWritten );
+
+		DecompressResult result = inflater.Inflate();
+
+		const size_t memberSize = inflater.GetOutputPos() - outWritten;
+		outWritten = inflater.GetOutputPos();
+
+		if( result != DECOMPRESS_DONE )
+			return result;
+
+		pos += inflater.GetInputUsed();
+
+		// Trailer: CRC-32 and the size of the member
+		if( pos + 8 > inSize )
+			return DECOMPRESS_INPUT_ENDED;
+
+		if( GetGzipUncompressedSize( pIn, pos + 8 ) != (uint32)memberSize )
+			return DECOMPRESS_CORRUPT;
+
+		pos += 8;
+	}
+	while( IsGzipData( pIn + pos, inSize - pos ) );
+
+	return DECOMPRESS_DONE;
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult DeflateDecompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten )
+{
+	Inflater inflater( pIn, inSize, out, 0 );
+
+	DecompressResult result = inflater.Inflate();
+
+	outWritten = inflater.GetOutputPos();
+
+	return result;
+}
+
+// =====================================================================================================================================================================
+
+static uint32 Crc32( const byte *pData, size_t size )
+{
+	static uint32 s_Table[ 256 ];
+	static bool s_bTableBuilt = false;
+
+	if( !s_bTableBuilt )
+	{
+		for( uint32 i = 0; i < 256; ++i )
+		{
+			uint32 value = i;
+
+			for( int bit = 0; bit < 8; ++bit )
+				value = ( value & 1 )? 0xEDB88320 ^ ( value >> 1 ) : value >> 1;
+
+			s_Table[ i ] = value;
+		}
+
+		s_bTableBuilt = true;
+	}
+
+	uint32 crc = 0xFFFFFFFF;
+
+	for( size_t i = 0; i < size; ++i )
+		crc = s_Table[ ( crc ^ pData[ i ] ) & 0xFF ] ^ ( crc >> 8 );
+
+	return ~crc;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Gives the symbols code lengths of at most maxBits bits
+ * The Huffman code is built from the counts, and while it is too long the counts are halved, which flattens the code.
+ * At least two symbols get a code, so the code is always complete.
+ */
+static void BuildCodeLengths( const uint32 *counts, int numSymbols, int maxBits, byte *lengths )
+{
+	std::vector< uint32 > weights( counts, counts + numSymbols );
+
+	int numUsed = 0;
+
+	for( int i = 0; i < numSymbols; ++i )
+		numUsed += weights[ i ]? 1 : 0;
+
+	for( int i = 0; numUsed < 2; ++i )
+	{
+		if( !weights[ i ] )
+		{
+			weights[ i ] = 1;
+			++numUsed;
+		}
+	}
+
+	std::vector< uint64 > nodeWeight( numSymbols * 2 );
+	std::vector< int > parent( numSymbols * 2 );
+	std::vector< int > leaf( numSymbols );
+	std::vector< int > active;
+
+	while( true )
+	{
+		int numNodes = 0;
+		active.clear();
+
+		for( int i = 0; i < numSymbols; ++i )
+		{
+			leaf[ i ] = -1;
+
+			if( !weights[ i ] )
+				continue;
+
+			leaf[ i ] = numNodes;
+			nodeWeight[ numNodes ] = weights[ i ];
+			parent[ numNodes ] = -1;
+			active.push_back( numNodes++ );
+		}
+
+		// Merge the two lightest nodes until one is left
+		while( active.size() > 1 )
+		{
+			int merged[ 2 ];
+
+			for( int pick = 0; pick < 2; ++pick )
+			{
+				size_t lightest = 0;
+
+				for( size_t i = 1; i < active.size(); ++i )
+				{
+					if( nodeWeight[ active[ i ] ] < nodeWeight[ active[ lightest ] ] )
+						lightest = i;
+				}
+
+				merged[ pick ] = active[ lightest ];
+				active.erase( active.begin() + lightest );
+			}
+
+			nodeWeight[ numNodes ] = nodeWeight[ merged[ 0 ] ] + nodeWeight[ merged[ 1 ] ];
+			parent[ numNodes ] = -1;
+			parent[ merged[ 0 ] ] = numNodes;
+			parent[ merged[ 1 ] ] = numNodes;
+			active.push_back( numNodes++ );
+		}
+
+		int maxLength = 0;
+
+		for( int i = 0; i < numSymbols; ++i )
+		{
+			int length = 0;
+
+			for( int node = leaf[ i ]; node >= 0 && parent[ node ] >= 0; node = parent[ node ] )
+				++length;
+
+			lengths[ i ] = (byte)length;
+
+			if( length > maxLength )
+				maxLength = length;
+		}
+
+		if( maxLength <= maxBits )
+			return;
+
+		for( int i = 0; i < numSymbols; ++i )
+		{
+			if( weights[ i ] )
+				weights[ i ] = ( weights[ i ] >> 1 ) | 1;
+		}
+	}
+}
+
+// =====================================================================================================================================================================
+/**
+ * Gives the symbols their canonical codes, bit reversed since the codes are written starting from the highest bit
+ */
+static void BuildCodes( const byte *lengths, int numSymbols, unsigned short *codes )
+{
+	int count[ INFLATE_MAX_BITS + 1 ] = {};
+	int next[ INFLATE_MAX_BITS + 1 ];
+
+	for( int i = 0; i < numSymbols; ++i )
+		++count[ lengths[ i ] ];
+
+	count[ 0 ] = 0;
+	next[ 1 ] = 0;
+
+	for( int len = 1; len < INFLATE_MAX_BITS; ++len )
+		next[ len + 1 ] = ( next[ len ] + count[ len ] ) << 1;
+
+	for( int i = 0; i < numSymbols; ++i )
+	{
+		const int len = lengths[ i ];
+		const int code = len? next[ len ]++ : 0;
+		int reversed = 0;
+
+		for( int bit = 0; bit < len; ++bit )
+			reversed |= ( ( code >> bit ) & 1 ) << ( len - 1 - bit );
+
+		codes[ i ] = (unsigned short)reversed;
+	}
+}
+
+// =====================================================================================================================================================================
+
+struct DeflateSymbol_t
+{
+	unsigned short	litLen;		///< Literal byte, or the match length if distance is set
+	unsigned short	distance;
+};
+
+/**
+ * Writes one deflate stream
+ */
+class Deflater
+{
+public:
+	Deflater( const byte *pData, size_t size, std::vector< byte > &out );
+
+	void Deflate( DeflateBlockType blockType );
+
+private:
+	void WriteBits( uint32 value, int numBits );
+	void FlushBits( void );						///< Pads the last byte with zero bits
+
+	void StoredBlock( size_t start, size_t end, bool bLastBlock );
+	void CompressedBlock( size_t start, size_t end, bool bLastBlock, bool bDynamic );
+	void FindMatches( size_t start, size_t end );
+	void WriteSymbols( const unsigned short *litLenCodes, const byte *litLenLengths, const unsigned short *distCodes, const byte *distLengths );
+
+	const byte *					m_pData;
+	size_t							m_size;
+	std::vector< byte > &			m_Out;
+	uint32							m_bitBuf;
+	int								m_bitCount;
+
+	std::vector< int >				m_HashHead;		///< Last position of each hash of 3 bytes
+	std::vector< DeflateSymbol_t >	m_Symbols;		///< Symbols of the current block
+};
+
+// =====================================================================================================================================================================
+
+static int GetLengthCode( int length )
+{
+	int code = 28;
+
+	while( s_LengthBase[ code ] > length )
+		--code;
+
+	return code;
+}
+
+// =====================================================================================================================================================================
+
+static int GetDistanceCode( int distance )
+{
+	int code = INFLATE_MAX_DIST_CODES - 1;
+
+	while( s_DistBase[ code ] > distance )
+		--code;
+
+	return code;
+}
+
+// =====================================================================================================================================================================
+
+Deflater::Deflater( const byte *pData, size_t size, std::vector< byte > &out ) : m_Out( out )
+{
+	m_pData = pData;
+	m_size = size;
+	m_bitBuf = 0;
+	m_bitCount = 0;
+}
+
+// =====================================================================================================================================================================
+
+void Deflater::WriteBits( uint32 value, int numBits )
+{
+	m_bitBuf |= value << m_bitCount;
+	m_bitCount += numBits;
+
+	while( m_bitCount >= 8 )
+	{
+		m_Out.push_back( (byte)m_bitBuf );
+		m_bitBuf >>= 8;
+		m_bitCount -= 8;
+	}
+}
+
+// =====================================================================================================================================================================
+
+void Deflater::FlushBits( void )
+{
+	if( m_bitCount )
+		WriteBits( 0, 8 - m_bitCount );
+}
+
+// =====================================================================================================================================================================
+
+void Deflater::Deflate( DeflateBlockType blockType )
+{
+	m_HashHead.assign( 1 << DEFLATE_HASH_BITS, -1 );
+
+	// An empty stream still needs its last block
+	size_t start = 0;
+
+	do
+	{
+		const size_t end = ( m_size - start > DEFLATE_BLOCK_SIZE )? start + DEFLATE_BLOCK_SIZE : m_size;
+		const bool bLastBlock = end == m_size;
+
+		if( blockType == DEFLATE_STORED )
+			StoredBlock( start, end, bLastBlock );
+		else
+			CompressedBlock( start, end, bLastBlock, blockType == DEFLATE_DYNAMIC );
+
+		start = end;
+	}
+	while( start < m_size );
+
+	FlushBits();
+}
+
+// =====================================================================================================================================================================
+
+void Deflater::StoredBlock( size_t start, size_t end, bool bLastBlock )
+{
+	const uint32 length = (uint32)( end - start );
+
+	WriteBits( bLastBlock? 1 : 0, 1 );
+	WriteBits( 0, 2 );
+	FlushBits();
+
+	WriteBits( length, 16 );
+	WriteBits( ~length & 0xFFFF, 16 );
+	m_Out.insert( m_Out.end(), m_pData + start, m_pData + end );
+}
+
+// =====================================================================================================================================================================
+
+void Deflater::FindMatches( size_t start, size_t end )
+{
+	m_Symbols.clear();
+
+	for( size_t pos = start; pos < end; )
+	{
+		size_t matchLength = 0;
+		size_t distance = 0;
+
+		if( pos + DEFLATE_MIN_MATCH <= end )
+		{
+			const uint32 hash = ( ( m_pData[ pos ] << 16 ) | ( m_pData[ pos + 1 ] << 8 ) | m_pData[ pos + 2 ] ) * 2654435761u >> ( 32 - DEFLATE_HASH_BITS );
+			const int candidate = m_HashHead[ hash ];
+			m_HashHead[ hash ] = (int)pos;
+
+			// The match can overlap the bytes it repeats
+			if( candidate >= 0 && pos - candidate <= DEFLATE_WINDOW_SIZE )
+			{
+				const size_t maxLength = ( end - pos < DEFLATE_MAX_MATCH )? end - pos : DEFLATE_MAX_MATCH;
+
+				while( matchLength < maxLength && m_pData[ candidate + matchLength ] == m_pData[ pos + matchLength ] )
+					++matchLength;
+
+				distance = pos - candidate;
+			}
+		}
+
+		DeflateSymbol_t symbol;
+
+		if( matchLength >= DEFLATE_MIN_MATCH )
+		{
+			symbol.litLen = (unsigned short)matchLength;
+			symbol.distance = (unsigned short)distance;
+			pos += matchLength;
+		}
+		else
+		{
+			symbol.litLen = m_pData[ pos ];
+			symbol.distance = 0;
+			++pos;
+		}
+
+		m_Symbols.push_back( symbol );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void Deflater::CompressedBlock( size_t start, size_t end, bool bLastBlock, bool bDynamic )
+{
+	FindMatches( start, end );
+
+	byte litLenLengths[ INFLATE_MAX_LITLEN_CODES ];
+	byte distLengths[ INFLATE_MAX_DIST_CODES ];
+	unsigned short litLenCodes[ INFLATE_MAX_LITLEN_CODES ];
+	unsigned short distCodes[ INFLATE_MAX_DIST_CODES ];
+
+	WriteBits( bLastBlock? 1 : 0, 1 );
+
+	if( !bDynamic )
+	{
+		memset( litLenLengths, 8, 144 );
+		memset( litLenLengths + 144, 9, 256 - 144 );
+		memset( litLenLengths + 256, 7, 280 - 256 );
+		memset( litLenLengths + 280, 8, INFLATE_MAX_LITLEN_CODES - 280 );
+		memset( distLengths, 5, INFLATE_MAX_DIST_CODES );
+
+		BuildCodes( litLenLengths, INFLATE_MAX_LITLEN_CODES, litLenCodes );
+		BuildCodes( distLengths, INFLATE_MAX_DIST_CODES, distCodes );
+
+		WriteBits( 1, 2 );
+		WriteSymbols( litLenCodes, litLenLengths, distCodes, distLengths );
+		return;
+	}
+
+	// Codes made from the symbol counts of the block
+	uint32 litLenCounts[ INFLATE_MAX_LITLEN_CODES ] = {};
+	uint32 distCounts[ INFLATE_MAX_DIST_CODES ] = {};
+
+	for( const DeflateSymbol_t &symbol : m_Symbols )
+	{
+		if( symbol.distance )
+		{
+			++litLenCounts[ 257 + GetLengthCode( symbol.litLen ) ];
+			++distCounts[ GetDistanceCode( symbol.distance ) ];
+		}
+		else
+		{
+			++litLenCounts[ symbol.litLen ];
+		}
+	}
+
+	++litLenCounts[ DEFLATE_END_OF_BLOCK ];
+
+	// Codes 286 and 287 are never used
+	BuildCodeLengths( litLenCounts, 286, INFLATE_MAX_BITS, litLenLengths );
+	BuildCodeLengths( distCounts, INFLATE_MAX_DIST_CODES, INFLATE_MAX_BITS, distLengths );
+	BuildCodes( litLenLengths, 286, litLenCodes );
+	BuildCodes( distLengths, INFLATE_MAX_DIST_CODES, distCodes );
+
+	int numLitLen = 286;
+	int numDist = INFLATE_MAX_DIST_CODES;
+
+	while( numLitLen > 257 && !litLenLengths[ numLitLen - 1 ] )
+		--numLitLen;
+
+	while( numDist > 1 && !distLengths[ numDist - 1 ] )
+		--numDist;
+
+	// Both code lengths run-length coded together: 16 repeats the previous length 3-6 times, 17 and 18 are 3-10 and 11-138 zeros
+	byte lengths[ INFLATE_MAX_LITLEN_CODES + INFLATE_MAX_DIST_CODES ];
+	const int numLengths = numLitLen + numDist;
+	memcpy( lengths, litLenLengths, numLitLen );
+	memcpy( lengths + numLitLen, distLengths, numDist );
+
+	std::vector< DeflateSymbol_t > lengthSymbols;	// Code length code and its extra bits
+	uint32 lengthCounts[ DEFLATE_CODE_LENGTH_CODES ] = {};
+
+	for( int i = 0; i < numLengths; )
+	{
+		int run = 1;
+
+		while( i + run < numLengths && lengths[ i + run ] == lengths[ i ] )
+			++run;
+
+		DeflateSymbol_t symbol;
+
+		if( !lengths[ i ] && run >= 11 )
+		{
+			run = ( run > 138 )? 138 : run;
+			symbol.litLen = 18;
+			symbol.distance = (unsigned short)( run - 11 );
+		}
+		else if( !lengths[ i ] && run >= 3 )
+		{
+			symbol.litLen = 17;
+			symbol.distance = (unsigned short)( run - 3 );
+		}
+		else if( lengths[ i ] && i > 0 && lengths[ i - 1 ] == lengths[ i ] && run >= 3 )
+		{
+			run = ( run > 6 )? 6 : run;
+			symbol.litLen = 16;
+			symbol.distance = (unsigned short)( run - 3 );
+		}
+		else
+		{
+			run = 1;
+			symbol.litLen = lengths[ i ];
+			symbol.distance = 0;
+		}
+
+		++lengthCounts[ symbol.litLen ];
+		lengthSymbols.push_back( symbol );
+		i += run;
+	}
+
+	byte lengthLengths[ DEFLATE_CODE_LENGTH_CODES ];
+	unsigned short lengthCodes[ DEFLATE_CODE_LENGTH_CODES ];
+	BuildCodeLengths( lengthCounts, DEFLATE_CODE_LENGTH_CODES, DEFLATE_MAX_CODE_LENGTH_BITS, lengthLengths );
+	BuildCodes( lengthLengths, DEFLATE_CODE_LENGTH_CODES, lengthCodes );
+
+	int numCodeLengths = DEFLATE_CODE_LENGTH_CODES;
+
+	while( numCodeLengths > 4 && !lengthLengths[ s_CodeLengthOrder[ numCodeLengths - 1 ] ] )
+		--numCodeLengths;
+
+	WriteBits( 2, 2 );
+	WriteBits( numLitLen - 257, 5 );
+	WriteBits( numDist - 1, 5 );
+	WriteBits( numCodeLengths - 4, 4 );
+
+	for( int i = 0; i < numCodeLengths; ++i )
+		WriteBits( lengthLengths[ s_CodeLengthOrder[ i ] ], 3 );
+
+	static const byte s_RepeatBits[ 3 ] = { 2, 3, 7 };
+
+	for( const DeflateSymbol_t &symbol : lengthSymbols )
+	{
+		WriteBits( lengthCodes[ symbol.litLen ], lengthLengths[ symbol.litLen ] );
+
+		if( symbol.litLen >= 16 )
+			WriteBits( symbol.distance, s_RepeatBits[ symbol.litLen - 16 ] );
+	}
+
+	WriteSymbols( litLenCodes, litLenLengths, distCodes, distLengths );
+}
+
+// =====================================================================================================================================================================
+
+void Deflater::WriteSymbols( const unsigned short *litLenCodes, const byte *litLenLengths, const unsigned short *distCodes, const byte *distLengths )
+{
+	for( const DeflateSymbol_t &symbol : m_Symbols )
+	{
+		if( !symbol.distance )
+		{
+			WriteBits( litLenCodes[ symbol.litLen ], litLenLengths[ symbol.litLen ] );
+			continue;
+		}
+
+		const int lengthCode = GetLengthCode( symbol.litLen );
+		const int distCode = GetDistanceCode( symbol.distance );
+
+		WriteBits( litLenCodes[ 257 + lengthCode ], litLenLengths[ 257 + lengthCode ] );
+		WriteBits( symbol.litLen - s_LengthBase[ lengthCode ], s_LengthExtra[ lengthCode ] );
+		WriteBits( distCodes[ distCode ], distLengths[ distCode ] );
+		WriteBits( symbol.distance - s_DistBase[ distCode ], s_DistExtra[ distCode ] );
+	}
+
+	WriteBits( litLenCodes[ DEFLATE_END_OF_BLOCK ], litLenLengths[ DEFLATE_END_OF_BLOCK ] );
+}
+
+// =====================================================================================================================================================================
+
+void GzipCompress( const byte *pData, size_t size, DeflateBlockType blockType, std::vector< byte > &out )
+{
+	// Header without a file name or time (magic, deflate, flags, time, extra flags and an unknown OS)
+	static const byte s_Header[ 10 ] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+	out.insert( out.end(), s_Header, s_Header + sizeof( s_Header ) );
+
+	Deflater deflater( pData, size, out );
+	deflater.Deflate( blockType );
+
+	const uint32 trailer[ 2 ] = { Crc32( pData, size ), (uint32)size };
+
+	for( int i = 0; i < 2; ++i )
+	{
+		for( int shift = 0; shift < 32; shift += 8 )
+			out.push_back( (byte)( trailer[ i ] >> shift ) );
+	}
+}
\ No newline at end of file
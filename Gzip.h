@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Common.h"
+#include "Decompress.h"
+#include <vector>
+
+#define GZIP_MIN_SIZE		18		// Header and trailer of an empty gzip file
+#define GZIP_MAX_RATIO		1032	// Deflate can't compress better than this, a larger size in the trailer means the file is truncated
+
+enum DeflateBlockType
+{
+	DEFLATE_STORED = 0,
+	DEFLATE_FIXED,					///< Compressed with the fixed Huffman codes
+	DEFLATE_DYNAMIC,				///< Compressed with Huffman codes made for the block
+};
+
+/**
+ * Whether the data starts with the gzip magic bytes
+ */
+bool IsGzipData( const byte *pData, size_t size );
+
+/**
+ * Gets the uncompressed size from the gzip trailer (it is the size of the last member, and modulo 4 GB)
+ */
+uint32 GetGzipUncompressedSize( const byte *pData, size_t size );
+
+/**
+ * Decompresses all members of a gzip file straight into the output buffer
+ * Stops when a fixed output buffer is full, so the start of a file can be read without decompressing all of it.
+ * @param outWritten			set to the # of bytes written to the output buffer
+ */
+DecompressResult GzipDecompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten );
+
+/**
+ * Decompresses a raw deflate stream without the gzip header and trailer (zip archive members)
+ */
+DecompressResult DeflateDecompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten );
+
+/**
+ * Compresses the data into a gzip member that only has blocks of the given type, and appends it to the output
+ * Only meant for writing test files of each block type: matches are found greedily and the output is not tuned for size.
+ */
+void GzipCompress( const byte *pData, size_t size, DeflateBlockType blockType, std::vector< byte > &out );
\ No newline at end of file
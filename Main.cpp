@@ -3,42 +3,62 @@
 #include "Common.h"
 #include "Errors.h"
 #include "Settings.h"
+#include "Stats.h"
+#include "Progress.h"
+#include "Prefetch.h"
+#include "BatchWriter.h"
+#include "Scan.h"
+#include "Dedup.h"
+#include "Daemon.h"
+#include "Watch.h"
+#include "Archive.h"
+#include "Generator.h"
+#include "Bench.h"
+#include "Slim.h"
 #include <Windows.h>
 #include <direct.h>
 #include <stdio.h>
 #include <vector>
 #include <ctime>
+#include <chrono>
 #include <fstream>
 #include <format>
+#include <map>
+#include <memory>
 
 std::string g_ProgramDirectory;						///< Program executable directory (with '\' in the end)
 std::string g_BatchDirectory;						///< Directory of the batch to be processed (with '\' in the end)
-std::string g_BatchOutput;							///< Buffer where all the found frags will be written during batch processing
+BatchWriter g_BatchWriter;							///< Streams the found frags to disk during batch processing (per settings profile)
+ParsingStats_t g_BatchStats;						///< Stats of all the parsed demos (only collected with CSSFF_ENABLE_STATS)
 static std::vector< std::string > s_DemosToParse;	///< Filenames of all the demos that will be parsed
 static std::vector< std::string > g_FailedDemos;	///< Filenames of the demos that failed to parse and their error messages
 extern std::vector< ParsingWarning_t > g_WarningDemos;
 
 /**
- * Populates the parsing list with demos in the specified directory
- * @param sDirectory			path to the directory
- * @return						false if failed to open directory or find first file, true otherwise
+ * Adds the demos in the specified directory to the parsing list, and the demos in its subfolders if enabled
+ * @param sDirectory			path to the directory (with '\' in the end)
  */
-bool FindDemosInFolder( const std::string &sDirectory )
+void FindDemosInFolder_Recursive( const std::string &sDirectory )
 {
-	std::string strSearchPath = sDirectory + "*.dem";
+	std::string strSearchPath = sDirectory + "*";
 
 	WIN32_FIND_DATAA data;
 
 	HANDLE hFile = FindFirstFileA( strSearchPath.c_str(), &data );
 
 	if( hFile == INVALID_HANDLE_VALUE )
-	{
-		return false;
-	}
+		return;
+
+	std::vector< std::string > subfolders;
 
 	do
 	{
-		if( !( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) )
+		if( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+		{
+			if( strcmp( data.cFileName, "." ) && strcmp( data.cFileName, ".." ) )
+				subfolders.emplace_back( sDirectory + data.cFileName + "\\" );
+		}
+		else if( IsDemoFile( data.cFileName ) )
 		{
 			s_DemosToParse.emplace_back( sDirectory + data.cFileName );
 		}
@@ -47,6 +67,28 @@ bool FindDemosInFolder( const std::string &sDirectory )
 
 	FindClose( hFile );
 
+	// Demos of this folder come first, then the subfolders in order
+	if( Settings()->SearchSubfolders() )
+	{
+		for( size_t i = 0; i < subfolders.size(); ++i )
+			FindDemosInFolder_Recursive( subfolders[ i ] );
+	}
+}
+
+/**
+ * Populates the parsing list with demos in the specified directory
+ * @param sDirectory			path to the directory
+ * @return						false if failed to open directory, true otherwise
+ */
+bool FindDemosInFolder( const std::string &sDirectory )
+{
+	if( !IsValidDirectory( sDirectory.c_str() ) )
+	{
+		return false;
+	}
+
+	FindDemosInFolder_Recursive( sDirectory );
+
 #ifdef _DEBUG_PRINT_DETAILS
 	printf( "Found demo files:\n" );
 	for( size_t i = 0; i < s_DemosToParse.size(); ++i )
@@ -58,12 +100,57 @@ bool FindDemosInFolder( const std::string &sDirectory )
 	return true;
 }
 
+/**
+ * Gets the name of a batch output file without the ending
+ * @param buffer				where the name is written to
+ * @param buffer_size			size of the buffer
+ * @param timeinfo				time in the name
+ * @param profile				settings profile whose frags are written to the file
+ */
+void GetBatchOutputName( char *buffer, size_t buffer_size, const tm &timeinfo, int profile )
+{
+	strftime( buffer, buffer_size, "_cssff_batch_%y-%m-%d_%H%M%S", &timeinfo );
+	if( Settings()->GetNumProfiles() > 1 )
+	{
+		strcat_s( buffer, buffer_size, "_" );
+		strcat_s( buffer, buffer_size, Settings()->GetProfileName( profile ).c_str() );
+	}
+}
+
+/**
+ * Starts streaming the found frags to partial output files, which are left behind if the program doesn't finish the batch
+ */
+void StartBatchOutput( void )
+{
+	tm timeinfo;
+	time_t rawtime;
+	time( &rawtime );
+	localtime_s( &timeinfo, &rawtime );
+
+	std::vector< std::string > filenames;
+
+	for( int profile = 0; profile < Settings()->GetNumProfiles(); ++profile )
+	{
+		char szOutputFile[ MAX_PATH ];
+		GetBatchOutputName( szOutputFile, sizeof(szOutputFile), timeinfo, profile );
+		strcat_s( szOutputFile, sizeof(szOutputFile), "_partial.txt" );
+
+		if( Settings()->WriteOutputToDemoDirectory() )
+			filenames.push_back( g_BatchDirectory + szOutputFile );
+		else
+			filenames.push_back( g_ProgramDirectory + szOutputFile );
+	}
+
+	g_BatchWriter.Start( filenames );
+}
+
 /**
  * Writes the results of the batch process to a file
  * @param bAborted				whether the process was aborted or not
+ * @param profile				settings profile whose frags are written
  * @return						true if successfully written, false otherwise
  */
-bool WriteBatchOutput( bool bAborted )
+bool WriteBatchOutput( bool bAborted, int profile )
 {
 	tm timeinfo;
 	time_t rawtime;
@@ -71,7 +158,7 @@ bool WriteBatchOutput( bool bAborted )
 	localtime_s( &timeinfo, &rawtime );
 
 	char szOutputFile[ MAX_PATH ];
-	strftime( szOutputFile, sizeof(szOutputFile), "_cssff_batch_%y-%m-%d_%H%M%S", &timeinfo );
+	GetBatchOutputName( szOutputFile, sizeof(szOutputFile), timeinfo, profile );
 	if( !bAborted )
 		_snprintf_s( szOutputFile, sizeof(szOutputFile), sizeof(szOutputFile), "%s_%d.txt", szOutputFile, s_DemosToParse.size() );
 	else
@@ -143,10 +230,11 @@ bool WriteBatchOutput( bool bAborted )
 	if( wrote_errors_or_warnings )
 		file_output.write( "\n\nFOUND FRAGS:\n\n", 16 );
 
-	if( g_BatchOutput.length() )
-		file_output.write( g_BatchOutput.c_str(), g_BatchOutput.length() );
-	else
+	// Frags were streamed to the partial output file during the batch
+	if( !g_BatchWriter.HasOutput( profile ) )
 		file_output.write( "No frags found\n\n", 16 );
+	else if( !g_BatchWriter.CopyOutput( profile, file_output ) )
+		printf( "Failed to copy the found frags from the partial output file, they can be found in the _partial.txt file\n" );
 
 	file_output.write( "Batch end", 9 );
 
@@ -157,6 +245,21 @@ bool WriteBatchOutput( bool bAborted )
 
 	printf( "Results have been written to file %s in %s folder\n\n", szOutputFile, Settings()->WriteOutputToDemoDirectory()? "processed" : "program" );
 
+#ifdef CSSFF_ENABLE_STATS
+	// Parsing stats are the same for all profiles
+	if( profile > 0 )
+		return true;
+
+	std::string strStatsFile = szOutputFile;
+	RemoveFileExtension( strStatsFile );
+	strStatsFile += "_stats.txt";
+
+	if( Settings()->WriteOutputToDemoDirectory() )
+		g_BatchStats.WriteToFile( g_BatchDirectory + strStatsFile, std::string( CSSFF_NAME ) + " parsing stats for the batch" );
+	else
+		g_BatchStats.WriteToFile( g_ProgramDirectory + strStatsFile, std::string( CSSFF_NAME ) + " parsing stats for the batch" );
+#endif
+
 	return true;
 }
 
@@ -169,53 +272,7 @@ void HandleDemoError( const DemoFile &demo )
 {
 	assert( !demo.IsValidDemo() );
 
-	std::string error;
-
-	demoheader_t *hdr = (demoheader_t *)demo.GetBuffer();
-
-	// Format the error message
-	switch( demo.GetError() )
-	{
-		case COULD_NOT_OPEN_FILE:
-		default:
-		{
-			error = std::format( "failed to open file \"{}\"", demo.GetFileName() );
-			break;
-		}
-		case FILE_TOO_SMALL:
-		{
-			error = "file too small";
-			break;
-		}
-		case INVALID_HDR_ID:
-		{
-			error = "invalid demo header ID";
-			break;
-		}
-		case INVALID_DEM_PROTOCOL:
-		{
-			error = std::format( "demo protocol {} is invalid - expected {}", hdr->demoprotocol, DEMO_PROTOCOL );
-			break;
-		}
-		case INVALID_GAMEDIR:
-		{
-			error = std::format( "game directory \"{}\" is invalid - expected \"{}\"", hdr->gamedirectory, CSS_GAMEDIR );
-			break;
-		}
-		case INVALID_NET_PROTOCOL:
-		{
-			if( hdr->networkprotocol >= NETWORK_PROTOCOL_NEW_MIN && hdr->networkprotocol <= NETWORK_PROTOCOL_NEW_MAX )
-			{
-				error = std::format( "CS:S v77{} demo - currently unsupported", hdr->networkprotocol == NETWORK_PROTOCOL_NEW_MAX ? " or Steam CS:S" : "" );
-			}
-			else
-			{
-				error = std::format( "network protocol {} is invalid - expected {}", hdr->networkprotocol, NETWORK_PROTOCOL_V34 );
-			}
-
-			break;
-		}
-	}
+	const std::string error = demo.GetErrorString();
 
 	// Print the error and add it to the failed demos list if need be
 	if( Settings()->BatchProcessingEnabled() )
@@ -241,19 +298,152 @@ int main( int argc, char *argv[] )
 	system( "pause" );
 #endif
 
-	const char *szSettingsArg = nullptr;
+	std::vector< const char * > settingsArgs;
 	const char *szBatchDirArg = nullptr;
 	bool bUnrecognizedArgs = false;
+	int nFirstRound = -1;		// Round range from -rounds/-round
+	int nLastRound = -1;
+	int nTargetTick = -1;		// Tick from -tick
+	bool bScan = false;			// Only list the demo metadata (-scan or -scaninfo)
+	bool bScanServerInfo = false;
+	bool bWatch = false;		// Parse new demos as they appear in the folder (-watch)
+	bool bDaemon = false;		// Parse demos on request from a socket (-daemon)
+	bool bDaemonRequest = false;	// Send the demos to a running daemon (-request)
+	bool bDaemonStop = false;		// Ask a running daemon to stop (-stopdaemon)
+	int nRequestProfile = -1;	// Settings profile from -profile for -request
+	const char *szSocketArg = nullptr;	// Socket path from -socket
+	const char *szGenerateArg = nullptr;	// Demo to write from -generate
+	GeneratorOptions_t generatorOptions;	// Set by the -gen* arguments
+	bool bBench = false;		// Benchmark parsing the demos (-bench)
+	int nBenchRuns = BENCH_DEFAULT_RUNS;	// Times each demo is parsed from -benchruns
+	const char *szGoldenArg = nullptr;	// Golden frag file from -golden
+	bool bSlim = false;			// Write slim copies of the demos (-slim)
 
 	// Process the arguments
 	for( int nArg = 1; nArg < argc; ++nArg )
 	{
 		const char *szArg = argv[ nArg ];
 
-		if( FileHasExtension( szArg, "dem" ) )
+		if( !strcmp( szArg, "-rounds" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d-%d", &nFirstRound, &nLastRound ) != 2 || nFirstRound < 0 || nLastRound < nFirstRound )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-round" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d", &nFirstRound ) != 1 || nFirstRound < 0 )
+				bUnrecognizedArgs = true;
+
+			nLastRound = nFirstRound;
+		}
+		else if( !strcmp( szArg, "-tick" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d", &nTargetTick ) != 1 || nTargetTick < 0 )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-scan" ) )
+		{
+			bScan = true;
+		}
+		else if( !strcmp( szArg, "-scaninfo" ) )
+		{
+			bScan = true;
+			bScanServerInfo = true;
+		}
+		else if( !strcmp( szArg, "-watch" ) )
+		{
+			bWatch = true;
+		}
+		else if( !strcmp( szArg, "-daemon" ) )
+		{
+			bDaemon = true;
+		}
+		else if( !strcmp( szArg, "-request" ) )
+		{
+			bDaemonRequest = true;
+		}
+		else if( !strcmp( szArg, "-stopdaemon" ) )
+		{
+			bDaemonStop = true;
+		}
+		else if( !strcmp( szArg, "-profile" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d", &nRequestProfile ) != 1 || nRequestProfile < 0 )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-socket" ) && nArg + 1 < argc )
+		{
+			szSocketArg = argv[ ++nArg ];
+		}
+		else if( !strcmp( szArg, "-bench" ) )
+		{
+			bBench = true;
+		}
+		else if( !strcmp( szArg, "-slim" ) )
+		{
+			bSlim = true;
+		}
+		else if( !strcmp( szArg, "-benchruns" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d", &nBenchRuns ) != 1 || nBenchRuns <= 0 )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-golden" ) && nArg + 1 < argc )
+		{
+			// The file doesn't have to exist yet
+			szGoldenArg = argv[ ++nArg ];
+		}
+		else if( !strcmp( szArg, "-generate" ) && nArg + 1 < argc )
+		{
+			// The demo doesn't exist yet, so it's not taken as a demo to parse
+			szGenerateArg = argv[ ++nArg ];
+		}
+		else if( !strcmp( szArg, "-genrounds" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d", &generatorOptions.numRounds ) != 1 )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-gensize" ) && nArg + 1 < argc )
+		{
+			int nSizeMB = 0;
+			if( sscanf_s( argv[ ++nArg ], "%d", &nSizeMB ) != 1 || nSizeMB <= 0 )
+				bUnrecognizedArgs = true;
+
+			generatorOptions.targetSize = (int64)nSizeMB * 1024 * 1024;
+		}
+		else if( !strcmp( szArg, "-genplayers" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d", &generatorOptions.numPlayers ) != 1 )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-gentickrate" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%d", &generatorOptions.tickRate ) != 1 )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-genkills" ) && nArg + 1 < argc )
+		{
+			generatorOptions.killPattern = argv[ ++nArg ];
+		}
+		else if( !strcmp( szArg, "-genseed" ) && nArg + 1 < argc )
+		{
+			if( sscanf_s( argv[ ++nArg ], "%u", &generatorOptions.seed ) != 1 )
+				bUnrecognizedArgs = true;
+		}
+		else if( !strcmp( szArg, "-gengzip" ) )
+		{
+			generatorOptions.bGzipCopies = true;
+		}
+		else if( IsDemoFile( szArg ) )
 			s_DemosToParse.emplace_back( szArg );
+		else if( IsArchiveFile( szArg ) )
+		{
+			// The demos in an archive are parsed as if they had been given one by one
+			if( !FindDemosInArchive( szArg, s_DemosToParse ) )
+				printf( "%s: Failed to read archive %s\n", CSSFF_NAME, szArg );
+		}
 		else if( FileHasExtension( szArg, "ini" ) )
-			szSettingsArg = szArg;
+			settingsArgs.push_back( szArg );
 		else if( IsValidDirectory( szArg ) )
 			szBatchDirArg = szArg;
 		else
@@ -271,7 +461,47 @@ int main( int argc, char *argv[] )
 	g_ProgramDirectory = g_ProgramDirectory.substr( 0, pos+1 );
 
 	// Load program settings
-	Settings()->LoadSettings( szSettingsArg );
+	// Additional settings files are profiles whose frags are found from the same parse
+	Settings()->LoadSettings( settingsArgs.empty()? nullptr : settingsArgs[ 0 ] );
+
+	for( size_t i = 1; i < settingsArgs.size(); ++i )
+	{
+		// Skipping the profile would change the index of every profile after it
+		if( !Settings()->AddProfile( settingsArgs[ i ] ) )
+		{
+			printf( "%s: Could not open settings file \"%s\" of settings profile %d\n", CSSFF_NAME, settingsArgs[ i ], (int)i );
+
+			// The daemon and benchmark modes run without user interaction
+			if( !bDaemon && !bDaemonRequest && !bDaemonStop && !bBench )
+				system( "pause" );
+
+			return 1;
+		}
+	}
+
+	// Generating a test demo doesn't parse anything
+	if( szGenerateArg )
+		return GenerateDemo( szGenerateArg, generatorOptions )? 0 : 1;
+
+	// The daemon and its clients run without user interaction, so they don't pause at the end
+	const std::string strSocketPath = szSocketArg? szSocketArg : g_ProgramDirectory + DAEMON_SOCKET_NAME;
+
+	if( bDaemon )
+		return RunDaemon( strSocketPath )? 0 : 1;
+
+	if( bDaemonStop )
+		return RunDaemonClient( strSocketPath, std::vector< std::string >(), -1 )? 0 : 1;
+
+	if( bDaemonRequest )
+	{
+		if( s_DemosToParse.empty() )
+		{
+			printf( "%s: No demos given for the daemon to parse\n", CSSFF_NAME );
+			return 1;
+		}
+
+		return RunDaemonClient( strSocketPath, s_DemosToParse, nRequestProfile )? 0 : 1;
+	}
 
 	// Check if we should search for demos from a different folder
 	if( szBatchDirArg )
@@ -296,6 +526,80 @@ int main( int argc, char *argv[] )
 		}
 	}
 
+	// Watch mode parses the demos that appear in the folder until the user stops it
+	if( bWatch )
+	{
+		bool bResult = WatchDirectory( g_BatchDirectory );
+
+		system( "pause" );
+		return bResult? 0 : 1;
+	}
+
+	// Benchmark mode runs without user interaction, so it doesn't pause at the end
+	if( bBench )
+	{
+		if( s_DemosToParse.empty() )
+			FindDemosInFolder( g_BatchDirectory );
+
+		tm timeinfo;
+		time_t rawtime;
+		time( &rawtime );
+		localtime_s( &timeinfo, &rawtime );
+
+		char szReportFile[ MAX_PATH ];
+		strftime( szReportFile, sizeof(szReportFile), "_cssff_bench_%y-%m-%d_%H%M%S.txt", &timeinfo );
+
+		const std::string strReportPath = ( Settings()->WriteOutputToDemoDirectory()? g_BatchDirectory : g_ProgramDirectory ) + szReportFile;
+
+		return RunBenchmark( s_DemosToParse, g_BatchDirectory, nBenchRuns, szGoldenArg? szGoldenArg : "", strReportPath )? 0 : 1;
+	}
+
+	// Slim mode writes a copy of each demo with only the data that the parser uses
+	if( bSlim )
+	{
+		if( s_DemosToParse.empty() )
+			FindDemosInFolder( g_BatchDirectory );
+
+		bool bResult = SlimDemos( s_DemosToParse );
+
+		system( "pause" );
+		return bResult? 0 : 1;
+	}
+
+	// Scan mode only reads the demo headers and writes them to a manifest
+	if( bScan )
+	{
+		if( s_DemosToParse.empty() )
+			FindDemosInFolder( g_BatchDirectory );
+
+		printf( "%s: Scanning %d demos...\n", CSSFF_NAME, (int)s_DemosToParse.size() );
+
+		tm timeinfo;
+		time_t rawtime;
+		time( &rawtime );
+		localtime_s( &timeinfo, &rawtime );
+
+		char szManifestFile[ MAX_PATH ];
+		strftime( szManifestFile, sizeof(szManifestFile), "_cssff_scan_%y-%m-%d_%H%M%S.txt", &timeinfo );
+
+		const std::string strManifestPath = ( Settings()->WriteOutputToDemoDirectory()? g_BatchDirectory : g_ProgramDirectory ) + szManifestFile;
+
+		auto scan_start = std::chrono::steady_clock::now();
+
+		if( ScanDemos( s_DemosToParse, bScanServerInfo, strManifestPath ) )
+		{
+			std::chrono::duration< double > scan_elapsed = std::chrono::steady_clock::now() - scan_start;
+			printf( "Manifest has been written to file %s in %s folder (%.2f seconds)\n\n", szManifestFile, Settings()->WriteOutputToDemoDirectory()? "processed" : "program", scan_elapsed.count() );
+		}
+		else
+		{
+			printf( "Failed to write the manifest to file\n\n" );
+		}
+
+		system( "pause" );
+		return 0;
+	}
+
 	// Should we batch process the folder?
 	if( s_DemosToParse.empty() )
 	{
@@ -323,19 +627,58 @@ int main( int argc, char *argv[] )
 	if( Settings()->BatchProcessingEnabled() && nDemosToParse <= 1 )
 		Settings()->DisableBatchProcessing();
 
+	// Copies of the same demo are only parsed once, and the output of the first copy is kept for the others
+	std::vector< int > duplicateOf( nDemosToParse, -1 );
+	std::map< int, KeptOutput_t > keptOutputs;
+	std::vector< std::string > demosToLoad;
+
+	if( Settings()->BatchProcessingEnabled() && Settings()->SkipDuplicateDemos() )
+	{
+		int nDuplicates = FindDuplicateDemos( s_DemosToParse, duplicateOf );
+
+		for( int nDemo = 0; nDemo < nDemosToParse; ++nDemo )
+		{
+			if( duplicateOf[ nDemo ] >= 0 )
+				keptOutputs[ duplicateOf[ nDemo ] ];
+			else
+				demosToLoad.push_back( s_DemosToParse[ nDemo ] );
+		}
+
+		if( nDuplicates > 0 )
+			printf( "%s: Found %d copies of other demos, they are only parsed once\n", CSSFF_NAME, nDuplicates );
+	}
+	else
+	{
+		demosToLoad = s_DemosToParse;
+	}
+
 	if( Settings()->BatchProcessingEnabled() )
 	{
-		g_BatchOutput.reserve( 512 );
+		StartBatchOutput();
 		printf( "%s: Batch processing %d demos...\n", CSSFF_NAME, nDemosToParse );
 		printf( "Press 'Q' to abort the process\n\n" );
 	}
 
 	// ===== The main parsing loop ========================================
 	bool bAborted = false;
-	std::time_t start_time = std::time( nullptr );
+	auto start_time = std::chrono::steady_clock::now();
+
+	Progress()->Start( s_DemosToParse );
+
+	// Loads the next demos while the current one is being parsed
+	DemoPrefetcher prefetcher( demosToLoad );
 
 	for( int nDemo = 0; nDemo < nDemosToParse; ++nDemo )
 	{
+		Progress()->SetCurrentDemo( nDemo );
+
+		// The user may have pressed 'Q' while the previous demo was finishing up
+		if( Progress()->AbortRequested() )
+		{
+			bAborted = true;
+			break;
+		}
+
 		if( Settings()->BatchProcessingEnabled() )
 		{
 			printf( "Demo %d/%d: ", nDemo+1, nDemosToParse );
@@ -343,9 +686,40 @@ int main( int argc, char *argv[] )
 
 		const char *szCurrentDemo = s_DemosToParse[ nDemo ].c_str();
 
+		// Write the output of the first copy again under this demo's name
+		if( duplicateOf[ nDemo ] >= 0 )
+		{
+			const KeptOutput_t &kept = keptOutputs[ duplicateOf[ nDemo ] ];
+
+			std::string strFilename = szCurrentDemo;
+			RemoveFileNameFolders( strFilename );
+
+			std::string strOriginal = s_DemosToParse[ duplicateOf[ nDemo ] ];
+			RemoveFileNameFolders( strOriginal );
+
+			if( kept.bComplete )
+			{
+				printf( "Copy of %s", strOriginal.c_str() );
+				FragOutput::WriteKeptOutput( kept, strFilename );
+
+				++nParsedDemos;
+			}
+			else
+			{
+				printf( "Skipped (copy of %s, which failed to parse)\n", strOriginal.c_str() );
+				g_FailedDemos.emplace_back( strFilename + ": copy of " + strOriginal + ", which failed to parse\n" );
+			}
+
+			continue;
+		}
+
+		// Set if this demo has copies later in the batch
+		auto kept = keptOutputs.find( nDemo );
+
 		try // Try parsing the demo
 		{
-			DemoFile demo( szCurrentDemo );
+			std::unique_ptr< DemoFile > pDemo( prefetcher.GetNextDemo() );
+			DemoFile &demo = *pDemo;
 
 			if( !demo.IsValidDemo() )
 			{
@@ -355,18 +729,32 @@ int main( int argc, char *argv[] )
 
 			DemoParser parser( &demo );
 
+			if( nFirstRound >= 0 || nTargetTick >= 0 )
+				parser.SetParseRange( nFirstRound, nLastRound, nTargetTick );
+
+			if( kept != keptOutputs.end() )
+				parser.KeepOutput( &kept->second );
+
 			bAborted = !parser.Parse();
 
 			if( bAborted )
 				break;
 
+			if( kept != keptOutputs.end() )
+				kept->second.bComplete = true;
+
 			++nParsedDemos;
 		}
 		catch( ParsingError_t error )
 		{
 			// Ignore errors at the end of a demo, since they often happen on map change etc.
 			if( error.at_end_of_demo )
+			{
+				if( kept != keptOutputs.end() )
+					kept->second.bComplete = true;
+
 				continue;
+			}
 
 			if( Settings()->BatchProcessingEnabled() )
 			{
@@ -384,16 +772,19 @@ int main( int argc, char *argv[] )
 		}
 	}
 
+	Progress()->Stop();
+	g_BatchWriter.Stop();
+
 	// Print elapsed time
-	std::time_t end_time = std::time( nullptr );
-	double elapsed_seconds = (double)(end_time - start_time);
+	std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start_time;
+	double elapsed_seconds = elapsed.count();
 	int elapsed_minutes = ((int)elapsed_seconds) / 60;
-	int remaining_seconds = ((int)elapsed_seconds) % 60;
+	double remaining_seconds = elapsed_seconds - elapsed_minutes * 60;
 
 	printf( "\nElapsed time: ");
 	if( elapsed_minutes )
 		printf( "%d minutes ", elapsed_minutes );
-	printf( "%d seconds\n\n", remaining_seconds );
+	printf( "%.2f seconds\n\n", remaining_seconds );
 
 	// Write batch output
 	if( Settings()->BatchProcessingEnabled() )
@@ -403,7 +794,8 @@ int main( int argc, char *argv[] )
 		else
 			printf( "\nProcess aborted - %d/%d demos successfully parsed\n", nParsedDemos, nDemosToParse );
 
-		WriteBatchOutput( bAborted );
+		for( int profile = 0; profile < Settings()->GetNumProfiles(); ++profile )
+			WriteBatchOutput( bAborted, profile );
 	}
 
 	system( "pause" );
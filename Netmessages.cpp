@@ -96,6 +96,7 @@ void DemoParser::HandleSVCServerInfo( bf_read &reader )
 	m_fTickInterval = tickinterval;
 	m_iTickRate = (int)floor( 1 / m_fTickInterval );
 	m_bIsPOV = !ishltv;
+	m_FragOutput.SetPOV( m_bIsPOV );
 	m_iPOVPlayerSlot = playerslot;
 
 	if( platform != 'w' && platform != 'l' )
@@ -114,7 +115,7 @@ void DemoParser::HandleSVCServerInfo( bf_read &reader )
 	reader.ReadString( hostname, sizeof(hostname) );
 
 	// Print demo info if this is the only demo being parsed
-	if( !Settings()->BatchProcessingEnabled() )
+	if( !Settings()->BatchProcessingEnabled() && !m_bSubParser )
 	{
 		float demoLength = m_demoHeader.playback_time;
 		int demoTicks = m_demoHeader.playback_ticks;
@@ -199,6 +200,8 @@ void DemoParser::HandleSVCSetPause( bf_read &reader )
 
 void DemoParser::HandleSVCCreateStringTable( bf_read &reader )
 {
+	STATS_SCOPE( PHASE_STRING_TABLES );
+
 	char name[ 512 ];
 	reader.ReadString( name, sizeof(name) );
 
@@ -221,8 +224,6 @@ void DemoParser::HandleSVCCreateStringTable( bf_read &reader )
 		throw ParsingError_t( "tried to create bogus string table" );
 	}
 
-	bool bIsUserInfo = !strcmp( name, "userinfo" );
-
 #if defined _DEBUG_PRINT_STRINGTABLES
 	std::cout << "    L " << "Table name: " << name << std::endl;
 	std::cout << "    L " << "Max entries: " << max_entries << std::endl;
@@ -238,13 +239,21 @@ void DemoParser::HandleSVCCreateStringTable( bf_read &reader )
 
 	CreateStringTable( name, max_entries, user_data_size, user_data_size_bits, user_data_fixed_size );
 
-	ParseStringTableUpdate( reader, num_entries, max_entries, user_data_size, user_data_size_bits, user_data_fixed_size, bIsUserInfo );
+	const StringTableData_t &table = m_StringTables[ m_iNumStringTables - 1 ];
+
+	// Only the players are needed, the other tables are skipped without decoding their entries
+	if( table.bIsUserInfo )
+		ParseUserInfoUpdate( reader, num_entries, table );
+	else
+		reader.SeekRelative( datasize );
 }
 
 // =====================================================================================================================================================================
 
 void DemoParser::HandleSVCUpdateStringTable( bf_read &reader )
 {
+	STATS_SCOPE( PHASE_STRING_TABLES );
+
 	int tableID = reader.ReadUBitLong( m_bUse5BitStringTableIndices ? 5 : 4 );
 
 	bool multiple_changed_entries = reader.ReadOneBit();
@@ -261,9 +270,10 @@ void DemoParser::HandleSVCUpdateStringTable( bf_read &reader )
 
 	if( pTable && pTable->nMaxEntries > num_changed_entries )
 	{
-		bool bIsUserInfo = !strcmp( pTable->szName, "userinfo" );
-
-		ParseStringTableUpdate( reader, num_changed_entries, pTable->nMaxEntries, pTable->nUserDataSize, pTable->nUserDataSizeBits, pTable->bUserDataFixedSize, bIsUserInfo );
+		if( pTable->bIsUserInfo )
+			ParseUserInfoUpdate( reader, num_changed_entries, *pTable );
+		else
+			reader.SeekRelative( datasize );
 	}
 	else
 	{
@@ -378,6 +388,8 @@ void DemoParser::HandleSVCEntityMessage( bf_read &reader )
 
 void DemoParser::HandleSVCGameEvent( bf_read &reader )
 {
+	STATS_SCOPE( PHASE_GAME_EVENTS );
+
 	int datalength = reader.ReadUBitLong( 11 );
 
 	HandleGameEvent( reader );
@@ -387,6 +399,8 @@ void DemoParser::HandleSVCGameEvent( bf_read &reader )
 
 void DemoParser::HandleSVCPacketEntities( bf_read &reader )
 {
+	STATS_SCOPE( PHASE_PACKET_ENTITIES );
+
 	int maxentries = reader.ReadUBitLong( 11 );
 	bool isdelta = reader.ReadOneBit();
 	int deltafrom = -1;
@@ -401,6 +415,10 @@ void DemoParser::HandleSVCPacketEntities( bf_read &reader )
 
 	bool updatebaseline = reader.ReadOneBit();
 
+	// ProcessPacketEntities lowers these if it stops before the end
+	m_iPlayerEntityUpdates = updatedentries;
+	m_iPlayerEntityBits = datalength;
+
 	// Fork the reader
 	int databytes = BITS2BYTES( datalength );
 	char *data = new char[ databytes ];
@@ -474,6 +492,168 @@ void DemoParser::HandleSVCGetCvarValue( bf_read &reader )
 
 // =====================================================================================================================================================================
 
+void DemoParser::HandleNetMessage( bf_read &reader, int msg )
+{
+	switch( msg )
+	{
+		default:
+		{
+			throw ParsingError_t( "invalid NET/SVC message type encountered" );
+		}
+		case NET_NOP:
+		{
+			break;
+		}
+		case NET_Disconnect:
+		{
+			HandleNETDisconnect( reader );
+			break;
+		}
+		case NET_File:
+		{
+			HandleNETFile( reader );
+			break;
+		}
+		case NET_Tick:
+		{
+			HandleNETTick( reader );
+			break;
+		}
+		case NET_StringCmd:
+		{
+			HandleNETStringCmd( reader );
+			break;
+		}
+		case NET_SetConVar:
+		{
+			HandleNETSetConVar( reader );
+			break;
+		}
+		case NET_SignOnState:
+		{
+			HandleNETSignOnState( reader );
+			break;
+		}
+		case SVC_Print:
+		{
+			HandleSVCPrint( reader );
+			break;
+		}
+		case SVC_ServerInfo:
+		{
+			HandleSVCServerInfo( reader );
+			break;
+		}
+		case SVC_SendTable:
+		{
+			HandleSVCSendTable( reader );
+			break;
+		}
+		case SVC_ClassInfo:
+		{
+			HandleSVCClassInfo( reader );
+			break;
+		}
+		case SVC_SetPause:
+		{
+			HandleSVCSetPause( reader );
+			break;
+		}
+		case SVC_CreateStringTable:
+		{
+			HandleSVCCreateStringTable( reader );
+			break;
+		}
+		case SVC_UpdateStringTable:
+		{
+			HandleSVCUpdateStringTable( reader );
+			break;
+		}
+		case SVC_VoiceInit:
+		{
+			HandleSVCVoiceInit( reader );
+			break;
+		}
+		case SVC_VoiceData:
+		{
+			HandleSVCVoiceData( reader );
+			break;
+		}
+		case SVC_Sounds:
+		{
+			HandleSVCSounds( reader );
+			break;
+		}
+		case SVC_SetView:
+		{
+			HandleSVCSetView( reader );
+			break;
+		}
+		case SVC_FixAngle:
+		{
+			HandleSVCFixAngle( reader );
+			break;
+		}
+		case SVC_CrosshairAngle:
+		{
+			HandleSVCCrosshairAngle( reader );
+			break;
+		}
+		case SVC_BSPDecal:
+		{
+			HandleSVCBSPDecal( reader );
+			break;
+		}
+		case SVC_UserMessage:
+		{
+			HandleSVCUserMessage( reader );
+			break;
+		}
+		case SVC_EntityMessage:
+		{
+			HandleSVCEntityMessage( reader );
+			break;
+		}
+		case SVC_GameEvent:
+		{
+			HandleSVCGameEvent( reader );
+			break;
+		}
+		case SVC_PacketEntities:
+		{
+			HandleSVCPacketEntities( reader );
+			break;
+		}
+		case SVC_TempEntities:
+		{
+			HandleSVCTempEntities( reader );
+			break;
+		}
+		case SVC_Prefetch:
+		{
+			HandleSVCPrefetch( reader );
+			break;
+		}
+		case SVC_Menu:
+		{
+			HandleSVCMenu( reader );
+			break;
+		}
+		case SVC_GameEventList:
+		{
+			HandleSVCGameEventList( reader );
+			break;
+		}
+		case SVC_GetCvarValue:
+		{
+			HandleSVCGetCvarValue( reader );
+			break;
+		}
+	}
+}
+
+// =====================================================================================================================================================================
+
 void DemoParser::HandleDemoPacket( bf_read &reader )
 {
 	democmdinfo_t info;
@@ -489,8 +669,13 @@ void DemoParser::HandleDemoPacket( bf_read &reader )
 	reader.ReadBytes( data, datasize );
 	bf_read packetreader( data, datasize );
 
+	if( m_pSlimWriter )
+		m_pSlimWriter->BeginPacket( datasize );
+
 	while( packetreader.GetNumBytesRead() < datasize )
 	{
+		const int startBit = packetreader.GetNumBitsRead();
+
 		byte msg = packetreader.ReadUBitLong( 5 );
 
 		if( msg < 0 || msg >= NumMessageTypes || packetreader.IsOverflowed() )
@@ -498,162 +683,12 @@ void DemoParser::HandleDemoPacket( bf_read &reader )
 			throw ParsingError_t( "invalid NET/SVC message type encountered" );
 		}
 
-		switch( msg )
-		{
-			default:
-			{
-				throw ParsingError_t( "invalid NET/SVC message type encountered" );
-			}
-			case NET_NOP:
-			{
-				break;
-			}
-			case NET_Disconnect:
-			{
-				HandleNETDisconnect( packetreader );
-				break;
-			}
-			case NET_File:
-			{
-				HandleNETFile( packetreader );
-				break;
-			}
-			case NET_Tick:
-			{
-				HandleNETTick( packetreader );
-				break;
-			}
-			case NET_StringCmd:
-			{
-				HandleNETStringCmd( packetreader );
-				break;
-			}
-			case NET_SetConVar:
-			{
-				HandleNETSetConVar( packetreader );
-				break;
-			}
-			case NET_SignOnState:
-			{
-				HandleNETSignOnState( packetreader );
-				break;
-			}
-			case SVC_Print:
-			{
-				HandleSVCPrint( packetreader );
-				break;
-			}
-			case SVC_ServerInfo:
-			{
-				HandleSVCServerInfo( packetreader );
-				break;
-			}
-			case SVC_SendTable:
-			{
-				HandleSVCSendTable( packetreader );
-				break;
-			}
-			case SVC_ClassInfo:
-			{
-				HandleSVCClassInfo( packetreader );
-				break;
-			}
-			case SVC_SetPause:
-			{
-				HandleSVCSetPause( packetreader );
-				break;
-			}
-			case SVC_CreateStringTable:
-			{
-				HandleSVCCreateStringTable( packetreader );
-				break;
-			}
-			case SVC_UpdateStringTable:
-			{
-				HandleSVCUpdateStringTable( packetreader );
-				break;
-			}
-			case SVC_VoiceInit:
-			{
-				HandleSVCVoiceInit( packetreader );
-				break;
-			}
-			case SVC_VoiceData:
-			{
-				HandleSVCVoiceData( packetreader );
-				break;
-			}
-			case SVC_Sounds:
-			{
-				HandleSVCSounds( packetreader );
-				break;
-			}
-			case SVC_SetView:
-			{
-				HandleSVCSetView( packetreader );
-				break;
-			}
-			case SVC_FixAngle:
-			{
-				HandleSVCFixAngle( packetreader );
-				break;
-			}
-			case SVC_CrosshairAngle:
-			{
-				HandleSVCCrosshairAngle( packetreader );
-				break;
-			}
-			case SVC_BSPDecal:
-			{
-				HandleSVCBSPDecal( packetreader );
-				break;
-			}
-			case SVC_UserMessage:
-			{
-				HandleSVCUserMessage( packetreader );
-				break;
-			}
-			case SVC_EntityMessage:
-			{
-				HandleSVCEntityMessage( packetreader );
-				break;
-			}
-			case SVC_GameEvent:
-			{
-				HandleSVCGameEvent( packetreader );
-				break;
-			}
-			case SVC_PacketEntities:
-			{
-				HandleSVCPacketEntities( packetreader );
-				break;
-			}
-			case SVC_TempEntities:
-			{
-				HandleSVCTempEntities( packetreader );
-				break;
-			}
-			case SVC_Prefetch:
-			{
-				HandleSVCPrefetch( packetreader );
-				break;
-			}
-			case SVC_Menu:
-			{
-				HandleSVCMenu( packetreader );
-				break;
-			}
-			case SVC_GameEventList:
-			{
-				HandleSVCGameEventList( packetreader );
-				break;
-			}
-			case SVC_GetCvarValue:
-			{
-				HandleSVCGetCvarValue( packetreader );
-				break;
-			}
-		}
+		STATS_ADD( messages[ msg ], 1 );
+
+		HandleNetMessage( packetreader, msg );
+
+		if( m_pSlimWriter )
+			SlimMessage( msg, packetreader, startBit );
 	}
 
 	delete[] data;
@@ -0,0 +1,636 @@
+#include "Pipeline.h"
+#include "DemoParser.h"
+#include "Errors.h"
+#include "Netmessages.h"
+#include "Progress.h"
+#include <thread>
+
+// Pipelined parsing
+//
+// The framing thread reads the demo commands and splits every packet into its NET/SVC messages. It reads just enough
+// of each message to find where it ends, and hands the parser only the spans of the messages that change the parser
+// state (server info, string tables, game events and entities). The parser thread decodes those spans, then does the
+// post checks and frag finding that depend on what it just decoded. The two threads are connected by a bounded queue,
+// so the framing thread stays at most PIPELINE_QUEUE_SIZE commands ahead.
+
+// =====================================================================================================================================================================
+
+FrameQueue::FrameQueue( void )
+{
+	m_iHead = 0;
+	m_iTail = 0;
+	m_bCancelled = false;
+}
+
+// =====================================================================================================================================================================
+
+DemoFrame_t *FrameQueue::BeginPush( void )
+{
+	const uint32 tail = m_iTail.load( std::memory_order_relaxed );
+	uint32 head = m_iHead.load( std::memory_order_acquire );
+
+	while( tail - head >= PIPELINE_QUEUE_SIZE )
+	{
+		if( m_bCancelled.load( std::memory_order_relaxed ) )
+			return nullptr;
+
+		m_iHead.wait( head, std::memory_order_acquire );
+		head = m_iHead.load( std::memory_order_acquire );
+	}
+
+	if( m_bCancelled.load( std::memory_order_relaxed ) )
+		return nullptr;
+
+	return &m_Frames[ tail % PIPELINE_QUEUE_SIZE ];
+}
+
+// =====================================================================================================================================================================
+
+void FrameQueue::EndPush( void )
+{
+	m_iTail.fetch_add( 1, std::memory_order_release );
+	m_iTail.notify_one();
+}
+
+// =====================================================================================================================================================================
+
+DemoFrame_t *FrameQueue::BeginPop( void )
+{
+	const uint32 head = m_iHead.load( std::memory_order_relaxed );
+	uint32 tail = m_iTail.load( std::memory_order_acquire );
+
+	while( tail == head )
+	{
+		m_iTail.wait( tail, std::memory_order_acquire );
+		tail = m_iTail.load( std::memory_order_acquire );
+	}
+
+	return &m_Frames[ head % PIPELINE_QUEUE_SIZE ];
+}
+
+// =====================================================================================================================================================================
+
+void FrameQueue::EndPop( void )
+{
+	m_iHead.fetch_add( 1, std::memory_order_release );
+	m_iHead.notify_one();
+}
+
+// =====================================================================================================================================================================
+
+void FrameQueue::Cancel( void )
+{
+	m_bCancelled.store( true, std::memory_order_relaxed );
+
+	// Wake up the framing thread if it's waiting for a free frame, it checks the flag before pushing anything
+	m_iHead.fetch_add( 1, std::memory_order_release );
+	m_iHead.notify_one();
+}
+
+// =====================================================================================================================================================================
+/**
+ * The framing stage
+ * Skipping a message reads exactly the same fields as its handler in Netmessages.cpp.
+ */
+class DemoFramer
+{
+public:
+	DemoFramer( const DemoFile *pDemo, uint32 startOffset, FrameQueue &queue );
+
+	void Run( void );									///< Entry point of the framing thread
+
+	const ParsingStats_t &GetStats( void ) const { return m_Stats; }
+
+private:
+	void FramePacket( bf_read &reader, DemoFrame_t &frame );	///< Sets the error of the frame if the packet can't be split
+	bool SkipMessage( bf_read &reader, int msg, DemoFrame_t &frame );	///< Reads past a message, returns whether the parser has to decode it (sets the frame error for types without a handler)
+
+	const DemoFile *	m_pDemo;
+	uint32				m_iStartOffset;
+	FrameQueue &		m_Queue;
+	bool				m_bUse5BitStringTableIndices;	///< Read from SVC_ServerInfo like the parser does
+	ParsingStats_t		m_Stats;						///< Message counters of the framing thread (only collected with CSSFF_ENABLE_STATS)
+};
+
+// =====================================================================================================================================================================
+
+DemoFramer::DemoFramer( const DemoFile *pDemo, uint32 startOffset, FrameQueue &queue ) : m_Queue( queue )
+{
+	m_pDemo = pDemo;
+	m_iStartOffset = startOffset;
+	m_bUse5BitStringTableIndices = true;
+}
+
+// =====================================================================================================================================================================
+
+void DemoFramer::Run( void )
+{
+#ifdef CSSFF_ENABLE_STATS
+	gpStats = &m_Stats;
+#endif
+
+	bf_read reader( m_pDemo->GetBuffer(), m_pDemo->GetFileSize() );
+	reader.Seek( BYTES2BITS( m_iStartOffset ) );
+
+	int tick = 0;
+
+	while( DemoFrame_t *pFrame = m_Queue.BeginPush() )
+	{
+		DemoFrame_t &frame = *pFrame;
+
+		frame.offset = reader.GetNumBytesRead();
+		frame.cmd = reader.ReadByte();
+		frame.tick = tick;
+		frame.spans.clear();
+		frame.bByteMismatch = false;
+		frame.error_msg = nullptr;
+
+		if( frame.cmd < dem_firstcmd || frame.cmd > dem_lastcmd || reader.IsOverflowed() )
+			frame.error_msg = "invalid cmd number";
+
+		// Nothing is read after dem_stop or an error
+		if( frame.error_msg || frame.cmd == dem_stop )
+		{
+			frame.endOffset = reader.GetNumBytesRead();
+			m_Queue.EndPush();
+			break;
+		}
+
+		frame.tick = tick = reader.ReadLong();
+
+		switch( frame.cmd )
+		{
+			case dem_synctick:
+			default:
+				break;
+
+			case dem_signon:
+			case dem_packet:
+			{
+				FramePacket( reader, frame );
+				break;
+			}
+
+			case dem_consolecmd:
+			{
+				size_t datasize = reader.ReadLong();
+				reader.SeekRelative( BYTES2BITS( datasize ) );
+				break;
+			}
+
+			case dem_datatables:
+			{
+				frame.dataSize = reader.ReadLong();
+				frame.dataOffset = reader.GetNumBytesRead();
+				reader.SeekRelative( BYTES2BITS( frame.dataSize ) );
+				break;
+			}
+
+			case dem_usercmd:
+			{
+				reader.ReadLong();	// outgoing_sequence
+				size_t datasize = reader.ReadLong();
+				reader.SeekRelative( BYTES2BITS( datasize ) );
+				break;
+			}
+		}
+
+		frame.endOffset = reader.GetNumBytesRead();
+
+		const bool bFailed = frame.error_msg != nullptr;
+
+		m_Queue.EndPush();
+
+		if( bFailed )
+			break;
+	}
+}
+
+// =====================================================================================================================================================================
+
+void DemoFramer::FramePacket( bf_read &reader, DemoFrame_t &frame )
+{
+	// democmdinfo_t, nSeqNrIn and nSeqNrOut
+	reader.SeekRelative( BYTES2BITS( sizeof( democmdinfo_t ) + 2 * sizeof( int32 ) ) );
+
+	int datasize = reader.ReadLong(); // In bytes
+
+	if( datasize < 0 || datasize > reader.GetNumBytesLeft() )
+	{
+		frame.error_msg = "invalid packet size";
+		return;
+	}
+
+	frame.packet.resize( datasize );
+	reader.ReadBytes( frame.packet.data(), datasize );
+	bf_read packetreader( frame.packet.data(), datasize );
+
+	while( packetreader.GetNumBytesRead() < datasize )
+	{
+		int msg = packetreader.ReadUBitLong( 5 );
+
+		if( msg >= NumMessageTypes || packetreader.IsOverflowed() )
+		{
+			frame.error_msg = "invalid NET/SVC message type encountered";
+			return;
+		}
+
+		STATS_ADD( messages[ msg ], 1 );
+
+		MessageSpan_t span;
+		span.msg = msg;
+		span.startBit = packetreader.GetNumBitsRead();
+
+		const bool bDecode = SkipMessage( packetreader, msg, frame );
+
+		// The parser decodes the spans before this one, then throws
+		if( frame.error_msg )
+			return;
+
+		if( bDecode )
+			frame.spans.push_back( span );
+	}
+
+	frame.bByteMismatch = datasize != packetreader.GetNumBytesRead();
+}
+
+// =====================================================================================================================================================================
+
+bool DemoFramer::SkipMessage( bf_read &reader, int msg, DemoFrame_t &frame )
+{
+	char buffer[ 1024 ];
+
+	switch( msg )
+	{
+		// Message types the parser has no handler for (16, 22), it throws on them
+		default:
+			frame.error_msg = "invalid NET/SVC message type encountered";
+			return false;
+
+		case NET_NOP:
+			return false;
+
+		case NET_Disconnect:
+		case NET_StringCmd:
+		case SVC_Print:
+			reader.ReadString( buffer, sizeof(buffer) );
+			return false;
+
+		case NET_File:
+			reader.ReadLong();
+			reader.ReadString( buffer, sizeof(buffer) );
+			reader.ReadOneBit();
+			return false;
+
+		case NET_Tick:
+			reader.ReadLong();
+			return false;
+
+		case NET_SetConVar:
+		{
+			int num = reader.ReadByte();
+			while( num-- > 0 )
+			{
+				reader.ReadString( buffer, 256 );
+				reader.ReadString( buffer, 256 );
+			}
+			return false;
+		}
+
+		case NET_SignOnState:
+			reader.ReadByte();
+			reader.ReadLong();
+			return false;
+
+		case SVC_ServerInfo:
+		{
+			reader.SeekRelative( 16 + 32 + 1 + 1 + 32 + 16 + 32 + 8 + 8 + 32 );
+			char platform = reader.ReadChar();
+
+			if( platform != 'w' && platform != 'l' )
+				m_bUse5BitStringTableIndices = false;
+
+			for( int i = 0; i < 4; ++i )
+				reader.ReadString( buffer, 256 );
+
+			return true;
+		}
+
+		case SVC_SendTable:
+		{
+			reader.ReadOneBit();
+			int datasize = reader.ReadShort();
+			reader.SeekRelative( datasize );
+			return false;
+		}
+
+		case SVC_ClassInfo:
+		{
+			int num = reader.ReadShort();
+			bool createonclient = reader.ReadOneBit();
+			if( !createonclient )
+			{
+				while( num-- > 0 )
+				{
+					reader.SeekRelative( (int)Log2( num ) + 1 );
+					reader.ReadString( buffer, 256 );
+					reader.ReadString( buffer, 256 );
+				}
+			}
+			return false;
+		}
+
+		case SVC_SetPause:
+			reader.ReadOneBit();
+			return false;
+
+		case SVC_CreateStringTable:
+		{
+			reader.ReadString( buffer, 512 );
+			int max_entries = reader.ReadShort();
+			reader.ReadUBitLong( (int)(Log2(max_entries)+1) );
+			int datasize = reader.ReadUBitLong( 20 );
+
+			if( reader.ReadOneBit() )
+				reader.SeekRelative( 12 + 4 );
+
+			reader.SeekRelative( datasize );
+			return true;
+		}
+
+		case SVC_UpdateStringTable:
+		{
+			reader.ReadUBitLong( m_bUse5BitStringTableIndices ? 5 : 4 );
+
+			if( reader.ReadOneBit() )
+				reader.ReadShort();
+
+			int datasize = reader.ReadWord();
+			reader.SeekRelative( datasize );
+			return true;
+		}
+
+		case SVC_VoiceInit:
+			reader.ReadString( buffer, 256 );
+			reader.ReadByte();
+			return false;
+
+		case SVC_VoiceData:
+		{
+			reader.ReadByte();
+			int datalength = reader.ReadWord();
+			reader.SeekRelative( datalength );
+			return false;
+		}
+
+		case SVC_Sounds:
+		{
+			bool reliablesound = reader.ReadOneBit();
+			if( !reliablesound )
+				reader.ReadByte();
+			int datalength = reliablesound? reader.ReadByte() : reader.ReadShort();
+			reader.SeekRelative( datalength );
+			return false;
+		}
+
+		case SVC_SetView:
+			reader.ReadUBitLong( 11 );
+			return false;
+
+		case SVC_FixAngle:
+			reader.SeekRelative( 1 + 3 * 16 );
+			return false;
+
+		case SVC_CrosshairAngle:
+			reader.SeekRelative( 3 * 16 );
+			return false;
+
+		case SVC_BSPDecal:
+		{
+			Vector pos;
+			reader.ReadBitVec3Coord( pos );
+			reader.ReadUBitLong( 9 );
+			if( reader.ReadOneBit() )
+				reader.SeekRelative( 11 + 11 );
+			reader.ReadOneBit();
+			return false;
+		}
+
+		case SVC_UserMessage:
+		{
+			reader.ReadByte();
+			int datalength = reader.ReadUBitLong( 11 );
+			reader.SeekRelative( datalength );
+			return false;
+		}
+
+		case SVC_EntityMessage:
+		{
+			reader.SeekRelative( 11 + 9 );
+			int datalength = reader.ReadUBitLong( 11 );
+			reader.SeekRelative( datalength );
+			return false;
+		}
+
+		case SVC_GameEvent:
+		{
+			int datalength = reader.ReadUBitLong( 11 );
+			reader.SeekRelative( datalength );
+			return true;
+		}
+
+		case SVC_PacketEntities:
+		{
+			reader.ReadUBitLong( 11 );
+			if( reader.ReadOneBit() )
+				reader.ReadLong();
+			reader.SeekRelative( 1 + 11 );
+			int datalength = reader.ReadUBitLong( 20 );
+			reader.SeekRelative( 1 + datalength );
+			return true;
+		}
+
+		case SVC_TempEntities:
+		{
+			reader.ReadByte();
+			int datalength = reader.ReadUBitLong( 17 );
+			reader.SeekRelative( datalength );
+			return false;
+		}
+
+		case SVC_Prefetch:
+			reader.ReadUBitLong( 13 );
+			return false;
+
+		case SVC_Menu:
+		{
+			reader.ReadShort();
+			int datalength = reader.ReadWord();
+			reader.SeekRelative( BYTES2BITS( datalength ) );
+			return false;
+		}
+
+		case SVC_GameEventList:
+		{
+			reader.ReadUBitLong( 9 );
+			int datalength = reader.ReadUBitLong( 20 );
+			reader.SeekRelative( datalength );
+			return true;
+		}
+
+		case SVC_GetCvarValue:
+			reader.ReadLong();
+			reader.ReadString( buffer, 512 );
+			return false;
+	}
+}
+
+// =====================================================================================================================================================================
+/**
+ * Parses the demo from the reader's position with the framing done on a separate thread
+ * Used instead of ParseCommands for whole demos (no keyframe to jump to, no segment end).
+ * @return						false if parsing was aborted
+ */
+bool DemoParser::ParsePipelined( bf_read &reader )
+{
+	FrameQueue queue;
+	DemoFramer framer( m_pDemo, reader.GetNumBytesRead(), queue );
+
+	std::thread thread( &DemoFramer::Run, &framer );
+
+	bool bCompleted;
+
+	try
+	{
+		bCompleted = DecodeFrames( queue );
+	}
+	catch( ... )
+	{
+		queue.Cancel();
+		thread.join();
+		throw;
+	}
+
+	queue.Cancel();
+	thread.join();
+
+#ifdef CSSFF_ENABLE_STATS
+	m_Stats.Accumulate( framer.GetStats() );
+#endif
+
+	return bCompleted;
+}
+
+// =====================================================================================================================================================================
+/**
+ * The decoding stage, does what ParseCommands does for each command but gets the packets already split into messages
+ */
+bool DemoParser::DecodeFrames( FrameQueue &queue )
+{
+	bool bSynced = false;	// Was sync tick encountered yet?
+
+	while( true )
+	{
+		const DemoFrame_t &frame = *queue.BeginPop();
+
+		m_iCommandOffset = frame.offset;
+		m_iCurrentTick = frame.tick;
+
+		// A packet that failed part way still has the messages before the error to decode
+		if( frame.error_msg && frame.spans.empty() )
+			throw ParsingError_t( frame.error_msg );
+
+		STATS_ADD( commands[ frame.cmd ], 1 );
+
+		// Done parsing?
+		if( frame.cmd == dem_stop )
+			break;
+
+		switch( frame.cmd )
+		{
+			case dem_synctick:
+			{
+				if( !m_bServerInfoEncountered )
+				{
+					throw ParsingError_t( "SVC_ServerInfo not encountered by sync tick" );
+				}
+
+				STATS_PHASE_SINCE( PHASE_SIGNON, m_iParseStartTime );
+
+				bSynced = true;
+				break;
+			}
+
+			case dem_signon:
+			case dem_packet:
+			{
+				DecodePacket( frame );
+				break;
+			}
+
+			case dem_datatables:
+			{
+				std::vector< char > data( m_pDemo->GetBuffer() + frame.dataOffset, m_pDemo->GetBuffer() + frame.dataOffset + frame.dataSize );
+				bf_read forkedReader( data.data(), frame.dataSize );
+
+				ParseDataTables( forkedReader );
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		const uint32 endOffset = frame.endOffset;
+
+		queue.EndPop();
+
+		STATS_SET( bytes_processed, endOffset );
+
+		// Round start was in this command, the next one is where a range parser can resume
+		if( m_bSaveSeekKeyframe )
+		{
+			m_bSaveSeekKeyframe = false;
+			SaveSeekKeyframe( endOffset );
+		}
+
+		if( m_bStopParsing )
+			break;
+
+		// Publish the progress only after sync tick, the sampler thread prints it
+		if( bSynced && !m_bSubParser )
+			Progress()->Update( m_iCurrentTick, endOffset );
+
+		// Check if the user wants to abort parsing (the sampler thread polls the keyboard)
+		if( Progress()->AbortRequested() )
+			return false;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+void DemoParser::DecodePacket( const DemoFrame_t &frame )
+{
+	bf_read packetreader( frame.packet.data(), (int)frame.packet.size() );
+
+	for( size_t i = 0; i < frame.spans.size(); ++i )
+	{
+		packetreader.Seek( frame.spans[ i ].startBit );
+		HandleNetMessage( packetreader, frame.spans[ i ].msg );
+	}
+
+	// The messages before the error are handled like the serial parser does before it throws
+	if( frame.error_msg )
+		throw ParsingError_t( frame.error_msg );
+
+	// Do flickshot/jumpshot checks after packet entities have been processed
+	DoPlayersPostCheck();
+
+	// Add a warning if # of bytes read doesn't match the supposed size of the packet
+	if( frame.bByteMismatch )
+	{
+		AddWarning( m_pDemo->GetFileName(), BYTE_MISMATCH );
+	}
+}
\ No newline at end of file
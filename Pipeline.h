@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <vector>
+
+#define PIPELINE_QUEUE_SIZE		64		// How many commands the framing thread can be ahead of the parser
+
+/**
+ * A NET/SVC message of a packet that the parser has to decode, as a bit range of the packet data
+ */
+struct MessageSpan_t
+{
+	int					msg;					///< Message type
+	int					startBit;				///< First bit after the message type
+};
+
+/**
+ * A demo command read by the framing thread
+ */
+struct DemoFrame_t
+{
+	byte				cmd;
+	int					tick;
+	uint32				offset;					///< Byte offset of the command
+	uint32				endOffset;				///< Byte offset of the next command
+	uint32				dataOffset;				///< Byte offset of the data of dem_datatables
+	uint32				dataSize;
+
+	std::vector< char >	packet;					///< Copy of the packet data (the bit reader needs it dword aligned)
+	std::vector< MessageSpan_t > spans;			///< Messages of the packet that change the parser state, the rest are left out (only the ones before the error if framing failed)
+	bool				bByteMismatch;			///< The messages didn't end at the packet size
+
+	const char *		error_msg;				///< Framing failed at this command, the parser throws this error when it gets here
+};
+
+/**
+ * Bounded single producer, single consumer queue between the framing thread and the parser
+ * The frames are reused, so their buffers are only allocated while the queue warms up.
+ */
+class FrameQueue
+{
+public:
+	FrameQueue( void );
+
+	DemoFrame_t *		BeginPush( void );		///< Waits for a free frame to fill (nullptr if the parser has stopped)
+	void				EndPush( void );
+	DemoFrame_t *		BeginPop( void );		///< Waits for the next filled frame
+	void				EndPop( void );
+
+	void				Cancel( void );			///< Called by the parser when it stops before dem_stop
+
+private:
+	FrameQueue( const FrameQueue & );
+	FrameQueue &operator=( const FrameQueue & );
+
+	DemoFrame_t			m_Frames[ PIPELINE_QUEUE_SIZE ];
+	std::atomic< uint32 > m_iHead;				///< # of frames popped
+	std::atomic< uint32 > m_iTail;				///< # of frames pushed
+	std::atomic< bool >	m_bCancelled;
+};
\ No newline at end of file
@@ -39,7 +39,7 @@ void Player::CopyFrom( const Player &src )
 void Player::AddKill(
 	int tick,
 	char team,
-	const char *weapon_name,
+	CSWeaponID weaponID,
 	bool teamkill,
 	bool headshot,
 	bool noscope,
@@ -54,7 +54,7 @@ void Player::AddKill(
 	kill_info_t info;
 	info.tick = tick;
 	info.team = team;
-	info.weaponID = AliasToWeaponID( weapon_name );
+	info.weaponID = weaponID;
 	info.teamkill = teamkill;
 	info.headshot = headshot;
 	info.noscope = noscope;
@@ -328,6 +328,8 @@ bool KillIsFlickshot( const Player *player, kill_info_t &kill )
 
 void DemoParser::DoPlayersPostCheck()
 {
+	STATS_SCOPE( PHASE_POST_CHECK );
+
 	for( auto it = m_PlayerPostCheckData.begin(); it != m_PlayerPostCheckData.end(); ++it )
 	{
 		PostCheckData_t &data = *it;
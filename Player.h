@@ -104,7 +104,7 @@ public:
 	void AddKill( 
 		int tick,
 		char team,
-		const char *weapon_name,
+		CSWeaponID weaponID,
 		bool teamkill,
 		bool headshot,
 		bool noscope,
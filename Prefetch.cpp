@@ -0,0 +1,77 @@
+#include "Prefetch.h"
+
+DemoPrefetcher::DemoPrefetcher( const std::vector< std::string > &demos )
+	: m_Demos( demos )
+{
+	m_nextDemo = 0;
+	m_bStopRequested = false;
+
+	m_thread = std::thread( &DemoPrefetcher::PrefetchThread, this );
+}
+
+// =====================================================================================================================================================================
+
+DemoPrefetcher::~DemoPrefetcher()
+{
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		m_bStopRequested = true;
+	}
+
+	m_cvTaken.notify_one();
+	m_thread.join();
+
+	// Demos that were loaded but not parsed (parsing was aborted)
+	for( size_t i = 0; i < m_LoadedDemos.size(); ++i )
+		delete m_LoadedDemos[ i ];
+}
+
+// =====================================================================================================================================================================
+
+DemoFile *DemoPrefetcher::GetNextDemo( void )
+{
+	std::unique_lock< std::mutex > lock( m_mutex );
+
+	if( m_nextDemo >= m_Demos.size() )
+		return nullptr;
+
+	m_cvLoaded.wait( lock, [this]{ return !m_LoadedDemos.empty(); } );
+
+	DemoFile *pDemo = m_LoadedDemos.front();
+	m_LoadedDemos.pop_front();
+	++m_nextDemo;
+
+	lock.unlock();
+	m_cvTaken.notify_one();
+
+	return pDemo;
+}
+
+// =====================================================================================================================================================================
+
+void DemoPrefetcher::PrefetchThread( void )
+{
+	for( size_t i = 0; i < m_Demos.size(); ++i )
+	{
+		{
+			std::unique_lock< std::mutex > lock( m_mutex );
+
+			m_cvTaken.wait( lock, [this]{ return m_bStopRequested || m_LoadedDemos.size() < PREFETCH_MAX_DEMOS; } );
+
+			if( m_bStopRequested )
+				return;
+		}
+
+		// Read the file without holding the lock, this is the slow part
+		DemoFile *pDemo = new DemoFile( m_Demos[ i ] );
+
+		{
+			std::lock_guard< std::mutex > lock( m_mutex );
+			m_LoadedDemos.push_back( pDemo );
+		}
+
+		m_cvLoaded.notify_one();
+	}
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
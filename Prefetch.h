@@ -0,0 +1,40 @@
+#pragma once
+
+#include "DemoFile.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PREFETCH_MAX_DEMOS		2		// How many demos can be loaded ahead of the one being parsed
+
+/**
+ * Reads the next demos of the batch into memory on a separate thread while the current demo is being parsed,
+ * so that disk (or network share) latency is hidden behind parsing
+ */
+class DemoPrefetcher
+{
+public:
+	DemoPrefetcher( const std::vector< std::string > &demos );
+	~DemoPrefetcher();
+
+	DemoFile *GetNextDemo( void );			///< Waits for the next demo in order (caller deletes it), nullptr if there are no more demos
+
+private:
+	DemoPrefetcher( const DemoPrefetcher & );
+	DemoPrefetcher &operator=( const DemoPrefetcher & );
+
+	void PrefetchThread( void );
+
+	const std::vector< std::string > &m_Demos;
+
+	std::thread					m_thread;
+	std::mutex					m_mutex;
+	std::condition_variable		m_cvLoaded;		///< Signaled when a demo has been loaded
+	std::condition_variable		m_cvTaken;		///< Signaled when a demo has been taken or the prefetcher is stopped
+	std::deque< DemoFile * >	m_LoadedDemos;	///< Loaded demos that haven't been taken yet
+	size_t						m_nextDemo;		///< Index of the next demo GetNextDemo returns
+	bool						m_bStopRequested;
+};
\ No newline at end of file
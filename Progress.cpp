@@ -0,0 +1,261 @@
+#include "Progress.h"
+#include "Settings.h"
+#include "Stats.h"
+#include <Windows.h>
+#include <conio.h>
+#include <format>
+
+#define PROGRESS_SAMPLE_INTERVAL_MS		100		// How often the sampler thread wakes up
+#define PROGRESS_TITLE_INTERVAL			5		// Update the console title every nth sample
+#define PROGRESS_UNKNOWN_DEMO_TICKS		250000	// Used for the progress bar if the demo header doesn't tell the length
+
+ProgressManager *ProgressManager::Instance( void )
+{
+	static ProgressManager progress;
+
+	return &progress;
+}
+
+ProgressManager::ProgressManager()
+{
+	m_bStopRequested = false;
+
+	m_iTick = 0;
+	m_iBytesRead = 0;
+	m_bAbortRequested = false;
+
+	m_iCurrentDemo = 0;
+	m_iBatchStartTime = 0;
+
+	m_bDemoActive = false;
+	m_iNumProgressDots = 0;
+	m_iProgressDotTicks = 1;
+	m_iNumPrintedDots = 0;
+	m_iDemoFileSize = 0;
+	m_iDemoStartTime = 0;
+	m_iDemoEndTime = 0;
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::Start( const std::vector< std::string > &demos )
+{
+	if( m_thread.joinable() )
+		return;
+
+	// Get the file sizes up front for the batch ETA
+	m_DemoOffsets.clear();
+	m_DemoOffsets.reserve( demos.size() + 1 );
+
+	int64 offset = 0;
+
+	for( size_t i = 0; i < demos.size(); ++i )
+	{
+		m_DemoOffsets.push_back( offset );
+
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if( GetFileAttributesExA( demos[ i ].c_str(), GetFileExInfoStandard, &data ) )
+			offset += ((int64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	}
+
+	m_DemoOffsets.push_back( offset );
+
+	m_iCurrentDemo = 0;
+	m_iBatchStartTime = StatsTimestamp();
+	m_bAbortRequested = false;
+	m_bStopRequested = false;
+
+	m_thread = std::thread( &ProgressManager::SamplerThread, this );
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::Stop( void )
+{
+	if( !m_thread.joinable() )
+		return;
+
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		m_bStopRequested = true;
+	}
+
+	m_cvStop.notify_one();
+	m_thread.join();
+
+	SetConsoleTitle( TEXT(CSSFF_NAME) );
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::SetCurrentDemo( int nDemo )
+{
+	std::lock_guard< std::mutex > lock( m_mutex );
+
+	m_iCurrentDemo = nDemo;
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::BeginDemo( int playbackTicks, int64 fileSize )
+{
+	std::lock_guard< std::mutex > lock( m_mutex );
+
+	m_iNumProgressDots = Settings()->BatchProcessingEnabled()? 5 : 10;
+	m_iProgressDotTicks = ( (playbackTicks > 0)? playbackTicks : PROGRESS_UNKNOWN_DEMO_TICKS ) / m_iNumProgressDots;
+	if( m_iProgressDotTicks <= 0 )
+		m_iProgressDotTicks = 1;
+
+	m_iNumPrintedDots = 0;
+	m_iDemoFileSize = fileSize;
+	m_iDemoStartTime = StatsTimestamp();
+	m_iDemoEndTime = 0;
+
+	Update( 0, 0 );
+
+	m_bDemoActive = true;
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::EndDemo( bool bAborted )
+{
+	std::lock_guard< std::mutex > lock( m_mutex );
+
+	if( !m_bDemoActive )
+		return;
+
+	m_iDemoEndTime = StatsTimestamp();
+	m_bDemoActive = false;
+
+	PrintProgressDots();
+
+	// Print the ending for the progress bar
+	const int numMinPrints = bAborted? 3 : m_iNumProgressDots;
+
+	for( ; m_iNumPrintedDots < numMinPrints; ++m_iNumPrintedDots )
+		printf( "." );
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::CancelDemo( void )
+{
+	std::lock_guard< std::mutex > lock( m_mutex );
+
+	if( !m_bDemoActive )
+		return;
+
+	m_iDemoEndTime = StatsTimestamp();
+	m_bDemoActive = false;
+}
+
+// =====================================================================================================================================================================
+
+double ProgressManager::GetDemoSeconds( void ) const
+{
+	int64 end = m_iDemoEndTime? m_iDemoEndTime : StatsTimestamp();
+
+	return (end - m_iDemoStartTime) / 1e9;
+}
+
+// =====================================================================================================================================================================
+
+double ProgressManager::GetDemoMBPerSecond( void ) const
+{
+	double seconds = GetDemoSeconds();
+
+	if( seconds <= 0 )
+		return 0.0;
+
+	return (m_iBytesRead.load( std::memory_order_relaxed ) / (1024.0 * 1024.0)) / seconds;
+}
+
+// =====================================================================================================================================================================
+
+double ProgressManager::GetDemoTicksPerSecond( void ) const
+{
+	double seconds = GetDemoSeconds();
+
+	if( seconds <= 0 )
+		return 0.0;
+
+	return m_iTick.load( std::memory_order_relaxed ) / seconds;
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::PrintProgressDots( void )
+{
+	const int numDots = m_iTick.load( std::memory_order_relaxed ) / m_iProgressDotTicks;
+
+	for( ; m_iNumPrintedDots < numDots; ++m_iNumPrintedDots )
+		printf( "." );
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::UpdateConsoleTitle( void )
+{
+	std::string title = CSSFF_NAME;
+
+	const int numDemos = (int)m_DemoOffsets.size() - 1;
+
+	if( numDemos > 1 )
+		title += std::format( " - Demo {}/{}", m_iCurrentDemo + 1, numDemos );
+
+	if( m_bDemoActive )
+	{
+		if( m_iDemoFileSize > 0 )
+			title += std::format( " - {}%", (int)( 100 * m_iBytesRead.load( std::memory_order_relaxed ) / m_iDemoFileSize ) );
+
+		title += std::format( " - {:.1f} MB/s, {:.0f} ticks/s", GetDemoMBPerSecond(), GetDemoTicksPerSecond() );
+	}
+
+	// Batch ETA is estimated from the bytes processed so far
+	if( numDemos > 1 )
+	{
+		const int64 totalBytes = m_DemoOffsets.back();
+		const int64 doneBytes = m_DemoOffsets[ m_iCurrentDemo ] + ( m_bDemoActive? m_iBytesRead.load( std::memory_order_relaxed ) : 0 );
+		const double elapsed = (StatsTimestamp() - m_iBatchStartTime) / 1e9;
+
+		if( doneBytes > 0 && totalBytes > doneBytes )
+		{
+			int eta = (int)( elapsed * (totalBytes - doneBytes) / doneBytes );
+
+			if( eta >= 60 )
+				title += std::format( " - ETA {}m {}s", eta / 60, eta % 60 );
+			else
+				title += std::format( " - ETA {}s", eta );
+		}
+	}
+
+	SetConsoleTitleA( title.c_str() );
+}
+
+// =====================================================================================================================================================================
+
+void ProgressManager::SamplerThread( void )
+{
+	int nSample = 0;
+
+	std::unique_lock< std::mutex > lock( m_mutex );
+
+	while( !m_cvStop.wait_for( lock, std::chrono::milliseconds( PROGRESS_SAMPLE_INTERVAL_MS ), [this]{ return m_bStopRequested; } ) )
+	{
+		// Check if the user wants to abort parsing
+		while( _kbhit() )
+		{
+			if( toupper( _getch() ) == 'Q' )
+				m_bAbortRequested.store( true, std::memory_order_relaxed );
+		}
+
+		if( m_bDemoActive )
+			PrintProgressDots();
+
+		if( ++nSample % PROGRESS_TITLE_INTERVAL == 0 )
+			UpdateConsoleTitle();
+	}
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
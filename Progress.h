@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Reports parsing progress from a separate low-frequency sampler thread
+ *
+ * The parser only publishes its current tick and read offset with Update() and checks AbortRequested(),
+ * so the main parsing loop does no console I/O. The sampler thread prints the progress bar dots,
+ * polls the keyboard for the abort key and shows throughput and batch ETA in the console title.
+ */
+class ProgressManager
+{
+public:
+	static ProgressManager *Instance( void );
+
+	void Start( const std::vector< std::string > &demos );		///< Starts the sampler thread for the given list of demos
+	void Stop( void );											///< Stops the sampler thread and restores the console title
+
+	void SetCurrentDemo( int nDemo );							///< Index of the demo that is going to be processed next
+	void BeginDemo( int playbackTicks, int64 fileSize );		///< Called when the parser starts parsing a demo
+	void EndDemo( bool bAborted );								///< Called when the demo has been parsed, prints the rest of the progress bar
+	void CancelDemo( void );									///< Called when parsing fails, stops the progress bar as is
+
+	// Throughput of the last parsed demo
+	double GetDemoMBPerSecond( void ) const;
+	double GetDemoTicksPerSecond( void ) const;
+
+	// Published by the parser, must stay cheap
+	inline void Update( int tick, int bytesRead )
+	{
+		m_iTick.store( tick, std::memory_order_relaxed );
+		m_iBytesRead.store( bytesRead, std::memory_order_relaxed );
+	}
+
+	inline bool AbortRequested( void ) const
+	{
+		return m_bAbortRequested.load( std::memory_order_relaxed );
+	}
+
+private:
+	ProgressManager( void );
+	ProgressManager( const ProgressManager & );
+	ProgressManager &operator=( const ProgressManager & );
+
+	void SamplerThread( void );
+	void PrintProgressDots( void );								///< Prints dots up to the current tick (m_mutex must be held)
+	void UpdateConsoleTitle( void );
+	double GetDemoSeconds( void ) const;
+
+	std::thread					m_thread;
+	std::mutex					m_mutex;						///< Guards console output and the demo state below
+	std::condition_variable		m_cvStop;
+	bool						m_bStopRequested;
+
+	std::atomic< int >			m_iTick;						///< Tick the parser is currently at
+	std::atomic< int >			m_iBytesRead;					///< Bytes of the current demo read by the parser
+	std::atomic< bool >			m_bAbortRequested;				///< Set when the user presses 'Q'
+
+	// Batch
+	std::vector< int64 >		m_DemoOffsets;					///< Sum of the file sizes of all the preceding demos (last element is the total size)
+	int							m_iCurrentDemo;
+	int64						m_iBatchStartTime;
+
+	// Current demo
+	bool						m_bDemoActive;					///< Whether dots should be printed for the current demo
+	int							m_iNumProgressDots;				///< How many dots a full progress bar has
+	int							m_iProgressDotTicks;			///< # of ticks per printed dot
+	int							m_iNumPrintedDots;
+	int64						m_iDemoFileSize;
+	int64						m_iDemoStartTime;
+	int64						m_iDemoEndTime;
+};
+
+#define Progress	ProgressManager::Instance
\ No newline at end of file
@@ -0,0 +1,328 @@
+#include "Scan.h"
+#include "Archive.h"
+#include "Gzip.h"
+#include "Decompress.h"
+#include "Netmessages.h"
+#include "bitbuf.h"
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+// Scan mode
+//
+// Only the demo header is read from each file, and optionally the start of the first signon packet where the server
+// sends SVC_ServerInfo. No file is ever read completely, so archives of hundreds of thousands of demos can be listed
+// quickly. The manifest lines are written in the order the demos were given. Compressed demos are decompressed only as
+// far as the header and the start of the first signon packet.
+
+// =====================================================================================================================================================================
+/**
+ * Reads the messages in the start of the first signon packet up to SVC_ServerInfo
+ * Only the messages that the server sends before SVC_ServerInfo are understood
+ */
+static bool ReadServerInfo( bf_read &reader, DemoMetadata_t &meta )
+{
+	char buffer[ 1024 ];
+
+	while( !reader.IsOverflowed() )
+	{
+		byte msg = reader.ReadUBitLong( 5 );
+
+		switch( msg )
+		{
+			default:
+				return false;
+
+			case NET_NOP:
+				break;
+
+			case NET_Tick:
+				reader.ReadLong();
+				break;
+
+			case NET_StringCmd:
+			case SVC_Print:
+				reader.ReadString( buffer, sizeof(buffer) );
+				break;
+
+			case NET_SetConVar:
+			{
+				int num = reader.ReadByte();
+				while( num-- > 0 && !reader.IsOverflowed() )
+				{
+					reader.ReadString( buffer, sizeof(buffer) );
+					reader.ReadString( buffer, sizeof(buffer) );
+				}
+				break;
+			}
+
+			case NET_SignOnState:
+				reader.ReadByte();
+				reader.ReadLong();
+				break;
+
+			case SVC_ServerInfo:
+			{
+				reader.ReadShort();		// protocol
+				reader.ReadLong();		// servercount
+				bool ishltv = reader.ReadOneBit();
+				reader.ReadOneBit();	// isdedicated
+				reader.ReadLong();		// clientcrc
+				reader.ReadShort();		// maxclasses
+				reader.ReadLong();		// mapcrc
+				reader.ReadByte();		// playerslot
+				int maxclients = reader.ReadByte();
+				float tickinterval = reader.ReadFloat();
+
+				if( reader.IsOverflowed() || tickinterval <= 0.f )
+					return false;
+
+				meta.bServerInfo = true;
+				meta.bIsPOV = !ishltv;
+				meta.maxClients = maxclients;
+				meta.tickRate = (int)floor( 1 / tickinterval );
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Reads the header of a demo, and SVC_ServerInfo from the first signon packet if asked to
+ * @return						false if the file is not a valid demo
+ */
+bool ReadDemoMetadata( const std::string &filename, bool bReadServerInfo, DemoMetadata_t &meta )
+{
+	// Demos in archives are read from their offset in the archive
+	std::string archive, member;
+	ArchiveMember_t info = {};
+	const bool bArchiveMember = SplitArchiveMemberPath( filename, archive, member );
+
+	if( bArchiveMember && !FindArchiveMember( archive, member, info ) )
+	{
+		meta.error = ARCHIVE_READ_FAILED;
+		return false;
+	}
+
+	if( info.compression == ARCHIVE_UNSUPPORTED )
+	{
+		meta.error = UNSUPPORTED_COMPRESSION;
+		return false;
+	}
+
+	std::ifstream file( bArchiveMember? archive : filename, std::ios::binary );
+
+	if( !file.is_open() )
+	{
+		meta.error = COULD_NOT_OPEN_FILE;
+		return false;
+	}
+
+	if( bArchiveMember )
+	{
+		meta.fileSize = (int64)info.compressedSize;
+	}
+	else
+	{
+		file.seekg( 0, std::ios_base::end );
+		meta.fileSize = file.tellg();
+	}
+
+	file.seekg( info.offset, std::ios_base::beg );
+
+	// Compressed demos are read from the decompressed start of the file
+	std::istream *pStream = &file;
+	std::istringstream decompressed;
+
+	// The largest of the sizes that the formats are detected from
+	byte magic[ GZIP_MIN_SIZE ] = {};
+	file.read( (char *)magic, sizeof( magic ) );
+	const size_t magicSize = (size_t)file.gcount();
+	file.clear();
+	file.seekg( info.offset, std::ios_base::beg );
+
+	const bool bDeflated = info.compression == ARCHIVE_DEFLATED;
+	const CompressionFormat format = bDeflated? COMPRESSION_NONE : GetCompressionFormat( magic, magicSize );
+
+	if( bDeflated || format != COMPRESSION_NONE )
+	{
+		const int64 readSize = ( bDeflated || format == COMPRESSION_GZIP )? SCAN_COMPRESSED_READ_SIZE : SCAN_BLOCK_READ_SIZE;
+		std::vector< char > compressed( (size_t)( ( meta.fileSize < readSize )? meta.fileSize : readSize ) );
+		file.read( compressed.data(), compressed.size() );
+
+		std::string data( SCAN_DECOMPRESSED_SIZE, '\0' );
+		DecompressBuffer buffer( (byte *)data.data(), data.size() );
+		size_t written;
+
+		DecompressResult result;
+
+		if( bDeflated )
+			result = DeflateDecompress( (const byte *)compressed.data(), (size_t)file.gcount(), buffer, written );
+		else
+			result = DecompressData( format, (const byte *)compressed.data(), (size_t)file.gcount(), buffer, written );
+
+		if( result == DECOMPRESS_CORRUPT )
+		{
+			meta.error = DECOMPRESSION_FAILED;
+			return false;
+		}
+
+		data.resize( written );
+		decompressed.str( data );
+		pStream = &decompressed;
+	}
+
+	std::istream &stream = *pStream;
+
+	if( meta.fileSize < (int64)sizeof( demoheader_t ) || !stream.read( (char *)&meta.header, sizeof( demoheader_t ) ) )
+	{
+		meta.error = FILE_TOO_SMALL;
+		return false;
+	}
+
+	meta.error = DemoFile::CheckHeader( meta.header );
+
+	if( meta.error != DEMO_OK )
+		return false;
+
+	if( !bReadServerInfo )
+		return true;
+
+	// The first command should be a signon packet
+	struct
+	{
+		byte			cmd;
+		int32			tick;
+		democmdinfo_t	info;
+		int32			seqNrIn;
+		int32			seqNrOut;
+		int32			datasize;
+	}
+	packet;
+
+	stream.read( (char *)&packet.cmd, sizeof(packet.cmd) );
+	stream.read( (char *)&packet.tick, sizeof(packet.tick) );
+	stream.read( (char *)&packet.info, sizeof(packet.info) );
+	stream.read( (char *)&packet.seqNrIn, sizeof(packet.seqNrIn) );
+	stream.read( (char *)&packet.seqNrOut, sizeof(packet.seqNrOut) );
+	stream.read( (char *)&packet.datasize, sizeof(packet.datasize) );
+
+	if( !stream || packet.cmd != dem_signon || packet.datasize <= 0 )
+		return true;
+
+	char data[ SCAN_SIGNON_READ_SIZE ];
+	const int readsize = ( packet.datasize < SCAN_SIGNON_READ_SIZE )? packet.datasize : SCAN_SIGNON_READ_SIZE;
+
+	stream.read( data, readsize );
+
+	bf_read reader( data, (int)stream.gcount() );
+	ReadServerInfo( reader, meta );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+static const char *GetScanStatus( DemoError error )
+{
+	switch( error )
+	{
+		case DEMO_OK:					return "ok";
+		case COULD_NOT_OPEN_FILE:		return "cannot_open";
+		case FILE_TOO_SMALL:			return "too_small";
+		case INVALID_HDR_ID:			return "invalid_header";
+		case INVALID_DEM_PROTOCOL:		return "invalid_demo_protocol";
+		case INVALID_NET_PROTOCOL:		return "unsupported_version";
+		case INVALID_GAMEDIR:			return "not_css";
+		case DECOMPRESSION_FAILED:		return "corrupt_archive";
+		case UNSUPPORTED_COMPRESSION:	return "unsupported_compression";
+		case ARCHIVE_READ_FAILED:		return "archive_error";
+	}
+
+	return "unknown";
+}
+
+// =====================================================================================================================================================================
+
+static void WriteManifestLine( std::ofstream &file, const std::string &filename, const DemoMetadata_t &meta, bool bReadServerInfo )
+{
+	file << filename << '\t' << GetScanStatus( meta.error );
+
+	// Header fields can be garbage if the header ID is wrong
+	if( meta.error == DEMO_OK || meta.error == INVALID_DEM_PROTOCOL || meta.error == INVALID_NET_PROTOCOL || meta.error == INVALID_GAMEDIR )
+	{
+		const demoheader_t &hdr = meta.header;
+
+		file << '\t' << hdr.networkprotocol << '\t' << hdr.mapname << '\t' << hdr.servername << '\t' << hdr.clientname
+			<< '\t' << hdr.playback_time << '\t' << hdr.playback_ticks << '\t' << meta.fileSize;
+
+		if( bReadServerInfo && meta.bServerInfo )
+			file << '\t' << meta.tickRate << '\t' << meta.maxClients << '\t' << ( meta.bIsPOV? "POV" : "STV" );
+	}
+
+	file << '\n';
+}
+
+// =====================================================================================================================================================================
+
+bool ScanDemos( const std::vector< std::string > &demos, bool bReadServerInfo, const std::string &manifestFile )
+{
+	std::ofstream file( manifestFile );
+
+	if( !file.is_open() )
+		return false;
+
+	file << "file\tstatus\tnetwork_protocol\tmap\tserver\tclient\tlength\tticks\tsize";
+	if( bReadServerInfo )
+		file << "\ttickrate\tmaxclients\ttype";
+	file << '\n';
+
+	// Threads take the demos in order, and each line is written as soon as all the demos before it are done,
+	// so only the results of the demos that are being read are kept in memory
+	std::vector< std::unique_ptr< DemoMetadata_t > > results( demos.size() );
+	std::unique_ptr< std::atomic< bool >[] > done( new std::atomic< bool >[ demos.size() ]() );
+	std::atomic< size_t > nextDemo( 0 );
+
+	auto ScanThread = [&]()
+	{
+		for( size_t i = nextDemo++; i < demos.size(); i = nextDemo++ )
+		{
+			results[ i ].reset( new DemoMetadata_t );
+			ReadDemoMetadata( demos[ i ], bReadServerInfo, *results[ i ] );
+
+			done[ i ].store( true, std::memory_order_release );
+			done[ i ].notify_one();
+		}
+	};
+
+	// Reading headers is mostly waiting for the disk, so use more threads than cores
+	int numThreads = (int)std::thread::hardware_concurrency() * 2;
+	if( numThreads < 1 )
+		numThreads = 1;
+
+	std::vector< std::thread > threads;
+
+	for( int i = 0; i < numThreads; ++i )
+		threads.emplace_back( ScanThread );
+
+	for( size_t i = 0; i < demos.size(); ++i )
+	{
+		done[ i ].wait( false, std::memory_order_acquire );
+
+		WriteManifestLine( file, demos[ i ], *results[ i ], bReadServerInfo );
+		results[ i ].reset();
+	}
+
+	for( size_t i = 0; i < threads.size(); ++i )
+		threads[ i ].join();
+
+	return true;
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
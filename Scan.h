@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Common.h"
+#include "DemoFile.h"
+#include <string>
+#include <vector>
+
+#define SCAN_SIGNON_READ_SIZE		4096	// How much of the first signon packet is read to find SVC_ServerInfo
+#define SCAN_COMPRESSED_READ_SIZE	65536	// How much of a gzipped demo is read to decompress the header and SCAN_SIGNON_READ_SIZE
+#define SCAN_BLOCK_READ_SIZE		( 1 << 20 )	// Same for zstd and bzip2, they only decompress whole blocks (up to 128 KB and 900 KB)
+#define SCAN_DECOMPRESSED_SIZE		/* header, signon packet header and SCAN_SIGNON_READ_SIZE */ ( sizeof( demoheader_t ) + 1 + 4 + sizeof( democmdinfo_t ) + 12 + SCAN_SIGNON_READ_SIZE )
+
+/**
+ * Demo metadata read by the scan mode without loading the demo
+ */
+struct DemoMetadata_t
+{
+	DemoMetadata_t( void ) : error( COULD_NOT_OPEN_FILE ), fileSize( 0 ), bServerInfo( false ), tickRate( 0 ), maxClients( 0 ), bIsPOV( false ) {}
+
+	DemoError		error;				///< DEMO_OK if this is a CS:S v34 demo
+	int64			fileSize;
+	demoheader_t	header;				///< Only valid if the file had a full header
+
+	// From SVC_ServerInfo in the first signon packet (only read if asked to)
+	bool			bServerInfo;		///< Whether SVC_ServerInfo was found
+	int				tickRate;
+	int				maxClients;
+	bool			bIsPOV;
+};
+
+bool ReadDemoMetadata( const std::string &filename, bool bReadServerInfo, DemoMetadata_t &meta );
+
+/**
+ * Reads the metadata of all the demos on multiple threads and writes it to a manifest file, one tab separated line per demo
+ * @return						false if the manifest could not be written
+ */
+bool ScanDemos( const std::vector< std::string > &demos, bool bReadServerInfo, const std::string &manifestFile );
\ No newline at end of file
@@ -0,0 +1,473 @@
+#include "SeekIndex.h"
+#include "Archive.h"
+#include "DemoParser.h"
+#include "Errors.h"
+#include "Settings.h"
+#include "PropDecode.h"
+#include <assert.h>
+#include <fstream>
+
+// Seek index
+//
+// The index is written beside the demo (<demo>.dem.cssffidx) the first time the demo is parsed with a round range or
+// with write_seek_index enabled (beside the archive as <archive>_<demo>.dem.cssffidx for demos inside archives). It
+// holds a keyframe for every round start. To parse a range of rounds, the signon is parsed from the beginning as usual,
+// then the keyframe of the first round is restored and parsing continues from its offset until the round start after
+// the last round.
+//
+// File layout:
+//   char[8]		magic
+//   int32			version
+//   uint32			demo file size
+//   demoheader_t	demo header (the index is rebuilt if either doesn't match the demo)
+//   int32			# of keyframes
+//   per keyframe:	int32 tick, uint32 round start offset, uint32 offset, uint32 state size, state
+
+static const char s_SeekIndexMagic[ 8 ] = { 'C', 'S', 'S', 'F', 'F', 'I', 'D', 'X' };
+
+// =====================================================================================================================================================================
+
+std::string SeekIndex::GetFileName( const DemoFile &demo )
+{
+	std::string archive, member;
+
+	if( SplitArchiveMemberPath( demo.GetFilePath(), archive, member ) )
+		return archive + "_" + demo.GetFileName() + SEEK_INDEX_EXTENSION;
+
+	return demo.GetFilePath() + SEEK_INDEX_EXTENSION;
+}
+
+// =====================================================================================================================================================================
+
+bool SeekIndex::Load( const DemoFile &demo )
+{
+	keyframes.clear();
+
+	std::ifstream file( GetFileName( demo ), std::ios::binary );
+
+	if( !file.is_open() )
+		return false;
+
+	char magic[ sizeof( s_SeekIndexMagic ) ];
+	int32 version = 0;
+	uint32 fileSize = 0;
+	demoheader_t header;
+
+	file.read( magic, sizeof( magic ) );
+	file.read( (char *)&version, sizeof( version ) );
+	file.read( (char *)&fileSize, sizeof( fileSize ) );
+	file.read( (char *)&header, sizeof( header ) );
+
+	if( !file || memcmp( magic, s_SeekIndexMagic, sizeof( magic ) ) || version != SEEK_INDEX_VERSION )
+		return false;
+
+	// The demo was changed after the index was written
+	if( fileSize != demo.GetFileSize() || memcmp( &header, demo.GetBuffer(), sizeof( header ) ) )
+		return false;
+
+	int32 numKeyframes = 0;
+	file.read( (char *)&numKeyframes, sizeof( numKeyframes ) );
+
+	if( !file || numKeyframes < 0 )
+		return false;
+
+	keyframes.resize( numKeyframes );
+
+	for( int i = 0; i < numKeyframes; ++i )
+	{
+		SeekKeyframe_t &keyframe = keyframes[ i ];
+		uint32 stateSize = 0;
+
+		file.read( (char *)&keyframe.tick, sizeof( keyframe.tick ) );
+		file.read( (char *)&keyframe.roundStartOffset, sizeof( keyframe.roundStartOffset ) );
+		file.read( (char *)&keyframe.offset, sizeof( keyframe.offset ) );
+		file.read( (char *)&stateSize, sizeof( stateSize ) );
+
+		if( !file || keyframe.offset >= fileSize || stateSize > fileSize )
+		{
+			keyframes.clear();
+			return false;
+		}
+
+		keyframe.state.resize( stateSize );
+		file.read( keyframe.state.data(), stateSize );
+	}
+
+	if( !file )
+	{
+		keyframes.clear();
+		return false;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool SeekIndex::Save( const DemoFile &demo ) const
+{
+	std::ofstream file( GetFileName( demo ), std::ios::binary | std::ios::trunc );
+
+	if( !file.is_open() )
+		return false;
+
+	const int32 version = SEEK_INDEX_VERSION;
+	const uint32 fileSize = demo.GetFileSize();
+	const int32 numKeyframes = (int32)keyframes.size();
+
+	file.write( s_SeekIndexMagic, sizeof( s_SeekIndexMagic ) );
+	file.write( (const char *)&version, sizeof( version ) );
+	file.write( (const char *)&fileSize, sizeof( fileSize ) );
+	file.write( demo.GetBuffer(), sizeof( demoheader_t ) );
+	file.write( (const char *)&numKeyframes, sizeof( numKeyframes ) );
+
+	for( size_t i = 0; i < keyframes.size(); ++i )
+	{
+		const SeekKeyframe_t &keyframe = keyframes[ i ];
+		const uint32 stateSize = (uint32)keyframe.state.size();
+
+		file.write( (const char *)&keyframe.tick, sizeof( keyframe.tick ) );
+		file.write( (const char *)&keyframe.roundStartOffset, sizeof( keyframe.roundStartOffset ) );
+		file.write( (const char *)&keyframe.offset, sizeof( keyframe.offset ) );
+		file.write( (const char *)&stateSize, sizeof( stateSize ) );
+		file.write( keyframe.state.data(), stateSize );
+	}
+
+	return file.good();
+}
+
+// =====================================================================================================================================================================
+
+int SeekIndex::GetNumRounds( void ) const
+{
+	return (int)keyframes.size();
+}
+
+// =====================================================================================================================================================================
+
+int SeekIndex::FindRoundByTick( int tick ) const
+{
+	int round = 0;
+
+	while( round < (int)keyframes.size() && keyframes[ round ].tick <= tick )
+		++round;
+
+	return round;
+}
+
+// =====================================================================================================================================================================
+
+void SeekStateReader::ReadBytes( void *pOut, size_t size )
+{
+	if( (size_t)( m_pEnd - m_pData ) < size )
+		throw ParsingError_t( "corrupt seek index" );
+
+	memcpy( pOut, m_pData, size );
+	m_pData += size;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Only parse the given rounds of the demo (round 0 is everything before the first round start)
+ * If tick is not negative, the round containing it is parsed instead
+ */
+void DemoParser::SetParseRange( int firstRound, int lastRound, int tick )
+{
+	m_iFirstRound = firstRound;
+	m_iLastRound = lastRound;
+	m_iTargetTick = tick;
+}
+
+// =====================================================================================================================================================================
+
+bool DemoParser::HasParseRange( void ) const
+{
+	return m_iFirstRound >= 0 || m_iTargetTick >= 0;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Parses only the requested rounds using the seek index of the demo, which is built first if it doesn't exist
+ * @return						false if parsing was aborted
+ */
+bool DemoParser::ParseRange( bf_read &reader )
+{
+	SeekIndex index;
+
+	if( !index.Load( *m_pDemo ) )
+	{
+		if( !Settings()->BatchProcessingEnabled() )
+			printf( "Building seek index...\n\n" );
+
+		// The demo is parsed normally, which will report the error properly
+		if( !BuildSeekIndex( index ) )
+			return ParseCommands( reader );
+
+		if( !index.Save( *m_pDemo ) && !Settings()->BatchProcessingEnabled() )
+			printf( "Failed to write the seek index file\n\n" );
+	}
+
+	int firstRound = m_iFirstRound;
+	int lastRound = m_iLastRound;
+
+	if( m_iTargetTick >= 0 )
+		firstRound = lastRound = index.FindRoundByTick( m_iTargetTick );
+
+	if( firstRound > index.GetNumRounds() )
+	{
+		if( !Settings()->BatchProcessingEnabled() )
+			printf( "The demo only has %d rounds\n\n", index.GetNumRounds() );
+
+		m_bStopParsing = true;
+		return true;
+	}
+
+	if( !Settings()->BatchProcessingEnabled() )
+	{
+		if( firstRound == lastRound )
+			printf( "Parsing round %d...\n\n", firstRound );
+		else
+			printf( "Parsing rounds %d-%d...\n\n", firstRound, lastRound );
+	}
+
+	// Round 0 has no keyframe, it's parsed from the beginning of the demo
+	m_pResumeKeyframe = ( firstRound > 0 )? &index.keyframes[ firstRound - 1 ] : nullptr;
+	m_iSegmentEndOffset = ( lastRound < index.GetNumRounds() )? index.keyframes[ lastRound ].roundStartOffset : 0;
+
+	return ParseCommands( reader );
+}
+
+// =====================================================================================================================================================================
+/**
+ * Parses the whole demo on a sub parser to collect the keyframes
+ * @return						false if the demo could not be parsed
+ */
+bool DemoParser::BuildSeekIndex( SeekIndex &index )
+{
+	DemoParser builder( m_pDemo );
+	builder.m_bSubParser = true;
+	builder.m_pSeekIndex = &index;
+
+	bf_read reader( m_pDemo->GetBuffer(), m_pDemo->GetFileSize() );
+	reader.ReadBytes( &builder.m_demoHeader, sizeof( builder.m_demoHeader ) );
+
+	try
+	{
+		if( !builder.ParseCommands( reader ) )
+			return false;
+	}
+	catch( ParsingError_t )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Called after the command with round_start has been handled
+ */
+void DemoParser::SaveSeekKeyframe( uint32 offset )
+{
+	assert( m_pSeekIndex );
+
+	SeekKeyframe_t keyframe;
+	keyframe.tick = m_iCurrentTick;
+	keyframe.roundStartOffset = m_iCommandOffset;
+	keyframe.offset = offset;
+
+	std::string &state = keyframe.state;
+
+	SeekStateWrite( state, m_iPOVPlayerUserID );
+	SeekStateWrite( state, m_bPOVPlayerIsDead );
+
+	SeekStateWrite( state, (uint32)m_ExpiredUserIDs.size() );
+	for( size_t i = 0; i < m_ExpiredUserIDs.size(); ++i )
+		SeekStateWrite( state, m_ExpiredUserIDs[ i ] );
+
+	// Players (the fields read from the userinfo string table come first in Player)
+	SeekStateWrite( state, (uint32)m_Players.size() );
+	for( auto pl = m_Players.begin(); pl != m_Players.end(); ++pl )
+	{
+		state.append( (const char *)&*pl, offsetof( Player, entityIndex ) );
+		SeekStateWrite( state, pl->entityIndex );
+		SeekStateWrite( state, pl->airstatus );
+		SeekStateWrite( state, pl->lastZ );
+		SeekStateWrite( state, pl->flashinfo.tick );
+		SeekStateWrite( state, pl->flashinfo.time );
+	}
+
+	// Player entities and their props by flattened prop index
+	SeekStateWrite( state, (uint32)m_Entities.size() );
+	for( size_t i = 0; i < m_Entities.size(); ++i )
+	{
+		const EntityEntry *pEntity = m_Entities[ i ];
+		const FlattenedPropEntry *pFirstProp = m_ServerClasses[ pEntity->m_uClass ].flattenedProps.data();
+
+		SeekStateWrite( state, pEntity->m_nEntity );
+		SeekStateWrite( state, pEntity->m_uClass );
+		SeekStateWrite( state, pEntity->m_uSerialNum );
+		SeekStateWrite( state, (uint32)pEntity->m_props.size() );
+
+		for( size_t j = 0; j < pEntity->m_props.size(); ++j )
+		{
+			const PropEntry *pProp = pEntity->m_props[ j ];
+
+			SeekStateWrite( state, (uint32)( pProp->m_pFlattenedProp - pFirstProp ) );
+
+			if( pProp->m_pFlattenedProp->m_prop->m_propType == DPT_Array )
+			{
+				// The first element holds the # of elements
+				const int nElements = pProp->m_pPropValue[ 0 ].m_nNumElements;
+
+				SeekStateWrite( state, nElements );
+				for( int k = 0; k < nElements; ++k )
+					SaveSeekPropValue( state, pProp->m_pPropValue[ k ] );
+			}
+			else
+			{
+				SaveSeekPropValue( state, *pProp->m_pPropValue );
+			}
+		}
+	}
+
+	m_pSeekIndex->keyframes.push_back( std::move( keyframe ) );
+}
+
+// =====================================================================================================================================================================
+
+void DemoParser::SaveSeekPropValue( std::string &state, const Prop_t &prop )
+{
+	SeekStateWrite( state, prop.m_type );
+
+	if( prop.m_type == DPT_String )
+	{
+		const uint32 len = (uint32)strlen( prop.m_value.m_pString );
+
+		SeekStateWrite( state, len );
+		state.append( prop.m_value.m_pString, len );
+	}
+	else
+	{
+		SeekStateWrite( state, prop.m_value.m_vector );
+	}
+}
+
+// =====================================================================================================================================================================
+/**
+ * Called at sync tick, after the signon has been parsed
+ */
+void DemoParser::RestoreSeekKeyframe( const SeekKeyframe_t &keyframe )
+{
+	SeekStateReader state( keyframe.state );
+
+	m_iPOVPlayerUserID = state.Read< int >();
+	m_bPOVPlayerIsDead = state.Read< bool >();
+
+	m_ExpiredUserIDs.resize( state.Read< uint32 >() );
+	for( size_t i = 0; i < m_ExpiredUserIDs.size(); ++i )
+		m_ExpiredUserIDs[ i ] = state.Read< int >();
+
+	// Players
+	m_Players.clear();
+	m_PlayerPostCheckData.clear();
+
+	const uint32 numPlayers = state.Read< uint32 >();
+
+	for( uint32 i = 0; i < numPlayers; ++i )
+	{
+		alignas( Player ) char userinfo[ sizeof( Player ) ] = {};
+		state.ReadBytes( userinfo, offsetof( Player, entityIndex ) );
+
+		Player player( *(const Player *)userinfo );
+		player.entityIndex = state.Read< int >();
+		player.airstatus = state.Read< PlayerAirStatus_e >();
+		player.lastZ = state.Read< float >();
+		player.flashinfo.tick = state.Read< int >();
+		player.flashinfo.time = state.Read< float >();
+
+		m_Players.push_back( player );
+	}
+
+	// Player entities
+	for( size_t i = 0; i < m_Entities.size(); ++i )
+		delete m_Entities[ i ];
+
+	m_Entities.clear();
+
+	const uint32 numEntities = state.Read< uint32 >();
+
+	for( uint32 i = 0; i < numEntities; ++i )
+	{
+		const int nEntity = state.Read< int >();
+		const uint32 uClass = state.Read< uint32 >();
+		const uint32 uSerialNum = state.Read< uint32 >();
+
+		if( uClass >= m_ServerClasses.size() )
+			throw ParsingError_t( "seek index doesn't match the demo" );
+
+		EntityEntry *pEntity = AddEntity( nEntity, uClass, uSerialNum );
+
+		const uint32 numProps = state.Read< uint32 >();
+
+		for( uint32 j = 0; j < numProps; ++j )
+		{
+			FlattenedPropEntry *pSendProp = GetSendPropByIndex( uClass, state.Read< uint32 >() );
+
+			if( !pSendProp )
+				throw ParsingError_t( "seek index doesn't match the demo" );
+
+			Prop_t *pProp;
+
+			if( pSendProp->m_prop->m_propType == DPT_Array )
+			{
+				const int nElements = state.Read< int >();
+
+				pProp = new Prop_t[ nElements ];
+
+				for( int k = 0; k < nElements; ++k )
+				{
+					RestoreSeekPropValue( state, pProp[ k ] );
+					pProp[ k ].m_nNumElements = nElements - k;
+				}
+			}
+			else
+			{
+				pProp = new Prop_t( DPT_Int );
+				RestoreSeekPropValue( state, *pProp );
+			}
+
+			pEntity->AddOrUpdateProp( pSendProp, pProp );
+		}
+	}
+
+	m_iCurrentTick = keyframe.tick;
+}
+
+// =====================================================================================================================================================================
+
+void DemoParser::RestoreSeekPropValue( SeekStateReader &state, Prop_t &prop )
+{
+	prop.m_type = state.Read< SendPropType >();
+
+	if( prop.m_type == DPT_String )
+	{
+		const uint32 len = state.Read< uint32 >();
+
+		if( len >= DT_MAX_STRING_BUFFERSIZE )
+			throw ParsingError_t( "corrupt seek index" );
+
+		char *pString = new char[ len + 1 ];
+		state.ReadBytes( pString, len );
+		pString[ len ] = 0;
+
+		prop.m_value.m_pString = pString;
+	}
+	else
+	{
+		prop.m_value.m_vector = state.Read< Vector >();
+	}
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Common.h"
+#include "DemoFile.h"
+#include <string>
+#include <vector>
+
+#define SEEK_INDEX_EXTENSION	".cssffidx"		// Appended to the demo file name
+#define SEEK_INDEX_VERSION		1
+
+/**
+ * The parser state right after a round start
+ *
+ * A range parser re-parses the signon (string tables, data tables, game event list), restores this state
+ * and jumps to the offset. Only the player entities are kept by the parser, so they are the only entities saved.
+ */
+struct SeekKeyframe_t
+{
+	int					tick;					///< Tick of the round start
+	uint32				roundStartOffset;		///< Byte offset of the demo command that contains round_start
+	uint32				offset;					///< Byte offset of the next demo command, where parsing is resumed
+	std::string			state;					///< Serialized players and player entities at offset
+};
+
+typedef std::vector< SeekKeyframe_t > SeekKeyframeVector;
+
+/**
+ * Round start keyframes of a demo, stored beside the demo so that a range of rounds can be re-parsed without parsing the whole demo
+ */
+class SeekIndex
+{
+public:
+	bool Load( const DemoFile &demo );			///< Loads the index of the demo, false if it doesn't exist or doesn't match the demo
+	bool Save( const DemoFile &demo ) const;
+
+	int GetNumRounds( void ) const;				///< # of round starts in the demo
+	int FindRoundByTick( int tick ) const;		///< Round that contains the tick (0 if it's before the first round start)
+
+	static std::string GetFileName( const DemoFile &demo );
+
+	SeekKeyframeVector	keyframes;				///< Keyframe of round n is keyframes[ n - 1 ]
+};
+
+/**
+ * Sequential reader for a serialized keyframe state
+ */
+class SeekStateReader
+{
+public:
+	SeekStateReader( const std::string &state )
+		: m_pData( state.data() )
+		, m_pEnd( state.data() + state.size() )
+	{
+	}
+
+	template< typename T >
+	T Read( void )
+	{
+		T value;
+		ReadBytes( &value, sizeof( T ) );
+		return value;
+	}
+
+	void ReadBytes( void *pOut, size_t size );
+
+private:
+	const char *		m_pData;
+	const char *		m_pEnd;
+};
+
+template< typename T >
+inline void SeekStateWrite( std::string &state, const T &value )
+{
+	state.append( (const char *)&value, sizeof( T ) );
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "Segments.h"
+#include "DemoParser.h"
+#include "Errors.h"
+#include <assert.h>
+#include <thread>
+
+// Segment parsing
+//
+// 1. The demo is split at the round start keyframes of its seek index. A demo without an index is parsed normally, and
+//    the index is built on the way, so the demo can be split the next time it is parsed.
+// 2. Keyframes are picked so that the demo is split into roughly even segments, one per thread.
+// 3. Each segment parser is a range parser: it parses the signon, restores the players and player entities of its
+//    keyframe and jumps to it. It stops after the round start where the next segment starts, so every round is parsed
+//    from its beginning by exactly one parser.
+// 4. The main parser parses the first segment itself and appends the frags of the other segments in order.
+
+// =====================================================================================================================================================================
+
+bool DemoParser::IsSubParser( void ) const
+{
+	return m_bSubParser;
+}
+
+std::vector< ParsingWarning_t > *DemoParser::GetWarnings( void ) const
+{
+	return m_pWarnings;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Splits the demo into segments that are parsed on multiple threads
+ * Falls back to parsing the demo normally if it doesn't have a seek index yet or has too few rounds to split
+ * @return						false if parsing was aborted
+ */
+bool DemoParser::ParseSegments( bf_read &reader )
+{
+	const int maxSegments = (int)std::thread::hardware_concurrency();
+
+	if( maxSegments <= 1 )
+		return ParseCommands( reader );
+
+	SeekIndex index;
+
+	if( !index.Load( *m_pDemo ) )
+	{
+		// Build the index on the way, it is split the next time
+		m_pSeekIndex = &index;
+
+		const bool bCompleted = ParseCommands( reader );
+
+		if( bCompleted )
+			index.Save( *m_pDemo );
+
+		m_pSeekIndex = nullptr;
+		return bCompleted;
+	}
+
+	// Pick evenly spaced keyframes
+	std::vector< const SeekKeyframe_t * > segmentStarts;
+	const uint32 segmentSize = m_pDemo->GetFileSize() / maxSegments;
+
+	for( size_t i = 0; i < index.keyframes.size(); ++i )
+	{
+		const SeekKeyframe_t &keyframe = index.keyframes[ i ];
+
+		if( (int)segmentStarts.size() + 1 >= maxSegments )
+			break;
+
+		if( keyframe.offset < segmentSize * ( segmentStarts.size() + 1 ) )
+			continue;
+
+		segmentStarts.push_back( &keyframe );
+	}
+
+	if( segmentStarts.empty() )
+		return ParseCommands( reader );
+
+	// Start the segment parsers
+	const size_t numSegments = segmentStarts.size();
+	std::vector< SegmentResult_t > results( numSegments );
+	std::vector< std::thread > threads;
+
+	m_bCancelSegments = false;
+
+	for( size_t i = 0; i < numSegments; ++i )
+	{
+		uint32 endOffset = ( i + 1 < numSegments )? segmentStarts[ i + 1 ]->roundStartOffset : 0;
+
+		threads.emplace_back( &DemoParser::SegmentThread, m_pDemo, segmentStarts[ i ], endOffset, &m_bCancelSegments, &results[ i ] );
+	}
+
+	// Parse the first segment on this thread
+	m_iSegmentEndOffset = segmentStarts[ 0 ]->roundStartOffset;
+
+	bool bAborted = false;
+
+	try
+	{
+		bAborted = !ParseCommands( reader );
+	}
+	catch( ... )
+	{
+		// Frags after the error are not needed
+		m_bCancelSegments = true;
+
+		for( size_t i = 0; i < numSegments; ++i )
+			threads[ i ].join();
+
+		throw;
+	}
+
+	for( size_t i = 0; i < numSegments; ++i )
+		threads[ i ].join();
+
+	// Merge the results in order
+	for( size_t i = 0; i < numSegments; ++i )
+	{
+		SegmentResult_t &result = results[ i ];
+
+		for( size_t profile = 0; profile < result.frags.size(); ++profile )
+		{
+			for( size_t j = 0; j < result.frags[ profile ].size(); ++j )
+				EmitFrag( result.frags[ profile ][ j ], (int)profile );
+		}
+
+#ifdef CSSFF_ENABLE_STATS
+		m_Stats.Accumulate( result.stats );
+#endif
+
+		if( result.bFailed )
+		{
+			// Behave as if the error was encountered while parsing normally
+			m_iCurrentTick = result.error_tick;
+			throw ParsingError_t( result.error_msg );
+		}
+
+		if( result.bAborted )
+		{
+			bAborted = true;
+			break;
+		}
+	}
+
+#ifdef CSSFF_ENABLE_STATS
+	m_Stats.bytes_processed = m_pDemo->GetFileSize();
+#endif
+
+	return !bAborted;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Called on round start, stops a segment or range parser at the end of its rounds
+ */
+void DemoParser::OnSegmentRoundStart( void )
+{
+	if( m_iSegmentEndOffset && m_iCommandOffset >= m_iSegmentEndOffset )
+		m_bStopParsing = true;
+}
+
+// =====================================================================================================================================================================
+
+void DemoParser::OnSegmentEnd( void )
+{
+	// Check for frags again in case the demo ended mid-round
+	if( !m_bStopParsing )
+		FindRoundFrags();
+}
+
+// =====================================================================================================================================================================
+
+void DemoParser::ParseSegment( SegmentResult_t &result )
+{
+	bf_read reader( m_pDemo->GetBuffer(), m_pDemo->GetFileSize() );
+	reader.ReadBytes( &m_demoHeader, sizeof( m_demoHeader ) );
+
+	try
+	{
+		result.bAborted = !ParseCommands( reader );
+
+		OnParsingEnd();
+	}
+	catch( ParsingError_t error ) // OnParsingEnd was already called by the error
+	{
+		result.bFailed = true;
+		result.error_msg = error.error_msg;
+		result.error_tick = error.tick;
+	}
+	catch( ... )
+	{
+		result.bFailed = true;
+		result.error_msg = "unexpected error in demo segment";
+		result.error_tick = m_iCurrentTick;
+	}
+
+	result.frags = m_Frags;
+	result.stats = m_Stats;
+}
+
+// =====================================================================================================================================================================
+
+void DemoParser::SegmentThread( DemoFile *pDemo, const SeekKeyframe_t *pKeyframe, uint32 endOffset, const std::atomic< bool > *pCancel, SegmentResult_t *pResult )
+{
+	DemoParser parser( pDemo );
+	parser.m_bSubParser = true;
+	parser.m_pResumeKeyframe = pKeyframe;
+	parser.m_pCancelSegments = pCancel;
+	parser.m_iSegmentEndOffset = endOffset;
+
+	parser.ParseSegment( *pResult );
+}
+
+// =====================================================================================================================================================================
\ No newline at end of file
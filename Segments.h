@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Common.h"
+#include "Frag.h"
+#include "Stats.h"
+#include <vector>
+
+/**
+ * What a segment parser hands back to the main parser
+ */
+struct SegmentResult_t
+{
+	SegmentResult_t( void ) : bAborted( false ), bFailed( false ), error_msg( nullptr ), error_tick( 0 ) {}
+
+	std::vector< FragVector > frags;			///< Frags from the rounds of this segment, per settings profile
+	ParsingStats_t		stats;
+
+	bool				bAborted;				///< User aborted parsing
+	bool				bFailed;				///< A parsing error was thrown, frags are valid up to the error
+	const char *		error_msg;
+	int					error_tick;
+};
\ No newline at end of file
@@ -12,9 +12,15 @@ extern std::string g_ProgramDirectory;
 // If you add more keys, you need to:
 // 1. add a default value to it in the constructor of SettingsManager
 // 2. add it to LoadSettings
-// 3. implement the logic for it
+// 3. add a field for it to CategorySettings_t or GeneralSettings_t and resolve it in CompileSettings
+// 4. implement the logic for it
 #define KEY_DUMP_TO_FILE						"dump_to_file"
 #define KEY_WRITE_FILE_TO_DEMO_DIR				"write_output_to_demo_directory"
+#define KEY_PARSE_SEGMENTS_IN_PARALLEL			"parse_segments_in_parallel"
+#define KEY_PARSE_PIPELINED						"parse_pipelined"
+#define KEY_WRITE_SEEK_INDEX					"write_seek_index"
+#define KEY_SEARCH_SUBFOLDERS					"search_subfolders"
+#define KEY_SKIP_DUPLICATE_DEMOS				"skip_duplicate_demos"
 #define KEY_ENABLE_BATCH_PROCESSING				"enable_batch_processing"
 #define KEY_TICK_5KS							"tick_5ks"
 #define KEY_TICK_4KS							"tick_4ks"
@@ -130,6 +136,11 @@ SettingsManager::SettingsManager()
 	general_settings[ KEY_DUMP_TO_FILE ].m_bool = false;
 	general_settings[ KEY_WRITE_FILE_TO_DEMO_DIR ].m_bool = false;
 	general_settings[ KEY_ENABLE_BATCH_PROCESSING ].m_bool = false;
+	general_settings[ KEY_PARSE_SEGMENTS_IN_PARALLEL ].m_bool = false;
+	general_settings[ KEY_PARSE_PIPELINED ].m_bool = false;
+	general_settings[ KEY_WRITE_SEEK_INDEX ].m_bool = false;
+	general_settings[ KEY_SEARCH_SUBFOLDERS ].m_bool = false;
+	general_settings[ KEY_SKIP_DUPLICATE_DEMOS ].m_bool = true;
 	general_settings[ KEY_TICK_5KS ].m_bool = true;
 	general_settings[ KEY_TICK_4KS ].m_bool = true;
 	general_settings[ KEY_TICK_3KS ].m_bool = true;
@@ -176,15 +187,18 @@ SettingsManager::SettingsManager()
 	general_settings[ KEY_FLICKSHOT_HEADSHOT_ONLY ].m_bool = false;
 
 	m_iMaxFlickDuration = general_settings[ KEY_FLICKSHOT_MAX_DURATION ].m_int;
+
+	// Used as is if there is no settings file
+	CompileSettings();
 }
 
 // This is where the settings for all categories are read from the settings file
-void SettingsManager::LoadSettings( const char *szSettingsFile )
+bool SettingsManager::LoadSettings( const char *szSettingsFile )
 {
 	using namespace std;
 
 	if( m_bSettingsLoaded )
-		return;
+		return true;
 
 	std::string sDefaultConfigPath;
 
@@ -195,6 +209,10 @@ void SettingsManager::LoadSettings( const char *szSettingsFile )
 		szSettingsFile = sDefaultConfigPath.c_str();
 	}
 
+	m_strProfileName = szSettingsFile;
+	RemoveFileNameFolders( m_strProfileName );
+	RemoveFileExtension( m_strProfileName );
+
 	ifstream file( szSettingsFile );
 
 	if( !file.is_open() )
@@ -204,7 +222,7 @@ void SettingsManager::LoadSettings( const char *szSettingsFile )
 
 		printf( "Warning: Could not open settings file \"%s\" - using built-in default values!\n", filename.c_str() );
 
-		return;
+		return false;
 	}
 
 	// Allow chaining multiple categories together
@@ -277,6 +295,26 @@ void SettingsManager::LoadSettings( const char *szSettingsFile )
 		{
 			SetKeyValueBool( KEY_ENABLE_BATCH_PROCESSING, value )
 		}
+		else if( key == KEY_PARSE_SEGMENTS_IN_PARALLEL )
+		{
+			SetKeyValueBool( KEY_PARSE_SEGMENTS_IN_PARALLEL, value )
+		}
+		else if( key == KEY_PARSE_PIPELINED )
+		{
+			SetKeyValueBool( KEY_PARSE_PIPELINED, value )
+		}
+		else if( key == KEY_WRITE_SEEK_INDEX )
+		{
+			SetKeyValueBool( KEY_WRITE_SEEK_INDEX, value )
+		}
+		else if( key == KEY_SEARCH_SUBFOLDERS )
+		{
+			SetKeyValueBool( KEY_SEARCH_SUBFOLDERS, value )
+		}
+		else if( key == KEY_SKIP_DUPLICATE_DEMOS )
+		{
+			SetKeyValueBool( KEY_SKIP_DUPLICATE_DEMOS, value )
+		}
 		else if( key == KEY_TICK_5KS )
 		{
 			SetKeyValueBool( KEY_TICK_5KS, value )
@@ -482,292 +520,248 @@ void SettingsManager::LoadSettings( const char *szSettingsFile )
 		}
 	}
 
+	CompileSettings();
+
 	m_bSettingsLoaded = true;
+
+	return true;
 }
 
-// TODO: Get rid of the horrifying macro-hell below by replacing them with actual functions
+// Resolves the settings of every category once, so that frag checks don't need to look up the settings maps
+void SettingsManager::CompileSettings( void )
+{
+	static_assert( NUM_SETTINGS_CATEGORIES == CATEGORY_INVALID, "NUM_SETTINGS_CATEGORIES doesn't match CSWeaponCategory" );
 
-// Macro used in ShouldTickFrag with multi-kill frags
-#define DoMultikillFragCheck( tick_key, tick_stationary_key, stationary_max_dist_key, time_key, min_headshots_key, sp_kill_key )\
-	if( category_settings.find( tick_key ) != category_settings.end() ){\
-		if( !category_settings[ tick_key ].m_bool )\
-			return false;\
-	}\
-	else{\
-		if( !general_settings[ tick_key ].m_bool )\
-			return false;\
-	}\
-	bool __bCheckTime = true;\
-	bool __bCheckDistance = false;\
-	if( category_settings.find( tick_stationary_key ) != category_settings.end() ){\
-		__bCheckDistance = category_settings[ tick_stationary_key ].m_bool;\
-	}\
-	else{\
-		__bCheckDistance = general_settings[ tick_stationary_key ].m_bool;\
-	}\
-	if( __bCheckDistance ){\
-		if( category_settings.find( stationary_max_dist_key ) != category_settings.end() ){\
-			if( category_settings[ stationary_max_dist_key ].m_float >= farthest_distance )\
-				__bCheckTime = false;\
-		}\
-		else{\
-			if( general_settings[ stationary_max_dist_key ].m_float >= farthest_distance )\
-				__bCheckTime = false;\
-		}\
-	}\
-	if( __bCheckTime ){\
-		if( category_settings.find( time_key ) != category_settings.end() ){\
-			if( category_settings[ time_key ].m_float < frag_time )\
-				return false;\
-		}\
-		else{\
-			if( general_settings[ time_key ].m_float < frag_time )\
-				return false;\
-		}\
-	}\
-	if( category != CATEGORY_KNIFE && category != CATEGORY_GRENADE ){\
-		if( category_settings.find( min_headshots_key ) != category_settings.end() ){\
-			if( headshots < category_settings[ min_headshots_key ].m_int )\
-				return false;\
-		}\
-		else{\
-			if( headshots < general_settings[ min_headshots_key ].m_int )\
-				return false;\
-		}\
-		if( !contains_sp_kills ){\
-			if( category_settings.find( sp_kill_key ) != category_settings.end() ){\
-				if( category_settings[ sp_kill_key ].m_bool )\
-					return false;\
-			}\
-			else{\
-				if( general_settings[ sp_kill_key ].m_bool )\
-					return false;\
-			}\
-		}\
-	}\
-	return true
+	static const char *s_MultiKillKeys[ 3 ][ 6 ] =
+	{
+		{ KEY_TICK_3KS, KEY_TICK_SLOW_STATIONARY_3KS, KEY_SLOW_3K_MAX_RANGE, KEY_3K_MAX_TIME, KEY_3K_MIN_HEADSHOTS, KEY_3K_MUST_INCLUDE_SP_KILL },
+		{ KEY_TICK_4KS, KEY_TICK_SLOW_STATIONARY_4KS, KEY_SLOW_4K_MAX_RANGE, KEY_4K_MAX_TIME, KEY_4K_MIN_HEADSHOTS, KEY_4K_MUST_INCLUDE_SP_KILL },
+		{ KEY_TICK_5KS, KEY_TICK_SLOW_STATIONARY_5KS, KEY_SLOW_5K_MAX_RANGE, KEY_5K_MAX_TIME, KEY_5K_MIN_HEADSHOTS, KEY_5K_MUST_INCLUDE_SP_KILL },
+	};
 
-bool SettingsManager::ShouldTickFrag( MultiKillFragType type, CSWeaponCategory category, float frag_time, float farthest_distance, short headshots, bool contains_sp_kills )
-{
-	WeaponSettingsField &category_settings = m_weaponSettings[ category ];
-	WeaponSettingsField &general_settings = GetGeneralSettings();
+	static const char *s_CollateralKeys[ 4 ][ 2 ] =
+	{
+		{ KEY_TICK_DOUBLES, KEY_DOUBLE_MIN_HEADSHOTS },
+		{ KEY_TICK_TRIPLES, KEY_TRIPLE_MIN_HEADSHOTS },
+		{ KEY_TICK_QUADROS, KEY_QUADRO_MIN_HEADSHOTS },
+		{ KEY_TICK_PENTAS, KEY_PENTA_MIN_HEADSHOTS },
+	};
 
-	switch( type )
+	for( int i = 0; i < NUM_SETTINGS_CATEGORIES; ++i )
 	{
-		case FRAG_5K:
-		{
-			DoMultikillFragCheck( KEY_TICK_5KS, KEY_TICK_SLOW_STATIONARY_5KS, KEY_SLOW_5K_MAX_RANGE, KEY_5K_MAX_TIME, KEY_5K_MIN_HEADSHOTS, KEY_5K_MUST_INCLUDE_SP_KILL );
-		}
-		break;
-		case FRAG_4K:
+		const CSWeaponCategory category = (CSWeaponCategory)i;
+		CategorySettings_t &settings = m_CategorySettings[ i ];
+
+		for( int j = 0; j < 3; ++j )
 		{
-			DoMultikillFragCheck( KEY_TICK_4KS, KEY_TICK_SLOW_STATIONARY_4KS, KEY_SLOW_4K_MAX_RANGE, KEY_4K_MAX_TIME, KEY_4K_MIN_HEADSHOTS, KEY_4K_MUST_INCLUDE_SP_KILL );
+			CategorySettings_t::MultiKill_t &multiKill = settings.multiKills[ j ];
+
+			multiKill.tick = GetSettingForCategory( category, s_MultiKillKeys[ j ][ 0 ] ).m_bool;
+			multiKill.tickSlowStationary = GetSettingForCategory( category, s_MultiKillKeys[ j ][ 1 ] ).m_bool;
+			multiKill.slowMaxRange = GetSettingForCategory( category, s_MultiKillKeys[ j ][ 2 ] ).m_float;
+			multiKill.maxTime = GetSettingForCategory( category, s_MultiKillKeys[ j ][ 3 ] ).m_float;
+			multiKill.minHeadshots = GetSettingForCategory( category, s_MultiKillKeys[ j ][ 4 ] ).m_int;
+			multiKill.mustIncludeSpecialKill = GetSettingForCategory( category, s_MultiKillKeys[ j ][ 5 ] ).m_bool;
 		}
-		break;
-		case FRAG_3K:
+
+		for( int j = 0; j < 4; ++j )
 		{
-			DoMultikillFragCheck( KEY_TICK_3KS, KEY_TICK_SLOW_STATIONARY_3KS, KEY_SLOW_3K_MAX_RANGE, KEY_3K_MAX_TIME, KEY_3K_MIN_HEADSHOTS, KEY_3K_MUST_INCLUDE_SP_KILL );
+			settings.collaterals[ j ].tick = GetSettingForCategory( category, s_CollateralKeys[ j ][ 0 ] ).m_bool;
+			settings.collaterals[ j ].minHeadshots = GetSettingForCategory( category, s_CollateralKeys[ j ][ 1 ] ).m_int;
 		}
-		break;
-	}
 
-	return false;
-}
+		settings.tickFlashSmokeKills = GetSettingForCategory( category, KEY_TICK_FLASH_SMOKE_KILLS ).m_bool;
 
-// Macro used in ShouldTickFrag to check if this kind of frag should be ticked at all
-#define DoFragCheck( tick_key )\
-	if( category_settings.find( tick_key ) != category_settings.end() ){\
-		if( category_settings[ tick_key ].m_bool )\
-			return true;\
-	}\
-	else{\
-		if( general_settings[ tick_key ].m_bool )\
-			return true;\
+		settings.tickFlickshots = GetSettingForCategory( category, KEY_TICK_FLICKSHOTS ).m_bool;
+		settings.flickshotHeadshotOnly = GetSettingForCategory( category, KEY_FLICKSHOT_HEADSHOT_ONLY ).m_bool;
+		settings.flickshotMaxDuration = GetSettingForCategory( category, KEY_FLICKSHOT_MAX_DURATION ).m_int;
+
+		settings.tickWallbangs = GetSettingForCategory( category, KEY_TICK_WALLBANGS ).m_bool;
+		settings.wallbangHeadshotOnly = GetSettingForCategory( category, KEY_WALLBANG_HEADSHOT_ONLY ).m_bool;
+		settings.wallbangRequireAnotherKill = GetSettingForCategory( category, KEY_WALLBANG_REQUIRE_ANOTHER_KILL ).m_bool;
+		settings.wallbangAnotherKillMaxDeltaTime = GetSettingForCategory( category, KEY_WALLBANG_ANOTHER_KILL_MAX_DT ).m_float;
+
+		settings.midAir.tick = GetSettingForCategory( category, KEY_TICK_MIDAIR_KILLS ).m_bool;
+		settings.midAir.minDistance = GetSettingForCategory( category, KEY_MIDAIR_MIN_DISTANCE ).m_float;
+		settings.midAir.headshotModifier = GetSettingForCategory( category, KEY_MIDAIR_MIN_DISTANCE_HS_MOD ).m_float;
+		settings.midAir.wallbangModifier = GetSettingForCategory( category, KEY_MIDAIR_MIN_DISTANCE_WB_MOD ).m_float;
+		settings.midAirMinPostKillAirTime = GetSettingForCategory( category, KEY_MIDAIR_MIN_POSTKILL_AIR_TIME ).m_float;
+
+		settings.noscope.tick = GetSettingForCategory( category, KEY_TICK_NOSCOPES ).m_bool;
+		settings.noscope.minDistance = GetSettingForCategory( category, KEY_NOSCOPE_MIN_DISTANCE ).m_float;
+		settings.noscope.headshotModifier = GetSettingForCategory( category, KEY_NOSCOPE_MIN_DISTANCE_HS_MOD ).m_float;
+		settings.noscope.wallbangModifier = GetSettingForCategory( category, KEY_NOSCOPE_MIN_DISTANCE_WB_MOD ).m_float;
 	}
 
-// Same as DoFragCheck, but also checks for (non)required headshot
-#define DoFragCheckWithHeadshot( tick_key, headshot_key, is_headshot )\
-	bool __bShouldTick = false;\
-	if( category_settings.find( tick_key ) != category_settings.end() ){\
-		if( category_settings[ tick_key ].m_bool )\
-			__bShouldTick = true;\
-	}\
-	else{\
-		if( general_settings[ tick_key ].m_bool )\
-			__bShouldTick = true;\
-	}\
-	if( __bShouldTick ){\
-		if( category_settings.find( headshot_key ) != category_settings.end() ){\
-			if( !category_settings[ headshot_key ].m_bool || is_headshot )\
-				return true;\
-		}\
-		else{\
-			if( !general_settings[ headshot_key ].m_bool || is_headshot )\
-				return true;\
-		}\
-	}\
-	else void(0);
+	WeaponSettingsField &general_settings = GetGeneralSettings();
 
-// Same as DoFragCheck, but also checks for minimum required headshots
-#define DoFragCheckWithMinHeadshots( tick_key, min_headshots_key, num_headshots )\
-	bool __bShouldTick = false;\
-	if( category_settings.find( tick_key ) != category_settings.end() ){\
-		if( category_settings[ tick_key ].m_bool )\
-			__bShouldTick = true;\
-	}\
-	else{\
-		if( general_settings[ tick_key ].m_bool )\
-			__bShouldTick = true;\
-	}\
-	if( __bShouldTick ){\
-		if( category_settings.find( min_headshots_key ) != category_settings.end() ){\
-			if( category_settings[ min_headshots_key ].m_int <= num_headshots )\
-				return true;\
-		}\
-		else{\
-			if( general_settings[ min_headshots_key ].m_int <= num_headshots )\
-				return true;\
-		}\
-	}\
-	else void(0);
+	m_GeneralSettings.dumpToFile = general_settings[ KEY_DUMP_TO_FILE ].m_bool;
+	m_GeneralSettings.writeOutputToDemoDirectory = general_settings[ KEY_WRITE_FILE_TO_DEMO_DIR ].m_bool;
+	m_GeneralSettings.enableBatchProcessing = general_settings[ KEY_ENABLE_BATCH_PROCESSING ].m_bool;
+	m_GeneralSettings.parseSegmentsInParallel = general_settings[ KEY_PARSE_SEGMENTS_IN_PARALLEL ].m_bool;
+	m_GeneralSettings.parsePipelined = general_settings[ KEY_PARSE_PIPELINED ].m_bool;
+	m_GeneralSettings.writeSeekIndex = general_settings[ KEY_WRITE_SEEK_INDEX ].m_bool;
+	m_GeneralSettings.searchSubfolders = general_settings[ KEY_SEARCH_SUBFOLDERS ].m_bool;
+	m_GeneralSettings.skipDuplicateDemos = general_settings[ KEY_SKIP_DUPLICATE_DEMOS ].m_bool;
+	m_GeneralSettings.tickFragsVsBots = general_settings[ KEY_TICK_FRAGS_VS_BOTS ].m_bool;
+}
 
-// Same as DoFragCheck, but also checks minimum distance and scales it by headshot modifier if it's a headshot
-#define DoFragCheckWithDistance( tick_key, min_dist_key, hs_mod_key, wb_mod_key, distance, is_headshot, is_wallbang )\
-	bool __bShouldTick = false;\
-	if( category_settings.find( tick_key ) != category_settings.end() ){\
-		if( category_settings[ tick_key ].m_bool )\
-			__bShouldTick = true;\
-	}\
-	else{\
-		if( general_settings[ tick_key ].m_bool )\
-			__bShouldTick = true;\
-	}\
-	if( __bShouldTick ){\
-		float __fMinDist;\
-		float __fHsMod;\
-		float __fWbMod;\
-		if( category_settings.find( min_dist_key ) != category_settings.end() ){\
-			__fMinDist = category_settings[ min_dist_key ].m_float;\
-		}\
-		else{\
-			__fMinDist = general_settings[ min_dist_key ].m_float;\
-		}\
-		if( is_headshot ){\
-			if( category_settings.find( hs_mod_key ) != category_settings.end() ){\
-				__fHsMod = category_settings[ hs_mod_key ].m_float;\
-			}\
-			else{\
-				__fHsMod = general_settings[ hs_mod_key ].m_float;\
-			}\
-			__fMinDist *= __fHsMod;\
-		}\
-		if( is_wallbang ){\
-			if( category_settings.find( wb_mod_key ) != category_settings.end() ){\
-				__fWbMod = category_settings[ wb_mod_key ].m_float;\
-			}\
-			else{\
-				__fWbMod = general_settings[ wb_mod_key ].m_float;\
-			}\
-			__fMinDist *= __fWbMod;\
-		}\
-		if( distance >= __fMinDist )\
-			return true;\
-	}\
-	else void(0);
+const CategorySettings_t &SettingsManager::GetCategorySettings( CSWeaponCategory category, int profile ) const
+{
+	if( category < 0 || category >= NUM_SETTINGS_CATEGORIES )
+		category = CATEGORY_GENERAL;
 
-// Frag check for collats in particular
-#define DoCollatFragCheck( category, tick_key, min_headshots_key, headshots )\
-		if( category != CATEGORY_GRENADE ){\
-			DoFragCheckWithMinHeadshots( tick_key, min_headshots_key, headshots )\
-		}\
-		else{\
-			DoFragCheck( tick_key )\
-		}
+	if( profile > 0 )
+		return m_Profiles[ profile - 1 ].categories[ category ];
 
-bool SettingsManager::WallbangIsCloseToAnotherKill( CSWeaponCategory category, float time_to_closest_kill )
+	return m_CategorySettings[ category ];
+}
+
+// Only the frag settings of an additional settings file are used, the general settings always come from the main file
+bool SettingsManager::AddProfile( const char *szSettingsFile )
 {
-	WeaponSettingsField &category_settings = m_weaponSettings[ category ];
-	WeaponSettingsField &general_settings = GetGeneralSettings();
+	// A profile is never replaced by the defaults, so check the file first to skip the warning of LoadSettings
+	if( !std::ifstream( szSettingsFile ).is_open() )
+		return false;
 
-	if( category_settings.find( KEY_WALLBANG_REQUIRE_ANOTHER_KILL ) != category_settings.end() )
-	{
-		if( !category_settings[ KEY_WALLBANG_REQUIRE_ANOTHER_KILL ].m_bool )
-			return true;
-	}
-	else
-	{
-		if( !general_settings[ KEY_WALLBANG_REQUIRE_ANOTHER_KILL ].m_bool )
-			return true;
-	}
+	SettingsManager profileSettings;
 
-	float max_deltatime;
+	if( !profileSettings.LoadSettings( szSettingsFile ) )
+		return false;
 
-	if( category_settings.find( KEY_WALLBANG_ANOTHER_KILL_MAX_DT ) != category_settings.end() )
+	SettingsProfile_t profile;
+	profile.name = profileSettings.m_strProfileName;
+
+	// The name suffixes the output files of the profile, so settings files with the same name (in different folders or
+	// given twice) get the profile number added instead of sharing the files
+	const int number = GetNumProfiles();
+
+	for( int i = 0; i < number; ++i )
 	{
-		max_deltatime = category_settings[ KEY_WALLBANG_ANOTHER_KILL_MAX_DT ].m_float;
+		if( !_stricmp( GetProfileName( i ).c_str(), profile.name.c_str() ) )
+		{
+			profile.name += "_" + std::to_string( number );
+			i = -1;
+		}
 	}
-	else
+
+	for( int i = 0; i < NUM_SETTINGS_CATEGORIES; ++i )
+		profile.categories[ i ] = profileSettings.m_CategorySettings[ i ];
+
+	m_Profiles.push_back( profile );
+
+	return true;
+}
+
+int SettingsManager::GetNumProfiles( void ) const
+{
+	return 1 + (int)m_Profiles.size();
+}
+
+const std::string &SettingsManager::GetProfileName( int profile ) const
+{
+	if( profile > 0 )
+		return m_Profiles[ profile - 1 ].name;
+
+	return m_strProfileName;
+}
+
+bool SettingsManager::ShouldTickFrag( MultiKillFragType type, CSWeaponCategory category, float frag_time, float farthest_distance, short headshots, bool contains_sp_kills, int profile )
+{
+	if( type < FRAG_3K || type > FRAG_5K )
+		return false;
+
+	const CategorySettings_t::MultiKill_t &settings = GetCategorySettings( category, profile ).multiKills[ type - FRAG_3K ];
+
+	if( !settings.tick )
+		return false;
+
+	// Slow frags are fine if the fragger stayed in place
+	bool bCheckTime = true;
+
+	if( settings.tickSlowStationary && settings.slowMaxRange >= farthest_distance )
+		bCheckTime = false;
+
+	if( bCheckTime && settings.maxTime < frag_time )
+		return false;
+
+	if( category != CATEGORY_KNIFE && category != CATEGORY_GRENADE )
 	{
-		max_deltatime = general_settings[ KEY_WALLBANG_ANOTHER_KILL_MAX_DT ].m_float;
+		if( headshots < settings.minHeadshots )
+			return false;
+
+		if( !contains_sp_kills && settings.mustIncludeSpecialKill )
+			return false;
 	}
 
-	return time_to_closest_kill <= max_deltatime;
+	return true;
 }
 
-bool SettingsManager::ShouldTickFrag( unsigned short type_flags, CSWeaponCategory category, float distance, short headshots, float time_to_closest_kill )
+// Checks the minimum distance, which is scaled by the headshot and wallbang modifiers
+static bool DistanceKillShouldTick( const CategorySettings_t::DistanceKill_t &settings, float distance, bool is_headshot, bool is_wallbang )
 {
-	WeaponSettingsField &category_settings = m_weaponSettings[ category ];
-	WeaponSettingsField &general_settings = GetGeneralSettings();
+	if( !settings.tick )
+		return false;
+
+	float min_distance = settings.minDistance;
+
+	if( is_headshot )
+		min_distance *= settings.headshotModifier;
+
+	if( is_wallbang )
+		min_distance *= settings.wallbangModifier;
+
+	return distance >= min_distance;
+}
+
+bool SettingsManager::ShouldTickFrag( unsigned short type_flags, CSWeaponCategory category, float distance, short headshots, float time_to_closest_kill, int profile )
+{
+	const CategorySettings_t &settings = GetCategorySettings( category, profile );
 
 	bool bHeadshot = headshots > 0;
 	bool bWallbang = (type_flags & FL_KILL_WALLBANG) != 0;
 
-	if( type_flags & FL_KILL_DOUBLE )
-	{
-		DoCollatFragCheck( category, KEY_TICK_DOUBLES, KEY_DOUBLE_MIN_HEADSHOTS, headshots )
-	}
+	// Collaterals (headshots are not required for grenades)
+	static const unsigned short s_CollateralFlags[ 4 ] = { FL_KILL_DOUBLE, FL_KILL_TRIPLE, FL_KILL_QUADRO, FL_KILL_PENTA };
 
-	if( type_flags & FL_KILL_TRIPLE )
+	for( int i = 0; i < 4; ++i )
 	{
-		DoCollatFragCheck( category, KEY_TICK_TRIPLES, KEY_TRIPLE_MIN_HEADSHOTS, headshots )
-	}
+		const CategorySettings_t::Collateral_t &collateral = settings.collaterals[ i ];
 
-	if( type_flags & FL_KILL_QUADRO )
-	{
-		DoCollatFragCheck( category, KEY_TICK_QUADROS, KEY_QUADRO_MIN_HEADSHOTS, headshots )
+		if( (type_flags & s_CollateralFlags[ i ]) && collateral.tick )
+		{
+			if( category == CATEGORY_GRENADE || collateral.minHeadshots <= headshots )
+				return true;
+		}
 	}
 
-	if( type_flags & FL_KILL_PENTA )
-	{
-		DoCollatFragCheck( category, KEY_TICK_PENTAS, KEY_PENTA_MIN_HEADSHOTS, headshots )
-	}
+	if( (type_flags & FL_KILL_FLASHKILL || type_flags & FL_KILL_SMOKEKILL) && settings.tickFlashSmokeKills )
+		return true;
 
-	if( type_flags & FL_KILL_FLASHKILL || type_flags & FL_KILL_SMOKEKILL )
+	if( (type_flags & FL_KILL_FLICKSHOT) && settings.tickFlickshots )
 	{
-		DoFragCheck( KEY_TICK_FLASH_SMOKE_KILLS )
+		if( !settings.flickshotHeadshotOnly || bHeadshot )
+			return true;
 	}
 
-	if( type_flags & FL_KILL_FLICKSHOT )
+	if( (type_flags & FL_KILL_WALLBANG) && settings.tickWallbangs )
 	{
-		DoFragCheckWithHeadshot( KEY_TICK_FLICKSHOTS, KEY_FLICKSHOT_HEADSHOT_ONLY, bHeadshot )
-	}
+		bool bCloseToAnotherKill = !settings.wallbangRequireAnotherKill || time_to_closest_kill <= settings.wallbangAnotherKillMaxDeltaTime;
 
-	if( type_flags & FL_KILL_WALLBANG )
-	{
-		if( WallbangIsCloseToAnotherKill( category, time_to_closest_kill ) )
-		{
-			DoFragCheckWithHeadshot( KEY_TICK_WALLBANGS, KEY_WALLBANG_HEADSHOT_ONLY, bHeadshot )
-		}
+		if( bCloseToAnotherKill && (!settings.wallbangHeadshotOnly || bHeadshot) )
+			return true;
 	}
 
 	if( (type_flags & FL_KILL_MIDAIR) || (type_flags & FL_KILL_LADDERSHOT) )
 	{
-		DoFragCheckWithDistance( KEY_TICK_MIDAIR_KILLS, KEY_MIDAIR_MIN_DISTANCE, KEY_MIDAIR_MIN_DISTANCE_HS_MOD, KEY_MIDAIR_MIN_DISTANCE_WB_MOD, distance, bHeadshot, bWallbang )
+		if( DistanceKillShouldTick( settings.midAir, distance, bHeadshot, bWallbang ) )
+			return true;
 	}
 
 	if( type_flags & FL_KILL_NOSCOPE )
 	{	// TODO: add running check
-		DoFragCheckWithDistance( KEY_TICK_NOSCOPES, KEY_NOSCOPE_MIN_DISTANCE, KEY_NOSCOPE_MIN_DISTANCE_HS_MOD, KEY_NOSCOPE_MIN_DISTANCE_WB_MOD, distance, bHeadshot, bWallbang )
+		if( DistanceKillShouldTick( settings.noscope, distance, bHeadshot, bWallbang ) )
+			return true;
 	}
 
 	return false;
@@ -775,27 +769,53 @@ bool SettingsManager::ShouldTickFrag( unsigned short type_flags, CSWeaponCategor
 
 bool SettingsManager::BatchProcessingEnabled( void )
 {
-	return m_weaponSettings[ CATEGORY_GENERAL ][ KEY_ENABLE_BATCH_PROCESSING ].m_bool;
+	return m_GeneralSettings.enableBatchProcessing;
 }
 
 void SettingsManager::DisableBatchProcessing( void )
 {
 	m_weaponSettings[ CATEGORY_GENERAL ][ KEY_ENABLE_BATCH_PROCESSING ].m_bool = false;
+	m_GeneralSettings.enableBatchProcessing = false;
 }
 
 bool SettingsManager::DumpToFileEnabled( void )
 {
-	return m_weaponSettings[ CATEGORY_GENERAL ][ KEY_DUMP_TO_FILE ].m_bool;
+	return m_GeneralSettings.dumpToFile;
 }
 
 bool SettingsManager::WriteOutputToDemoDirectory( void )
 {
-	return m_weaponSettings[ CATEGORY_GENERAL ][ KEY_WRITE_FILE_TO_DEMO_DIR ].m_bool;
+	return m_GeneralSettings.writeOutputToDemoDirectory;
+}
+
+bool SettingsManager::ParseSegmentsInParallel( void )
+{
+	return m_GeneralSettings.parseSegmentsInParallel;
+}
+
+bool SettingsManager::ParsePipelined( void )
+{
+	return m_GeneralSettings.parsePipelined;
+}
+
+bool SettingsManager::WriteSeekIndex( void )
+{
+	return m_GeneralSettings.writeSeekIndex;
+}
+
+bool SettingsManager::SearchSubfolders( void )
+{
+	return m_GeneralSettings.searchSubfolders;
+}
+
+bool SettingsManager::SkipDuplicateDemos( void )
+{
+	return m_GeneralSettings.skipDuplicateDemos;
 }
 
 bool SettingsManager::ShouldTickFragsVsBots( void )
 {
-	return m_weaponSettings[ CATEGORY_GENERAL ][ KEY_TICK_FRAGS_VS_BOTS ].m_bool;
+	return m_GeneralSettings.tickFragsVsBots;
 }
 
 int SettingsManager::GetMaxFlickshotDuration( void )
@@ -805,30 +825,12 @@ int SettingsManager::GetMaxFlickshotDuration( void )
 
 int SettingsManager::GetFlickshotDurationForCategory( CSWeaponCategory category )
 {
-	WeaponSettingsField &category_settings = m_weaponSettings[ category ];
-
-	if( category_settings.find( KEY_FLICKSHOT_MAX_DURATION ) != category_settings.end() )
-	{
-		return category_settings[ KEY_FLICKSHOT_MAX_DURATION ].m_int;
-	}
-	else
-	{
-		return m_weaponSettings[ CATEGORY_GENERAL ][ KEY_FLICKSHOT_MAX_DURATION ].m_int;
-	}
+	return GetCategorySettings( category ).flickshotMaxDuration;
 }
 
 float SettingsManager::GetMinPostKillAirTimeForCategory( CSWeaponCategory category )
 {
-	WeaponSettingsField &category_settings = m_weaponSettings[ category ];
-
-	if( category_settings.find( KEY_MIDAIR_MIN_POSTKILL_AIR_TIME ) != category_settings.end() )
-	{
-		return category_settings[ KEY_MIDAIR_MIN_POSTKILL_AIR_TIME ].m_float;
-	}
-	else
-	{
-		return m_weaponSettings[ CATEGORY_GENERAL ][ KEY_MIDAIR_MIN_POSTKILL_AIR_TIME ].m_float;
-	}
+	return GetCategorySettings( category ).midAirMinPostKillAirTime;
 }
 
 CSWeaponCategory SettingsManager::GetCategoryByName( const char *szCategoryName )
@@ -858,4 +860,16 @@ CSWeaponCategory SettingsManager::GetCategoryByName( const char *szCategoryName
 SettingsManager::WeaponSettingsField &SettingsManager::GetGeneralSettings( void )
 {
 	return m_weaponSettings[ CATEGORY_GENERAL ];
+}
+
+const SettingsManager::setting_value &SettingsManager::GetSettingForCategory( CSWeaponCategory category, const char *szKey )
+{
+	WeaponSettingsField &category_settings = m_weaponSettings[ category ];
+
+	auto it = category_settings.find( szKey );
+
+	if( it != category_settings.end() )
+		return it->second;
+
+	return GetGeneralSettings()[ szKey ];
 }
\ No newline at end of file
@@ -2,30 +2,119 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 enum MultiKillFragType;
 enum CSWeaponCategory;
 
+#define NUM_SETTINGS_CATEGORIES		9		// CATEGORY_GENERAL to CATEGORY_GRENADE
+
+/**
+ * Frag settings of one weapon category, with the general settings filled in where the category doesn't set a value
+ * These are resolved once when the settings are loaded, so checking frags is just reading the fields
+ */
+struct CategorySettings_t
+{
+	struct MultiKill_t
+	{
+		bool	tick;
+		bool	tickSlowStationary;			///< Ignore max time if all kills are within slowMaxRange
+		float	slowMaxRange;
+		float	maxTime;
+		int		minHeadshots;
+		bool	mustIncludeSpecialKill;
+	};
+
+	struct Collateral_t
+	{
+		bool	tick;
+		int		minHeadshots;
+	};
+
+	struct DistanceKill_t
+	{
+		bool	tick;
+		float	minDistance;
+		float	headshotModifier;			///< Min distance is scaled by this for headshots
+		float	wallbangModifier;			///< Min distance is scaled by this for wallbangs
+	};
+
+	MultiKill_t		multiKills[ 3 ];		///< 3k, 4k, 5k
+	Collateral_t	collaterals[ 4 ];		///< Doubles, triples, quadros, pentas
+
+	bool			tickFlashSmokeKills;
+
+	bool			tickFlickshots;
+	bool			flickshotHeadshotOnly;
+	int				flickshotMaxDuration;	///< In milliseconds
+
+	bool			tickWallbangs;
+	bool			wallbangHeadshotOnly;
+	bool			wallbangRequireAnotherKill;
+	float			wallbangAnotherKillMaxDeltaTime;
+
+	DistanceKill_t	midAir;
+	float			midAirMinPostKillAirTime;
+
+	DistanceKill_t	noscope;
+};
+
+/**
+ * Frag settings of an additional settings file, which are applied to the same parsed kills as the main settings
+ */
+struct SettingsProfile_t
+{
+	std::string			name;								///< Settings file name without folders and extension
+	CategorySettings_t	categories[ NUM_SETTINGS_CATEGORIES ];
+};
+
+/**
+ * Settings that are only read from the general category
+ */
+struct GeneralSettings_t
+{
+	bool			dumpToFile;
+	bool			writeOutputToDemoDirectory;
+	bool			enableBatchProcessing;
+	bool			parseSegmentsInParallel;
+	bool			parsePipelined;
+	bool			writeSeekIndex;
+	bool			searchSubfolders;
+	bool			skipDuplicateDemos;
+	bool			tickFragsVsBots;
+};
+
 class SettingsManager
 {
 public:
 	static SettingsManager *Instance( void );
 
-	void LoadSettings( const char *szSettingsFile = nullptr );
+	bool LoadSettings( const char *szSettingsFile = nullptr );	///< Returns false if the file could not be opened
+
+	// Settings profiles - the frags are found separately with the frag settings of each profile
+	// Profile 0 is the main settings file, which is also used for everything that is decided while parsing (e.g. flickshot durations)
+	bool AddProfile( const char *szSettingsFile );				///< Returns false if the file could not be opened
+	int GetNumProfiles( void ) const;
+	const std::string &GetProfileName( int profile ) const;
 
 	// Checks if the multi-kill frag should be ticked in the given category
 	// Also checks if the frag is fast enough to be ticked
-	bool ShouldTickFrag( MultiKillFragType type, CSWeaponCategory category, float frag_time, float farthest_distance, short headshots, bool contains_sp_kills );
+	bool ShouldTickFrag( MultiKillFragType type, CSWeaponCategory category, float frag_time, float farthest_distance, short headshots, bool contains_sp_kills, int profile = 0 );
 
 	// Check if the flags indicate any frags that should be ticked in the given category
 	// Also checks for minimum distance, minimum headshots etc.
-	bool ShouldTickFrag( unsigned short type_flags, CSWeaponCategory category, float distance, short headshots, float time_to_closest_kill );
+	bool ShouldTickFrag( unsigned short type_flags, CSWeaponCategory category, float distance, short headshots, float time_to_closest_kill, int profile = 0 );
 
 	bool BatchProcessingEnabled( void );
 	void DisableBatchProcessing( void );
 
 	bool DumpToFileEnabled( void );
 	bool WriteOutputToDemoDirectory( void );
+	bool ParseSegmentsInParallel( void );
+	bool ParsePipelined( void );
+	bool WriteSeekIndex( void );
+	bool SearchSubfolders( void );
+	bool SkipDuplicateDemos( void );
 
 	bool ShouldTickFragsVsBots( void );
 
@@ -42,7 +131,8 @@ private:
 
 	CSWeaponCategory GetCategoryByName( const char *szCategoryName );
 
-	bool WallbangIsCloseToAnotherKill( CSWeaponCategory category, float time_to_closest_kill );
+	void CompileSettings( void );			///< Resolves the settings maps into the structs below
+	const CategorySettings_t &GetCategorySettings( CSWeaponCategory category, int profile = 0 ) const;
 
 	union setting_value
 	{
@@ -58,6 +148,14 @@ private:
 	std::map< CSWeaponCategory, WeaponSettingsField > m_weaponSettings;
 
 	WeaponSettingsField &GetGeneralSettings( void );
+	const setting_value &GetSettingForCategory( CSWeaponCategory category, const char *szKey );	///< Falls back to the general setting
+
+	// Read-only after loading, so these can be shared between parser threads
+	CategorySettings_t m_CategorySettings[ NUM_SETTINGS_CATEGORIES ];
+	GeneralSettings_t m_GeneralSettings;
+
+	std::string m_strProfileName;							///< Name of profile 0
+	std::vector< SettingsProfile_t > m_Profiles;			///< Profiles 1...n
 
 	int m_iMaxFlickDuration;
 
@@ -0,0 +1,384 @@
+#include "Slim.h"
+#include "DemoParser.h"
+#include "Archive.h"
+#include "Errors.h"
+#include "FragOutput.h"
+#include "Netmessages.h"
+
+// Slim export
+//
+// The demo is parsed normally, and every command is written to the slim copy after it has been parsed:
+// - Packets (signon included) keep only the messages that the parser uses. Voice, sounds, temp entities, user and
+//   entity messages, decals, prints and console variables are left out.
+// - SVC_PacketEntities keeps only the updates of the world and the players. The parser stops reading entity updates
+//   after the last player, and the copy ends at the same point.
+// - Data tables and sync tick are copied, console and user commands are left out.
+// Every packet is kept, even if it's empty, so the ticks and the per-packet checks stay the same. The copy is parsed
+// again afterwards to make sure that it has exactly the same frags.
+
+// Messages that the parser uses, by message type
+static const bool s_bSlimKeepMessage[ NumMessageTypes ] = {
+	false,	// NET_NOP
+	true,	// NET_Disconnect
+	false,	// NET_File
+	true,	// NET_Tick
+	false,	// NET_StringCmd
+	false,	// NET_SetConVar
+	true,	// NET_SignOnState
+	false,	// SVC_Print
+	true,	// SVC_ServerInfo
+	true,	// SVC_SendTable
+	true,	// SVC_ClassInfo
+	true,	// SVC_SetPause
+	true,	// SVC_CreateStringTable
+	true,	// SVC_UpdateStringTable
+	false,	// SVC_VoiceInit
+	false,	// SVC_VoiceData
+	false,	// (16)
+	false,	// SVC_Sounds
+	false,	// SVC_SetView
+	false,	// SVC_FixAngle
+	false,	// SVC_CrosshairAngle
+	false,	// SVC_BSPDecal
+	false,	// (22)
+	false,	// SVC_UserMessage
+	false,	// SVC_EntityMessage
+	true,	// SVC_GameEvent
+	true,	// SVC_PacketEntities
+	false,	// SVC_TempEntities
+	false,	// SVC_Prefetch
+	false,	// SVC_Menu
+	true,	// SVC_GameEventList
+	false };	// SVC_GetCvarValue
+
+// =====================================================================================================================================================================
+
+SlimDemoWriter::SlimDemoWriter( void )
+{
+	memset( &m_Header, 0, sizeof( m_Header ) );
+	m_iFileSize = 0;
+}
+
+// =====================================================================================================================================================================
+
+bool SlimDemoWriter::Open( const std::string &filename, const demoheader_t &header )
+{
+	m_File.open( filename, std::ios::binary | std::ios::trunc );
+
+	if( !m_File.is_open() )
+		return false;
+
+	// The signon length is filled in at the end
+	m_Header = header;
+	m_File.write( (const char *)&m_Header, sizeof( m_Header ) );
+
+	return m_File.good();
+}
+
+// =====================================================================================================================================================================
+
+bool SlimDemoWriter::Finish( int stopTick )
+{
+	m_File.put( (char)dem_stop );
+	m_File.write( (const char *)&stopTick, sizeof( stopTick ) );
+
+	m_iFileSize = (int64)m_File.tellp();
+
+	m_File.seekp( 0 );
+	m_File.write( (const char *)&m_Header, sizeof( m_Header ) );
+	m_File.close();
+
+	return !m_File.fail();
+}
+
+// =====================================================================================================================================================================
+
+void SlimDemoWriter::WriteCommand( const char *pData, int numBytes )
+{
+	m_File.write( pData, numBytes );
+}
+
+// =====================================================================================================================================================================
+
+void SlimDemoWriter::MarkSignonEnd( void )
+{
+	m_Header.signonlength = (int32)( (int64)m_File.tellp() - sizeof( m_Header ) );
+}
+
+// =====================================================================================================================================================================
+
+void SlimDemoWriter::BeginPacket( int maxBytes )
+{
+	// The copy of a packet is never bigger than the packet
+	const size_t numWords = ( maxBytes + 3 ) / 4 + 1;
+
+	if( m_PacketBuffer.size() < numWords )
+		m_PacketBuffer.resize( numWords );
+
+	// Clear the bits after the end too, so that the same demo always gives the same copy
+	memset( m_PacketBuffer.data(), 0, numWords * sizeof( uint32 ) );
+	m_Packet.StartWriting( m_PacketBuffer.data(), (int)( numWords * sizeof( uint32 ) ) );
+}
+
+// =====================================================================================================================================================================
+
+void SlimDemoWriter::CopyMessage( bf_read &reader, int startBit )
+{
+	const int endBit = reader.GetNumBitsRead();
+
+	reader.Seek( startBit );
+	m_Packet.WriteBitsFromBuffer( &reader, endBit - startBit );
+}
+
+// =====================================================================================================================================================================
+/**
+ * The header fields are the same as in HandleSVCPacketEntities
+ */
+void SlimDemoWriter::CopyPacketEntities( bf_read &reader, int startBit, int numUpdates, int numDataBits )
+{
+	const int endBit = reader.GetNumBitsRead();
+
+	reader.Seek( startBit );
+	m_Packet.WriteUBitLong( reader.ReadUBitLong( 5 ), 5 );		// Message type
+	m_Packet.WriteUBitLong( reader.ReadUBitLong( 11 ), 11 );	// maxentries
+
+	const bool isdelta = reader.ReadOneBit();
+	m_Packet.WriteOneBit( isdelta );
+
+	if( isdelta )
+		m_Packet.WriteLong( reader.ReadLong() );				// deltafrom
+
+	m_Packet.WriteUBitLong( reader.ReadUBitLong( 1 ), 1 );		// baseline
+
+	reader.ReadUBitLong( 11 );
+	m_Packet.WriteUBitLong( numUpdates, 11 );
+
+	reader.ReadUBitLong( 20 );
+	m_Packet.WriteUBitLong( numDataBits, 20 );
+
+	m_Packet.WriteOneBit( reader.ReadOneBit() );				// updatebaseline
+
+	if( numDataBits > 0 )
+		m_Packet.WriteBitsFromBuffer( &reader, numDataBits );
+
+	reader.Seek( endBit );
+}
+
+// =====================================================================================================================================================================
+
+void SlimDemoWriter::EndPacket( const char *pHeader, int headerBytes )
+{
+	const int32 datasize = m_Packet.GetNumBytesWritten();
+
+	m_File.write( pHeader, headerBytes );
+	m_File.write( (const char *)&datasize, sizeof( datasize ) );
+	m_File.write( (const char *)m_Packet.GetData(), datasize );
+}
+
+// =====================================================================================================================================================================
+/**
+ * Parses the demo and writes the slim copy on the way, the frags are handed to the sink as they are found
+ * @return						false if the demo couldn't be parsed to the end or the copy couldn't be written
+ */
+bool DemoParser::ExportSlim( DemoFile *pDemo, const std::string &filename, FragSink *pSink )
+{
+	SlimDemoWriter writer;
+
+	// Sub-parsers don't print anything or touch the progress bar
+	DemoParser parser( pDemo );
+	parser.m_bSubParser = true;
+	parser.m_pFragSink = pSink;
+	parser.m_pSlimWriter = &writer;
+
+	bf_read reader( pDemo->GetBuffer(), pDemo->GetFileSize() );
+	reader.ReadBytes( &parser.m_demoHeader, sizeof( parser.m_demoHeader ) );
+
+	if( !writer.Open( filename, parser.m_demoHeader ) )
+		return false;
+
+	try
+	{
+		parser.ParseCommands( reader );
+		parser.OnParsingEnd();
+	}
+	catch( ParsingError_t error ) // OnParsingEnd was already called by the error
+	{
+		// Errors at the end of a demo are ignored, since they often happen on map change etc.
+		// The copy ends with the last command that was parsed completely.
+		if( !error.at_end_of_demo )
+		{
+			writer.Finish( parser.m_iCurrentTick );
+			return false;
+		}
+	}
+
+	return writer.Finish( parser.m_iCurrentTick );
+}
+
+// =====================================================================================================================================================================
+/**
+ * Writes the command that was just parsed to the slim copy
+ */
+void DemoParser::SlimCommand( byte cmd, bf_read &reader )
+{
+	const char *pCommand = m_pDemo->GetBuffer() + m_iCommandOffset;
+
+	switch( cmd )
+	{
+		case dem_signon:
+		case dem_packet:
+		{
+			// The command up to the data size is copied as it is
+			m_pSlimWriter->EndPacket( pCommand, 1 + sizeof( int32 ) + sizeof( democmdinfo_t ) + 2 * sizeof( int32 ) );
+			break;
+		}
+
+		case dem_synctick:
+		{
+			m_pSlimWriter->MarkSignonEnd();
+			m_pSlimWriter->WriteCommand( pCommand, reader.GetNumBytesRead() - m_iCommandOffset );
+			break;
+		}
+
+		case dem_datatables:
+		{
+			m_pSlimWriter->WriteCommand( pCommand, reader.GetNumBytesRead() - m_iCommandOffset );
+			break;
+		}
+
+		// Console and user commands are not used
+		default:
+			break;
+	}
+}
+
+// =====================================================================================================================================================================
+/**
+ * Adds the message that was just parsed to the slim copy of the packet if the parser uses it
+ */
+void DemoParser::SlimMessage( int msg, bf_read &packetReader, int startBit )
+{
+	if( !s_bSlimKeepMessage[ msg ] )
+		return;
+
+	if( msg == SVC_PacketEntities )
+		m_pSlimWriter->CopyPacketEntities( packetReader, startBit, m_iPlayerEntityUpdates, m_iPlayerEntityBits );
+	else
+		m_pSlimWriter->CopyMessage( packetReader, startBit );
+}
+
+// =====================================================================================================================================================================
+/**
+ * Slim copies are written beside the demo, or beside the archive the demo is in
+ */
+static std::string GetSlimDemoPath( const DemoFile &demo )
+{
+	std::string path = demo.GetFilePath();
+
+	size_t pos = path.find( ARCHIVE_MEMBER_SEPARATOR );
+	if( pos != std::string::npos )
+		path.erase( pos );
+
+	pos = path.find_last_of( "\\/" );
+	path.erase( ( pos != std::string::npos )? pos + 1 : 0 );
+
+	std::string name = demo.GetFileName();
+	RemoveDemoExtension( name );
+
+	return path + name + SLIM_DEMO_SUFFIX ".dem";
+}
+
+// =====================================================================================================================================================================
+
+bool SlimDemos( const std::vector< std::string > &demos )
+{
+	int numFailed = 0;
+	int64 totalBytes = 0, totalSlimBytes = 0;
+
+	printf( "%s: Writing slim copies of %d demos...\n\n", CSSFF_NAME, (int)demos.size() );
+
+	for( size_t nDemo = 0; nDemo < demos.size(); ++nDemo )
+	{
+		printf( "Demo %d/%d: ", (int)nDemo + 1, (int)demos.size() );
+
+		DemoFile demo( demos[ nDemo ] );
+
+		std::string name = demo.GetFileName();
+		RemoveDemoExtension( name );
+
+		// Don't make copies of copies when a folder is slimmed again
+		if( name.length() >= sizeof( SLIM_DEMO_SUFFIX ) - 1 && !name.compare( name.length() - ( sizeof( SLIM_DEMO_SUFFIX ) - 1 ), std::string::npos, SLIM_DEMO_SUFFIX ) )
+		{
+			printf( "%s is already a slim copy\n", demo.GetFileName().c_str() );
+			continue;
+		}
+
+		if( !demo.IsValidDemo() )
+		{
+			printf( "%s (%s)\n", demo.GetFileName().c_str(), demo.GetErrorString().c_str() );
+			++numFailed;
+			continue;
+		}
+
+		const std::string slimPath = GetSlimDemoPath( demo );
+
+		FragLines frags( -1 );
+
+		if( !DemoParser::ExportSlim( &demo, slimPath, &frags ) )
+		{
+			printf( "%s (failed to parse or write the slim copy)\n", demo.GetFileName().c_str() );
+			remove( slimPath.c_str() );
+			++numFailed;
+			continue;
+		}
+
+		// The copy must have the same frags
+		bool bSame = false;
+		int64 slimBytes = 0;
+
+		{
+			DemoFile slimDemo( slimPath );
+			FragLines slimFrags( -1 );
+			std::vector< ParsingWarning_t > slimWarnings;		// Only the frags are compared
+
+			if( slimDemo.IsValidDemo() )
+			{
+				slimBytes = slimDemo.GetFileSize();
+
+				try
+				{
+					DemoParser::ParseRequest( &slimDemo, &slimFrags, slimWarnings );
+					bSame = ( slimFrags.m_strText == frags.m_strText );
+				}
+				catch( ParsingError_t error )
+				{
+					bSame = error.at_end_of_demo && ( slimFrags.m_strText == frags.m_strText );
+				}
+			}
+		}
+
+		printf( "%s %.1f MB -> %.1f MB (%.0f%%)%s\n", demo.GetFileName().c_str(), demo.GetFileSize() / (1024.0 * 1024.0), slimBytes / (1024.0 * 1024.0),
+			100.0 * slimBytes / demo.GetFileSize(), bSame? "" : " - the frags of the slim copy are different!" );
+
+		if( !bSame )
+		{
+			// The slim demo has been closed, so the copy can be deleted
+			remove( slimPath.c_str() );
+			++numFailed;
+			continue;
+		}
+
+		totalBytes += demo.GetFileSize();
+		totalSlimBytes += slimBytes;
+	}
+
+	if( totalBytes > 0 )
+		printf( "\nSlim copies take %.1f MB instead of %.1f MB (%.0f%%)\n", totalSlimBytes / (1024.0 * 1024.0), totalBytes / (1024.0 * 1024.0), 100.0 * totalSlimBytes / totalBytes );
+
+	if( numFailed )
+		printf( "%d demos could not be slimmed\n", numFailed );
+
+	printf( "\n" );
+
+	return numFailed == 0;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Common.h"
+#include "DemoFile.h"
+#include "bitbuf.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define SLIM_DEMO_SUFFIX		"_slim"		// Slim copies are written beside the demo as "<demo>_slim.dem"
+
+/**
+ * Writes the slim copy of a demo while the parser goes through it
+ *
+ * The parser hands over every command it has parsed. Packets are rebuilt from the messages that the parser uses,
+ * the other commands are copied as they are or left out.
+ */
+class SlimDemoWriter
+{
+public:
+	SlimDemoWriter( void );
+
+	bool Open( const std::string &filename, const demoheader_t &header );
+	bool Finish( int stopTick );					///< Writes dem_stop and the final header, false if the file couldn't be written
+
+	void WriteCommand( const char *pData, int numBytes );	///< Copies a command as it is
+	void MarkSignonEnd( void );						///< Called before the sync tick is written
+
+	void BeginPacket( int maxBytes );				///< Starts collecting the messages of a packet that has maxBytes of data
+	void CopyMessage( bf_read &reader, int startBit );	///< Copies the message that the reader has just read from startBit
+	void CopyPacketEntities( bf_read &reader, int startBit, int numUpdates, int numDataBits );	///< Copies SVC_PacketEntities with only the first numUpdates entity updates
+	void EndPacket( const char *pHeader, int headerBytes );	///< Writes the packet command, header is the command up to the data size
+
+	int64 GetFileSize( void ) const { return m_iFileSize; }
+
+private:
+	std::ofstream			m_File;
+	demoheader_t			m_Header;
+	std::vector< uint32 >	m_PacketBuffer;
+	bf_write				m_Packet;				///< Messages of the packet being rebuilt
+	int64					m_iFileSize;
+};
+
+/**
+ * Writes a slim copy of every demo and checks that the copy has the same frags
+ * @return						false if a demo couldn't be slimmed or the frags of its copy were different
+ */
+bool SlimDemos( const std::vector< std::string > &demos );
\ No newline at end of file
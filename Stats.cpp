@@ -0,0 +1,210 @@
+#include "Stats.h"
+#include <chrono>
+#include <fstream>
+#include <format>
+#include <cstdlib>
+#include <new>
+
+thread_local ParsingStats_t *gpStats = nullptr;
+
+// Textual representation of the phases
+// These match the StatsPhase enum
+static const char *s_szPhaseNames[ NUM_STATS_PHASES ] = {
+	"Signon (incl. datatables)",
+	"Datatables",
+	"Packet entities",
+	"Game events",
+	"String tables",
+	"Post check",
+	"Frag finding" };
+
+// These match the demo command enum
+static const char *s_szCommandNames[ dem_lastcmd + 1 ] = {
+	"",
+	"dem_signon",
+	"dem_packet",
+	"dem_synctick",
+	"dem_consolecmd",
+	"dem_usercmd",
+	"dem_datatables",
+	"dem_stop" };
+
+// These match NetMessages and SvcMessages
+static const char *s_szMessageNames[ NumMessageTypes ] = {
+	"NET_NOP",
+	"NET_Disconnect",
+	"NET_File",
+	"NET_Tick",
+	"NET_StringCmd",
+	"NET_SetConVar",
+	"NET_SignOnState",
+	"SVC_Print",
+	"SVC_ServerInfo",
+	"SVC_SendTable",
+	"SVC_ClassInfo",
+	"SVC_SetPause",
+	"SVC_CreateStringTable",
+	"SVC_UpdateStringTable",
+	"SVC_VoiceInit",
+	"SVC_VoiceData",
+	"SVC_HLTV",
+	"SVC_Sounds",
+	"SVC_SetView",
+	"SVC_FixAngle",
+	"SVC_CrosshairAngle",
+	"SVC_BSPDecal",
+	"SVC_TerrainMod",
+	"SVC_UserMessage",
+	"SVC_EntityMessage",
+	"SVC_GameEvent",
+	"SVC_PacketEntities",
+	"SVC_TempEntities",
+	"SVC_Prefetch",
+	"SVC_Menu",
+	"SVC_GameEventList",
+	"SVC_GetCvarValue" };
+
+// =====================================================================================================================================================================
+
+int64 StatsTimestamp( void )
+{
+	using namespace std::chrono;
+
+	return duration_cast< nanoseconds >( steady_clock::now().time_since_epoch() ).count();
+}
+
+// =====================================================================================================================================================================
+
+ParsingStats_t::ParsingStats_t( void )
+{
+	Reset();
+}
+
+// =====================================================================================================================================================================
+
+void ParsingStats_t::Reset( void )
+{
+	total_ns = 0;
+	bytes_processed = 0;
+	entities_decoded = 0;
+	props_decoded = 0;
+	allocations = 0;
+	allocated_bytes = 0;
+	demos = 0;
+
+	for( int i = 0; i < NUM_STATS_PHASES; ++i )
+	{
+		phase_ns[ i ] = 0;
+		phase_calls[ i ] = 0;
+	}
+
+	for( int i = 0; i <= dem_lastcmd; ++i )
+		commands[ i ] = 0;
+
+	for( int i = 0; i < NumMessageTypes; ++i )
+		messages[ i ] = 0;
+}
+
+// =====================================================================================================================================================================
+
+void ParsingStats_t::Accumulate( const ParsingStats_t &other )
+{
+	total_ns += other.total_ns;
+	bytes_processed += other.bytes_processed;
+	entities_decoded += other.entities_decoded;
+	props_decoded += other.props_decoded;
+	allocations += other.allocations;
+	allocated_bytes += other.allocated_bytes;
+	demos += other.demos;
+
+	for( int i = 0; i < NUM_STATS_PHASES; ++i )
+	{
+		phase_ns[ i ] += other.phase_ns[ i ];
+		phase_calls[ i ] += other.phase_calls[ i ];
+	}
+
+	for( int i = 0; i <= dem_lastcmd; ++i )
+		commands[ i ] += other.commands[ i ];
+
+	for( int i = 0; i < NumMessageTypes; ++i )
+		messages[ i ] += other.messages[ i ];
+}
+
+// =====================================================================================================================================================================
+
+bool ParsingStats_t::WriteToFile( const std::string &filename, const std::string &title ) const
+{
+	std::ofstream file_output( filename );
+
+	if( !file_output.is_open() )
+		return false;
+
+	const double total_ms = total_ns / 1e6;
+	const double mb_per_sec = total_ns > 0 ? (bytes_processed / (1024.0 * 1024.0)) / (total_ns / 1e9) : 0.0;
+
+	file_output << title << "\n\n";
+
+	if( demos > 1 )
+		file_output << std::format( "Demos:                      {}\n", demos );
+
+	file_output << std::format( "Total time:                 {:.3f} ms\n", total_ms );
+	file_output << std::format( "Bytes processed:            {} ({:.2f} MB/s)\n", bytes_processed, mb_per_sec );
+	file_output << std::format( "Entities decoded:           {}\n", entities_decoded );
+	file_output << std::format( "Props decoded:              {}\n", props_decoded );
+	file_output << std::format( "Allocations:                {} ({} bytes)\n\n", allocations, allocated_bytes );
+
+	file_output << "PHASES (inclusive):\n";
+	for( int i = 0; i < NUM_STATS_PHASES; ++i )
+	{
+		file_output << std::format( "\t{:<28}{:>14.3f} ms {:>12} calls\n", s_szPhaseNames[ i ], phase_ns[ i ] / 1e6, phase_calls[ i ] );
+	}
+
+	file_output << "\nCOMMANDS:\n";
+	for( int i = dem_firstcmd; i <= dem_lastcmd; ++i )
+	{
+		if( commands[ i ] )
+			file_output << std::format( "\t{:<28}{:>14}\n", s_szCommandNames[ i ], commands[ i ] );
+	}
+
+	file_output << "\nMESSAGES:\n";
+	for( int i = 0; i < NumMessageTypes; ++i )
+	{
+		if( messages[ i ] )
+			file_output << std::format( "\t{:<28}{:>14}\n", s_szMessageNames[ i ], messages[ i ] );
+	}
+
+	file_output.close();
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+#ifdef CSSFF_ENABLE_STATS
+
+// Count heap allocations made by the thread that is parsing a demo
+
+void *operator new( size_t size )
+{
+	if( gpStats )
+	{
+		++gpStats->allocations;
+		gpStats->allocated_bytes += size;
+	}
+
+	void *p = malloc( size ? size : 1 );
+
+	if( !p )
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void operator delete( void *p ) noexcept
+{
+	free( p );
+}
+
+#endif
+
+// =====================================================================================================================================================================
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Common.h"
+#include "DemoFile.h"
+#include "Netmessages.h"
+#include <string>
+
+// Hot-path instrumentation
+//
+// Define CSSFF_ENABLE_STATS in the project's preprocessor definitions to collect per-phase timings and counters
+// while parsing. Stats are written to "<demo>_stats.txt" after each demo and aggregated into a batch stats file.
+// When the switch is not defined, all the STATS_* macros below compile to nothing.
+
+/**
+ * Parsing phases that are timed separately
+ * NOTE: phases can nest (for example string tables are also parsed during signon), so the times are inclusive
+ */
+enum StatsPhase
+{
+	PHASE_SIGNON = 0,			///< Everything before dem_synctick, including datatables
+	PHASE_DATATABLES,			///< Parsing and flattening dem_datatables
+	PHASE_PACKET_ENTITIES,		///< Decoding SVC_PacketEntities
+	PHASE_GAME_EVENTS,			///< Decoding SVC_GameEvent and the special event handlers
+	PHASE_STRING_TABLES,		///< SVC_CreateStringTable and SVC_UpdateStringTable
+	PHASE_POST_CHECK,			///< Flickshot and jumpshot post checks after each packet
+	PHASE_FRAG_FINDING,			///< FindRoundFrags
+
+	NUM_STATS_PHASES
+};
+
+/**
+ * Counters collected while parsing a demo (or a whole batch when accumulated)
+ */
+struct ParsingStats_t
+{
+	ParsingStats_t( void );
+
+	void Reset( void );
+	void Accumulate( const ParsingStats_t &other );
+
+	// Write the stats in a human-readable form, title is written on the first line
+	bool WriteToFile( const std::string &filename, const std::string &title ) const;
+
+	int64 total_ns;								///< Wall time from the start of parsing to the end
+	int64 phase_ns[ NUM_STATS_PHASES ];			///< Time spent in each phase
+	int64 phase_calls[ NUM_STATS_PHASES ];		///< How many times each phase was entered
+
+	int64 bytes_processed;						///< Demo bytes consumed by the parser
+	int64 commands[ dem_lastcmd + 1 ];			///< Demo commands per type
+	int64 messages[ NumMessageTypes ];			///< NET/SVC messages per type
+	int64 entities_decoded;						///< Entity updates that were actually decoded (players only)
+	int64 props_decoded;						///< Send props decoded for those entities
+	int64 allocations;							///< Heap allocations made while parsing
+	int64 allocated_bytes;						///< Bytes requested by those allocations
+
+	int demos;									///< Number of demos these stats were collected from
+};
+
+int64 StatsTimestamp( void );	///< Monotonic timestamp in nanoseconds
+
+// Stats of the demo currently being parsed on this thread (nullptr if none)
+extern thread_local ParsingStats_t *gpStats;
+
+#ifdef CSSFF_ENABLE_STATS
+
+/**
+ * Adds the time spent in the enclosing scope to a phase
+ */
+class StatsScopeTimer
+{
+public:
+	StatsScopeTimer( StatsPhase phase ) : m_phase( phase ), m_start( StatsTimestamp() ) {}
+
+	~StatsScopeTimer()
+	{
+		if( gpStats )
+		{
+			gpStats->phase_ns[ m_phase ] += StatsTimestamp() - m_start;
+			++gpStats->phase_calls[ m_phase ];
+		}
+	}
+
+private:
+	StatsPhase m_phase;
+	int64 m_start;
+};
+
+// Timer names include the line number, so a scope can time more than one phase
+#define STATS_CONCAT_INNER( a, b )		a##b
+#define STATS_CONCAT( a, b )			STATS_CONCAT_INNER( a, b )
+
+#define STATS_SCOPE( phase )			StatsScopeTimer STATS_CONCAT( statsScopeTimer, __LINE__ )( phase )
+#define STATS_ADD( counter, amount )	if( gpStats ) gpStats->counter += (amount); else void(0)
+#define STATS_SET( counter, value )		if( gpStats ) gpStats->counter = (value); else void(0)
+#define STATS_PHASE_SINCE( phase, start )\
+	if( gpStats ){\
+		gpStats->phase_ns[ phase ] += StatsTimestamp() - (start);\
+		++gpStats->phase_calls[ phase ];\
+	}\
+	else void(0)
+
+#else
+
+#define STATS_SCOPE( phase )
+#define STATS_ADD( counter, amount )
+#define STATS_SET( counter, value )
+#define STATS_PHASE_SINCE( phase, start )
+
+#endif
\ No newline at end of file
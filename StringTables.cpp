@@ -5,6 +5,7 @@
 #include <string>
 
 #define SUBSTRING_BITS		5
+#define HISTORY_SIZE		32		// # of previous entry strings that substrings can refer to
 
 // =====================================================================================================================================================================
 
@@ -26,17 +27,21 @@ void DemoParser::CreateStringTable( const char *name, int max_entries, int user_
 	m_StringTables[ m_iNumStringTables ].nUserDataSize = user_data_size;
 	m_StringTables[ m_iNumStringTables ].nUserDataSizeBits = user_data_size_bits;
 	m_StringTables[ m_iNumStringTables ].bUserDataFixedSize = user_data_fixed_size;
+	m_StringTables[ m_iNumStringTables ].bIsUserInfo = !strcmp( name, "userinfo" );
 	++m_iNumStringTables;
 }
 
 // =====================================================================================================================================================================
 
-void DemoParser::ParseStringTableUpdate( bf_read &reader, int entries, int max_entries, int user_data_size, int user_data_size_bits, bool user_data_fixed_size, bool is_user_info )
+void DemoParser::ParseUserInfoUpdate( bf_read &reader, int entries, const StringTableData_t &table )
 {
-	struct StringHistoryEntry
-	{
-		char string[ ( 1 << SUBSTRING_BITS ) ];
-	};
+	static_assert( sizeof( Player ) <= MAX_USERDATA_SIZE, "user data buffer is read as a Player" );
+
+	const int max_entries = table.nMaxEntries;
+
+	// Ring of the last HISTORY_SIZE entry strings, substring index 0 is the oldest one
+	char history[ HISTORY_SIZE ][ ( 1 << SUBSTRING_BITS ) ];
+	int historyCount = 0;
 
 	int lastEntry = -1;
 	int lastDictionaryIndex = -1;
@@ -49,8 +54,6 @@ void DemoParser::ParseStringTableUpdate( bf_read &reader, int entries, int max_e
 	if( ( 1 << nEntryBits ) != max_entries )
 		throw ParsingError_t( "string table size not a power of two" );
 
-	std::vector< StringHistoryEntry > history;
-
 	for( int i = 0; i < entries; i++ )
 	{
 		int entryIndex = lastEntry + 1;
@@ -64,7 +67,7 @@ void DemoParser::ParseStringTableUpdate( bf_read &reader, int entries, int max_e
 
 		if( entryIndex < 0 || entryIndex >= max_entries )
 		{
-			throw ParsingError_t( "bogus string index in ParseStringTableUpdate" );
+			throw ParsingError_t( "bogus string index in ParseUserInfoUpdate" );
 		}
 
 		const char *pEntry = nullptr;
@@ -78,13 +81,15 @@ void DemoParser::ParseStringTableUpdate( bf_read &reader, int entries, int max_e
 
 			if( substringcheck )
 			{
+				const int historySize = ( historyCount < HISTORY_SIZE )? historyCount : HISTORY_SIZE;
+
 				int index = reader.ReadUBitLong( 5 );
-				if( size_t( index ) >= history.size() )
+				if( index >= historySize )
 				{
-					throw ParsingError_t( "invalid string history index in ParseStringTableUpdate" );
+					throw ParsingError_t( "invalid string history index in ParseUserInfoUpdate" );
 				}
 				int bytestocopy = reader.ReadUBitLong( SUBSTRING_BITS );
-				strncpy_s( entry, history[ index ].string, bytestocopy + 1 );
+				strncpy_s( entry, history[ ( historyCount - historySize + index ) % HISTORY_SIZE ], bytestocopy + 1 );
 				reader.ReadString( substr, sizeof( substr ) );
 				strcat_s( entry, substr );
 			}
@@ -97,34 +102,37 @@ void DemoParser::ParseStringTableUpdate( bf_read &reader, int entries, int max_e
 		}
 
 		unsigned char tempbuf[ MAX_USERDATA_SIZE ];
-		memset( tempbuf, 0, sizeof( tempbuf ) );
 		const void *pUserData = nullptr;
 		int nBytes = 0;
 
 		// Read in the user data
 		if( reader.ReadOneBit() )
 		{
-			if( user_data_fixed_size )
+			if( table.bUserDataFixedSize )
 			{
 				// Don't need to read length - it's fixed length and the length was networked down already
-				nBytes = user_data_size;
-				if( nBytes <= 0 )
-					throw ParsingError_t( "fixed user data size <= 0 in ParseStringTableUpdate" );
+				nBytes = table.nUserDataSize;
+				if( nBytes <= 0 || nBytes > sizeof( tempbuf ) )
+					throw ParsingError_t( "bad fixed user data size in ParseUserInfoUpdate" );
 
 				tempbuf[ nBytes - 1 ] = 0; // Be safe, clear last byte
-				reader.ReadBits( tempbuf, user_data_size_bits );
+				reader.ReadBits( tempbuf, table.nUserDataSizeBits );
 			}
 			else
 			{
 				nBytes = reader.ReadUBitLong( MAX_USERDATA_BITS );
 				if( nBytes > sizeof( tempbuf ) )
 				{
-					throw ParsingError_t( "user data too large in ParseStringTableUpdate" );
+					throw ParsingError_t( "user data too large in ParseUserInfoUpdate" );
 				}
 
 				reader.ReadBytes( tempbuf, nBytes );
 			}
 
+			// Only the part that is read as a Player has to be cleared
+			if( nBytes < sizeof( Player ) )
+				memset( tempbuf + nBytes, 0, sizeof( Player ) - nBytes );
+
 			pUserData = tempbuf;
 		}
 
@@ -137,8 +145,8 @@ void DemoParser::ParseStringTableUpdate( bf_read &reader, int entries, int max_e
 		std::cout << "       L " << entryIndex << ". " << pEntry << " (" << nBytes << " bytes) " << pUserData << std::endl;
 #endif
 
-		// Add/update players if this is the userinfo string table
-		if( is_user_info && pUserData )
+		// Add/update players
+		if( pUserData )
 		{
 			Player player( *(const Player *)pUserData );
 			player.entityIndex = entryIndex + 1;
@@ -187,14 +195,8 @@ void DemoParser::ParseStringTableUpdate( bf_read &reader, int entries, int max_e
 			}
 		}
 
-		if( history.size() > 31 )
-		{
-			history.erase( history.begin() );
-		}
-
-		StringHistoryEntry she;
-		strncpy_s( she.string, pEntry, sizeof( she.string ) - 1 );
-		history.push_back( she );
+		strncpy_s( history[ historyCount % HISTORY_SIZE ], pEntry, sizeof( history[ 0 ] ) - 1 );
+		++historyCount;
 	}
 }
 
@@ -9,4 +9,5 @@ struct StringTableData_t
 	int		nUserDataSize;
 	int		nUserDataSizeBits;
 	bool	bUserDataFixedSize;
+	bool	bIsUserInfo;			///< Only the userinfo table is parsed, the other tables are skipped
 };
\ No newline at end of file
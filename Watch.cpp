@@ -0,0 +1,523 @@
+#include "Watch.h"
+#include "DemoFile.h"
+#include "DemoParser.h"
+#include "Errors.h"
+#include "FragOutput.h"
+#include "Settings.h"
+#include <Windows.h>
+#include <conio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+extern std::string g_ProgramDirectory;
+
+// Watch mode
+//
+// A watcher thread blocks in ReadDirectoryChangesW and marks the demos that were added, renamed or written to as
+// pending. The main thread checks the pending demos a few times per second and queues the complete ones for a pool of
+// parser threads. The journal has one line per processed demo (path relative to the watched directory, file size and
+// result), so a demo is only parsed again if it is replaced by a file of a different size.
+
+typedef std::chrono::steady_clock WatchClock;
+
+// =====================================================================================================================================================================
+/**
+ * Collects the frag text of a demo for every settings profile
+ */
+class WatchFragText : public FragSink
+{
+public:
+	WatchFragText( void ) : m_Text( Settings()->GetNumProfiles() ), m_NumFrags( Settings()->GetNumProfiles(), 0 ) {}
+
+	virtual void OnFrag( const Frag &frag, int profile )
+	{
+		frag.GetStringRepresentation( m_Text[ profile ] );
+		++m_NumFrags[ profile ];
+	}
+
+	std::vector< std::string >	m_Text;
+	std::vector< int >			m_NumFrags;
+};
+
+// =====================================================================================================================================================================
+
+struct WatchedDemo_t
+{
+	std::string			path;				///< Relative to the watched directory
+	int64				fileSize;
+};
+
+class DemoWatcher
+{
+public:
+	DemoWatcher( const std::string &directory );
+
+	bool Run( void );
+
+private:
+	void LoadJournal( void );
+	void FindExistingDemos( const std::string &relativeDir );
+	void WatchThread( void );
+	void WorkerThread( void );
+	void QueueCompleteDemos( void );
+	bool IsDemoComplete( const std::string &path, int64 &fileSize ) const;
+	void ParseDemo( const WatchedDemo_t &demo );
+	void WriteResult( const WatchedDemo_t &demo, const WatchFragText &frags, const std::vector< ParsingWarning_t > &warnings, const std::string &result );
+
+	static std::string GetJournalKey( const std::string &path, int64 fileSize );
+
+	std::string					m_strDirectory;
+	std::string					m_strOutputDirectory;
+	HANDLE						m_hDirectory;
+	std::atomic< bool >			m_bWatcherStopping;
+	std::atomic< bool >			m_bWatcherDone;
+
+	// Demos that were changed, guarded by m_PendingMutex
+	std::mutex					m_PendingMutex;
+	std::map< std::string, WatchClock::time_point > m_Pending;	///< Relative path -> time of the last change
+
+	// Demos for the parser threads, guarded by m_QueueMutex
+	std::mutex					m_QueueMutex;
+	std::condition_variable		m_cvQueue;
+	std::deque< WatchedDemo_t >	m_Queue;
+	bool						m_bStopping;
+
+	// Guarded by m_OutputMutex
+	std::mutex					m_OutputMutex;
+	std::set< std::string >		m_Processed;		///< Journal keys of the processed and queued demos
+	std::ofstream				m_Journal;
+};
+
+// =====================================================================================================================================================================
+
+DemoWatcher::DemoWatcher( const std::string &directory )
+{
+	m_strDirectory = directory;
+	m_strOutputDirectory = Settings()->WriteOutputToDemoDirectory()? directory : g_ProgramDirectory;
+	m_hDirectory = INVALID_HANDLE_VALUE;
+	m_bWatcherStopping = false;
+	m_bWatcherDone = false;
+	m_bStopping = false;
+}
+
+// =====================================================================================================================================================================
+
+bool DemoWatcher::Run( void )
+{
+	m_hDirectory = CreateFileA( m_strDirectory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr );
+
+	if( m_hDirectory == INVALID_HANDLE_VALUE )
+	{
+		printf( "%s: Failed to open folder %s for watching\n", CSSFF_NAME, m_strDirectory.c_str() );
+		return false;
+	}
+
+	LoadJournal();
+
+	m_Journal.open( m_strDirectory + WATCH_JOURNAL_NAME, std::ios::app );
+
+	if( !m_Journal.is_open() )
+	{
+		printf( "%s: Failed to open the watch journal %s\n", CSSFF_NAME, WATCH_JOURNAL_NAME );
+		CloseHandle( m_hDirectory );
+		return false;
+	}
+
+	// Demos that were added while the watch wasn't running
+	FindExistingDemos( "" );
+
+	std::thread watcher( &DemoWatcher::WatchThread, this );
+
+	const int numWorkers = std::max( 1, (int)std::thread::hardware_concurrency() );
+	std::vector< std::thread > workers;
+
+	for( int i = 0; i < numWorkers; ++i )
+		workers.emplace_back( &DemoWatcher::WorkerThread, this );
+
+	printf( "%s: Watching %s for new demos with %d parser threads\n", CSSFF_NAME, m_strDirectory.c_str(), numWorkers );
+	printf( "Press 'Q' to stop watching\n\n" );
+
+	bool bQuit = false;
+
+	while( !bQuit )
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( WATCH_POLL_MS ) );
+
+		while( _kbhit() )
+		{
+			if( toupper( _getch() ) == 'Q' )
+				bQuit = true;
+		}
+
+		QueueCompleteDemos();
+	}
+
+	printf( "Finishing the demos that are being parsed...\n" );
+
+	// Wake the watcher thread up from ReadDirectoryChangesW (it may not be waiting in it yet)
+	m_bWatcherStopping = true;
+
+	while( !m_bWatcherDone )
+	{
+		CancelIoEx( m_hDirectory, nullptr );
+		std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+	}
+
+	watcher.join();
+
+	// Queued demos that haven't been started are left for the next watch, they aren't in the journal yet
+	{
+		std::lock_guard< std::mutex > lock( m_QueueMutex );
+		m_bStopping = true;
+	}
+
+	m_cvQueue.notify_all();
+
+	for( size_t i = 0; i < workers.size(); ++i )
+		workers[ i ].join();
+
+	CloseHandle( m_hDirectory );
+
+	printf( "%s: Stopped watching\n\n", CSSFF_NAME );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+std::string DemoWatcher::GetJournalKey( const std::string &path, int64 fileSize )
+{
+	return path + "\t" + std::to_string( fileSize );
+}
+
+// =====================================================================================================================================================================
+
+void DemoWatcher::LoadJournal( void )
+{
+	std::ifstream journal( m_strDirectory + WATCH_JOURNAL_NAME );
+	std::string line;
+
+	// <path> <file size> <result>
+	while( std::getline( journal, line ) )
+	{
+		size_t end = line.rfind( '\t' );
+
+		if( end != std::string::npos )
+			m_Processed.insert( line.substr( 0, end ) );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void DemoWatcher::FindExistingDemos( const std::string &relativeDir )
+{
+	std::string strSearchPath = m_strDirectory + relativeDir + "*";
+
+	WIN32_FIND_DATAA data;
+
+	HANDLE hFile = FindFirstFileA( strSearchPath.c_str(), &data );
+
+	if( hFile == INVALID_HANDLE_VALUE )
+		return;
+
+	std::vector< std::string > subfolders;
+
+	do
+	{
+		if( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+		{
+			if( strcmp( data.cFileName, "." ) && strcmp( data.cFileName, ".." ) )
+				subfolders.emplace_back( relativeDir + data.cFileName + "\\" );
+		}
+		else if( IsDemoFile( data.cFileName ) )
+		{
+			// These don't have to settle, but they still have to be complete
+			std::lock_guard< std::mutex > lock( m_PendingMutex );
+			m_Pending.emplace( relativeDir + data.cFileName, WatchClock::time_point() );
+		}
+	}
+	while( FindNextFileA( hFile, &data ) != 0 );
+
+	FindClose( hFile );
+
+	if( Settings()->SearchSubfolders() )
+	{
+		for( size_t i = 0; i < subfolders.size(); ++i )
+			FindExistingDemos( subfolders[ i ] );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void DemoWatcher::WatchThread( void )
+{
+	// Notifications are DWORD aligned
+	std::vector< DWORD > buffer( 16 * 1024 );
+
+	const DWORD notifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+	while( !m_bWatcherStopping )
+	{
+		DWORD bytesReturned = 0;
+
+		// Fails when cancelled
+		if( !ReadDirectoryChangesW( m_hDirectory, buffer.data(), (DWORD)( buffer.size() * sizeof( DWORD ) ), Settings()->SearchSubfolders(), notifyFilter, &bytesReturned, nullptr, nullptr ) )
+			break;
+
+		// Too many changes for the buffer, so look through the folder again
+		if( bytesReturned == 0 )
+		{
+			FindExistingDemos( "" );
+			continue;
+		}
+
+		const WatchClock::time_point now = WatchClock::now();
+		const byte *pEntry = (const byte *)buffer.data();
+
+		std::lock_guard< std::mutex > lock( m_PendingMutex );
+
+		while( true )
+		{
+			const FILE_NOTIFY_INFORMATION *pInfo = (const FILE_NOTIFY_INFORMATION *)pEntry;
+
+			char szName[ MAX_PATH ];
+			int length = WideCharToMultiByte( CP_ACP, 0, pInfo->FileName, pInfo->FileNameLength / sizeof( WCHAR ), szName, sizeof( szName ) - 1, nullptr, nullptr );
+
+			if( length > 0 )
+			{
+				szName[ length ] = 0;
+
+				if( IsDemoFile( szName ) )
+				{
+					if( pInfo->Action == FILE_ACTION_REMOVED || pInfo->Action == FILE_ACTION_RENAMED_OLD_NAME )
+						m_Pending.erase( szName );
+					else
+						m_Pending[ szName ] = now;
+				}
+			}
+
+			if( !pInfo->NextEntryOffset )
+				break;
+
+			pEntry += pInfo->NextEntryOffset;
+		}
+	}
+
+	m_bWatcherDone = true;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Opening fails with a sharing violation while the demo is still open for writing
+ */
+bool DemoWatcher::IsDemoComplete( const std::string &path, int64 &fileSize ) const
+{
+	HANDLE hFile = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+	if( hFile == INVALID_HANDLE_VALUE )
+		return false;
+
+	LARGE_INTEGER size;
+	const bool bGotSize = GetFileSizeEx( hFile, &size ) != 0;
+
+	CloseHandle( hFile );
+
+	if( !bGotSize )
+		return false;
+
+	fileSize = size.QuadPart;
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+void DemoWatcher::QueueCompleteDemos( void )
+{
+	const WatchClock::time_point now = WatchClock::now();
+
+	std::vector< std::pair< std::string, WatchClock::time_point > > settled;
+
+	{
+		std::lock_guard< std::mutex > lock( m_PendingMutex );
+
+		for( auto it = m_Pending.begin(); it != m_Pending.end(); ++it )
+		{
+			if( now - it->second >= std::chrono::milliseconds( WATCH_SETTLE_MS ) )
+				settled.push_back( *it );
+		}
+	}
+
+	for( size_t i = 0; i < settled.size(); ++i )
+	{
+		const std::string &path = settled[ i ].first;
+		const std::string fullPath = m_strDirectory + path;
+		int64 fileSize = 0;
+
+		const bool bExists = GetFileAttributesA( fullPath.c_str() ) != INVALID_FILE_ATTRIBUTES;
+
+		// Incomplete demos stay pending and are checked again on the next poll
+		if( bExists && !IsDemoComplete( fullPath, fileSize ) )
+			continue;
+
+		{
+			std::lock_guard< std::mutex > lock( m_PendingMutex );
+
+			// Changed again while it was being checked
+			auto it = m_Pending.find( path );
+			if( it == m_Pending.end() || it->second != settled[ i ].second )
+				continue;
+
+			m_Pending.erase( it );
+		}
+
+		if( !bExists )
+			continue;
+
+		{
+			std::lock_guard< std::mutex > lock( m_OutputMutex );
+
+			if( !m_Processed.insert( GetJournalKey( path, fileSize ) ).second )
+				continue;
+		}
+
+		{
+			std::lock_guard< std::mutex > lock( m_QueueMutex );
+			m_Queue.push_back( WatchedDemo_t{ path, fileSize } );
+		}
+
+		m_cvQueue.notify_one();
+	}
+}
+
+// =====================================================================================================================================================================
+
+void DemoWatcher::WorkerThread( void )
+{
+	while( true )
+	{
+		WatchedDemo_t demo;
+
+		{
+			std::unique_lock< std::mutex > lock( m_QueueMutex );
+			m_cvQueue.wait( lock, [this]{ return m_bStopping || !m_Queue.empty(); } );
+
+			if( m_bStopping )
+				return;
+
+			demo = std::move( m_Queue.front() );
+			m_Queue.pop_front();
+		}
+
+		ParseDemo( demo );
+	}
+}
+
+// =====================================================================================================================================================================
+
+void DemoWatcher::ParseDemo( const WatchedDemo_t &demo )
+{
+	DemoFile file( m_strDirectory + demo.path );
+	WatchFragText frags;
+	std::vector< ParsingWarning_t > warnings;
+	std::string result;
+
+	if( !file.IsValidDemo() )
+	{
+		result = "failed (" + file.GetErrorString() + ")";
+	}
+	else
+	{
+		try
+		{
+			DemoParser::ParseRequest( &file, &frags, warnings );
+			result = "ok";
+		}
+		catch( ParsingError_t error )
+		{
+			// Errors at the end of a demo are ignored, since they often happen on map change etc.
+			if( error.at_end_of_demo )
+				result = "ok";
+			else
+				result = std::format( "failed ({} on tick {})", error.error_msg, error.tick );
+		}
+		catch( ... )
+		{
+			result = "failed (unexpected error)";
+		}
+	}
+
+	WriteResult( demo, frags, warnings, result );
+}
+
+// =====================================================================================================================================================================
+
+void DemoWatcher::WriteResult( const WatchedDemo_t &demo, const WatchFragText &frags, const std::vector< ParsingWarning_t > &warnings, const std::string &result )
+{
+	std::lock_guard< std::mutex > lock( m_OutputMutex );
+
+	// The output rolls over to a new file every day
+	tm timeinfo;
+	time_t rawtime;
+	time( &rawtime );
+	localtime_s( &timeinfo, &rawtime );
+
+	const int numProfiles = Settings()->GetNumProfiles();
+	std::string fragCounts;
+
+	for( int profile = 0; profile < numProfiles; ++profile )
+	{
+		fragCounts += ( profile? "/" : "" ) + std::to_string( frags.m_NumFrags[ profile ] );
+
+		if( !frags.m_NumFrags[ profile ] )
+			continue;
+
+		char szOutputFile[ MAX_PATH ];
+		strftime( szOutputFile, sizeof(szOutputFile), "_cssff_watch_%y-%m-%d", &timeinfo );
+
+		if( numProfiles > 1 )
+		{
+			strcat_s( szOutputFile, sizeof(szOutputFile), "_" );
+			strcat_s( szOutputFile, sizeof(szOutputFile), Settings()->GetProfileName( profile ).c_str() );
+		}
+
+		strcat_s( szOutputFile, sizeof(szOutputFile), ".txt" );
+
+		std::ofstream output( m_strOutputDirectory + szOutputFile, std::ios::app );
+		output << "========== " << demo.path << " ==========\n\n" << frags.m_Text[ profile ];
+	}
+
+	// Journaled after the output, so a crash in between parses the demo again instead of losing its frags
+	m_Journal << GetJournalKey( demo.path, demo.fileSize ) << '\t' << result << '\n';
+	m_Journal.flush();
+
+	if( result == "ok" )
+		printf( "%s: %s frags\n", demo.path.c_str(), fragCounts.c_str() );
+	else
+		printf( "%s: %s\n", demo.path.c_str(), result.c_str() );
+
+	for( size_t i = 0; i < warnings.size(); ++i )
+	{
+		std::string warning;
+		warnings[ i ].GetString( warning );
+		printf( "%s", warning.c_str() );
+	}
+}
+
+// =====================================================================================================================================================================
+
+bool WatchDirectory( const std::string &directory )
+{
+	DemoWatcher watcher( directory );
+
+	return watcher.Run();
+}
\ No newline at end of file
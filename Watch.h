@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Common.h"
+#include <string>
+
+#define WATCH_JOURNAL_NAME		"_cssff_watch_journal.txt"	// Demos that have been processed, in the watched directory
+#define WATCH_SETTLE_MS			2000						// How long a demo has to stay unchanged before it is parsed
+#define WATCH_POLL_MS			250							// How often the pending demos and the keyboard are checked
+
+/**
+ * Watch mode - parses the demos that appear in the directory until 'Q' is pressed
+ *
+ * A demo is parsed once it hasn't changed for WATCH_SETTLE_MS and it can be opened without sharing it for writing,
+ * which means the recorder or copier has closed it. The frags are appended to a daily output file, and every
+ * processed demo is added to a journal, so that a restarted watch only parses the demos it hasn't seen yet.
+ * @param directory				path to the directory (with '\' in the end)
+ */
+bool WatchDirectory( const std::string &directory );
\ No newline at end of file
@@ -1,64 +1,11 @@
 #include "Weapons.h"
+#include "Common.h"
 #include <string>
 #include <map>
 #include <assert.h>
 
 // =====================================================================================================================================================================
 
-CSWeaponCategory GetWeaponCategory( CSWeaponID weapon )
-{
-	switch( weapon )
-	{
-		default: return CATEGORY_NONE;
-
-		case WEAPON_KNIFE:
-			return CATEGORY_KNIFE;
-
-		case WEAPON_GLOCK:
-		case WEAPON_USP:
-		case WEAPON_P228:
-		case WEAPON_DEAGLE:
-		case WEAPON_FIVESEVEN:
-		case WEAPON_ELITE:
-			return CATEGORY_PISTOL;
-
-		case WEAPON_M3:
-		case WEAPON_XM1014:
-			return CATEGORY_SHOTGUN;
-
-		case WEAPON_TMP:
-		case WEAPON_MAC10:
-		case WEAPON_MP5NAVY:
-		case WEAPON_UMP45:
-		case WEAPON_P90:
-			return CATEGORY_SMG;
-
-		case WEAPON_FAMAS:
-		case WEAPON_GALIL:
-		case WEAPON_M4A1:
-		case WEAPON_AK47:
-		case WEAPON_AUG:
-		case WEAPON_SG552:
-		case WEAPON_M249:
-			return CATEGORY_RIFLE;
-
-		case WEAPON_SCOUT:
-		case WEAPON_AWP:
-			return CATEGORY_SNIPER;
-
-		case WEAPON_SG550:
-		case WEAPON_G3SG1:
-			return CATEGORY_AUTOSNIPER;
-
-		case WEAPON_HEGRENADE:
-		case WEAPON_FLASHBANG:
-		case WEAPON_SMOKEGRENADE:
-			return CATEGORY_GRENADE;
-	}
-}
-
-// =====================================================================================================================================================================
-
 CSWeaponCategory GetWeaponCategory( CSWeaponID *pWeapons, int num_weapons )
 {
 	// This function is a bit hacky in that it relies on the fact that num_weapons == number of kills,
@@ -95,13 +42,77 @@ CSWeaponCategory GetWeaponCategory( CSWeaponID *pWeapons, int num_weapons )
 
 // =====================================================================================================================================================================
 
+// Weapon names are resolved with a perfect hash table that is generated at compile time from s_WeaponAliasInfo.
+// The seed is searched for until every alias gets its own slot, so a lookup is a single hash and compare.
+
+#define WEAPON_HASH_TABLE_BITS		8
+#define WEAPON_HASH_TABLE_SIZE		(1 << WEAPON_HASH_TABLE_BITS)
+
+struct weapon_hash_table_t
+{
+	uint32 seed;
+	signed char weaponIDs[ WEAPON_HASH_TABLE_SIZE ];	///< -1 for empty slots
+};
+
+// Case insensitive FNV-1a, the slot is taken from the top bits
+constexpr uint32 GetWeaponHashSlot( const char *alias, uint32 seed )
+{
+	uint32 hash = 2166136261u ^ seed;
+
+	for( ; *alias; ++alias )
+	{
+		char c = *alias;
+
+		if( c >= 'A' && c <= 'Z' )
+			c += 'a' - 'A';
+
+		hash = (hash ^ (unsigned char)c) * 16777619u;
+	}
+
+	return hash >> (32 - WEAPON_HASH_TABLE_BITS);
+}
+
+constexpr weapon_hash_table_t BuildWeaponHashTable( void )
+{
+	weapon_hash_table_t table = {};
+
+	for( uint32 seed = 0; ; ++seed )
+	{
+		table.seed = seed;
+
+		for( int i = 0; i < WEAPON_HASH_TABLE_SIZE; ++i )
+			table.weaponIDs[ i ] = -1;
+
+		bool bCollision = false;
+
+		for( int i = 0; i < WEAPON_MAX && !bCollision; ++i )
+		{
+			signed char &slot = table.weaponIDs[ GetWeaponHashSlot( s_WeaponAliasInfo[ i ], seed ) ];
+
+			if( slot != -1 )
+				bCollision = true;
+			else
+				slot = (signed char)i;
+		}
+
+		if( !bCollision )
+			return table;
+	}
+}
+
+constexpr weapon_hash_table_t s_WeaponHashTable = BuildWeaponHashTable();
+
+static_assert( s_WeaponHashTable.weaponIDs[ GetWeaponHashSlot( "smokegrenade_projectile", s_WeaponHashTable.seed ) ] == WEAPON_SMOKEGRENADE, "weapon hash table is broken" );
+
 CSWeaponID AliasToWeaponID( const char *alias )
 {
 	if( alias )
 	{
-		for( int i = 0; s_WeaponAliasInfo[ i ] != nullptr; ++i )
-			if( !_stricmp( s_WeaponAliasInfo[i], alias ) )
-				return (CSWeaponID)i;
+		int weaponID = s_WeaponHashTable.weaponIDs[ GetWeaponHashSlot( alias, s_WeaponHashTable.seed ) ];
+
+		// Names that aren't weapons can still land in a used slot
+		if( weaponID != -1 && !_stricmp( s_WeaponAliasInfo[ weaponID ], alias ) )
+			return (CSWeaponID)weaponID;
 	}
 
 	assert( false );
@@ -135,41 +146,4 @@ const char *WeaponIDToAlias( CSWeaponID weaponID )
 	return nullptr;
 }
 
-// =====================================================================================================================================================================
-
-bool WeaponIsSniper( const char *szWeaponAlias )
-{
-	CSWeaponID weaponID = AliasToWeaponID( szWeaponAlias );
-
-	switch( weaponID )
-	{
-		case WEAPON_AWP:
-		case WEAPON_SCOUT:
-		case WEAPON_SG550:
-		case WEAPON_G3SG1:
-			return true;
-	}
-
-	return false;
-}
-
-// =====================================================================================================================================================================
-
-bool WeaponUsesBullets( const char *szWeaponAlias )
-{
-	CSWeaponID weaponID = AliasToWeaponID( szWeaponAlias );
-
-	switch( weaponID )
-	{
-		case WEAPON_HEGRENADE:
-		case WEAPON_FLASHBANG:
-		case WEAPON_SMOKEGRENADE:
-		case WEAPON_KNIFE:
-		case WEAPON_C4:
-			return false;
-	}
-
-	return true;
-}
-
 // =====================================================================================================================================================================
\ No newline at end of file
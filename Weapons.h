@@ -1,7 +1,7 @@
 #pragma once
 
 // This matches CSWeaponID
-static const char * s_WeaponAliasInfo[] = 
+constexpr const char *s_WeaponAliasInfo[] = 
 {
 	"NONE",		// 0 WEAPON_NONE
 	"P228",		// 1 WEAPON_P228
@@ -99,14 +99,76 @@ enum CSWeaponCategory
 
 #define CATEGORY_GENERAL	CATEGORY_NONE
 
-CSWeaponCategory GetWeaponCategory( CSWeaponID weapon );
+static_assert( sizeof(s_WeaponAliasInfo) / sizeof(s_WeaponAliasInfo[0]) == WEAPON_MAX, "s_WeaponAliasInfo doesn't match CSWeaponID" );
 
-CSWeaponCategory GetWeaponCategory( CSWeaponID *pWeapons, int num_weapons );
+// Weapon trait flags
+#define FL_WEAPON_SNIPER		(1<<0)	// Can zoom in, so kills can be noscopes
+#define FL_WEAPON_BULLETS		(1<<1)	// Kills with bullets (can penetrate, gets checked for flickshots)
+
+struct weapon_info_t
+{
+	CSWeaponCategory category;
+	unsigned char flags;
+};
+
+// This matches CSWeaponID
+constexpr weapon_info_t s_WeaponInfo[] =
+{
+	{ CATEGORY_NONE,		FL_WEAPON_BULLETS },						// WEAPON_NONE
+	{ CATEGORY_PISTOL,		FL_WEAPON_BULLETS },						// WEAPON_P228
+	{ CATEGORY_PISTOL,		FL_WEAPON_BULLETS },						// WEAPON_GLOCK
+	{ CATEGORY_SNIPER,		FL_WEAPON_BULLETS | FL_WEAPON_SNIPER },		// WEAPON_SCOUT
+	{ CATEGORY_SHOTGUN,		FL_WEAPON_BULLETS },						// WEAPON_XM1014
+	{ CATEGORY_NONE,		0 },										// WEAPON_C4
+	{ CATEGORY_SMG,			FL_WEAPON_BULLETS },						// WEAPON_MAC10
+	{ CATEGORY_RIFLE,		FL_WEAPON_BULLETS },						// WEAPON_AUG
+	{ CATEGORY_PISTOL,		FL_WEAPON_BULLETS },						// WEAPON_ELITE
+	{ CATEGORY_PISTOL,		FL_WEAPON_BULLETS },						// WEAPON_FIVESEVEN
+	{ CATEGORY_SMG,			FL_WEAPON_BULLETS },						// WEAPON_UMP45
+	{ CATEGORY_AUTOSNIPER,	FL_WEAPON_BULLETS | FL_WEAPON_SNIPER },		// WEAPON_SG550
+
+	{ CATEGORY_RIFLE,		FL_WEAPON_BULLETS },						// WEAPON_GALIL
+	{ CATEGORY_RIFLE,		FL_WEAPON_BULLETS },						// WEAPON_FAMAS
+	{ CATEGORY_PISTOL,		FL_WEAPON_BULLETS },						// WEAPON_USP
+	{ CATEGORY_SNIPER,		FL_WEAPON_BULLETS | FL_WEAPON_SNIPER },		// WEAPON_AWP
+	{ CATEGORY_SMG,			FL_WEAPON_BULLETS },						// WEAPON_MP5NAVY
+	{ CATEGORY_RIFLE,		FL_WEAPON_BULLETS },						// WEAPON_M249
+	{ CATEGORY_SHOTGUN,		FL_WEAPON_BULLETS },						// WEAPON_M3
+	{ CATEGORY_RIFLE,		FL_WEAPON_BULLETS },						// WEAPON_M4A1
+	{ CATEGORY_SMG,			FL_WEAPON_BULLETS },						// WEAPON_TMP
+	{ CATEGORY_AUTOSNIPER,	FL_WEAPON_BULLETS | FL_WEAPON_SNIPER },		// WEAPON_G3SG1
+	{ CATEGORY_PISTOL,		FL_WEAPON_BULLETS },						// WEAPON_DEAGLE
+	{ CATEGORY_RIFLE,		FL_WEAPON_BULLETS },						// WEAPON_SG552
+	{ CATEGORY_RIFLE,		FL_WEAPON_BULLETS },						// WEAPON_AK47
+	{ CATEGORY_KNIFE,		0 },										// WEAPON_KNIFE
+	{ CATEGORY_SMG,			FL_WEAPON_BULLETS },						// WEAPON_P90
+
+	{ CATEGORY_NONE,		FL_WEAPON_BULLETS },						// WEAPON_WORLD
+
+	{ CATEGORY_GRENADE,		0 },										// WEAPON_HEGRENADE
+	{ CATEGORY_GRENADE,		0 },										// WEAPON_FLASHBANG
+	{ CATEGORY_GRENADE,		0 }											// WEAPON_SMOKEGRENADE
+};
 
-CSWeaponID AliasToWeaponID( const char *alias );
+static_assert( sizeof(s_WeaponInfo) / sizeof(s_WeaponInfo[0]) == WEAPON_MAX, "s_WeaponInfo doesn't match CSWeaponID" );
 
-const char *WeaponIDToAlias( CSWeaponID weaponID );
+constexpr CSWeaponCategory GetWeaponCategory( CSWeaponID weapon )
+{
+	return ( weapon >= WEAPON_NONE && weapon < WEAPON_MAX )? s_WeaponInfo[ weapon ].category : CATEGORY_NONE;
+}
+
+constexpr bool WeaponIsSniper( CSWeaponID weapon )
+{
+	return ( weapon >= WEAPON_NONE && weapon < WEAPON_MAX ) && ( s_WeaponInfo[ weapon ].flags & FL_WEAPON_SNIPER );
+}
+
+constexpr bool WeaponUsesBullets( CSWeaponID weapon )
+{
+	return !( weapon >= WEAPON_NONE && weapon < WEAPON_MAX ) || ( s_WeaponInfo[ weapon ].flags & FL_WEAPON_BULLETS );
+}
+
+CSWeaponCategory GetWeaponCategory( CSWeaponID *pWeapons, int num_weapons );
 
-bool WeaponIsSniper( const char *szWeaponAlias );
+CSWeaponID AliasToWeaponID( const char *alias );		///< Resolves the weapon name of a player_death event, call once per kill
 
-bool WeaponUsesBullets( const char *szWeaponAlias );
\ No newline at end of file
+const char *WeaponIDToAlias( CSWeaponID weaponID );
\ No newline at end of file
@@ -0,0 +1,1142 @@
+#include "Zstd.h"
+#include <string.h>
+
+// Zstandard decompression (RFC 8878)
+//
+// Frames are decoded block by block straight into the caller's buffer, which is also the window that the matches are
+// copied from. The literals of a block are decoded into a buffer of the decoder first (unless they are stored raw), the
+// sequences then copy them to the output between the matches. Dictionaries aren't supported, zstd only uses them when
+// they are given to it explicitly, and the content checksum is skipped.
+//
+// The entropy coded streams are read backwards: they start from the last byte, where the highest set bit marks the end
+// of the padding, and the bits past the start of the stream read as zeros.
+
+#define ZSTD_MAGIC					0xFD2FB528
+#define ZSTD_SKIPPABLE_MAGIC		0x184D2A50		// Skippable frames have any of the 16 magic numbers starting from this
+#define ZSTD_SKIPPABLE_MASK			0xFFFFFFF0
+#define ZSTD_MAX_BLOCK_SIZE			( 1 << 17 )
+
+#define ZSTD_MAX_HUFFMAN_BITS		11
+#define ZSTD_MAX_HUFFMAN_SYMBOLS	256
+#define ZSTD_MAX_WEIGHT_LOG			6				// Accuracy log of the FSE coded Huffman weights
+
+#define ZSTD_MAX_FSE_LOG			9
+#define ZSTD_MAX_FSE_SYMBOLS		256
+#define ZSTD_MAX_LITLEN_LOG			9
+#define ZSTD_MAX_MATCHLEN_LOG		9
+#define ZSTD_MAX_OFFSET_LOG			8
+#define ZSTD_MAX_LITLEN_CODE		35
+#define ZSTD_MAX_MATCHLEN_CODE		52
+#define ZSTD_MAX_OFFSET_CODE		31
+
+// Block types
+#define ZSTD_BLOCK_RAW				0
+#define ZSTD_BLOCK_RLE				1
+#define ZSTD_BLOCK_COMPRESSED		2
+
+// Literals block types
+#define ZSTD_LITERALS_RAW			0
+#define ZSTD_LITERALS_RLE			1
+#define ZSTD_LITERALS_COMPRESSED	2
+#define ZSTD_LITERALS_TREELESS		3				// Huffman coded with the table of the previous block
+
+// Sequence table modes
+#define ZSTD_TABLE_PREDEFINED		0
+#define ZSTD_TABLE_RLE				1
+#define ZSTD_TABLE_FSE				2
+#define ZSTD_TABLE_REPEAT			3				// Table of the previous block
+
+static const uint32 s_LitLenBase[ ZSTD_MAX_LITLEN_CODE + 1 ] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536 };
+static const byte s_LitLenExtra[ ZSTD_MAX_LITLEN_CODE + 1 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+static const uint32 s_MatchLenBase[ ZSTD_MAX_MATCHLEN_CODE + 1 ] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051, 4099, 8195, 16387, 32771, 65539 };
+static const byte s_MatchLenExtra[ ZSTD_MAX_MATCHLEN_CODE + 1 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+// Predefined distributions of the sequence codes, -1 is a probability of less than one
+static const short s_LitLenDefault[ ZSTD_MAX_LITLEN_CODE + 1 ] = { 4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1 };
+static const short s_MatchLenDefault[ ZSTD_MAX_MATCHLEN_CODE + 1 ] = { 1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1 };
+static const short s_OffsetDefault[ 29 ] = { 1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1 };
+
+#define ZSTD_LITLEN_DEFAULT_LOG		6
+#define ZSTD_MATCHLEN_DEFAULT_LOG	6
+#define ZSTD_OFFSET_DEFAULT_LOG		5
+
+// =====================================================================================================================================================================
+
+static inline int HighestBit( uint32 value )
+{
+	int bit = 0;
+
+	while( value >>= 1 )
+		++bit;
+
+	return bit;
+}
+
+// =====================================================================================================================================================================
+
+static inline uint64 ReadLittleEndian( const byte *pData, int numBytes )
+{
+	uint64 value = 0;
+
+	for( int i = 0; i < numBytes; ++i )
+		value |= (uint64)pData[ i ] << ( i * 8 );
+
+	return value;
+}
+
+// =====================================================================================================================================================================
+
+struct FseTable_t
+{
+	int				accuracyLog;
+	byte			symbol[ 1 << ZSTD_MAX_FSE_LOG ];
+	byte			numBits[ 1 << ZSTD_MAX_FSE_LOG ];		///< # of bits read for the next state
+	unsigned short	baseline[ 1 << ZSTD_MAX_FSE_LOG ];		///< Next state before the bits read for it are added
+};
+
+struct ZstdHuffmanTable_t
+{
+	int				maxBits;
+	byte			symbol[ 1 << ZSTD_MAX_HUFFMAN_BITS ];	///< Symbol of the code that the next maxBits bits start with
+	byte			numBits[ 1 << ZSTD_MAX_HUFFMAN_BITS ];	///< Length of that code
+};
+
+// =====================================================================================================================================================================
+/**
+ * Reads an entropy coded stream from its end towards its start
+ */
+class BackwardBitReader
+{
+public:
+	bool Init( const byte *pData, size_t size );			///< false if the stream doesn't have the end marker
+
+	uint32 Peek( int numBits ) const;
+	void Skip( int numBits ) { m_bitPos -= numBits; }
+	uint32 Read( int numBits ) { const uint32 value = Peek( numBits ); m_bitPos -= numBits; return value; }
+
+	bool IsOverflowed( void ) const { return m_bitPos < 0; }	///< More bits were read than the stream has
+	bool IsFinished( void ) const { return m_bitPos == 0; }	///< All bits were read
+
+private:
+	uint64 Load( size_t byteIndex ) const;
+
+	const byte *		m_pData;
+	size_t				m_size;
+	int64				m_bitPos;								///< # of bits that haven't been read yet
+};
+
+// =====================================================================================================================================================================
+
+bool BackwardBitReader::Init( const byte *pData, size_t size )
+{
+	if( !size || !pData[ size - 1 ] )
+		return false;
+
+	m_pData = pData;
+	m_size = size;
+	m_bitPos = (int64)( size - 1 ) * 8 + HighestBit( pData[ size - 1 ] );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+inline uint64 BackwardBitReader::Load( size_t byteIndex ) const
+{
+	if( byteIndex + 8 <= m_size )
+	{
+		uint64 value;
+		memcpy( &value, m_pData + byteIndex, 8 );
+		return value;
+	}
+
+	return ReadLittleEndian( m_pData + byteIndex, (int)( m_size - byteIndex ) );
+}
+
+// =====================================================================================================================================================================
+
+inline uint32 BackwardBitReader::Peek( int numBits ) const
+{
+	const int64 start = m_bitPos - numBits;
+
+	if( start >= 0 )
+		return (uint32)( ( Load( (size_t)( start >> 3 ) ) >> ( start & 7 ) ) & ( ( 1ull << numBits ) - 1 ) );
+
+	if( m_bitPos <= 0 )
+		return 0;
+
+	// The bits past the start of the stream are zeros
+	return (uint32)( ( Load( 0 ) & ( ( 1ull << m_bitPos ) - 1 ) ) << -start );
+}
+
+// =====================================================================================================================================================================
+/**
+ * Builds the FSE decoding table from the normalized symbol counts
+ * @return						false if the counts don't spread over the table
+ */
+static bool BuildFseTable( FseTable_t &table, const short *counts, int numSymbols, int accuracyLog )
+{
+	const int size = 1 << accuracyLog;
+	int highThreshold = size;
+	unsigned short nextState[ ZSTD_MAX_FSE_SYMBOLS ];
+
+	// Symbols with a probability of less than one get a single state at the end of the table
+	for( int symbol = 0; symbol < numSymbols; ++symbol )
+	{
+		if( counts[ symbol ] == -1 )
+		{
+			table.symbol[ --highThreshold ] = (byte)symbol;
+			nextState[ symbol ] = 1;
+		}
+	}
+
+	// The other symbols are spread over the table
+	const int step = ( size >> 1 ) + ( size >> 3 ) + 3;
+	const int mask = size - 1;
+	int pos = 0;
+
+	for( int symbol = 0; symbol < numSymbols; ++symbol )
+	{
+		if( counts[ symbol ] <= 0 )
+			continue;
+
+		nextState[ symbol ] = counts[ symbol ];
+
+		for( int i = 0; i < counts[ symbol ]; ++i )
+		{
+			table.symbol[ pos ] = (byte)symbol;
+
+			do
+			{
+				pos = ( pos + step ) & mask;
+			}
+			while( pos >= highThreshold );
+		}
+	}
+
+	if( pos != 0 )
+		return false;
+
+	for( int state = 0; state < size; ++state )
+	{
+		const int next = nextState[ table.symbol[ state ] ]++;
+		const int numBits = accuracyLog - HighestBit( next );
+
+		table.numBits[ state ] = (byte)numBits;
+		table.baseline[ state ] = (unsigned short)( ( next << numBits ) - size );
+	}
+
+	table.accuracyLog = accuracyLog;
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+static inline uint32 PeekForwardBits( const byte *pData, size_t size, size_t bitPos, int numBits )
+{
+	uint32 value = 0;
+
+	for( int i = 0; i < numBits; ++i, ++bitPos )
+	{
+		if( bitPos / 8 < size )
+			value |= (uint32)( ( pData[ bitPos / 8 ] >> ( bitPos & 7 ) ) & 1 ) << i;
+	}
+
+	return value;
+}
+
+// =====================================================================================================================================================================
+/**
+ * Decompresses the frames of a zstd file
+ */
+class ZstdDecoder
+{
+public:
+	ZstdDecoder( const byte *pIn, size_t inSize, DecompressBuffer &out );
+
+	DecompressResult Decompress( void );
+	size_t GetOutputPos( void ) const { return m_outPos; }
+
+private:
+	bool Frame( void );
+	bool CompressedBlock( const byte *pData, size_t size );
+	bool Literals( const byte *pData, size_t size, size_t &used );
+	bool Sequences( const byte *pData, size_t size );
+
+	bool FseTable( const byte *pData, size_t size, int maxLog, int maxSymbol, FseTable_t &table, size_t &used );
+	bool SequenceTable( int mode, const byte *pData, size_t size, size_t &pos, FseTable_t &table, bool &bDefined, const short *defaultCounts, int numDefault, int defaultLog, int maxLog, int maxSymbol );
+	bool HuffmanTable( const byte *pData, size_t size, size_t &used );
+	bool HuffmanStream( const byte *pData, size_t size, byte *pOut, size_t count );
+
+	size_t MakeRoom( size_t size );							///< Grows the output buffer if it can, returns how many of the bytes fit
+	bool Write( const byte *pData, size_t size );
+	bool Fill( byte value, size_t size );
+	bool Match( size_t offset, size_t length );
+
+	bool Fail( DecompressResult result ) { m_result = result; return false; }
+
+	const byte *		m_pIn;
+	size_t				m_inSize;
+	size_t				m_inPos;
+
+	DecompressBuffer &	m_Out;
+	byte *				m_pOut;								///< Output buffer, cached since it only changes when the buffer grows
+	size_t				m_outSize;
+	size_t				m_outPos;
+	size_t				m_frameStart;						///< Start of the frame in the output, matches can't go further
+
+	DecompressResult	m_result;							///< Why decoding stopped early
+
+	// State that the blocks of a frame share
+	uint32				m_RepeatOffsets[ 3 ];
+	bool				m_bHuffmanTable;
+	bool				m_bLitLenTable;
+	bool				m_bMatchLenTable;
+	bool				m_bOffsetTable;
+
+	ZstdHuffmanTable_t	m_Huffman;
+	FseTable_t			m_Weights;
+	FseTable_t			m_LitLen;
+	FseTable_t			m_MatchLen;
+	FseTable_t			m_Offset;
+
+	const byte *		m_pLiterals;						///< Literals of the current block, in the input if they are raw
+	size_t				m_numLiterals;
+	byte				m_Literals[ ZSTD_MAX_BLOCK_SIZE ];
+};
+
+// =====================================================================================================================================================================
+
+ZstdDecoder::ZstdDecoder( const byte *pIn, size_t inSize, DecompressBuffer &out ) : m_Out( out )
+{
+	m_pIn = pIn;
+	m_inSize = inSize;
+	m_inPos = 0;
+
+	m_pOut = out.GetData();
+	m_outSize = out.GetSize();
+	m_outPos = 0;
+	m_frameStart = 0;
+
+	m_result = DECOMPRESS_CORRUPT;
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult ZstdDecoder::Decompress( void )
+{
+	while( m_inPos < m_inSize )
+	{
+		if( m_inSize - m_inPos < 8 )
+			return DECOMPRESS_INPUT_ENDED;
+
+		const uint32 magic = (uint32)ReadLittleEndian( m_pIn + m_inPos, 4 );
+
+		if( ( magic & ZSTD_SKIPPABLE_MASK ) == ZSTD_SKIPPABLE_MAGIC )
+		{
+			const uint32 size = (uint32)ReadLittleEndian( m_pIn + m_inPos + 4, 4 );
+
+			if( size > m_inSize - m_inPos - 8 )
+				return DECOMPRESS_INPUT_ENDED;
+
+			m_inPos += 8 + size;
+			continue;
+		}
+
+		if( magic != ZSTD_MAGIC )
+			return DECOMPRESS_CORRUPT;
+
+		if( !Frame() )
+			return m_result;
+	}
+
+	return DECOMPRESS_DONE;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::Frame( void )
+{
+	static const int s_DictionaryIdSize[ 4 ] = { 0, 1, 2, 4 };
+	static const int s_ContentSizeSize[ 4 ] = { 0, 2, 4, 8 };
+
+	m_inPos += 4;
+
+	const byte descriptor = m_pIn[ m_inPos++ ];
+	const bool bSingleSegment = ( descriptor & ( 1 << 5 ) ) != 0;
+	const bool bChecksum = ( descriptor & ( 1 << 2 ) ) != 0;
+	const int dictionaryIdSize = s_DictionaryIdSize[ descriptor & 3 ];
+	int contentSizeSize = s_ContentSizeSize[ descriptor >> 6 ];
+
+	// The content size is always there when the window is the whole frame
+	if( bSingleSegment && !contentSizeSize )
+		contentSizeSize = 1;
+
+	if( descriptor & ( 1 << 3 ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	if( m_inPos + ( bSingleSegment? 0 : 1 ) + dictionaryIdSize + contentSizeSize > m_inSize )
+		return Fail( DECOMPRESS_INPUT_ENDED );
+
+	// The window size doesn't matter since the whole output is the window
+	if( !bSingleSegment )
+		++m_inPos;
+
+	if( ReadLittleEndian( m_pIn + m_inPos, dictionaryIdSize ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	m_inPos += dictionaryIdSize;
+
+	uint64 contentSize = ReadLittleEndian( m_pIn + m_inPos, contentSizeSize );
+
+	if( contentSizeSize == 2 )
+		contentSize += 256;
+
+	m_inPos += contentSizeSize;
+
+	m_frameStart = m_outPos;
+	m_RepeatOffsets[ 0 ] = 1;
+	m_RepeatOffsets[ 1 ] = 4;
+	m_RepeatOffsets[ 2 ] = 8;
+	m_bHuffmanTable = false;
+	m_bLitLenTable = false;
+	m_bMatchLenTable = false;
+	m_bOffsetTable = false;
+
+	bool bLastBlock;
+
+	do
+	{
+		if( m_inPos + 3 > m_inSize )
+			return Fail( DECOMPRESS_INPUT_ENDED );
+
+		const uint32 header = (uint32)ReadLittleEndian( m_pIn + m_inPos, 3 );
+		const size_t blockSize = header >> 3;
+		m_inPos += 3;
+
+		bLastBlock = ( header & 1 ) != 0;
+
+		switch( ( header >> 1 ) & 3 )
+		{
+			case ZSTD_BLOCK_RAW:
+			{
+				const size_t available = m_inSize - m_inPos;
+
+				if( blockSize > available )
+				{
+					if( !Write( m_pIn + m_inPos, available ) )
+						return false;
+
+					return Fail( DECOMPRESS_INPUT_ENDED );
+				}
+
+				if( !Write( m_pIn + m_inPos, blockSize ) )
+					return false;
+
+				m_inPos += blockSize;
+				break;
+			}
+
+			case ZSTD_BLOCK_RLE:
+			{
+				if( m_inPos >= m_inSize )
+					return Fail( DECOMPRESS_INPUT_ENDED );
+
+				if( !Fill( m_pIn[ m_inPos ], blockSize ) )
+					return false;
+
+				++m_inPos;
+				break;
+			}
+
+			case ZSTD_BLOCK_COMPRESSED:
+			{
+				if( blockSize > ZSTD_MAX_BLOCK_SIZE )
+					return Fail( DECOMPRESS_CORRUPT );
+
+				if( blockSize > m_inSize - m_inPos )
+					return Fail( DECOMPRESS_INPUT_ENDED );
+
+				if( !CompressedBlock( m_pIn + m_inPos, blockSize ) )
+					return false;
+
+				m_inPos += blockSize;
+				break;
+			}
+
+			default:
+				return Fail( DECOMPRESS_CORRUPT );
+		}
+	}
+	while( !bLastBlock );
+
+	if( bChecksum )
+	{
+		if( m_inPos + 4 > m_inSize )
+			return Fail( DECOMPRESS_INPUT_ENDED );
+
+		m_inPos += 4;
+	}
+
+	if( contentSizeSize && m_outPos - m_frameStart != contentSize )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::CompressedBlock( const byte *pData, size_t size )
+{
+	size_t used;
+
+	if( !Literals( pData, size, used ) )
+		return false;
+
+	return Sequences( pData + used, size - used );
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::Literals( const byte *pData, size_t size, size_t &used )
+{
+	if( !size )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	const int type = pData[ 0 ] & 3;
+	const int sizeFormat = ( pData[ 0 ] >> 2 ) & 3;
+
+	if( type == ZSTD_LITERALS_RAW || type == ZSTD_LITERALS_RLE )
+	{
+		// The size takes 5, 12 or 20 bits
+		size_t headerSize;
+
+		switch( sizeFormat )
+		{
+			case 1:		headerSize = 2; break;
+			case 3:		headerSize = 3; break;
+			default:	headerSize = 1; break;
+		}
+
+		if( headerSize > size )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		const size_t header = (size_t)ReadLittleEndian( pData, (int)headerSize );
+		m_numLiterals = ( headerSize == 1 )? header >> 3 : header >> 4;
+
+		if( m_numLiterals > ZSTD_MAX_BLOCK_SIZE )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		if( type == ZSTD_LITERALS_RAW )
+		{
+			if( headerSize + m_numLiterals > size )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			m_pLiterals = pData + headerSize;
+			used = headerSize + m_numLiterals;
+		}
+		else
+		{
+			if( headerSize + 1 > size )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			memset( m_Literals, pData[ headerSize ], m_numLiterals );
+			m_pLiterals = m_Literals;
+			used = headerSize + 1;
+		}
+
+		return true;
+	}
+
+	// Both sizes take 10, 10, 14 or 18 bits, with one Huffman coded stream for the first format and four for the others
+	const size_t headerSize = ( sizeFormat < 2 )? 3 : sizeFormat + 2;
+	const int sizeBits = ( sizeFormat < 2 )? 10 : sizeFormat * 4 + 6;
+	const int numStreams = ( sizeFormat == 0 )? 1 : 4;
+
+	if( headerSize > size )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	const uint64 header = ReadLittleEndian( pData, (int)headerSize );
+	const size_t sizeMask = ( (size_t)1 << sizeBits ) - 1;
+	m_numLiterals = (size_t)( header >> 4 ) & sizeMask;
+	size_t streamsSize = (size_t)( header >> ( 4 + sizeBits ) ) & sizeMask;
+
+	if( m_numLiterals > ZSTD_MAX_BLOCK_SIZE || headerSize + streamsSize > size )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	used = headerSize + streamsSize;
+
+	const byte *pStreams = pData + headerSize;
+
+	if( type == ZSTD_LITERALS_COMPRESSED )
+	{
+		size_t tableSize;
+
+		if( !HuffmanTable( pStreams, streamsSize, tableSize ) )
+			return false;
+
+		pStreams += tableSize;
+		streamsSize -= tableSize;
+		m_bHuffmanTable = true;
+	}
+	else if( !m_bHuffmanTable )
+	{
+		return Fail( DECOMPRESS_CORRUPT );
+	}
+
+	m_pLiterals = m_Literals;
+
+	if( numStreams == 1 )
+		return HuffmanStream( pStreams, streamsSize, m_Literals, m_numLiterals );
+
+	// Four streams with a jump table of the sizes of the first three, each decodes a quarter of the literals
+	if( streamsSize < 6 )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	size_t sizes[ 4 ];
+	sizes[ 0 ] = pStreams[ 0 ] | ( pStreams[ 1 ] << 8 );
+	sizes[ 1 ] = pStreams[ 2 ] | ( pStreams[ 3 ] << 8 );
+	sizes[ 2 ] = pStreams[ 4 ] | ( pStreams[ 5 ] << 8 );
+
+	if( sizes[ 0 ] + sizes[ 1 ] + sizes[ 2 ] + 6 > streamsSize )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	sizes[ 3 ] = streamsSize - 6 - sizes[ 0 ] - sizes[ 1 ] - sizes[ 2 ];
+
+	const size_t quarter = ( m_numLiterals + 3 ) / 4;
+
+	if( quarter * 3 > m_numLiterals )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	pStreams += 6;
+
+	for( int i = 0; i < 4; ++i )
+	{
+		const size_t count = ( i < 3 )? quarter : m_numLiterals - quarter * 3;
+
+		if( !HuffmanStream( pStreams, sizes[ i ], m_Literals + quarter * i, count ) )
+			return false;
+
+		pStreams += sizes[ i ];
+	}
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::HuffmanTable( const byte *pData, size_t size, size_t &used )
+{
+	if( !size )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	// Weights of all symbols but the last one, which gets the weight that completes the code
+	byte weights[ ZSTD_MAX_HUFFMAN_SYMBOLS + 3 ];
+	int numWeights = 0;
+	const int header = pData[ 0 ];
+
+	if( header >= 128 )
+	{
+		// Four bits per weight
+		numWeights = header - 127;
+		used = 1 + ( numWeights + 1 ) / 2;
+
+		if( used > size )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		for( int i = 0; i < numWeights; ++i )
+			weights[ i ] = ( i & 1 )? pData[ 1 + i / 2 ] & 15 : pData[ 1 + i / 2 ] >> 4;
+	}
+	else
+	{
+		// FSE coded with two interleaved states, until the stream runs out
+		used = 1 + header;
+
+		if( !header || used > size )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		size_t tableSize;
+
+		if( !FseTable( pData + 1, header, ZSTD_MAX_WEIGHT_LOG, ZSTD_MAX_HUFFMAN_BITS, m_Weights, tableSize ) )
+			return false;
+
+		BackwardBitReader bits;
+
+		if( tableSize >= (size_t)header || !bits.Init( pData + 1 + tableSize, header - tableSize ) )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		uint32 state1 = bits.Read( m_Weights.accuracyLog );
+		uint32 state2 = bits.Read( m_Weights.accuracyLog );
+
+		while( true )
+		{
+			if( numWeights >= ZSTD_MAX_HUFFMAN_SYMBOLS - 1 )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			weights[ numWeights++ ] = m_Weights.symbol[ state1 ];
+			state1 = m_Weights.baseline[ state1 ] + bits.Read( m_Weights.numBits[ state1 ] );
+
+			if( bits.IsOverflowed() )
+			{
+				weights[ numWeights++ ] = m_Weights.symbol[ state2 ];
+				break;
+			}
+
+			weights[ numWeights++ ] = m_Weights.symbol[ state2 ];
+			state2 = m_Weights.baseline[ state2 ] + bits.Read( m_Weights.numBits[ state2 ] );
+
+			if( bits.IsOverflowed() )
+			{
+				weights[ numWeights++ ] = m_Weights.symbol[ state1 ];
+				break;
+			}
+		}
+
+		if( numWeights > ZSTD_MAX_HUFFMAN_SYMBOLS - 1 )
+			return Fail( DECOMPRESS_CORRUPT );
+	}
+
+	// A weight w is a code of maxBits + 1 - w bits, the weights add up to a power of two
+	uint32 total = 0;
+
+	for( int i = 0; i < numWeights; ++i )
+	{
+		if( weights[ i ] > ZSTD_MAX_HUFFMAN_BITS )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		if( weights[ i ] )
+			total += 1 << ( weights[ i ] - 1 );
+	}
+
+	if( !total )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	const int maxBits = HighestBit( total ) + 1;
+	const uint32 left = ( 1 << maxBits ) - total;
+
+	if( maxBits > ZSTD_MAX_HUFFMAN_BITS || ( left & ( left - 1 ) ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	weights[ numWeights++ ] = (byte)( HighestBit( left ) + 1 );
+
+	// The longest codes come first in the table, the symbols of each length in order
+	int rankCount[ ZSTD_MAX_HUFFMAN_BITS + 1 ];
+	memset( rankCount, 0, sizeof( rankCount ) );
+
+	for( int i = 0; i < numWeights; ++i )
+	{
+		if( weights[ i ] )
+			++rankCount[ maxBits + 1 - weights[ i ] ];
+	}
+
+	int rankStart[ ZSTD_MAX_HUFFMAN_BITS + 1 ];
+	rankStart[ maxBits ] = 0;
+
+	for( int length = maxBits; length >= 1; --length )
+	{
+		rankStart[ length - 1 ] = rankStart[ length ] + ( rankCount[ length ] << ( maxBits - length ) );
+		memset( m_Huffman.numBits + rankStart[ length ], length, rankStart[ length - 1 ] - rankStart[ length ] );
+	}
+
+	for( int i = 0; i < numWeights; ++i )
+	{
+		if( !weights[ i ] )
+			continue;
+
+		const int length = maxBits + 1 - weights[ i ];
+		const int count = 1 << ( maxBits - length );
+
+		memset( m_Huffman.symbol + rankStart[ length ], i, count );
+		rankStart[ length ] += count;
+	}
+
+	m_Huffman.maxBits = maxBits;
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::HuffmanStream( const byte *pData, size_t size, byte *pOut, size_t count )
+{
+	BackwardBitReader bits;
+
+	if( !bits.Init( pData, size ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	const int maxBits = m_Huffman.maxBits;
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		const uint32 index = bits.Peek( maxBits );
+
+		pOut[ i ] = m_Huffman.symbol[ index ];
+		bits.Skip( m_Huffman.numBits[ index ] );
+	}
+
+	if( !bits.IsFinished() )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::FseTable( const byte *pData, size_t size, int maxLog, int maxSymbol, FseTable_t &table, size_t &used )
+{
+	const int accuracyLog = 5 + PeekForwardBits( pData, size, 0, 4 );
+	size_t bitPos = 4;
+
+	if( accuracyLog > maxLog )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	// The counts use as few bits as the remaining probability allows
+	short counts[ ZSTD_MAX_FSE_SYMBOLS ];
+	int remaining = 1 << accuracyLog;
+	int numSymbols = 0;
+
+	while( remaining > 0 && numSymbols <= maxSymbol )
+	{
+		const int numBits = HighestBit( remaining + 1 ) + 1;
+		const uint32 lowerMask = ( 1 << ( numBits - 1 ) ) - 1;
+		const uint32 threshold = ( 1 << numBits ) - 1 - ( remaining + 1 );
+		uint32 value = PeekForwardBits( pData, size, bitPos, numBits );
+
+		if( ( value & lowerMask ) < threshold )
+		{
+			value &= lowerMask;
+			bitPos += numBits - 1;
+		}
+		else
+		{
+			if( value > lowerMask )
+				value -= threshold;
+
+			bitPos += numBits;
+		}
+
+		const int count = (int)value - 1;
+		remaining -= ( count < 0 )? -count : count;
+		counts[ numSymbols++ ] = (short)count;
+
+		// A zero count is followed by the # of zero counts after it, two bits at a time
+		if( !count )
+		{
+			uint32 repeat;
+
+			do
+			{
+				repeat = PeekForwardBits( pData, size, bitPos, 2 );
+				bitPos += 2;
+
+				for( uint32 i = 0; i < repeat && numSymbols <= maxSymbol; ++i )
+					counts[ numSymbols++ ] = 0;
+			}
+			while( repeat == 3 && bitPos <= size * 8 );
+		}
+
+		if( bitPos > size * 8 )
+			return Fail( DECOMPRESS_CORRUPT );
+	}
+
+	if( remaining != 0 || !BuildFseTable( table, counts, numSymbols, accuracyLog ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	used = ( bitPos + 7 ) / 8;
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::SequenceTable( int mode, const byte *pData, size_t size, size_t &pos, FseTable_t &table, bool &bDefined, const short *defaultCounts, int numDefault, int defaultLog, int maxLog, int maxSymbol )
+{
+	switch( mode )
+	{
+		case ZSTD_TABLE_PREDEFINED:
+		{
+			BuildFseTable( table, defaultCounts, numDefault, defaultLog );
+			break;
+		}
+
+		case ZSTD_TABLE_RLE:
+		{
+			if( pos >= size || pData[ pos ] > maxSymbol )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			table.accuracyLog = 0;
+			table.symbol[ 0 ] = pData[ pos++ ];
+			table.numBits[ 0 ] = 0;
+			table.baseline[ 0 ] = 0;
+			break;
+		}
+
+		case ZSTD_TABLE_FSE:
+		{
+			size_t used;
+
+			if( pos >= size || !FseTable( pData + pos, size - pos, maxLog, maxSymbol, table, used ) )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			pos += used;
+			break;
+		}
+
+		default:
+		{
+			if( !bDefined )
+				return Fail( DECOMPRESS_CORRUPT );
+
+			break;
+		}
+	}
+
+	bDefined = true;
+
+	return true;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::Sequences( const byte *pData, size_t size )
+{
+	if( !size )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	uint32 numSequences = pData[ 0 ];
+	size_t pos = 1;
+
+	if( numSequences >= 255 )
+	{
+		if( size < 3 )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		numSequences = pData[ 1 ] + ( pData[ 2 ] << 8 ) + 0x7F00;
+		pos = 3;
+	}
+	else if( numSequences >= 128 )
+	{
+		if( size < 2 )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		numSequences = ( ( numSequences - 128 ) << 8 ) + pData[ 1 ];
+		pos = 2;
+	}
+
+	// A block of literals only
+	if( !numSequences )
+		return Write( m_pLiterals, m_numLiterals );
+
+	if( pos >= size )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	const byte modes = pData[ pos++ ];
+
+	if( modes & 3 )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	if( !SequenceTable( modes >> 6, pData, size, pos, m_LitLen, m_bLitLenTable, s_LitLenDefault, ZSTD_MAX_LITLEN_CODE + 1, ZSTD_LITLEN_DEFAULT_LOG, ZSTD_MAX_LITLEN_LOG, ZSTD_MAX_LITLEN_CODE )
+		|| !SequenceTable( ( modes >> 4 ) & 3, pData, size, pos, m_Offset, m_bOffsetTable, s_OffsetDefault, 29, ZSTD_OFFSET_DEFAULT_LOG, ZSTD_MAX_OFFSET_LOG, ZSTD_MAX_OFFSET_CODE )
+		|| !SequenceTable( ( modes >> 2 ) & 3, pData, size, pos, m_MatchLen, m_bMatchLenTable, s_MatchLenDefault, ZSTD_MAX_MATCHLEN_CODE + 1, ZSTD_MATCHLEN_DEFAULT_LOG, ZSTD_MAX_MATCHLEN_LOG, ZSTD_MAX_MATCHLEN_CODE ) )
+		return false;
+
+	BackwardBitReader bits;
+
+	if( !bits.Init( pData + pos, size - pos ) )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	uint32 litLenState = bits.Read( m_LitLen.accuracyLog );
+	uint32 offsetState = bits.Read( m_Offset.accuracyLog );
+	uint32 matchLenState = bits.Read( m_MatchLen.accuracyLog );
+
+	size_t literalPos = 0;
+
+	for( uint32 sequence = 0; sequence < numSequences; ++sequence )
+	{
+		const int offsetCode = m_Offset.symbol[ offsetState ];
+		const int matchLenCode = m_MatchLen.symbol[ matchLenState ];
+		const int litLenCode = m_LitLen.symbol[ litLenState ];
+
+		const uint32 offsetValue = ( 1u << offsetCode ) + bits.Read( offsetCode );
+		const uint32 matchLength = s_MatchLenBase[ matchLenCode ] + bits.Read( s_MatchLenExtra[ matchLenCode ] );
+		const uint32 literalLength = s_LitLenBase[ litLenCode ] + bits.Read( s_LitLenExtra[ litLenCode ] );
+
+		// The states aren't updated after the last sequence
+		if( sequence + 1 < numSequences )
+		{
+			litLenState = m_LitLen.baseline[ litLenState ] + bits.Read( m_LitLen.numBits[ litLenState ] );
+			matchLenState = m_MatchLen.baseline[ matchLenState ] + bits.Read( m_MatchLen.numBits[ matchLenState ] );
+			offsetState = m_Offset.baseline[ offsetState ] + bits.Read( m_Offset.numBits[ offsetState ] );
+		}
+
+		// Values 1-3 are the recent offsets, shifted by one when there are no literals before the match
+		uint32 offset;
+
+		if( offsetValue > 3 )
+		{
+			offset = offsetValue - 3;
+			m_RepeatOffsets[ 2 ] = m_RepeatOffsets[ 1 ];
+			m_RepeatOffsets[ 1 ] = m_RepeatOffsets[ 0 ];
+			m_RepeatOffsets[ 0 ] = offset;
+		}
+		else
+		{
+			const uint32 index = offsetValue - 1 + ( literalLength? 0 : 1 );
+
+			if( index == 0 )
+			{
+				offset = m_RepeatOffsets[ 0 ];
+			}
+			else
+			{
+				offset = ( index < 3 )? m_RepeatOffsets[ index ] : m_RepeatOffsets[ 0 ] - 1;
+
+				if( index > 1 )
+					m_RepeatOffsets[ 2 ] = m_RepeatOffsets[ 1 ];
+
+				m_RepeatOffsets[ 1 ] = m_RepeatOffsets[ 0 ];
+				m_RepeatOffsets[ 0 ] = offset;
+			}
+		}
+
+		if( literalLength > m_numLiterals - literalPos )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		if( !Write( m_pLiterals + literalPos, literalLength ) )
+			return false;
+
+		literalPos += literalLength;
+
+		if( !offset || offset > m_outPos - m_frameStart )
+			return Fail( DECOMPRESS_CORRUPT );
+
+		if( !Match( offset, matchLength ) )
+			return false;
+	}
+
+	if( !bits.IsFinished() )
+		return Fail( DECOMPRESS_CORRUPT );
+
+	// The literals after the last match
+	return Write( m_pLiterals + literalPos, m_numLiterals - literalPos );
+}
+
+// =====================================================================================================================================================================
+
+size_t ZstdDecoder::MakeRoom( size_t size )
+{
+	if( size > m_outSize - m_outPos && m_Out.Grow( m_outPos + size ) )
+	{
+		m_pOut = m_Out.GetData();
+		m_outSize = m_Out.GetSize();
+	}
+
+	return ( size > m_outSize - m_outPos )? m_outSize - m_outPos : size;
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::Write( const byte *pData, size_t size )
+{
+	const size_t room = MakeRoom( size );
+
+	memcpy( m_pOut + m_outPos, pData, room );
+	m_outPos += room;
+
+	return room == size || Fail( DECOMPRESS_OUTPUT_FULL );
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::Fill( byte value, size_t size )
+{
+	const size_t room = MakeRoom( size );
+
+	memset( m_pOut + m_outPos, value, room );
+	m_outPos += room;
+
+	return room == size || Fail( DECOMPRESS_OUTPUT_FULL );
+}
+
+// =====================================================================================================================================================================
+
+bool ZstdDecoder::Match( size_t offset, size_t length )
+{
+	const size_t room = MakeRoom( length );
+
+	byte *pDest = m_pOut + m_outPos;
+	const byte *pSrc = pDest - offset;
+
+	// The source overlaps the destination when the offset is shorter than the length (repeating pattern)
+	if( offset >= room )
+	{
+		memcpy( pDest, pSrc, room );
+	}
+	else
+	{
+		for( size_t i = 0; i < room; ++i )
+			pDest[ i ] = pSrc[ i ];
+	}
+
+	m_outPos += room;
+
+	return room == length || Fail( DECOMPRESS_OUTPUT_FULL );
+}
+
+// =====================================================================================================================================================================
+
+bool IsZstdData( const byte *pData, size_t size )
+{
+	return size >= ZSTD_MIN_SIZE && ReadLittleEndian( pData, 4 ) == ZSTD_MAGIC;
+}
+
+// =====================================================================================================================================================================
+
+size_t GetZstdContentSize( const byte *pData, size_t size )
+{
+	static const int s_DictionaryIdSize[ 4 ] = { 0, 1, 2, 4 };
+	static const int s_ContentSizeSize[ 4 ] = { 0, 2, 4, 8 };
+
+	if( !IsZstdData( pData, size ) )
+		return 0;
+
+	const byte descriptor = pData[ 4 ];
+	const bool bSingleSegment = ( descriptor & ( 1 << 5 ) ) != 0;
+	int contentSizeSize = s_ContentSizeSize[ descriptor >> 6 ];
+
+	if( bSingleSegment && !contentSizeSize )
+		contentSizeSize = 1;
+
+	const size_t pos = 5 + ( bSingleSegment? 0 : 1 ) + s_DictionaryIdSize[ descriptor & 3 ];
+
+	if( !contentSizeSize || pos + contentSizeSize > size )
+		return 0;
+
+	uint64 contentSize = ReadLittleEndian( pData + pos, contentSizeSize );
+
+	if( contentSizeSize == 2 )
+		contentSize += 256;
+
+	return ( contentSize <= DECOMPRESS_MAX_SIZE )? (size_t)contentSize : 0;
+}
+
+// =====================================================================================================================================================================
+
+DecompressResult ZstdDecompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten )
+{
+	outWritten = 0;
+
+	if( !IsZstdData( pIn, inSize ) )
+		return DECOMPRESS_CORRUPT;
+
+	// The tables and the literals buffer are too large for the stack
+	ZstdDecoder *pDecoder = new ZstdDecoder( pIn, inSize, out );
+
+	DecompressResult result = pDecoder->Decompress();
+
+	outWritten = pDecoder->GetOutputPos();
+	delete pDecoder;
+
+	return result;
+}
\ No newline at end of file
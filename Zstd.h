@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Common.h"
+#include "Decompress.h"
+
+#define ZSTD_MIN_SIZE		9		// Magic, frame header descriptor, the shortest frame header and one block header
+
+/**
+ * Whether the data starts with the zstd frame magic bytes
+ */
+bool IsZstdData( const byte *pData, size_t size );
+
+/**
+ * Gets the decompressed size from the header of the first frame (0 if the frame doesn't have it)
+ */
+size_t GetZstdContentSize( const byte *pData, size_t size );
+
+/**
+ * Decompresses all frames of a zstd file straight into the output buffer
+ * Stops when a fixed output buffer is full, so the start of a file can be read without decompressing all of it.
+ * @param outWritten			set to the # of bytes written to the output buffer
+ */
+DecompressResult ZstdDecompress( const byte *pIn, size_t inSize, DecompressBuffer &out, size_t &outWritten );
\ No newline at end of file